@@ -0,0 +1,469 @@
+#include "rgspch.h"
+#include "BenchScenes.h"
+
+#include "RGS/JobSystem.h"
+#include "RGS/Timer.h"
+#include "RGS/Tuning.h"
+#include "RGS/Base/RollingHistogram.h"
+#include "Headless/HeadlessWindow.h"
+
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <limits>
+
+#ifndef RGS_ASSETS_DIR
+    #define RGS_ASSETS_DIR "Assets"
+#endif
+
+namespace RGS::Bench {
+
+    struct Options
+    {
+        std::vector<std::string> Scenes;                  // empty runs all of them
+        std::vector<std::pair<uint32_t, uint32_t>> Resolutions = { { 800u, 600u } };
+        std::vector<int> MSAALevels = { 1 };
+        std::vector<uint32_t> ThreadCounts = { 0u };      // 0 is one worker per hardware thread
+        uint32_t WarmupFrames = 10u;
+        uint32_t Frames = 50u;
+        std::string AssetsDir = RGS_ASSETS_DIR;
+        std::string ObjPath;                              // defaults to <assets>/sphere.obj
+        int ObjSubdivisions = 3;
+        std::string OutputPath;                           // empty writes the JSON to stdout
+        std::string ImageDir;                             // last frame of every run as png, empty disables it
+        std::string ReplayPath;                           // recorded session, replaces --scenes and --msaa
+        std::string TuningPath = Config::TuningFilePath;  // group sizes loaded before the runs
+        std::string TuneOutputPath;                       // tuning mode: find the group sizes and write them here
+        bool FastMath = false;                            // Program::EnableFastMath of the scene programs
+        TextureStorage Textures = TextureStorage::Linear; // layout of the scene textures
+    };
+
+    struct RunResult
+    {
+        std::string Scene;
+        uint32_t Width, Height;
+        int MSAALevel;
+        uint32_t Threads;
+        RollingHistogram::Percentiles FrameTimes;
+        uint32_t Frames;
+        float MinFrameTime;
+        double TotalTime;             // ms over the measured frames
+        uint64_t Triangles;           // submitted over the measured frames
+    };
+
+    static void PrintUsage()
+    {
+        std::cerr << "rgs-bench [options]\n"
+                  << "  --scenes ibl_sphere,skybox,transparent_quads,pbr_grid,obj,ibl_cube,textured_floor,virtual_skybox,self_overlap   (default: all)\n"
+                  << "  --resolutions 640x480,1280x720                            (default: 800x600)\n"
+                  << "  --msaa 1,4                                                (default: 1)\n"
+                  << "  --threads 1,4,0                                           (default: 0 = hardware threads)\n"
+                  << "  --warmup N --frames N                                     (default: 10, 50)\n"
+                  << "  --assets DIR --obj FILE --obj-subdivide N                 (default: " RGS_ASSETS_DIR ", sphere.obj, 3)\n"
+                  << "  --output FILE.json                                        (default: stdout)\n"
+                  << "  --save-images DIR                                         (last frame of every run)\n"
+                  << "  --replay FILE.rgss                                        (recorded session instead of the scenes)\n"
+                  << "  --math exact|fast                                         (default: exact, fast uses the FastMath approximations)\n"
+                  << "  --textures linear|tiled|bc                                (default: linear, tiled stores 4x4 tiles, bc block compresses)\n"
+                  << "  --tuning FILE                                             (default: " << Config::TuningFilePath << ")\n"
+                  << "  --tune FILE                                               (benchmark the job group sizes on the first\n"
+                  << "                                                             resolution, MSAA level and thread count, write the best)\n";
+    }
+
+    static std::vector<std::string> Split(const std::string& str, const char delimiter)
+    {
+        std::vector<std::string> parts;
+        std::stringstream stream(str);
+        std::string part;
+        while (std::getline(stream, part, delimiter))
+        {
+            if (!part.empty())
+                parts.push_back(part);
+        }
+        return parts;
+    }
+
+    static bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc)
+                return false;
+
+            const std::string value = argv[++i];
+            try
+            {
+                if (arg == "--scenes")
+                {
+                    options.Scenes = Split(value, ',');
+                }
+                else if (arg == "--resolutions")
+                {
+                    options.Resolutions.clear();
+                    for (const std::string& resolution : Split(value, ','))
+                    {
+                        std::vector<std::string> size = Split(resolution, 'x');
+                        if (size.size() != 2)
+                            return false;
+                        options.Resolutions.emplace_back((uint32_t)std::stoul(size[0]), (uint32_t)std::stoul(size[1]));
+                    }
+                }
+                else if (arg == "--msaa")
+                {
+                    options.MSAALevels.clear();
+                    for (const std::string& level : Split(value, ','))
+                    {
+                        int msaa = std::stoi(level);
+                        if (msaa < (int)MSAA::None || msaa > (int)MSAA::X8)
+                            return false;
+                        options.MSAALevels.push_back(msaa);
+                    }
+                }
+                else if (arg == "--threads")
+                {
+                    options.ThreadCounts.clear();
+                    for (const std::string& count : Split(value, ','))
+                        options.ThreadCounts.push_back((uint32_t)std::stoul(count));
+                }
+                else if (arg == "--warmup")         options.WarmupFrames = (uint32_t)std::stoul(value);
+                else if (arg == "--frames")         options.Frames = std::max(1u, (uint32_t)std::stoul(value));
+                else if (arg == "--assets")         options.AssetsDir = value;
+                else if (arg == "--obj")            options.ObjPath = value;
+                else if (arg == "--obj-subdivide")  options.ObjSubdivisions = std::stoi(value);
+                else if (arg == "--output")         options.OutputPath = value;
+                else if (arg == "--save-images")    options.ImageDir = value;
+                else if (arg == "--replay")         options.ReplayPath = value;
+                else if (arg == "--tuning")         options.TuningPath = value;
+                else if (arg == "--tune")           options.TuneOutputPath = value;
+                else if (arg == "--math")
+                {
+                    if (value != "exact" && value != "fast")
+                        return false;
+                    options.FastMath = value == "fast";
+                }
+                else if (arg == "--textures")
+                {
+                    if (value == "linear")
+                        options.Textures = TextureStorage::Linear;
+                    else if (value == "tiled")
+                        options.Textures = TextureStorage::Tiled;
+                    else if (value == "bc")
+                        options.Textures = TextureStorage::Compressed;
+                    else
+                        return false;
+                }
+                else
+                    return false;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        if (options.ObjPath.empty())
+            options.ObjPath = options.AssetsDir + "/sphere.obj";
+        return !options.Resolutions.empty() && !options.MSAALevels.empty() && !options.ThreadCounts.empty();
+    }
+
+    // With a session, every frame takes its camera, uniforms and MSAA level from the recording and 
+    // the warmup repeats its first frame
+    static RunResult Run(Scene& scene, const Options& options, const uint32_t width, const uint32_t height, int msaaLevel,
+                         const SessionPlayer* session = nullptr)
+    {
+        const uint32_t frameCount = session ? session->GetFrameCount() : options.Frames;
+        if (session)
+            msaaLevel = session->GetFrame(0).MSAALevel;
+
+        HeadlessWindow window("rgs-bench", width, height);
+        std::unique_ptr<Framebuffer> screen = Framebuffer::Create(width, height);
+        std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(width, height, (MSAA)msaaLevel);
+
+        Camera camera;
+        camera.Aspect = (float)width / (float)height;
+        camera.Pos = { 0.0f, 0.0f, 2.0f, 1.0f };
+
+        RunResult result = {};
+        result.Scene = scene.GetName();
+        result.Width = width;
+        result.Height = height;
+        result.MSAALevel = msaaLevel;
+        result.Threads = JobSystem::GetThreadCount();
+        result.Frames = frameCount;
+        result.MinFrameTime = std::numeric_limits<float>::max();
+
+        RollingHistogram frameTimes(frameCount);
+        Pipeline pipeline;
+        for (uint32_t frame = 0; frame < options.WarmupFrames + frameCount; ++frame)
+        {
+            Timer timer;
+
+            if (session)
+            {
+                const SessionFrame& sessionFrame = session->GetFrame(frame < options.WarmupFrames ? 0 : frame - options.WarmupFrames);
+                sessionFrame.ApplyCamera(camera);
+                scene.OnReplay(sessionFrame);
+                if (sessionFrame.MSAALevel != (uint8_t)framebuffer->GetMSAA())
+                    framebuffer = Framebuffer::Create(width, height, (MSAA)sessionFrame.MSAALevel);
+            }
+
+            uint64_t triangles = RenderFrame(scene, pipeline, *framebuffer, *screen, camera);
+            window.DrawFramebuffer(*screen);
+            scene.UpdateStreaming(false);
+
+            const float frameTime = (float)timer.GetDuration();
+            if (frame >= options.WarmupFrames)
+            {
+                frameTimes.Add(frameTime);
+                result.MinFrameTime = std::min(result.MinFrameTime, frameTime);
+                result.TotalTime += frameTime;
+                result.Triangles += triangles;
+            }
+        }
+
+        result.FrameTimes = frameTimes.GetPercentiles();
+
+        if (!options.ImageDir.empty())
+        {
+            const std::string path = options.ImageDir + "/" + scene.GetName() + "_" + std::to_string(width) + "x" + std::to_string(height)
+                                   + "_msaa" + std::to_string(msaaLevel) + ".png";
+            if (!window.SaveImage(path))
+                std::cerr << "写入失败: " << path << std::endl;
+        }
+        return result;
+    }
+
+    // Median ms of func over options.Frames runs after the warmup
+    template<typename func_t>
+    static float MeasureMedian(const Options& options, func_t&& func)
+    {
+        RollingHistogram times(options.Frames);
+        for (uint32_t i = 0; i < options.WarmupFrames + options.Frames; ++i)
+        {
+            Timer timer;
+            func();
+            if (i >= options.WarmupFrames)
+                times.Add((float)timer.GetDuration());
+        }
+        return times.GetPercentiles().P50;
+    }
+
+    // Tries every candidate group size per kernel, one kernel at a time with the others at their current value,
+    // and keeps the fastest. Rasterize is timed on whole frames of the selected scenes, resolve and blit on their own.
+    static void Tune(std::vector<std::unique_ptr<Scene>>& scenes, const Options& options)
+    {
+        constexpr uint32_t candidates[] = { 64u, 128u, 256u, 512u, 1024u, 2048u, 4096u, 8192u, 16384u };
+
+        const auto [width, height] = options.Resolutions.front();
+        const int msaaLevel = options.MSAALevels.front();
+
+        HeadlessWindow window("rgs-bench", width, height);
+        std::unique_ptr<Framebuffer> screen = Framebuffer::Create(width, height);
+        std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(width, height, (MSAA)msaaLevel);
+
+        Camera camera;
+        camera.Aspect = (float)width / (float)height;
+        camera.Pos = { 0.0f, 0.0f, 2.0f, 1.0f };
+        Pipeline pipeline;
+
+        auto measure = [&](const TunedKernel kernel)
+        {
+            switch (kernel)
+            {
+            case TunedKernel::Rasterize:
+            {
+                float total = 0.0f;
+                for (auto& scene : scenes)
+                {
+                    if (!options.Scenes.empty() && std::find(options.Scenes.begin(), options.Scenes.end(), scene->GetName()) == options.Scenes.end())
+                        continue;
+                    total += MeasureMedian(options, [&]() { RenderFrame(*scene, pipeline, *framebuffer, *screen, camera); });
+                }
+                return total;
+            }
+            case TunedKernel::Resolve:
+                return MeasureMedian(options, [&]() { framebuffer->ResolveParallel(true); });
+            case TunedKernel::Blit:
+                return MeasureMedian(options, [&]() { window.DrawFramebuffer(*screen); });
+            case TunedKernel::PostProcess:
+                return MeasureMedian(options, [&]() { framebuffer->PostProcess(PostProcessSettings()); });
+            default:
+                return 0.0f;
+            }
+        };
+
+        std::cerr << std::fixed << std::setprecision(3) << "Tuning at " << width << "x" << height << " msaa " << msaaLevel
+                  << " threads " << JobSystem::GetThreadCount() << std::endl;
+        for (int i = 0; i < (int)TunedKernel::Count; ++i)
+        {
+            const TunedKernel kernel = (TunedKernel)i;
+            uint32_t best = Tuning::GetGroupSize(kernel);
+            float bestTime = std::numeric_limits<float>::max();
+            for (uint32_t groupSize : candidates)
+            {
+                Tuning::SetGroupSize(kernel, groupSize);
+                const float time = measure(kernel);
+                std::cerr << "  " << Tuning::GetName(kernel) << " " << groupSize << ": " << time << " ms" << std::endl;
+                if (time < bestTime)
+                {
+                    bestTime = time;
+                    best = groupSize;
+                }
+            }
+            Tuning::SetGroupSize(kernel, best);
+            std::cerr << Tuning::GetName(kernel) << " = " << best << std::endl;
+        }
+    }
+
+    static void WriteJson(std::ostream& out, const Options& options, const std::vector<RunResult>& results)
+    {
+        out << std::fixed << std::setprecision(3);
+        out << "{\n";
+        out << "  \"warmup_frames\": " << options.WarmupFrames << ",\n";
+        out << "  \"frames\": " << options.Frames << ",\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"math\": \"" << (options.FastMath ? "fast" : "exact") << "\",\n";
+        out << "  \"textures\": \"" << (options.Textures == TextureStorage::Compressed ? "bc" : (options.Textures == TextureStorage::Tiled ? "tiled" : "linear")) << "\",\n";
+        out << "  \"group_sizes\": { ";
+        for (int i = 0; i < (int)TunedKernel::Count; ++i)
+            out << (i > 0 ? ", " : "") << "\"" << Tuning::GetName((TunedKernel)i) << "\": " << Tuning::GetGroupSize((TunedKernel)i);
+        out << " },\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const RunResult& result = results[i];
+            const double seconds = std::max(result.TotalTime, 1e-3) * 0.001;
+            const double mpixels = (double)result.Width * result.Height * result.Frames / seconds * 1e-6;
+            const double triangles = (double)result.Triangles / seconds;
+
+            out << "    {\n";
+            out << "      \"scene\": \"" << result.Scene << "\",\n";
+            out << "      \"width\": " << result.Width << ",\n";
+            out << "      \"height\": " << result.Height << ",\n";
+            out << "      \"msaa\": " << result.MSAALevel << ",\n";
+            out << "      \"threads\": " << result.Threads << ",\n";
+            out << "      \"frames\": " << result.Frames << ",\n";
+            out << "      \"ms_per_frame\": { "
+                << "\"mean\": " << result.FrameTimes.Mean << ", "
+                << "\"min\": " << result.MinFrameTime << ", "
+                << "\"p50\": " << result.FrameTimes.P50 << ", "
+                << "\"p95\": " << result.FrameTimes.P95 << ", "
+                << "\"p99\": " << result.FrameTimes.P99 << ", "
+                << "\"max\": " << result.FrameTimes.Max << " },\n";
+            out << "      \"mpixels_per_s\": " << mpixels << ",\n";
+            out << "      \"triangles_per_frame\": " << result.Triangles / result.Frames << ",\n";
+            out << "      \"triangles_per_s\": " << triangles << "\n";
+            out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+}
+
+// Renders fixed scenes headlessly and reports frame time percentiles and throughput as JSON.
+int main(int argc, char** argv)
+{
+    using namespace RGS;
+    using namespace RGS::Bench;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Tuning starts from the defaults so a stale file doesn't bias the search
+    if (options.TuneOutputPath.empty() && Tuning::Load(options.TuningPath))
+        std::cerr << "Loaded group sizes from " << options.TuningPath << std::endl;
+
+    SceneAssets assets;
+    if (!assets.Load(options.AssetsDir, options.ObjPath, options.ObjSubdivisions, options.Textures))
+        return 1;
+
+    SessionPlayer session;
+    if (!options.ReplayPath.empty())
+    {
+        if (!session.Load(options.ReplayPath))
+        {
+            std::cerr << "加载失败: " << options.ReplayPath << std::endl;
+            return 1;
+        }
+        options.Scenes.clear();
+        options.MSAALevels = { 1 };
+    }
+
+    std::vector<std::unique_ptr<Scene>> scenes;
+    if (options.ReplayPath.empty())
+        scenes = CreateScenes(assets);
+    else
+        scenes.emplace_back(CreateReplayScene(assets));
+    for (auto& scene : scenes)
+        scene->SetFastMath(options.FastMath);
+    for (const std::string& name : options.Scenes)
+    {
+        auto it = std::find_if(scenes.begin(), scenes.end(), [&name](const std::unique_ptr<Scene>& scene) { return scene->GetName() == name; });
+        if (it == scenes.end())
+        {
+            std::cerr << "Unknown scene: " << name << std::endl;
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!options.TuneOutputPath.empty())
+    {
+        JobSystem::Init(options.ThreadCounts.front());
+        Tune(scenes, options);
+        JobSystem::Shutdown();
+        if (!Tuning::Save(options.TuneOutputPath))
+        {
+            std::cerr << "写入失败: " << options.TuneOutputPath << std::endl;
+            return 1;
+        }
+        std::cerr << "Saved group sizes to " << options.TuneOutputPath << std::endl;
+        return 0;
+    }
+
+    std::vector<RunResult> results;
+    for (uint32_t threads : options.ThreadCounts)
+    {
+        JobSystem::Init(threads);
+        for (const auto& [width, height] : options.Resolutions)
+        {
+            for (int msaa : options.MSAALevels)
+            {
+                for (auto& scene : scenes)
+                {
+                    if (!options.Scenes.empty() && std::find(options.Scenes.begin(), options.Scenes.end(), scene->GetName()) == options.Scenes.end())
+                        continue;
+
+                    RunResult result = Run(*scene, options, width, height, msaa, options.ReplayPath.empty() ? nullptr : &session);
+                    std::cerr << std::fixed << std::setprecision(2) << result.Scene << " " << width << "x" << height
+                              << " msaa " << result.MSAALevel << " threads " << result.Threads
+                              << ": p50 " << result.FrameTimes.P50 << " ms, p99 " << result.FrameTimes.P99 << " ms" << std::endl;
+                    results.push_back(std::move(result));
+                }
+            }
+        }
+        JobSystem::Shutdown();
+    }
+
+    if (options.OutputPath.empty())
+    {
+        WriteJson(std::cout, options, results);
+    }
+    else
+    {
+        std::ofstream file(options.OutputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "写入失败: " << options.OutputPath << std::endl;
+            return 1;
+        }
+        WriteJson(file, options, results);
+    }
+    return 0;
+}
@@ -0,0 +1,590 @@
+#include "rgspch.h"
+#include "BenchScenes.h"
+
+#include "RGS/Render/RenderCommand.h"
+#include "RGS/Shader/SkyboxShader.h"
+#include "RGS/Shader/IBLPBRShader.h"
+#include "RGS/Shader/FlatColorShader.h"
+#include "RGS/Shader/BlinnShader.h"
+
+#include <fstream>
+
+namespace RGS::Bench {
+
+    using SkyboxProgram = Program<SkyboxVertex, SkyboxUniforms, SkyboxVaryings>;
+    using IBLPBRProgram = Program<IBLPBRVertex, IBLPBRUniforms, IBLPBRVaryings>;
+    using FlatColorProgram = Program<FlatColorVertex, FlatColorUniforms, FlatColorVaryings>;
+    using BlinnProgram = Program<BlinnVertex, BlinnUniforms, BlinnVaryings>;
+
+    static bool FileExists(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            std::cout << "加载失败: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Splits every triangle into 4 at the edge midpoints, normals are interpolated
+    static std::shared_ptr<Mesh<VertexBase3D>> Subdivide(const Mesh<VertexBase3D>& mesh)
+    {
+        auto result = std::make_shared<Mesh<VertexBase3D>>();
+        result->Triangles.reserve(mesh.Triangles.size() * 4);
+
+        auto midpoint = [](const VertexBase3D& a, const VertexBase3D& b)
+        {
+            VertexBase3D vertex;
+            vertex.ModelPos = (a.ModelPos + b.ModelPos) * 0.5f;
+            vertex.ModelNormal = Normalize(a.ModelNormal + b.ModelNormal);
+            return vertex;
+        };
+
+        for (const Triangle<VertexBase3D>& tri : mesh.Triangles)
+        {
+            const VertexBase3D ab = midpoint(tri[0], tri[1]);
+            const VertexBase3D bc = midpoint(tri[1], tri[2]);
+            const VertexBase3D ca = midpoint(tri[2], tri[0]);
+            const VertexBase3D corners[4][3] = { { tri[0], ab, ca }, { ab, tri[1], bc }, { ca, bc, tri[2] }, { ab, bc, ca } };
+            for (const auto& corner : corners)
+            {
+                Triangle<VertexBase3D> sub;
+                sub[0] = corner[0];
+                sub[1] = corner[1];
+                sub[2] = corner[2];
+                result->Triangles.emplace_back(sub);
+            }
+        }
+        return result;
+    }
+
+    bool SceneAssets::Load(const std::string& assetsDir, const std::string& objPath, const int objSubdivisions, const TextureStorage textureStorage)
+    {
+        const std::string skyboxPath = assetsDir + "/hdr/newport_loft.hdr";
+        const std::string irradiancePath = assetsDir + "/diffuse_conv.hdr";
+        const std::string brdfPath = assetsDir + "/brdf.jpg";
+        const std::string floorDiffusePath = assetsDir + "/container2.png";
+        const std::string floorSpecularPath = assetsDir + "/container2_specular.png";
+        const std::vector<std::string> prefilterPaths = { assetsDir + "/prefilter/prefilter-800x400-0.00.hdr",
+                                                          assetsDir + "/prefilter/prefilter-640x320-0.25.hdr",
+                                                          assetsDir + "/prefilter/prefilter-480x240-0.50.hdr",
+                                                          assetsDir + "/prefilter/prefilter-320x160-0.75.hdr",
+                                                          assetsDir + "/prefilter/prefilter-160x80-1.00.hdr" };
+
+        if (!FileExists(skyboxPath) || !FileExists(irradiancePath) || !FileExists(brdfPath) ||
+            !FileExists(floorDiffusePath) || !FileExists(floorSpecularPath))
+            return false;
+        for (const std::string& path : prefilterPaths)
+        {
+            if (!FileExists(path))
+                return false;
+        }
+
+        Skybox.reset(TextureSphere::LoadTextureSphere(skyboxPath, textureStorage));
+        IrradianceMap.reset(TextureSphere::LoadTextureSphere(irradiancePath, textureStorage));
+        PrefilterMap = std::make_unique<LodTextureSphere>(prefilterPaths);
+        BrdfLUT = std::make_unique<Texture>(brdfPath, textureStorage);
+        FloorDiffuse = std::make_unique<Texture>(floorDiffusePath, textureStorage);
+        FloorSpecular = std::make_unique<Texture>(floorSpecularPath, textureStorage);
+        VirtualSkybox.reset(VirtualTextureSphere::LoadVirtualTextureSphere(skyboxPath));
+        if (!Skybox || !IrradianceMap || !VirtualSkybox)
+            return false;
+        SkyboxCube = std::make_unique<TextureCube>(*Skybox);
+        IrradianceCube = std::make_unique<TextureCube>(*IrradianceMap);
+        PrefilterCube = std::make_unique<TextureCube>(*PrefilterMap);
+
+        ObjMesh = Mesh<VertexBase3D>::LoadObjMesh(objPath);
+        if (!ObjMesh)
+        {
+            std::cout << "加载失败: " << objPath << std::endl;
+            return false;
+        }
+        for (int i = 0; i < objSubdivisions; ++i)
+            ObjMesh = Subdivide(*ObjMesh);
+
+        return true;
+    }
+
+    static std::shared_ptr<IBLPBRUniforms> CreateIBLPBRUniforms(const SceneAssets& assets, const Camera& camera, const Mat4& model)
+    {
+        auto uniforms = std::make_shared<IBLPBRUniforms>();
+        uniforms->Albedo = { 1.0f, 1.0f, 1.0f };
+        uniforms->Ao = 1.0f;
+        uniforms->Metallic = 0.85f;
+        uniforms->Roughness = 0.275f;
+        uniforms->LightPos = { 10.0f, 10.0f, 10.0f };
+        uniforms->LightColor = { 1000.0f, 500.0f, 400.0f };
+        uniforms->BrdfLUT = assets.BrdfLUT.get();
+        uniforms->IrradianceMap = assets.IrradianceMap.get();
+        uniforms->PrefilterMap = assets.PrefilterMap.get();
+
+        Mat4 normalToWorld = model;
+        normalToWorld.M[0][3] = 0.0f;
+        normalToWorld.M[1][3] = 0.0f;
+        normalToWorld.M[2][3] = 0.0f;
+
+        uniforms->CamPos = camera.Pos;
+        uniforms->ModelMatrix = model;
+        uniforms->NormalMatrix = normalToWorld;
+        uniforms->MVP = camera.ProjectionMat4() * camera.ViewMat4() * model;
+        return uniforms;
+    }
+
+    // Draw helpers shared by the scenes, same state as IBLPBRLayer
+    class SceneBase : public Scene
+    {
+    public:
+        SceneBase(const std::string& name, const SceneAssets& assets)
+            : Scene(name), m_Assets(assets)
+        {
+            m_BoxMesh = Mesh<SkyboxVertex>::CreateBoxMesh();
+            m_SphereMesh = Mesh<IBLPBRVertex>::CreateSphereMesh();
+            m_QuadMesh = Mesh<FlatColorVertex>::CreateQuadMesh();
+
+            m_SkyboxProgram = std::make_shared<SkyboxProgram>(SkyboxVertexShader, SkyboxFragmentShader);
+            m_SkyboxProgram->DepthFunc = DepthFuncType::LEQUAL;
+            m_SkyboxProgram->EnableDoubleSided = true;
+
+            m_IBLPBRProgram = std::make_shared<IBLPBRProgram>(IBLPBRVertexShader, IBLPBRFragmentShader);
+
+            m_QuadProgram = std::make_shared<FlatColorProgram>(FlatColorVertexShader, FlatColorFragmentShader);
+            m_QuadProgram->EnableBlend = true;
+            m_QuadProgram->EnableWriteDepth = false;
+            m_QuadProgram->EnableDoubleSided = true;
+        }
+
+        void SetFastMath(const bool enabled) override
+        {
+            m_SkyboxProgram->EnableFastMath = enabled;
+            m_IBLPBRProgram->EnableFastMath = enabled;
+            m_QuadProgram->EnableFastMath = enabled;
+        }
+
+    protected:
+        uint64_t DrawSkybox(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera, 
+                            TextureSphere* skyboxTex = nullptr, LodTextureSphere* lodSkyboxTex = nullptr, const float lod = 0.0f,
+                            TextureCube* skyboxCube = nullptr)
+        {
+            auto uniforms = std::make_shared<SkyboxUniforms>();
+            Mat4 view = camera.ViewMat4();
+            view.M[0][3] = 0.0f;
+            view.M[1][3] = 0.0f;
+            view.M[2][3] = 0.0f;
+            uniforms->MVP = camera.ProjectionMat4() * view;
+            uniforms->SkyboxTex = lodSkyboxTex == nullptr && skyboxTex == nullptr && skyboxCube == nullptr ? m_Assets.Skybox.get() : skyboxTex;
+            uniforms->LodSkyboxTex = lodSkyboxTex;
+            uniforms->SkyboxCube = skyboxCube;
+            uniforms->Lod = lod;
+
+            auto command = RenderCommand::Draw(framebuffer, m_SkyboxProgram, m_BoxMesh, uniforms, framebuffer.GetMSAA());
+            command->SetName("Skybox");
+            pipeline.AddCommand(std::move(command), RenderStage::Geometry);
+            return m_BoxMesh->Triangles.size();
+        }
+
+        uint64_t DrawPBR(Pipeline& pipeline, Framebuffer& framebuffer, std::shared_ptr<Mesh<IBLPBRVertex>> mesh,
+                         std::shared_ptr<IBLPBRUniforms> uniforms, const char* name)
+        {
+            auto command = RenderCommand::Draw(framebuffer, m_IBLPBRProgram, mesh, uniforms, framebuffer.GetMSAA());
+            command->SetName(name);
+            pipeline.AddCommand(std::move(command), RenderStage::Geometry);
+            return mesh->Triangles.size();
+        }
+
+        uint64_t DrawQuad(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera, const Vec3 pos, const Vec4 color)
+        {
+            auto uniforms = std::make_shared<FlatColorUniforms>();
+            uniforms->Color = color;
+            uniforms->MVP = camera.ProjectionMat4() * camera.ViewMat4() * Mat4Translate(pos.X, pos.Y, pos.Z);
+
+            auto command = RenderCommand::Draw(framebuffer, m_QuadProgram, m_QuadMesh, uniforms, framebuffer.GetMSAA());
+            command->SetName("Quad");
+            pipeline.AddCommand(std::move(command), RenderStage::Transparent);
+            return m_QuadMesh->Triangles.size();
+        }
+
+        const SceneAssets& m_Assets;
+        std::shared_ptr<Mesh<SkyboxVertex>> m_BoxMesh;
+        std::shared_ptr<Mesh<IBLPBRVertex>> m_SphereMesh;
+        std::shared_ptr<Mesh<FlatColorVertex>> m_QuadMesh;
+        std::shared_ptr<SkyboxProgram> m_SkyboxProgram;
+        std::shared_ptr<IBLPBRProgram> m_IBLPBRProgram;
+        std::shared_ptr<FlatColorProgram> m_QuadProgram;
+    };
+
+    // The default view of the viewer: IBL PBR sphere in front of the skybox
+    class IBLSphereScene : public SceneBase
+    {
+    public:
+        IBLSphereScene(const SceneAssets& assets)
+            : SceneBase("ibl_sphere", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            uint64_t triangles = DrawPBR(pipeline, framebuffer, m_SphereMesh, CreateIBLPBRUniforms(m_Assets, camera, Mat4Identity()), "Sphere");
+            triangles += DrawSkybox(pipeline, framebuffer, camera);
+            return triangles;
+        }
+    };
+
+    // Every pixel runs the skybox shader
+    class SkyboxScene : public SceneBase
+    {
+    public:
+        SkyboxScene(const SceneAssets& assets)
+            : SceneBase("skybox", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            return DrawSkybox(pipeline, framebuffer, camera);
+        }
+    };
+
+    // ibl_sphere with blended quads stacked in front of the camera, stresses the transparent stage
+    class TransparentQuadsScene : public SceneBase
+    {
+    public:
+        TransparentQuadsScene(const SceneAssets& assets)
+            : SceneBase("transparent_quads", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            uint64_t triangles = DrawPBR(pipeline, framebuffer, m_SphereMesh, CreateIBLPBRUniforms(m_Assets, camera, Mat4Identity()), "Sphere");
+            triangles += DrawSkybox(pipeline, framebuffer, camera);
+            constexpr int quadCount = 4;
+            for (int i = 0; i < quadCount; ++i)
+            {
+                const float offset = 0.2f * (float)i;
+                triangles += DrawQuad(pipeline, framebuffer, camera, { offset - 0.3f, offset - 0.3f, 1.0f + offset },
+                                      { 0.1f + offset, 1.0f - offset, 1.0f, 0.5f });
+            }
+            return triangles;
+        }
+    };
+
+    // 7x7 spheres, metallic along x and roughness along y, many small draws
+    class PBRGridScene : public SceneBase
+    {
+    public:
+        PBRGridScene(const SceneAssets& assets)
+            : SceneBase("pbr_grid", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            constexpr int gridSize = 7;
+            constexpr float spacing = 0.6f;
+            constexpr float scale = 0.25f;
+            uint64_t triangles = 0;
+            for (int y = 0; y < gridSize; ++y)
+            {
+                for (int x = 0; x < gridSize; ++x)
+                {
+                    const float posX = (x - gridSize / 2) * spacing;
+                    const float posY = (y - gridSize / 2) * spacing;
+                    Mat4 model = Mat4Translate(posX, posY, -1.0f) * Mat4Scale(scale, scale, scale);
+                    auto uniforms = CreateIBLPBRUniforms(m_Assets, camera, model);
+                    uniforms->Metallic = (float)x / (float)(gridSize - 1);
+                    uniforms->Roughness = std::clamp((float)y / (float)(gridSize - 1), 0.05f, 1.0f);
+                    triangles += DrawPBR(pipeline, framebuffer, m_SphereMesh, uniforms, "GridSphere");
+                }
+            }
+            triangles += DrawSkybox(pipeline, framebuffer, camera);
+            return triangles;
+        }
+    };
+
+    // High-poly .obj, mostly vertex and setup work
+    class ObjScene : public SceneBase
+    {
+    public:
+        ObjScene(const SceneAssets& assets)
+            : SceneBase("obj", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            uint64_t triangles = DrawPBR(pipeline, framebuffer, m_Assets.ObjMesh, CreateIBLPBRUniforms(m_Assets, camera, Mat4Scale(2.0f, 2.0f, 2.0f)), "Obj");
+            triangles += DrawSkybox(pipeline, framebuffer, camera);
+            return triangles;
+        }
+    };
+
+    // ibl_sphere with every environment lookup going through the TextureCube versions of the maps
+    class IBLCubeScene : public SceneBase
+    {
+    public:
+        IBLCubeScene(const SceneAssets& assets)
+            : SceneBase("ibl_cube", assets) {}
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            auto uniforms = CreateIBLPBRUniforms(m_Assets, camera, Mat4Identity());
+            uniforms->IrradianceCube = m_Assets.IrradianceCube.get();
+            uniforms->PrefilterCube = m_Assets.PrefilterCube.get();
+            uint64_t triangles = DrawPBR(pipeline, framebuffer, m_SphereMesh, uniforms, "Sphere");
+            triangles += DrawSkybox(pipeline, framebuffer, camera, nullptr, nullptr, 0.0f, m_Assets.SkyboxCube.get());
+            return triangles;
+        }
+    };
+
+    // A textured ground plane running to the far plane in front of the skybox. The texture repeats
+    // every unit, so most of the floor is minified and samples the small mips.
+    class TexturedFloorScene : public SceneBase
+    {
+    public:
+        TexturedFloorScene(const SceneAssets& assets)
+            : SceneBase("textured_floor", assets)
+        {
+            constexpr float halfSize = 100.0f;
+            constexpr float height = -1.0f;
+            const Vec2 corners[4] = { { -halfSize, halfSize }, { halfSize, halfSize }, { halfSize, -halfSize }, { -halfSize, -halfSize } };
+            BlinnVertex vertices[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                vertices[i].ModelPos = { corners[i].X, height, corners[i].Y, 1.0f };
+                vertices[i].ModelNormal = { 0.0f, 1.0f, 0.0f };
+                vertices[i].TexCoord = corners[i];
+            }
+
+            m_FloorMesh = std::make_shared<Mesh<BlinnVertex>>();
+            const int indices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            for (const auto& index : indices)
+            {
+                Triangle<BlinnVertex> triangle;
+                for (int i = 0; i < 3; ++i)
+                    triangle[i] = vertices[index[i]];
+                m_FloorMesh->Triangles.emplace_back(triangle);
+            }
+
+            m_FloorProgram = std::make_shared<BlinnProgram>(BlinnVertexShader, BlinnFragmentShader);
+            m_FloorProgram->EnableDerivatives = true;
+        }
+
+        void SetFastMath(const bool enabled) override
+        {
+            SceneBase::SetFastMath(enabled);
+            m_FloorProgram->EnableFastMath = enabled;
+        }
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            auto uniforms = std::make_shared<BlinnUniforms>();
+            uniforms->Model = Mat4Identity();
+            uniforms->ModelNormalToWorld = Mat4Identity();
+            uniforms->MVP = camera.ProjectionMat4() * camera.ViewMat4();
+            uniforms->LightPos = { 0.0f, 4.0f, -4.0f };
+            uniforms->CameraPos = camera.Pos;
+            uniforms->Diffuse = m_Assets.FloorDiffuse.get();
+            uniforms->Specular = m_Assets.FloorSpecular.get();
+
+            auto command = RenderCommand::Draw(framebuffer, m_FloorProgram, m_FloorMesh, uniforms, framebuffer.GetMSAA());
+            command->SetName("Floor");
+            pipeline.AddCommand(std::move(command), RenderStage::Geometry);
+            return m_FloorMesh->Triangles.size() + DrawSkybox(pipeline, framebuffer, camera);
+        }
+
+    private:
+        std::shared_ptr<Mesh<BlinnVertex>> m_FloorMesh;
+        std::shared_ptr<BlinnProgram> m_FloorProgram;
+    };
+
+    // The skybox through the VirtualTextureSphere, the LOD follows the pixel footprint. The first frames
+    // sample the coarser resident levels until UpdateStreaming has loaded the pages they asked for.
+    class VirtualSkyboxScene : public SceneBase
+    {
+    public:
+        VirtualSkyboxScene(const SceneAssets& assets)
+            : SceneBase("virtual_skybox", assets)
+        {
+            m_VirtualSkyboxProgram = std::make_shared<SkyboxProgram>(SkyboxVertexShader, SkyboxFragmentShader);
+            m_VirtualSkyboxProgram->DepthFunc = DepthFuncType::LEQUAL;
+            m_VirtualSkyboxProgram->EnableDoubleSided = true;
+            m_VirtualSkyboxProgram->EnableDerivatives = true;
+        }
+
+        void SetFastMath(const bool enabled) override
+        {
+            SceneBase::SetFastMath(enabled);
+            m_VirtualSkyboxProgram->EnableFastMath = enabled;
+        }
+
+        bool UpdateStreaming(const bool wait) override
+        {
+            const int missing = m_Assets.VirtualSkybox->Update();
+            if (wait)
+                m_Assets.VirtualSkybox->Wait();
+            return missing != 0;
+        }
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            auto uniforms = std::make_shared<SkyboxUniforms>();
+            Mat4 view = camera.ViewMat4();
+            view.M[0][3] = 0.0f;
+            view.M[1][3] = 0.0f;
+            view.M[2][3] = 0.0f;
+            uniforms->MVP = camera.ProjectionMat4() * view;
+            uniforms->SkyboxTex = nullptr;
+            uniforms->VirtualSkyboxTex = m_Assets.VirtualSkybox.get();
+
+            auto command = RenderCommand::Draw(framebuffer, m_VirtualSkyboxProgram, m_BoxMesh, uniforms, framebuffer.GetMSAA());
+            command->SetName("VirtualSkybox");
+            pipeline.AddCommand(std::move(command), RenderStage::Geometry);
+            return m_BoxMesh->Triangles.size();
+        }
+
+    private:
+        std::shared_ptr<SkyboxProgram> m_VirtualSkyboxProgram;
+    };
+
+    // A fan of quads crossing each other on the y axis, each one twice in the same plane with a tilted normal, and the
+    // fan again turned through the first one in a second draw. Many samples are covered by fragments of one draw with
+    // equal or close depths, the nearest one and of equal ones the first must win whatever the thread count.
+    class SelfOverlapScene : public SceneBase
+    {
+    public:
+        SelfOverlapScene(const SceneAssets& assets)
+            : SceneBase("self_overlap", assets)
+        {
+            m_FanMesh = std::make_shared<Mesh<IBLPBRVertex>>();
+            constexpr int quadCount = 6;
+            for (int i = 0; i < quadCount; ++i)
+            {
+                const float angle = PI * (float)i / (float)quadCount;
+                const Vec3 side = { std::cos(angle), 0.0f, std::sin(angle) };
+                const Vec3 normal = { -side.Z, 0.0f, side.X };
+                AddQuad(side, normal);
+                AddQuad(side, Normalize(normal + Vec3{ 0.0f, 1.0f, 0.0f }));
+            }
+
+            m_FanProgram = std::make_shared<IBLPBRProgram>(IBLPBRVertexShader, IBLPBRFragmentShader);
+            m_FanProgram->EnableDoubleSided = true;
+        }
+
+        void SetFastMath(const bool enabled) override
+        {
+            SceneBase::SetFastMath(enabled);
+            m_FanProgram->EnableFastMath = enabled;
+        }
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            const Mat4 tilt = Mat4RotateX(0.3f);
+            uint64_t triangles = DrawFan(pipeline, framebuffer, CreateIBLPBRUniforms(m_Assets, camera, tilt), "Fan");
+            triangles += DrawFan(pipeline, framebuffer, CreateIBLPBRUniforms(m_Assets, camera, Mat4RotateY(0.25f) * tilt), "TurnedFan");
+            triangles += DrawSkybox(pipeline, framebuffer, camera);
+            return triangles;
+        }
+
+    private:
+        void AddQuad(const Vec3 side, const Vec3 normal)
+        {
+            const Vec3 up = { 0.0f, 0.6f, 0.0f };
+            const Vec3 corners[4] = { side * -0.8f - up, side * 0.8f - up, side * 0.8f + up, side * -0.8f + up };
+            const int indices[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+            for (const auto& index : indices)
+            {
+                Triangle<IBLPBRVertex> triangle;
+                for (int i = 0; i < 3; ++i)
+                {
+                    const Vec3& corner = corners[index[i]];
+                    triangle[i].ModelPos = { corner.X, corner.Y, corner.Z, 1.0f };
+                    triangle[i].ModelNormal = normal;
+                }
+                m_FanMesh->Triangles.emplace_back(triangle);
+            }
+        }
+
+        uint64_t DrawFan(Pipeline& pipeline, Framebuffer& framebuffer, std::shared_ptr<IBLPBRUniforms> uniforms, const char* name)
+        {
+            auto command = RenderCommand::Draw(framebuffer, m_FanProgram, m_FanMesh, uniforms, framebuffer.GetMSAA());
+            command->SetName(name);
+            pipeline.AddCommand(std::move(command), RenderStage::Geometry);
+            return m_FanMesh->Triangles.size();
+        }
+
+        std::shared_ptr<Mesh<IBLPBRVertex>> m_FanMesh;
+        std::shared_ptr<IBLPBRProgram> m_FanProgram;
+    };
+
+    // Same draws as IBLPBRLayer::OnUpdate
+    class ReplayScene : public SceneBase
+    {
+    public:
+        ReplayScene(const SceneAssets& assets)
+            : SceneBase("replay", assets) {}
+
+        void OnReplay(const SessionFrame& frame) override
+        {
+            m_Frame = frame;
+        }
+
+        uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) override
+        {
+            auto uniforms = CreateIBLPBRUniforms(m_Assets, camera, Mat4Identity());
+            uniforms->Roughness = m_Frame.Roughness;
+            uniforms->Metallic = m_Frame.Metallic;
+            uint64_t triangles = DrawPBR(pipeline, framebuffer, m_SphereMesh, uniforms, "Sphere");
+
+            switch (m_Frame.SkyboxIndex)
+            {
+            case 0:
+                triangles += DrawSkybox(pipeline, framebuffer, camera, m_Assets.Skybox.get());
+                break;
+            case 1:
+                triangles += DrawSkybox(pipeline, framebuffer, camera, m_Assets.IrradianceMap.get());
+                break;
+            case 2:
+                triangles += DrawSkybox(pipeline, framebuffer, camera, nullptr, m_Assets.PrefilterMap.get(), m_Frame.Roughness);
+                break;
+            default:
+                break;
+            }
+
+            if (m_Frame.DrawQuad)
+                triangles += DrawQuad(pipeline, framebuffer, camera, { 0.0f, 0.0f, 1.3f }, { 0.1f, 1.0f, 1.0f, 0.5f });
+            return triangles;
+        }
+
+    private:
+        SessionFrame m_Frame;
+    };
+
+    std::unique_ptr<Scene> CreateReplayScene(const SceneAssets& assets)
+    {
+        return std::make_unique<ReplayScene>(assets);
+    }
+
+    std::vector<std::unique_ptr<Scene>> CreateScenes(const SceneAssets& assets)
+    {
+        std::vector<std::unique_ptr<Scene>> scenes;
+        scenes.emplace_back(std::make_unique<IBLSphereScene>(assets));
+        scenes.emplace_back(std::make_unique<SkyboxScene>(assets));
+        scenes.emplace_back(std::make_unique<TransparentQuadsScene>(assets));
+        scenes.emplace_back(std::make_unique<PBRGridScene>(assets));
+        scenes.emplace_back(std::make_unique<ObjScene>(assets));
+        scenes.emplace_back(std::make_unique<IBLCubeScene>(assets));
+        scenes.emplace_back(std::make_unique<TexturedFloorScene>(assets));
+        scenes.emplace_back(std::make_unique<VirtualSkyboxScene>(assets));
+        scenes.emplace_back(std::make_unique<SelfOverlapScene>(assets));
+        return scenes;
+    }
+
+    uint64_t RenderFrame(Scene& scene, Pipeline& pipeline, Framebuffer& framebuffer, Framebuffer& screen, const Camera& camera)
+    {
+#if RGS_ENABLE_RENDER_STATS
+        // The stats collect every flushed command until reset, the bench and the golden test render thousands of frames
+        Pipeline::ResetFrameStats();
+#endif
+        pipeline.BeginFrame();
+        pipeline.AddCommand(RenderCommand::Clear(framebuffer), RenderStage::BeginFrame);
+        pipeline.AddCommand(RenderCommand::ClearDepth(framebuffer), RenderStage::BeginFrame);
+        uint64_t triangles = scene.Render(pipeline, framebuffer, camera);
+        pipeline.AddCommand(RenderCommand::ResolveParallel(framebuffer), RenderStage::EndFrame);
+        pipeline.AddCommand(RenderCommand::PostProcess(framebuffer), RenderStage::EndFrame);
+        pipeline.AddCommand(RenderCommand::BlitToScreen(framebuffer, screen), RenderStage::EndFrame);
+        pipeline.EndFrame();
+        return triangles;
+    }
+
+}
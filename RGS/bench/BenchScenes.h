@@ -0,0 +1,74 @@
+#pragma once
+#include "RGS/Texture.h"
+#include "RGS/VirtualTexture.h"
+#include "RGS/Render/Mesh.h"
+#include "RGS/Render/Renderer.h"
+#include "RGS/Render/Pipeline.h"
+#include "RGS/Render/Framebuffer.h"
+#include "RGS/Session.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace RGS::Bench {
+
+    // Textures and meshes shared by all scenes, loaded once before the runs.
+    struct SceneAssets
+    {
+        std::unique_ptr<TextureSphere> Skybox;
+        std::unique_ptr<TextureSphere> IrradianceMap;
+        std::unique_ptr<LodTextureSphere> PrefilterMap;
+        std::unique_ptr<Texture> BrdfLUT;
+        // The three maps above converted to cubemaps
+        std::unique_ptr<TextureCube> SkyboxCube;
+        std::unique_ptr<TextureCube> IrradianceCube;
+        std::unique_ptr<TextureCube> PrefilterCube;
+        // Mipmapped 2D textures of the textured_floor scene
+        std::unique_ptr<Texture> FloorDiffuse;
+        std::unique_ptr<Texture> FloorSpecular;
+        // The skybox image streamed from its tile file, built next to it on first use
+        std::unique_ptr<VirtualTextureSphere> VirtualSkybox;
+        std::shared_ptr<Mesh<VertexBase3D>> ObjMesh;
+
+        // objSubdivisions splits every triangle of the .obj into 4^n to make it high-poly.
+        // textureStorage applies to the Texture and TextureSphere images, Compressed is BC1-BC5 for Texture and BC6H
+        // for TextureSphere. TextureSphere stores Tiled in rows.
+        bool Load(const std::string& assetsDir, const std::string& objPath, const int objSubdivisions,
+                  const TextureStorage textureStorage = TextureStorage::Linear);
+    };
+
+    // A fixed, deterministic frame: same camera, same draws every time.
+    class Scene
+    {
+    public:
+        Scene(const std::string& name)
+            : m_Name(name) {}
+        virtual ~Scene() = default;
+
+        const std::string& GetName() const { return m_Name; }
+
+        // Adds the draws of one frame to the pipeline, returns the number of triangles submitted.
+        virtual uint64_t Render(Pipeline& pipeline, Framebuffer& framebuffer, const Camera& camera) = 0;
+        // Applies the uniforms of a recorded frame, like Layer::OnReplay
+        virtual void OnReplay([[maybe_unused]] const SessionFrame& frame) {}
+        // Program::EnableFastMath of every program the scene draws with
+        virtual void SetFastMath([[maybe_unused]] const bool enabled) {}
+        // Between two frames: starts loading the virtual texture pages the last frame was missing and with wait
+        // blocks until they are in. Returns false when none were missing.
+        virtual bool UpdateStreaming([[maybe_unused]] const bool wait) { return false; }
+
+    private:
+        std::string m_Name;
+    };
+
+    // ibl_sphere, skybox, transparent_quads, pbr_grid, obj, ibl_cube, textured_floor, virtual_skybox and self_overlap
+    std::vector<std::unique_ptr<Scene>> CreateScenes(const SceneAssets& assets);
+
+    // "replay": the IBLPBRLayer view driven by the uniforms of a recorded session
+    std::unique_ptr<Scene> CreateReplayScene(const SceneAssets& assets);
+
+    // One full frame: reset the frame stats, clear, the scene, resolve and blit into screen. Returns the triangles submitted.
+    uint64_t RenderFrame(Scene& scene, Pipeline& pipeline, Framebuffer& framebuffer, Framebuffer& screen, const Camera& camera);
+
+}
@@ -0,0 +1,839 @@
+#include "rgspch.h"
+
+#include "RGS/JobSystem.h"
+#include "RGS/Texture.h"
+#include "RGS/VirtualTexture.h"
+#include "RGS/Base/FastMath.h"
+#include "RGS/Render/Renderer.h"
+#include "RGS/Render/Framebuffer.h"
+#include "RGS/Render/PostProcess.h"
+#include "RGS/Shader/FlatColorShader.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#ifndef RGS_ASSETS_DIR
+    #define RGS_ASSETS_DIR "Assets"
+#endif
+
+namespace RGS {
+
+    // Forwards to the private stages of the Renderer, see the friend declaration there
+    struct RendererKernels
+    {
+        static constexpr int MaxVaryings = Renderer::RGS_MAX_VARYINGS;
+        using ScreenWeights = Renderer::ScreenWeights;
+        using Weights = Renderer::Weights;
+
+        static void CalculateWeights(ScreenWeights& screenWeights, Weights& weights, const Vec4(&fragCoords)[3], const Vec2& screenPoint)
+        {
+            Renderer::CalculateWeights(screenWeights, weights, fragCoords, screenPoint);
+        }
+
+        template<typename varyings_t>
+        static int Clip(varyings_t(&varyings)[MaxVaryings])
+        {
+            return Renderer::Clip(varyings);
+        }
+    };
+
+}
+
+namespace RGS::MicroBench {
+
+    // Keeps the compiler from optimizing the benchmarked work away
+    template<typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile char sink;
+        sink = *(const volatile char*)&value;
+#endif
+    }
+
+    struct Options
+    {
+        std::string Filter;             // only kernels whose name contains it
+        uint32_t Repetitions = 21u;
+        double MinRunTime = 20.0;       // ms per repetition
+        bool Pin = true;
+        std::string AssetsDir = RGS_ASSETS_DIR;
+        std::string OutputPath;         // JSON, empty only prints the table
+    };
+
+    struct Result
+    {
+        std::string Name;
+        double NsPerOp;                 // median of the repetitions left after outlier rejection
+        double MinNsPerOp;
+        double Deviation;               // relative standard deviation of the kept repetitions
+        double BytesPerOp;              // memory read + written by one op
+        uint32_t Kept, Repetitions;
+    };
+
+    static uint64_t Now()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Pins the calling thread to one core and raises its priority so that repetitions are comparable
+    static void PinCurrentThread()
+    {
+#ifdef _WIN32
+        SetThreadAffinityMask(GetCurrentThread(), 1);
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#elif defined(__linux__)
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(0, &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+    }
+
+    class Runner
+    {
+    public:
+        Runner(const Options& options)
+            : m_Options(options) {}
+
+        // run() performs opsPerRun operations. It is repeated until a repetition takes MinRunTime,
+        // then the repetitions whose ns/op is further than 3 MADs from the median are dropped.
+        template<typename func_t>
+        void Run(const std::string& name, const uint64_t opsPerRun, const double bytesPerOp, func_t&& run)
+        {
+            if (!m_Options.Filter.empty() && name.find(m_Options.Filter) == std::string::npos)
+                return;
+
+            // Warm up caches and calibrate the number of runs per repetition
+            uint64_t start = Now();
+            run();
+            const double once = (double)std::max<uint64_t>(Now() - start, 1);
+            const uint64_t runs = std::max<uint64_t>(1, (uint64_t)(m_Options.MinRunTime * 1e6 / once));
+
+            std::vector<double> samples;
+            for (uint32_t rep = 0; rep < m_Options.Repetitions; ++rep)
+            {
+                start = Now();
+                for (uint64_t i = 0; i < runs; ++i)
+                    run();
+                samples.push_back((double)(Now() - start) / (double)(runs * opsPerRun));
+            }
+
+            std::sort(samples.begin(), samples.end());
+            const double median = samples[samples.size() / 2];
+            std::vector<double> deviations;
+            for (double sample : samples)
+                deviations.push_back(std::abs(sample - median));
+            std::sort(deviations.begin(), deviations.end());
+            const double mad = 1.4826 * deviations[deviations.size() / 2];
+
+            std::vector<double> kept;
+            for (double sample : samples)
+            {
+                if (std::abs(sample - median) <= 3.0 * mad || mad == 0.0)
+                    kept.push_back(sample);
+            }
+
+            double mean = 0.0;
+            for (double sample : kept)
+                mean += sample;
+            mean /= (double)kept.size();
+            double variance = 0.0;
+            for (double sample : kept)
+                variance += (sample - mean) * (sample - mean);
+            variance /= (double)kept.size();
+
+            Result result;
+            result.Name = name;
+            result.NsPerOp = kept[kept.size() / 2];
+            result.MinNsPerOp = kept.front();
+            result.Deviation = mean > 0.0 ? std::sqrt(variance) / mean : 0.0;
+            result.BytesPerOp = bytesPerOp;
+            result.Kept = (uint32_t)kept.size();
+            result.Repetitions = (uint32_t)samples.size();
+            Print(result);
+            m_Results.push_back(result);
+        }
+
+        void WriteJson(std::ostream& out) const
+        {
+            out << std::fixed << std::setprecision(3);
+            out << "{\n  \"repetitions\": " << m_Options.Repetitions << ",\n  \"results\": [\n";
+            for (size_t i = 0; i < m_Results.size(); ++i)
+            {
+                const Result& result = m_Results[i];
+                out << "    { \"name\": \"" << result.Name << "\", "
+                    << "\"ns_per_op\": " << result.NsPerOp << ", "
+                    << "\"min_ns_per_op\": " << result.MinNsPerOp << ", "
+                    << "\"rel_stddev\": " << result.Deviation << ", "
+                    << "\"bytes_per_op\": " << result.BytesPerOp << ", "
+                    << "\"gb_per_s\": " << result.BytesPerOp / result.NsPerOp << ", "
+                    << "\"kept\": " << result.Kept << " }"
+                    << (i + 1 < m_Results.size() ? "," : "") << "\n";
+            }
+            out << "  ]\n}\n";
+        }
+
+        static void PrintHeader()
+        {
+            std::cout << std::left << std::setw(34) << "kernel" << std::right
+                      << std::setw(12) << "ns/op" << std::setw(12) << "min"
+                      << std::setw(9) << "stddev" << std::setw(10) << "bytes/op"
+                      << std::setw(9) << "GB/s" << std::setw(8) << "kept" << std::endl;
+        }
+
+    private:
+        static void Print(const Result& result)
+        {
+            std::cout << std::left << std::setw(34) << result.Name << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(12) << result.NsPerOp << std::setw(12) << result.MinNsPerOp
+                      << std::setprecision(1) << std::setw(8) << result.Deviation * 100.0 << "%"
+                      << std::setprecision(0) << std::setw(10) << result.BytesPerOp
+                      << std::setprecision(2) << std::setw(9) << result.BytesPerOp / result.NsPerOp
+                      << std::setw(5) << result.Kept << "/" << result.Repetitions << std::endl;
+        }
+
+        const Options& m_Options;
+        std::vector<Result> m_Results;
+    };
+
+    static void RunMathKernels(Runner& runner)
+    {
+        constexpr uint32_t count = 4096;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        std::vector<Vec4> a(count), b(count), out(count);
+        std::vector<Vec3> vec3s(count), vec3Out(count);
+        std::vector<Mat4> mats(count), matOut(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            a[i] = { dist(random), dist(random), dist(random), 1.0f };
+            b[i] = { dist(random), dist(random), dist(random), 1.0f };
+            vec3s[i] = { dist(random), dist(random), dist(random) };
+            mats[i] = Mat4RotateY(dist(random)) * Mat4Translate(dist(random), dist(random), dist(random));
+        }
+        const Mat4 mvp = Mat4Perspective(1.5f, 4.0f / 3.0f, 0.1f, 100.0f) * Mat4Translate(0.0f, 0.0f, -2.0f);
+
+        runner.Run("Vec4 a * s + b", count, 3 * sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out[i] = a[i] * 0.5f + b[i];
+            DoNotOptimize(out.data());
+        });
+
+        runner.Run("Vec3 Dot + Cross", count, 3 * sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                vec3Out[i] = Cross(vec3s[i], (Vec3)a[i]) * Dot(vec3s[i], (Vec3)b[i]);
+            DoNotOptimize(vec3Out.data());
+        });
+
+        runner.Run("Normalize(Vec3)", count, 2 * sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                vec3Out[i] = Normalize(vec3s[i]);
+            DoNotOptimize(vec3Out.data());
+        });
+
+        runner.Run("Mat4 * Vec4", count, 2 * sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out[i] = mvp * a[i];
+            DoNotOptimize(out.data());
+        });
+
+        runner.Run("TransformPoints", count, 2 * sizeof(Vec4), [&]()
+        {
+            TransformPoints(mvp, a.data(), out.data(), count);
+            DoNotOptimize(out.data());
+        });
+
+        runner.Run("Mat4 * Mat4", count, 2 * sizeof(Mat4), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                matOut[i] = mvp * mats[i];
+            DoNotOptimize(matOut.data());
+        });
+    }
+
+    // libm against the FastMath approximations, rgs-fastmath-test reports their errors
+    static void RunFastMathKernels(Runner& runner)
+    {
+        constexpr uint32_t count = 4096;
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        std::vector<float> xs(count), ys(count), out(count);
+        std::vector<Vec3> colors(count), colorOut(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            xs[i] = dist(random);
+            ys[i] = dist(random);
+            colors[i] = { std::abs(dist(random)), std::abs(dist(random)), std::abs(dist(random)) };
+        }
+
+        auto run = [&](const std::string& name, auto func)
+        {
+            runner.Run(name, count, 2 * sizeof(float), [&]()
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    out[i] = func(xs[i], ys[i]);
+                DoNotOptimize(out.data());
+            });
+        };
+        run("std::atan2", [](float x, float y) { return std::atan2(y, x); });
+        run("FastMath::Atan2", [](float x, float y) { return FastMath::Atan2(y, x); });
+        run("std::acos", [](float x, float) { return std::acos(x); });
+        run("FastMath::Acos", [](float x, float) { return FastMath::Acos(x); });
+        run("std::sin", [](float x, float) { return std::sin(x * 10.0f); });
+        run("FastMath::Sin", [](float x, float) { return FastMath::Sin(x * 10.0f); });
+        run("std::pow(x, 1/2.2)", [](float x, float) { return std::pow(std::abs(x), 1.0f / 2.2f); });
+        run("FastMath::Pow(x, 1/2.2)", [](float x, float) { return FastMath::Pow(std::abs(x), 1.0f / 2.2f); });
+        run("EncodingLUT::Encode (gamma 2.2)", [&lut = EncodingLUT::Get(OutputEncoding::Gamma22)](float x, float) { return lut.Encode(std::abs(x)); });
+        run("std::pow(x, 5)", [](float x, float) { return std::pow(x, 5.0f); });
+        run("FastMath::Pow5", [](float x, float) { return FastMath::Pow5(x); });
+
+#if RGS_SIMD_SSE
+        auto run4 = [&](const std::string& name, auto func)
+        {
+            runner.Run(name, count, 2 * sizeof(float), [&]()
+            {
+                for (uint32_t i = 0; i < count; i += 4)
+                    _mm_storeu_ps(&out[i], func(_mm_loadu_ps(&xs[i]), _mm_loadu_ps(&ys[i])));
+                DoNotOptimize(out.data());
+            });
+        };
+        run4("FastMath::Atan2 x4", [](__m128 x, __m128 y) { return FastMath::Atan2(y, x); });
+        run4("FastMath::Acos x4", [](__m128 x, __m128) { return FastMath::Acos(x); });
+        run4("FastMath::Sin x4", [](__m128 x, __m128) { return FastMath::Sin(_mm_mul_ps(x, _mm_set1_ps(10.0f))); });
+        run4("FastMath::Pow(x, 1/2.2) x4", [](__m128 x, __m128)
+        {
+            return FastMath::Pow(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(1.0f / 2.2f));
+        });
+#endif
+
+        // The gamma correction at the end of the shaders
+        runner.Run("Pow(Vec3, 1/2.2)", count, 2 * sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                colorOut[i] = Pow(colors[i], 1.0f / 2.2f);
+            DoNotOptimize(colorOut.data());
+        });
+
+        runner.Run("FastMath::Pow(Vec3, 1/2.2)", count, 2 * sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                colorOut[i] = FastMath::Pow(colors[i], 1.0f / 2.2f);
+            DoNotOptimize(colorOut.data());
+        });
+    }
+
+    static void RunSamplingKernels(Runner& runner, const Options& options)
+    {
+        constexpr uint32_t count = 4096;
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+        // Textures are created from a noise framebuffer so they don't depend on the assets
+        std::unique_ptr<Framebuffer> noise = Framebuffer::Create(1024, 512);
+        for (uint32_t y = 0; y < noise->GetHeight(); ++y)
+        {
+            for (uint32_t x = 0; x < noise->GetWidth(); ++x)
+                noise->SetColor(x, y, { dist(random), dist(random), dist(random) });
+        }
+        Texture texture(*noise);
+        TextureSphere textureSphere(*noise);
+        TextureCube textureCube(textureSphere);
+
+        std::vector<Vec2> texCoords(count);
+        std::vector<Vec3> dirs(count);
+        std::vector<Vec4> out4(count);
+        std::vector<Vec3> out3(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            texCoords[i] = { dist(random), dist(random) };
+            dirs[i] = { dist(random) * 2.0f - 1.0f, dist(random) * 2.0f - 1.0f, dist(random) * 2.0f - 1.0f };
+        }
+
+        // Random coordinates, so this is mostly cache misses. Bytes are the texels read, the framebuffer
+        // texture is RGBA16F and the HDR ones RGB9E5.
+        constexpr size_t texelSize = sizeof(TexelTraits<TexelFormat::RGBA16F>::storage_t);
+        constexpr size_t hdrTexelSize = sizeof(TexelTraits<TexelFormat::RGB9E5>::storage_t);
+        runner.Run("Texture::Sample", count, 4 * texelSize + sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out4[i] = texture.Sample(texCoords[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        // The same lookups batched, the coordinates in SoA form
+        std::vector<float> texU(count), texV(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            texU[i] = texCoords[i].X;
+            texV[i] = texCoords[i].Y;
+        }
+        runner.Run("Texture::Sample4", count, 4 * texelSize + sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; i += 4)
+                texture.Sample4(&texU[i], &texV[i], &out4[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        runner.Run("Texture::Sample8", count, 4 * texelSize + sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; i += 8)
+                texture.Sample8(&texU[i], &texV[i], &out4[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        // Same lookups through the sampler specializations, random LODs across the pyramid
+        std::vector<float> textureLods(count);
+        for (uint32_t i = 0; i < count; ++i)
+            textureLods[i] = dist(random) * (float)(texture.GetLevelCount() - 1);
+
+        runner.Run("Texture::Sample clamp nearest", count, texelSize + sizeof(Vec4), [&]()
+        {
+            const Sampler<WrapMode::Clamp, FilterMode::Nearest> sampler;
+            for (uint32_t i = 0; i < count; ++i)
+                out4[i] = texture.Sample(sampler, texCoords[i], textureLods[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        runner.Run("Texture::Sample repeat bilinear", count, 4 * texelSize + sizeof(Vec4), [&]()
+        {
+            const Sampler<WrapMode::Repeat, FilterMode::Bilinear> sampler;
+            for (uint32_t i = 0; i < count; ++i)
+                out4[i] = texture.Sample(sampler, texCoords[i], textureLods[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        runner.Run("Texture::Sample repeat trilinear", count, 8 * texelSize + sizeof(Vec4), [&]()
+        {
+            const RepeatTrilinearSampler sampler;
+            for (uint32_t i = 0; i < count; ++i)
+                out4[i] = texture.Sample(sampler, texCoords[i], textureLods[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        runner.Run("TextureSphere::Sample", count, hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = textureSphere.Sample(dirs[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        runner.Run("TextureSphere::Sample fast math", count, hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            FastMath::Scope fastMath(true);
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = textureSphere.Sample(dirs[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        // One bilinear lookup, the face is picked by the major axis
+        runner.Run("TextureCube::Sample", count, 4 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = textureCube.Sample(dirs[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        // LodTextureSphere can only be loaded from files
+        const std::string prefilterDir = options.AssetsDir + "/prefilter/";
+        const std::vector<std::string> prefilterPaths = { prefilterDir + "prefilter-800x400-0.00.hdr",
+                                                          prefilterDir + "prefilter-640x320-0.25.hdr",
+                                                          prefilterDir + "prefilter-480x240-0.50.hdr",
+                                                          prefilterDir + "prefilter-320x160-0.75.hdr",
+                                                          prefilterDir + "prefilter-160x80-1.00.hdr" };
+        for (const std::string& path : prefilterPaths)
+        {
+            if (!std::ifstream(path).is_open())
+            {
+                std::cout << "LodTextureSphere::Sample skipped, 加载失败: " << path << std::endl;
+                return;
+            }
+        }
+        LodTextureSphere lodTexture(prefilterPaths);
+        std::vector<float> lods(count);
+        for (uint32_t i = 0; i < count; ++i)
+            lods[i] = dist(random) * 4.0f;
+
+        // Two bilinear lookups in adjacent levels
+        runner.Run("LodTextureSphere::Sample", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = lodTexture.Sample(dirs[i], lods[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        std::vector<float> dirX(count), dirY(count), dirZ(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dirX[i] = dirs[i].X;
+            dirY[i] = dirs[i].Y;
+            dirZ[i] = dirs[i].Z;
+        }
+        runner.Run("LodTextureSphere::Sample4", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; i += 4)
+                lodTexture.Sample4(&dirX[i], &dirY[i], &dirZ[i], &lods[i], &out3[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        runner.Run("LodTextureSphere::Sample fast math", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            FastMath::Scope fastMath(true);
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = lodTexture.Sample(dirs[i], lods[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        runner.Run("LodTextureSphere::Sample8 fast math", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            FastMath::Scope fastMath(true);
+            for (uint32_t i = 0; i < count; i += 8)
+                lodTexture.Sample8(&dirX[i], &dirY[i], &dirZ[i], &lods[i], &out3[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        TextureCube lodCube(lodTexture);
+        runner.Run("TextureCube::Sample trilinear", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = lodCube.Sample(dirs[i], lods[i]);
+            DoNotOptimize(out3.data());
+        });
+
+        // The same lookups through the page tables, with every page they need streamed in first
+        const std::string skyboxPath = options.AssetsDir + "/hdr/newport_loft.hdr";
+        std::unique_ptr<VirtualTextureSphere> virtualTexture(VirtualTextureSphere::LoadVirtualTextureSphere(skyboxPath));
+        if (!virtualTexture)
+        {
+            std::cout << "VirtualTextureSphere::Sample skipped, 加载失败: " << skyboxPath << std::endl;
+            return;
+        }
+        int missing = 0;
+        do
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                virtualTexture->Sample(dirs[i], lods[i]);
+            missing = virtualTexture->Update();
+            virtualTexture->Wait();
+        } while (missing != 0);
+
+        runner.Run("VirtualTextureSphere::Sample", count, 8 * hdrTexelSize + sizeof(Vec3), [&]()
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                out3[i] = virtualTexture->Sample(dirs[i], lods[i]);
+            DoNotOptimize(out3.data());
+        });
+    }
+
+    // Block compressed against plain storage of the same images. The lookups walk a 64x64 grid in scanline
+    // order like the rasterizer does, so neighbouring pixels mostly hit the decoded blocks in BlockCache.
+    static void RunCompressedSamplingKernels(Runner& runner, const Options& options)
+    {
+        constexpr uint32_t side = 64;
+        constexpr uint32_t count = side * side;
+
+        const std::string imagePath = options.AssetsDir + "/container2.png";
+        const std::string hdrPath = options.AssetsDir + "/hdr/newport_loft.hdr";
+        for (const std::string& path : { imagePath, hdrPath })
+        {
+            if (!std::ifstream(path).is_open())
+            {
+                std::cout << "Compressed texture kernels skipped, 加载失败: " << path << std::endl;
+                return;
+            }
+        }
+        Texture image(imagePath);
+        Texture imageBC(imagePath, TextureStorage::Compressed);
+        const std::unique_ptr<TextureSphere> hdr(TextureSphere::LoadTextureSphere(hdrPath));
+        const std::unique_ptr<TextureSphere> hdrBC(TextureSphere::LoadTextureSphere(hdrPath, TextureStorage::Compressed));
+
+        // About one texel per lookup, like a textured surface at LOD 0
+        const float texelAngle = 2.0f * PI / hdr->GetWidth();
+        std::vector<Vec2> texCoords(count);
+        std::vector<Vec3> dirs(count);
+        for (uint32_t y = 0; y < side; ++y)
+        {
+            for (uint32_t x = 0; x < side; ++x)
+            {
+                texCoords[y * side + x] = { 0.25f + (float)x / image.GetWidth(), 0.25f + (float)y / image.GetHeight() };
+                dirs[y * side + x] = { ((float)x - side * 0.5f) * texelAngle, ((float)side * 0.5f - y) * texelAngle, -1.0f };
+            }
+        }
+        std::vector<Vec4> out4(count);
+        std::vector<Vec3> out3(count);
+
+        auto runTexture = [&](const char* name, const Texture& texture, const size_t texelSize)
+        {
+            runner.Run(name, count, 4 * texelSize + sizeof(Vec4), [&]()
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    out4[i] = texture.Sample(texCoords[i]);
+                DoNotOptimize(out4.data());
+            });
+        };
+        runTexture("Texture::Sample RGBA8 scanline", image, sizeof(TexelTraits<TexelFormat::RGBA8>::storage_t));
+        runTexture("Texture::Sample BC3 scanline", imageBC, 1);
+
+        std::vector<float> texU(count), texV(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            texU[i] = texCoords[i].X;
+            texV[i] = texCoords[i].Y;
+        }
+        runner.Run("Texture::Sample4 RGBA8 scanline", count, 4 * sizeof(TexelTraits<TexelFormat::RGBA8>::storage_t) + sizeof(Vec4), [&]()
+        {
+            for (uint32_t i = 0; i < count; i += 4)
+                image.Sample4(&texU[i], &texV[i], &out4[i]);
+            DoNotOptimize(out4.data());
+        });
+
+        auto runSphere = [&](const char* name, const TextureSphere& sphere, const size_t texelSize)
+        {
+            runner.Run(name, count, texelSize + sizeof(Vec3), [&]()
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    out3[i] = sphere.Sample(dirs[i]);
+                DoNotOptimize(out3.data());
+            });
+        };
+        runSphere("TextureSphere::Sample RGB9E5 scanline", *hdr, sizeof(TexelTraits<TexelFormat::RGB9E5>::storage_t));
+        runSphere("TextureSphere::Sample BC6H scanline", *hdrBC, 1);
+    }
+
+    // Linear against tiled storage of the same image. The diagonal lookups walk a 256x256 grid turned by 45 degrees
+    // at about one texel per step, like a reflection sweeping over the environment map, so every step moves to
+    // another row. The random ones are spread over the whole image and miss the cache in both layouts.
+    // TextureSphere has no tiled storage, its nearest lookups only measured slower with it.
+    static void RunTiledSamplingKernels(Runner& runner, const Options& options)
+    {
+        constexpr uint32_t side = 256;
+        constexpr uint32_t count = side * side;
+
+        const std::string imagePath = options.AssetsDir + "/container2.png";
+        if (!std::ifstream(imagePath).is_open())
+        {
+            std::cout << "Tiled texture kernels skipped, 加载失败: " << imagePath << std::endl;
+            return;
+        }
+        Texture image(imagePath);
+        Texture imageTiled(imagePath, TextureStorage::Tiled);
+
+        std::vector<Vec2> diagonalCoords(count);
+        std::vector<Vec2> randomCoords(count);
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (uint32_t y = 0; y < side; ++y)
+        {
+            for (uint32_t x = 0; x < side; ++x)
+            {
+                const float s = ((float)x - side * 0.5f) * 0.70710678f;
+                const float t = ((float)y - side * 0.5f) * 0.70710678f;
+                const uint32_t i = y * side + x;
+                diagonalCoords[i] = { 0.5f + (s - t) / image.GetWidth(), 0.5f + (s + t) / image.GetHeight() };
+                randomCoords[i] = { dist(random), dist(random) };
+            }
+        }
+        std::vector<Vec4> out4(count);
+
+        constexpr size_t texelSize = sizeof(TexelTraits<TexelFormat::RGBA8>::storage_t);
+        auto runTexture = [&](const char* name, const Texture& texture, const std::vector<Vec2>& texCoords)
+        {
+            runner.Run(name, count, 4 * texelSize + sizeof(Vec4), [&]()
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    out4[i] = texture.Sample(texCoords[i]);
+                DoNotOptimize(out4.data());
+            });
+        };
+        runTexture("Texture::Sample RGBA8 linear diagonal", image, diagonalCoords);
+        runTexture("Texture::Sample RGBA8 tiled diagonal", imageTiled, diagonalCoords);
+        runTexture("Texture::Sample RGBA8 linear random", image, randomCoords);
+        runTexture("Texture::Sample RGBA8 tiled random", imageTiled, randomCoords);
+    }
+
+    static void RunRasterKernels(Runner& runner)
+    {
+        constexpr uint32_t count = 4096;
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+        const Vec4 fragCoords[3] = { { 10.0f, 10.0f, 0.5f, 0.5f }, { 700.0f, 40.0f, 0.4f, 0.25f }, { 300.0f, 550.0f, 0.6f, 0.75f } };
+        std::vector<Vec2> points(count);
+        for (uint32_t i = 0; i < count; ++i)
+            points[i] = { dist(random) * 800.0f, dist(random) * 600.0f };
+        std::vector<RendererKernels::Weights> weights(count);
+
+        runner.Run("Renderer::CalculateWeights", count, sizeof(fragCoords) + sizeof(Vec2) + 2 * sizeof(RendererKernels::Weights), [&]()
+        {
+            RendererKernels::ScreenWeights screenWeights;
+            for (uint32_t i = 0; i < count; ++i)
+                RendererKernels::CalculateWeights(screenWeights, weights[i], fragCoords, points[i]);
+            DoNotOptimize(weights.data());
+        });
+
+        // Triangles crossing the frustum, so every one is clipped against several planes
+        constexpr uint32_t triangleCount = 1024;
+        std::vector<FlatColorVaryings> triangles(triangleCount * 3);
+        for (FlatColorVaryings& varyings : triangles)
+            varyings.ClipPos = { dist(random) * 4.0f - 2.0f, dist(random) * 4.0f - 2.0f, dist(random) * 2.0f - 0.5f, 1.0f };
+
+        runner.Run("Renderer::Clip", triangleCount, RendererKernels::MaxVaryings * sizeof(FlatColorVaryings), [&]()
+        {
+            int vertices = 0;
+            for (uint32_t i = 0; i < triangleCount; ++i)
+            {
+                FlatColorVaryings varyings[RendererKernels::MaxVaryings];
+                varyings[0] = triangles[i * 3 + 0];
+                varyings[1] = triangles[i * 3 + 1];
+                varyings[2] = triangles[i * 3 + 2];
+                vertices += RendererKernels::Clip(varyings);
+            }
+            DoNotOptimize(vertices);
+        });
+    }
+
+    static void RunFramebufferKernels(Runner& runner)
+    {
+        constexpr uint32_t width = 800, height = 600;
+        constexpr uint32_t pixels = width * height;
+
+        std::unique_ptr<Framebuffer> msaaFramebuffer = Framebuffer::Create(width, height, MSAA::X4);
+        msaaFramebuffer->Clear({ 0.25f, 0.5f, 0.75f });
+        runner.Run("Framebuffer::ResolveParallel x4", pixels, (4 + 1) * sizeof(Vec3), [&]()
+        {
+            msaaFramebuffer->ResolveParallel(true);
+        });
+
+        std::unique_ptr<Framebuffer> src = Framebuffer::Create(width, height);
+        std::unique_ptr<Framebuffer> dst = Framebuffer::Create(width, height);
+        src->Clear({ 0.25f, 0.5f, 0.75f });
+        runner.Run("Framebuffer::Blit", pixels, 2 * sizeof(Vec3), [&]()
+        {
+            dst->Blit(*src);
+        });
+
+        // In place, the colors shrink a little every run but stay in the same LUT segments for long
+        runner.Run("Framebuffer::PostProcess", pixels, 2 * sizeof(Vec3), [&]()
+        {
+            dst->PostProcess(PostProcessSettings());
+        });
+    }
+
+    static void RunJobSystemKernels(Runner& runner)
+    {
+        constexpr uint32_t jobCount = 4096;
+        std::atomic<uint32_t> counter{ 0 };
+
+        for (uint32_t groupSize : { 1u, 64u, 1024u })
+        {
+            // Empty jobs, i.e. the cost per job of queueing, waking workers and completing
+            runner.Run("JobSystem::Dispatch group " + std::to_string(groupSize), jobCount, 0.0, [&]()
+            {
+                JobSystem::Dispatch(jobCount, groupSize, [&counter](JobSystem::JobDispatchArgs args)
+                {
+                    if (args.JobIndex == 0)
+                        counter.fetch_add(1, std::memory_order_relaxed);
+                });
+                JobSystem::Wait();
+            });
+        }
+    }
+
+    static bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg == "--no-pin")
+            {
+                options.Pin = false;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc)
+                return false;
+
+            const std::string value = argv[++i];
+            try
+            {
+                if (arg == "--filter")              options.Filter = value;
+                else if (arg == "--reps")           options.Repetitions = std::max(1u, (uint32_t)std::stoul(value));
+                else if (arg == "--min-time")       options.MinRunTime = std::stod(value);
+                else if (arg == "--assets")         options.AssetsDir = value;
+                else if (arg == "--output")         options.OutputPath = value;
+                else
+                    return false;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+// Isolated throughput of the hot kernels in ns/op and bytes/op.
+int main(int argc, char** argv)
+{
+    using namespace RGS;
+    using namespace RGS::MicroBench;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::cerr << "rgs-microbench [--filter NAME] [--reps N] [--min-time MS] [--no-pin] [--assets DIR] [--output FILE.json]" << std::endl;
+        return 1;
+    }
+
+    JobSystem::Init();
+    if (options.Pin)
+        PinCurrentThread();
+
+    Runner runner(options);
+    Runner::PrintHeader();
+    RunMathKernels(runner);
+    RunFastMathKernels(runner);
+    RunSamplingKernels(runner, options);
+    RunCompressedSamplingKernels(runner, options);
+    RunTiledSamplingKernels(runner, options);
+    RunRasterKernels(runner);
+    RunFramebufferKernels(runner);
+    RunJobSystemKernels(runner);
+
+    int result = 0;
+    if (!options.OutputPath.empty())
+    {
+        std::ofstream file(options.OutputPath);
+        if (file.is_open())
+        {
+            runner.WriteJson(file);
+        }
+        else
+        {
+            std::cerr << "写入失败: " << options.OutputPath << std::endl;
+            result = 1;
+        }
+    }
+
+    JobSystem::Shutdown();
+    return result;
+}
@@ -5,6 +5,10 @@
 #include "RGS/Layer/IBLPBRLayer.h"
 #include "RGS/Layer/ToolLayer.h"
 #include "RGS/JobSystem.h"
+#include "RGS/Render/Pipeline.h"
+#include "RGS/Render/FrameTimings.h"
+#include "RGS/Config.h"
+#include "RGS/Tuning.h"
 
 #include "RGS/Base/Instrumentor.h"
 
@@ -32,6 +36,8 @@ namespace RGS {
 
         // JobSystem
         JobSystem::Init();
+        if (Tuning::Load(Config::TuningFilePath))
+            std::cout << "Loaded group sizes from " << Config::TuningFilePath << std::endl;
 
         // Window & Framebuffer
         Platform::Init();
@@ -54,6 +60,7 @@ namespace RGS {
     {
         delete m_Window;
         Platform::Terminate();
+        JobSystem::Shutdown();
     }
 
     float Application::GetDeltaTime()
@@ -68,14 +75,75 @@ namespace RGS {
         return deltaTime;
     }
 
+    bool Application::Record(const std::string& path)
+    {
+        if (!m_SessionRecorder.Open(path))
+        {
+            std::cout << "写入失败: " << path << std::endl;
+            return false;
+        }
+        std::cout << "Recording session to " << path << std::endl;
+        return true;
+    }
+
+    bool Application::Replay(const std::string& path)
+    {
+        if (!m_SessionPlayer.Load(path))
+        {
+            std::cout << "加载失败: " << path << std::endl;
+            return false;
+        }
+        m_ReplayPath = path;
+        m_Replaying = true;
+        FrameTimings::Clear();
+        std::cout << "Replaying " << m_SessionPlayer.GetFrameCount() << " frames from " << path << std::endl;
+        return true;
+    }
+
+    void Application::FinishReplay()
+    {
+        m_Replaying = false;
+
+        RollingHistogram::Percentiles frame = FrameTimings::GetFrameTimes().GetPercentiles();
+        std::cout << "Replay finished: " << m_SessionPlayer.GetFrameCount() << " frames, mean " << frame.Mean
+                  << " ms, p50 " << frame.P50 << " ms, p95 " << frame.P95 << " ms, p99 " << frame.P99 << " ms" << std::endl;
+
+        const std::string csvPath = m_ReplayPath + ".csv";
+        if (FrameTimings::ExportCSV(csvPath))
+            std::cout << "已导出 " << csvPath << std::endl;
+        else
+            std::cout << "写入失败: " << csvPath << std::endl;
+    }
+
     void Application::Run()
     {
         RGS_PROFILE_BEGIN_SESSION("Runtime", "RGSProfile-Runtime.json");
+        RGS_PROFILE_THREAD("Main");
         while (!m_Window->Closed())
         {
             RGS_PROFILE_SCOPE("Frame");
-            Renderer::s_FaceCount = 0;
+#if RGS_ENABLE_RENDER_STATS
+            Pipeline::ResetFrameStats();
+#endif
             float deltaTime = GetDeltaTime();
+            FrameTimings::AddFrameTime(deltaTime * 1000.0f);
+
+            if (m_Replaying)
+            {
+                const SessionFrame* frame = m_SessionPlayer.Next();
+                if (frame == nullptr)
+                {
+                    FinishReplay();
+                    break;
+                }
+
+                // Layers step with a fixed delta so the replay doesn't depend on how fast it runs
+                deltaTime = Config::ReplayTimeStep;
+                for (Layer* layer : m_LayerStack)
+                {
+                    layer->OnReplay(*frame);
+                }
+            }
 
             if (!m_Window->Minimized())
             {
@@ -85,6 +153,17 @@ namespace RGS {
                     layer->OnUpdate(deltaTime);
                 }
             }
+
+            if (m_SessionRecorder.IsOpen())
+            {
+                SessionFrame frame;
+                frame.DeltaTime = deltaTime;
+                for (Layer* layer : m_LayerStack)
+                {
+                    layer->OnRecord(frame);
+                }
+                m_SessionRecorder.Record(frame);
+            }
             
             {
                 RGS_PROFILE_SCOPE("layer::OnImGuiRender");
@@ -104,6 +183,14 @@ namespace RGS {
             Platform::PollInputEvents();
         }
         RGS_PROFILE_END_SESSION();
+
+        if (m_SessionRecorder.IsOpen())
+        {
+            std::cout << "Recorded " << m_SessionRecorder.GetFrameCount() << " frames" << std::endl;
+            m_SessionRecorder.Close();
+        }
+
+        JobSystem::PrintStats();
     }
 
 }
\ No newline at end of file
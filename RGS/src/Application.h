@@ -2,6 +2,7 @@
 #include "RGS/Window.h"
 #include "RGS/Render/Framebuffer.h"
 #include "RGS/Layer/Layer.h"
+#include "RGS/Session.h"
 #include "ImGui/ImGuiWindow.h"
 
 #include <chrono>
@@ -18,6 +19,13 @@ namespace RGS {
         Framebuffer& GetFramebuffer() { return *m_Framebuffer; }
         Window& GetWindow() { return *m_Window; }
 
+        // Call before Run(). Replay drives the layers with the recorded frames at Config::ReplayTimeStep,
+        // then exports the frame timings to path + ".csv" and quits.
+        bool Record(const std::string& path);
+        bool Replay(const std::string& path);
+        bool IsRecording() const { return m_SessionRecorder.IsOpen(); }
+        bool IsReplaying() const { return m_Replaying; }
+
         static Application& Instance() { return *s_Instance; }
 
     private:
@@ -25,6 +33,7 @@ namespace RGS {
         void Terminate();
 
         float GetDeltaTime();
+        void FinishReplay();
 
     private:
         const char* m_Name;
@@ -38,6 +47,11 @@ namespace RGS {
 
         LayerStack m_LayerStack;
 
+        SessionRecorder m_SessionRecorder;
+        SessionPlayer m_SessionPlayer;
+        std::string m_ReplayPath;
+        bool m_Replaying = false;
+
         static Application* s_Instance;
 
     };
@@ -0,0 +1,96 @@
+#include "rgspch.h"
+
+#include "RGS/Platform.h"
+#include "RGS/JobSystem.h"
+#include "RGS/Render/Framebuffer.h"
+#include "RGS/Render/Mesh.h"
+#include "RGS/Render/Pipeline.h"
+#include "RGS/Render/RenderCommand.h"
+#include "RGS/Render/FrameTimings.h"
+#include "RGS/Shader/FlatColorShader.h"
+#include "RGS/Timer.h"
+#include "RGS/Tuning.h"
+#include "Headless/HeadlessWindow.h"
+
+// rgs-headless [width] [height] [frames] [output.png|output.ppm]
+// Drives the full pipeline without a screen and writes the last frame to a file.
+int main(int argc, char** argv)
+{
+    using namespace RGS;
+
+    const uint32_t width = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 800u;
+    const uint32_t height = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 600u;
+    const uint32_t frames = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 60u;
+    const std::string output = argc > 4 ? argv[4] : "rgs-headless.png";
+
+    JobSystem::Init();
+    Tuning::Load(Config::TuningFilePath);
+    Platform::Init();
+
+    HeadlessWindow window("Headless", width, height);
+    window.SetMaxFrames(frames);
+    std::unique_ptr<Framebuffer> screen = Framebuffer::Create(width, height);
+    std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(width, height);
+
+    Camera camera;
+    camera.Aspect = (float)width / (float)height;
+    camera.Pos = { 0.0f, 0.0f, 2.0f, 1.0f };
+
+    auto sphereMesh = Mesh<FlatColorVertex>::CreateSphereMesh();
+    auto quadMesh = Mesh<FlatColorVertex>::CreateQuadMesh();
+    auto sphereProgram = std::make_shared<Program<FlatColorVertex, FlatColorUniforms, FlatColorVaryings>>(FlatColorVertexShader, FlatColorFragmentShader);
+    auto quadProgram = std::make_shared<Program<FlatColorVertex, FlatColorUniforms, FlatColorVaryings>>(FlatColorVertexShader, FlatColorFragmentShader);
+    quadProgram->EnableBlend = true;
+    quadProgram->EnableWriteDepth = false;
+    quadProgram->EnableDoubleSided = true;
+
+    auto sphereUniforms = std::make_shared<FlatColorUniforms>();
+    sphereUniforms->Color = { 1.0f, 0.5f, 0.2f, 1.0f };
+    sphereUniforms->MVP = camera.ProjectionMat4() * camera.ViewMat4();
+    auto quadUniforms = std::make_shared<FlatColorUniforms>();
+    quadUniforms->Color = { 0.1f, 1.0f, 1.0f, 0.5f };
+    quadUniforms->MVP = camera.ProjectionMat4() * camera.ViewMat4() * Mat4Translate(0.0f, 0.0f, 1.3f);
+
+    Pipeline pipeline;
+    while (!window.Closed())
+    {
+        Timer frameTimer;
+#if RGS_ENABLE_RENDER_STATS
+        Pipeline::ResetFrameStats();
+#endif
+        pipeline.BeginFrame();
+        pipeline.AddCommand(RenderCommand::Clear(*framebuffer), RenderStage::BeginFrame);
+        pipeline.AddCommand(RenderCommand::ClearDepth(*framebuffer), RenderStage::BeginFrame);
+
+        auto sphere = RenderCommand::Draw(*framebuffer, sphereProgram, sphereMesh, sphereUniforms, framebuffer->GetMSAA());
+        sphere->SetName("Sphere");
+        pipeline.AddCommand(std::move(sphere), RenderStage::Geometry);
+
+        auto quad = RenderCommand::Draw(*framebuffer, quadProgram, quadMesh, quadUniforms, framebuffer->GetMSAA());
+        quad->SetName("Quad");
+        pipeline.AddCommand(std::move(quad), RenderStage::Transparent);
+
+        pipeline.AddCommand(RenderCommand::ResolveParallel(*framebuffer), RenderStage::EndFrame);
+        pipeline.AddCommand(RenderCommand::BlitToScreen(*framebuffer, *screen), RenderStage::EndFrame);
+        pipeline.EndFrame();
+
+        window.DrawFramebuffer(*screen);
+        Platform::PollInputEvents();
+        FrameTimings::AddFrameTime((float)frameTimer.GetDuration());
+    }
+
+    RollingHistogram::Percentiles percentiles = FrameTimings::GetFrameTimes().GetPercentiles();
+    std::cout << window.GetFrameCount() << " frames, p50 " << percentiles.P50 << " ms, p95 " << percentiles.P95
+              << " ms, p99 " << percentiles.P99 << " ms" << std::endl;
+
+    int result = 0;
+    if (!window.SaveImage(output))
+    {
+        std::cout << "写入失败: " << output << std::endl;
+        result = 1;
+    }
+
+    Platform::Terminate();
+    JobSystem::Shutdown();
+    return result;
+}
@@ -0,0 +1,69 @@
+#include "rgspch.h"
+#include "HeadlessWindow.h"
+
+#include "RGS/JobSystem.h"
+#include "RGS/Tuning.h"
+
+#include <stb_image_write.h>
+#include <fstream>
+
+namespace RGS {
+
+    HeadlessWindow::HeadlessWindow(const char* title, const uint32_t width, const uint32_t height)
+        :Window(title, width, height), m_Buffer(width * height * 3, 0)
+    {
+        m_Closed = false;
+        m_Minimized = false;
+    }
+
+    void HeadlessWindow::DrawFramebuffer(const Framebuffer& framebuffer)
+    {
+        const uint32_t fWidth = framebuffer.GetWidth();
+        const uint32_t fHeight = framebuffer.GetHeight();
+        const uint32_t width = (std::min)((uint32_t)m_Width, fWidth);
+        const uint32_t height = (std::min)((uint32_t)m_Height, fHeight);
+
+        uint32_t jobCount = width * height;
+        const uint32_t groupSize = Tuning::GetGroupSize(TunedKernel::Blit);
+        JobSystem::Dispatch(jobCount, groupSize, [=, this, &framebuffer](JobSystem::JobDispatchArgs args)
+        {
+            int x = args.JobIndex % width;
+            int y = args.JobIndex / width;
+
+            // Framebuffer rows go bottom up, images top down
+            Vec3 color = framebuffer.GetColor(x, y);
+            const uint32_t pixStart = (x + (m_Height - 1 - y) * m_Width) * 3;
+            m_Buffer[pixStart + 0] = Float2UChar(color.X);
+            m_Buffer[pixStart + 1] = Float2UChar(color.Y);
+            m_Buffer[pixStart + 2] = Float2UChar(color.Z);
+        });
+
+        JobSystem::Wait();
+        Show();
+    }
+
+    void HeadlessWindow::Show()
+    {
+        m_FrameCount++;
+
+        if (!m_OutputPath.empty() && !SaveImage(m_OutputPath))
+            std::cout << "写入失败: " << m_OutputPath << std::endl;
+
+        if (m_MaxFrames != 0 && m_FrameCount >= m_MaxFrames)
+            m_Closed = true;
+    }
+
+    bool HeadlessWindow::SaveImage(const std::string& path) const
+    {
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0)
+            return stbi_write_png(path.c_str(), m_Width, m_Height, 3, m_Buffer.data(), m_Width * 3) != 0;
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file << "P6\n" << m_Width << ' ' << m_Height << "\n255\n";
+        file.write((const char*)m_Buffer.data(), m_Buffer.size());
+        return file.good();
+    }
+
+}
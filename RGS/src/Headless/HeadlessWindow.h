@@ -0,0 +1,40 @@
+#pragma once 
+#include "RGS/Render/Framebuffer.h"
+#include "RGS/Window.h"
+
+#include <string>
+#include <vector>
+
+namespace RGS {
+
+    // Window without a screen: frames are presented into memory (RGB8, top row first)
+    // and can be written to .ppm/.png files. Used on Linux and for benchmarks.
+    class HeadlessWindow : public Window {
+
+    private:
+        std::vector<unsigned char> m_Buffer;
+        uint32_t m_FrameCount = 0;
+        uint32_t m_MaxFrames = 0;
+        std::string m_OutputPath;
+
+    public:
+        HeadlessWindow(const char* title, const unsigned int width, const unsigned int height);
+        ~HeadlessWindow() = default;
+
+        void DrawFramebuffer(const Framebuffer& framebuffer) override;
+        void Show() override;
+
+        // Closes the window after the given number of presented frames, 0 keeps it open.
+        void SetMaxFrames(const uint32_t maxFrames) { m_MaxFrames = maxFrames; }
+        // Every presented frame overwrites this file, empty disables it.
+        void SetOutputPath(const std::string& path) { m_OutputPath = path; }
+        void Close() { m_Closed = true; }
+
+        const unsigned char* GetBuffer() const { return m_Buffer.data(); }
+        uint32_t GetFrameCount() const { return m_FrameCount; }
+
+        // Format picked by the extension: .png, anything else is written as binary .ppm
+        bool SaveImage(const std::string& path) const;
+    };
+
+}
@@ -1,12 +1,28 @@
 #include "Application.h"
 
-int main() 
+#include <cstring>
+
+// Usage: RGS [--record session.rgss | --replay session.rgss]
+int main(int argc, char** argv) 
 {
 #if 0
     RGS::Application app("Viewport", 400, 300);
 #else
     RGS::Application app("Viewport", 800, 600);
 #endif
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--record") == 0)
+        {
+            if (!app.Record(argv[i + 1]))
+                return 1;
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0)
+        {
+            if (!app.Replay(argv[i + 1]))
+                return 1;
+        }
+    }
     app.Run();
 
     return 0;
@@ -0,0 +1,100 @@
+#include "rgspch.h"
+#include "AssetManager.h"
+
+#include "RGS/Render/Framebuffer.h"
+
+#include <algorithm>
+
+namespace RGS {
+
+    AssetManager::~AssetManager()
+    {
+        // A loader may reference its caller, which usually goes away with the manager
+        Wait();
+    }
+
+    AssetHandle<Texture> AssetManager::LoadTexture(const std::string& path, std::shared_ptr<Texture> placeholder, const TextureStorage storage)
+    {
+        return Load<Texture>(path, [path, storage]() { return Texture::LoadTexture(path, storage); }, std::move(placeholder));
+    }
+
+    AssetHandle<TextureSphere> AssetManager::LoadTextureSphere(const std::string& path, std::shared_ptr<TextureSphere> placeholder, const TextureStorage storage)
+    {
+        return Load<TextureSphere>(path, [path, storage]() { return TextureSphere::LoadTextureSphere(path, storage); }, std::move(placeholder));
+    }
+
+    AssetHandle<LodTextureSphere> AssetManager::LoadLodTextureSphere(const std::vector<std::string>& paths, std::shared_ptr<LodTextureSphere> placeholder)
+    {
+        const std::string& first = paths.front();
+        const size_t separator = first.find_last_of("/\\");
+        const std::string dir = separator == std::string::npos ? std::string() : first.substr(0, separator);
+        return Load<LodTextureSphere>(dir, [paths]() { return LodTextureSphere::LoadLodTextureSphere(paths); }, std::move(placeholder));
+    }
+
+    AssetHandle<LodTextureSphere> AssetManager::LoadLodTextureSphere(const std::string& dir, std::shared_ptr<LodTextureSphere> placeholder)
+    {
+        return Load<LodTextureSphere>(dir, [dir]() { return LodTextureSphere::LoadLodTextureSphere(dir, LodTextureSphere::LoadType::Directory); },
+                                      std::move(placeholder));
+    }
+
+    void AssetManager::Start(std::function<void()> publish, std::function<void()> load)
+    {
+        auto request = std::make_shared<Request>();
+        request->Publish = std::move(publish);
+        JobSystem::Execute(m_Loads, [request, load = std::move(load)]()
+        {
+            load();
+            request->Done.store(true, std::memory_order_release);
+        });
+        m_Requests.push_back(std::move(request));
+    }
+
+    int AssetManager::Update()
+    {
+        int loading = 0;
+        std::erase_if(m_Requests, [&loading](const std::shared_ptr<Request>& request)
+        {
+            if (!request->Done.load(std::memory_order_acquire))
+            {
+                loading++;
+                return false;
+            }
+            request->Publish();
+            return true;
+        });
+        return loading;
+    }
+
+    void AssetManager::Wait()
+    {
+        JobSystem::Wait(m_Loads);
+    }
+
+    static std::unique_ptr<Framebuffer> CreatePixel(const Vec3& color)
+    {
+        std::unique_ptr<Framebuffer> pixel = Framebuffer::Create(1, 1);
+        pixel->Clear(color);
+        return pixel;
+    }
+
+    std::shared_ptr<Texture> AssetManager::CreatePlaceholderTexture(const Vec3& color)
+    {
+        return std::make_shared<Texture>(*CreatePixel(color));
+    }
+
+    std::shared_ptr<TextureSphere> AssetManager::CreatePlaceholderTextureSphere(const Vec3& color)
+    {
+        return std::make_shared<TextureSphere>(*CreatePixel(color));
+    }
+
+    std::shared_ptr<LodTextureSphere> AssetManager::CreatePlaceholderLodTextureSphere(const Vec3& color)
+    {
+        return std::make_shared<LodTextureSphere>(*CreatePixel(color));
+    }
+
+    std::shared_ptr<TextureCube> AssetManager::CreatePlaceholderTextureCube(const Vec3& color)
+    {
+        return std::make_shared<TextureCube>(TextureSphere(*CreatePixel(color)));
+    }
+
+}
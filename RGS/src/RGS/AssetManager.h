@@ -0,0 +1,159 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+#include "RGS/JobSystem.h"
+#include "RGS/Texture.h"
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace RGS {
+
+    enum class AssetState
+    {
+        Loading,
+        Ready,
+        Failed,         // the handle keeps its placeholder
+    };
+
+    // An asset loaded by AssetManager. Get returns the placeholder until AssetManager::Update publishes the
+    // loaded asset; Update runs between two frames, so a frame draws with one or the other throughout.
+    // Only the thread calling Update may use the handle.
+    template <typename asset_t>
+    class Asset
+    {
+    public:
+        asset_t* Get() const { return m_Current; }
+        AssetState GetState() const { return m_State; }
+        bool IsLoading() const { return m_State == AssetState::Loading; }
+        const std::string& GetPath() const { return m_Path; }
+
+    private:
+        friend class AssetManager;
+
+        std::string m_Path;
+        asset_t* m_Current = nullptr;                   // m_Asset once ready, m_Placeholder until then
+        AssetState m_State = AssetState::Loading;
+        std::shared_ptr<asset_t> m_Placeholder;         // shared by all the handles waiting with it, may be null
+        std::unique_ptr<asset_t> m_Asset;
+    };
+
+    template <typename asset_t>
+    using AssetHandle = std::shared_ptr<Asset<asset_t>>;
+
+    // Decodes files on Background jobs, in parallel and behind the frame work, and hands out handles that
+    // resolve when the asset is ready. Draws use the placeholder of a handle until then, no frame waits for a file.
+    class AssetManager
+    {
+    public:
+        AssetManager() { m_Loads.Priority = JobSystem::JobPriority::Background; }
+        ~AssetManager();
+
+        AssetManager(const AssetManager&) = delete;
+        AssetManager& operator=(const AssetManager&) = delete;
+
+        // Runs loader on a job. Its result replaces the placeholder in the first Update after it returns,
+        // nullptr marks the load as failed. path only names the asset.
+        template <typename asset_t>
+        AssetHandle<asset_t> Load(const std::string& path, std::function<asset_t*()> loader, std::shared_ptr<asset_t> placeholder)
+        {
+            auto handle = CreateHandle(path, std::move(placeholder));
+            auto result = std::make_shared<std::unique_ptr<asset_t>>();
+            Start([handle, result]() { Publish(*handle, *result); },
+                  [result, loader = std::move(loader)]() { result->reset(loader()); });
+            return handle;
+        }
+
+        // Runs derive on the asset loader returns, in the same job, e.g. the cubemap of a sphere map: the file
+        // is decoded once. The two are published by the same Update; when loader fails both handles fail.
+        template <typename asset_t, typename derived_t>
+        std::pair<AssetHandle<asset_t>, AssetHandle<derived_t>> Load(const std::string& path,
+                                                                     std::function<asset_t*()> loader, std::shared_ptr<asset_t> placeholder,
+                                                                     std::function<derived_t*(const asset_t&)> derive,
+                                                                     std::shared_ptr<derived_t> derivedPlaceholder)
+        {
+            auto handle = CreateHandle(path, std::move(placeholder));
+            auto derivedHandle = CreateHandle(path, std::move(derivedPlaceholder));
+            auto result = std::make_shared<std::unique_ptr<asset_t>>();
+            auto derivedResult = std::make_shared<std::unique_ptr<derived_t>>();
+            Start([handle, derivedHandle, result, derivedResult]()
+                  {
+                      Publish(*handle, *result);
+                      Publish(*derivedHandle, *derivedResult);
+                  },
+                  [result, derivedResult, loader = std::move(loader), derive = std::move(derive)]()
+                  {
+                      result->reset(loader());
+                      if (*result)
+                          derivedResult->reset(derive(**result));
+                  });
+            return { handle, derivedHandle };
+        }
+
+        AssetHandle<Texture> LoadTexture(const std::string& path, std::shared_ptr<Texture> placeholder,
+                                         TextureStorage storage = TextureStorage::Linear);
+        AssetHandle<TextureSphere> LoadTextureSphere(const std::string& path, std::shared_ptr<TextureSphere> placeholder,
+                                                     TextureStorage storage = TextureStorage::Linear);
+        // The five levels, named by the directory of the first one
+        AssetHandle<LodTextureSphere> LoadLodTextureSphere(const std::vector<std::string>& paths, std::shared_ptr<LodTextureSphere> placeholder);
+        // dir\0.hdr to dir\4.hdr, see LodTextureSphere::LoadLodTextureSphere
+        AssetHandle<LodTextureSphere> LoadLodTextureSphere(const std::string& dir, std::shared_ptr<LodTextureSphere> placeholder);
+
+        // Between two frames, on the thread that loads: publishes the finished loads and returns how many are
+        // still loading
+        int Update();
+        // Blocks until every load has finished, Update still has to publish them
+        void Wait();
+
+        // 1x1 stand-ins of one color
+        static std::shared_ptr<Texture> CreatePlaceholderTexture(const Vec3& color);
+        static std::shared_ptr<TextureSphere> CreatePlaceholderTextureSphere(const Vec3& color);
+        static std::shared_ptr<LodTextureSphere> CreatePlaceholderLodTextureSphere(const Vec3& color);
+        static std::shared_ptr<TextureCube> CreatePlaceholderTextureCube(const Vec3& color);
+
+    private:
+        struct Request
+        {
+            std::function<void()> Publish;      // on the Update thread
+            std::atomic<bool> Done{ false };    // set by the job once the result is written
+        };
+
+        template <typename asset_t>
+        static AssetHandle<asset_t> CreateHandle(const std::string& path, std::shared_ptr<asset_t> placeholder)
+        {
+            auto handle = std::make_shared<Asset<asset_t>>();
+            handle->m_Path = path;
+            handle->m_Placeholder = std::move(placeholder);
+            handle->m_Current = handle->m_Placeholder.get();
+            return handle;
+        }
+
+        template <typename asset_t>
+        static void Publish(Asset<asset_t>& handle, std::unique_ptr<asset_t>& result)
+        {
+            if (result)
+            {
+                handle.m_Asset = std::move(result);
+                handle.m_Current = handle.m_Asset.get();
+                handle.m_State = AssetState::Ready;
+                handle.m_Placeholder.reset();
+            }
+            else
+            {
+                std::cout << "加载失败: " << handle.m_Path << std::endl;
+                handle.m_State = AssetState::Failed;
+            }
+        }
+
+        // Runs load on a job and publish in the first Update after it has returned
+        void Start(std::function<void()> publish, std::function<void()> load);
+
+        std::vector<std::shared_ptr<Request>> m_Requests;
+        JobSystem::Context m_Loads;
+    };
+
+}
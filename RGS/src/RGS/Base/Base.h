@@ -6,9 +6,14 @@
 #endif
 
 #ifdef RGS_BUILD_DEBUG
+	#ifdef _MSC_VER
+		#define RGS_DEBUGBREAK() __debugbreak()
+	#else
+		#define RGS_DEBUGBREAK() __builtin_trap()
+	#endif
 	#define LOG(...) 
-	#define ASSERT(x, ...) { if(!(x)) { LOG(__VA_ARGS__); __debugbreak(); } }
-	#define BREAKIF(x) {if(x){__debugbreak();}}
+	#define ASSERT(x, ...) { if(!(x)) { LOG(__VA_ARGS__); RGS_DEBUGBREAK(); } }
+	#define BREAKIF(x) {if(x){RGS_DEBUGBREAK();}}
 #endif
 
 #define UNUSED(x) ((void)(x))
@@ -0,0 +1,197 @@
+#include "rgspch.h"
+#include "BlockCompression.h"
+
+#include <stb_dxt.h>
+#include <atomic>
+
+namespace RGS {
+
+    uint32_t BlockCache::CreateImageId()
+    {
+        // 0 is the tag of the empty entries
+        static std::atomic<uint32_t> s_NextId = 1u;
+        return s_NextId.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    namespace BlockCodec {
+
+        // stb_dxt takes 8-bit channels, interleaved
+        static void ToBytes(const Vec4 texels[16], unsigned char* bytes, const int channels)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < channels; ++c)
+                    bytes[i * channels + c] = Float2UChar((&texels[i].X)[c]);
+            }
+        }
+
+        void EncodeBC1(const Vec4 texels[16], uint8_t* block)
+        {
+            unsigned char rgba[64];
+            ToBytes(texels, rgba, 4);
+            stb_compress_dxt_block(block, rgba, 0, STB_DXT_HIGHQUAL);
+        }
+
+        void EncodeBC3(const Vec4 texels[16], uint8_t* block)
+        {
+            unsigned char rgba[64];
+            ToBytes(texels, rgba, 4);
+            stb_compress_dxt_block(block, rgba, 1, STB_DXT_HIGHQUAL);
+        }
+
+        void EncodeBC4(const Vec4 texels[16], uint8_t* block)
+        {
+            unsigned char r[16];
+            ToBytes(texels, r, 1);
+            stb_compress_bc4_block(block, r);
+        }
+
+        void EncodeBC5(const Vec4 texels[16], uint8_t* block)
+        {
+            unsigned char rg[32];
+            ToBytes(texels, rg, 2);
+            stb_compress_bc5_block(block, rg);
+        }
+
+        // Closest of the 16 colors between the quantized endpoints for every texel, returns the squared error
+        static int64_t FindIndices(const int halves[16][3], const int e0[3], const int e1[3], int indices[16])
+        {
+            using traits = BlockTraits<TexelFormat::BC6H>;
+
+            int palette[16][3];
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                    palette[i][c] = traits::FinishUnquantize(traits::Interpolate(traits::Unquantize(e0[c]), traits::Unquantize(e1[c]), traits::Weights[i]));
+            }
+
+            int64_t totalError = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                int64_t bestError = INT64_MAX;
+                for (int j = 0; j < 16; ++j)
+                {
+                    int64_t error = 0;
+                    for (int c = 0; c < 3; ++c)
+                        error += (int64_t)(palette[j][c] - halves[i][c]) * (palette[j][c] - halves[i][c]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[i] = j;
+                    }
+                }
+                totalError += bestError;
+            }
+            return totalError;
+        }
+
+        // Inverse of FinishUnquantize(Unquantize(q)) = 31q + 15
+        static int QuantizeEndpoint(const double half)
+        {
+            return std::clamp((int)std::floor((half + 0.5) / 31.0), 0, 1023);
+        }
+
+        // The endpoints start at the corners of the bounding box of the block in half float bits, on the diagonal
+        // that follows the channel with the largest range, then one least squares fit to the chosen indices.
+        void EncodeBC6H(const Vec4 texels[16], uint8_t* block)
+        {
+            using traits = BlockTraits<TexelFormat::BC6H>;
+
+            // Negative and NaN channels become 0
+            int halves[16][3];
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    const float value = (&texels[i].X)[c];
+                    halves[i][c] = TexelTraits<TexelFormat::RGBA16F>::EncodeHalf(value > 0.0f ? value : 0.0f);
+                }
+            }
+
+            int low[3], high[3];
+            double mean[3] = { 0.0, 0.0, 0.0 };
+            int axis = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                low[c] = high[c] = halves[0][c];
+                for (int i = 0; i < 16; ++i)
+                {
+                    low[c] = std::min(low[c], halves[i][c]);
+                    high[c] = std::max(high[c], halves[i][c]);
+                    mean[c] += halves[i][c] / 16.0;
+                }
+                if (high[c] - low[c] > high[axis] - low[axis])
+                    axis = c;
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                double covariance = 0.0;
+                for (int i = 0; i < 16; ++i)
+                    covariance += (halves[i][c] - mean[c]) * (halves[i][axis] - mean[axis]);
+                if (covariance < 0.0)
+                    std::swap(low[c], high[c]);
+            }
+
+            int e0[3], e1[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                e0[c] = QuantizeEndpoint(low[c]);
+                e1[c] = QuantizeEndpoint(high[c]);
+            }
+            int indices[16];
+            const int64_t error = FindIndices(halves, e0, e1, indices);
+
+            // Least squares endpoints of h = (1 - t) e0 + t e1 over the texels, t the weights of their indices
+            double oo = 0.0, ot = 0.0, tt = 0.0;
+            for (int i = 0; i < 16; ++i)
+            {
+                const double t = traits::Weights[indices[i]] / 64.0;
+                oo += (1.0 - t) * (1.0 - t);
+                ot += (1.0 - t) * t;
+                tt += t * t;
+            }
+            const double determinant = oo * tt - ot * ot;
+            if (std::abs(determinant) > 1e-9)
+            {
+                int fit0[3], fit1[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    double ho = 0.0, ht = 0.0;
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        const double t = traits::Weights[indices[i]] / 64.0;
+                        ho += halves[i][c] * (1.0 - t);
+                        ht += halves[i][c] * t;
+                    }
+                    fit0[c] = QuantizeEndpoint((ho * tt - ht * ot) / determinant);
+                    fit1[c] = QuantizeEndpoint((ht * oo - ho * ot) / determinant);
+                }
+                int fitIndices[16];
+                if (FindIndices(halves, fit0, fit1, fitIndices) < error)
+                {
+                    std::memcpy(e0, fit0, sizeof(e0));
+                    std::memcpy(e1, fit1, sizeof(e1));
+                    std::memcpy(indices, fitIndices, sizeof(indices));
+                }
+            }
+
+            // The top bit of the first index is implicit 0, the palette is symmetric so swapping the endpoints flips the indices
+            if (indices[0] >= 8)
+            {
+                std::swap(e0, e1);
+                for (int& index : indices)
+                    index = 15 - index;
+            }
+
+            uint64_t lo = traits::Mode | ((uint64_t)e0[0] << 5) | ((uint64_t)e0[1] << 15) | ((uint64_t)e0[2] << 25) |
+                          ((uint64_t)e1[0] << 35) | ((uint64_t)e1[1] << 45) | ((uint64_t)e1[2] << 55);
+            uint64_t hi = ((uint64_t)e1[2] >> 9) | ((uint64_t)indices[0] << 1);
+            for (int i = 1; i < 16; ++i)
+                hi |= (uint64_t)indices[i] << (4 * i);
+            std::memcpy(block, &lo, 8);
+            std::memcpy(block + 8, &hi, 8);
+        }
+
+    }
+
+}
@@ -0,0 +1,297 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+#include "RGS/Base/TexelFormat.h"
+#include "RGS/Config.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace RGS {
+
+    // 4x4 texel blocks in the layouts of the D3D10 BC formats. The encoders run at load time,
+    // the decoders expand a whole block to 16 Vec4 in the x + 4y order.
+    template <TexelFormat format>
+    struct BlockTraits;
+
+    namespace BlockCodec {
+
+        // BC1/BC3/BC4/BC5 through stb_dxt from 8-bit channels, BC6H with its own encoder
+        void EncodeBC1(const Vec4 texels[16], uint8_t* block);
+        void EncodeBC3(const Vec4 texels[16], uint8_t* block);
+        void EncodeBC4(const Vec4 texels[16], uint8_t* block);
+        void EncodeBC5(const Vec4 texels[16], uint8_t* block);
+        void EncodeBC6H(const Vec4 texels[16], uint8_t* block);
+
+        // Two 565 endpoints and 2-bit indices, decoded with a = 0. In BC1 the block has three colors
+        // and black when c0 <= c1, the color block of BC3 always has four.
+        inline void DecodeColorBlock(const uint8_t* block, Vec4 texels[16], const bool alwaysFourColors)
+        {
+            const uint32_t c0 = block[0] | (block[1] << 8);
+            const uint32_t c1 = block[2] | (block[3] << 8);
+            auto expand = [](const uint32_t c)
+            {
+                const uint32_t r = (c >> 11) & 31u, g = (c >> 5) & 63u, b = c & 31u;
+                return Vec4{ (float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)), 0.0f } * (1.0f / 255.0f);
+            };
+
+            Vec4 palette[4];
+            palette[0] = expand(c0);
+            palette[1] = expand(c1);
+            if (alwaysFourColors || c0 > c1)
+            {
+                palette[2] = (palette[0] * 2.0f + palette[1]) * (1.0f / 3.0f);
+                palette[3] = (palette[0] + palette[1] * 2.0f) * (1.0f / 3.0f);
+            }
+            else
+            {
+                palette[2] = (palette[0] + palette[1]) * 0.5f;
+                palette[3] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            }
+
+            const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+            for (int i = 0; i < 16; ++i)
+                texels[i] = palette[(indices >> (2 * i)) & 3u];
+        }
+
+        // Two 8-bit endpoints and 3-bit indices into 8 values, written to one channel
+        inline void DecodeAlphaBlock(const uint8_t* block, Vec4 texels[16], const int channel)
+        {
+            const float a0 = block[0] * (1.0f / 255.0f);
+            const float a1 = block[1] * (1.0f / 255.0f);
+            float palette[8] = { a0, a1 };
+            if (block[0] > block[1])
+            {
+                for (int i = 1; i < 7; ++i)
+                    palette[i + 1] = (a0 * (7 - i) + a1 * i) * (1.0f / 7.0f);
+            }
+            else
+            {
+                for (int i = 1; i < 5; ++i)
+                    palette[i + 1] = (a0 * (5 - i) + a1 * i) * (1.0f / 5.0f);
+                palette[6] = 0.0f;
+                palette[7] = 1.0f;
+            }
+
+            uint64_t indices = 0;
+            std::memcpy(&indices, block + 2, 6);
+            for (int i = 0; i < 16; ++i)
+                (&texels[i].X)[channel] = palette[(indices >> (3 * i)) & 7u];
+        }
+
+    }
+
+    template <>
+    struct BlockTraits<TexelFormat::BC1>
+    {
+        static constexpr int BlockSize = 8;
+        static void Encode(const Vec4 texels[16], uint8_t* block) { BlockCodec::EncodeBC1(texels, block); }
+        // Like the uncompressed RGB images, a = 0
+        static void Decode(const uint8_t* block, Vec4 texels[16]) { BlockCodec::DecodeColorBlock(block, texels, false); }
+    };
+
+    template <>
+    struct BlockTraits<TexelFormat::BC3>
+    {
+        static constexpr int BlockSize = 16;
+        static void Encode(const Vec4 texels[16], uint8_t* block) { BlockCodec::EncodeBC3(texels, block); }
+        // Alpha block first, then a color block that always has four colors
+        static void Decode(const uint8_t* block, Vec4 texels[16])
+        {
+            BlockCodec::DecodeColorBlock(block + 8, texels, true);
+            BlockCodec::DecodeAlphaBlock(block, texels, 3);
+        }
+    };
+
+    template <>
+    struct BlockTraits<TexelFormat::BC4>
+    {
+        static constexpr int BlockSize = 8;
+        static void Encode(const Vec4 texels[16], uint8_t* block) { BlockCodec::EncodeBC4(texels, block); }
+        static void Decode(const uint8_t* block, Vec4 texels[16])
+        {
+            for (int i = 0; i < 16; ++i)
+                texels[i] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            BlockCodec::DecodeAlphaBlock(block, texels, 0);
+        }
+    };
+
+    template <>
+    struct BlockTraits<TexelFormat::BC5>
+    {
+        static constexpr int BlockSize = 16;
+        static void Encode(const Vec4 texels[16], uint8_t* block) { BlockCodec::EncodeBC5(texels, block); }
+        static void Decode(const uint8_t* block, Vec4 texels[16])
+        {
+            for (int i = 0; i < 16; ++i)
+                texels[i] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            BlockCodec::DecodeAlphaBlock(block, texels, 0);
+            BlockCodec::DecodeAlphaBlock(block + 8, texels, 1);
+        }
+    };
+
+    // Unsigned BC6H, only mode 11 is written and read: one region, two 10-bit endpoints per channel
+    // and 4-bit indices. The endpoints are interpolated in the bits of the half floats, which is close
+    // to a log scale, so dark and bright texels of a block keep a similar relative error.
+    template <>
+    struct BlockTraits<TexelFormat::BC6H>
+    {
+        static constexpr int BlockSize = 16;
+        static constexpr uint32_t Mode = 0x03;                  // 5 bits
+        static constexpr int Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Endpoint to 16 bits, interpolated, then scaled to the half float bits (at most 0x7BFF)
+        static int Unquantize(const int q) { return q == 0 ? 0 : (q == 1023 ? 0xFFFF : ((q << 16) + 0x8000) >> 10); }
+        static int Interpolate(const int e0, const int e1, const int weight) { return (e0 * (64 - weight) + e1 * weight + 32) >> 6; }
+        static int FinishUnquantize(const int value) { return (value * 31) >> 6; }
+
+        static void Encode(const Vec4 texels[16], uint8_t* block) { BlockCodec::EncodeBC6H(texels, block); }
+        static void Decode(const uint8_t* block, Vec4 texels[16])
+        {
+            uint64_t lo, hi;
+            std::memcpy(&lo, block, 8);
+            std::memcpy(&hi, block + 8, 8);
+            ASSERT((lo & 0x1Fu) == Mode);
+
+            const int e0[3] = { Unquantize((int)(lo >> 5) & 0x3FF), Unquantize((int)(lo >> 15) & 0x3FF), Unquantize((int)(lo >> 25) & 0x3FF) };
+            const int e1[3] = { Unquantize((int)(lo >> 35) & 0x3FF), Unquantize((int)(lo >> 45) & 0x3FF),
+                                Unquantize((int)((lo >> 55) | (hi << 9)) & 0x3FF) };
+
+            // 16 palette entries, the index of texel 0 has 3 bits (its top bit is 0), the others 4
+            Vec4 palette[16];
+#if RGS_SIMD_SSE
+            // The channels in lanes. The integer steps are exact in float: the products stay below 2^23
+            // and the divides by 64 are powers of two, truncating is the floor of the positive values.
+            const __m128 end0 = _mm_setr_ps((float)e0[0], (float)e0[1], (float)e0[2], 0.0f);
+            const __m128 end1 = _mm_setr_ps((float)e1[0], (float)e1[1], (float)e1[2], 0.0f);
+            for (int i = 0; i < 16; ++i)
+            {
+                const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(end0, _mm_set1_ps((float)(64 - Weights[i]))),
+                                                         _mm_mul_ps(end1, _mm_set1_ps((float)Weights[i]))), _mm_set1_ps(32.0f));
+                const __m128 value = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(sum, _mm_set1_ps(1.0f / 64.0f))));
+                const __m128i half = _mm_cvttps_epi32(_mm_mul_ps(value, _mm_set1_ps(31.0f / 64.0f)));
+                _mm_store_ps(&palette[i].X, _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(half, 13)), _mm_set1_ps(0x1p112f)));
+            }
+#else
+            for (int i = 0; i < 16; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                    (&palette[i].X)[c] = TexelTraits<TexelFormat::RGBA16F>::DecodeHalf((uint16_t)FinishUnquantize(Interpolate(e0[c], e1[c], Weights[i])));
+                palette[i].W = 0.0f;
+            }
+#endif
+            texels[0] = palette[(hi >> 1) & 7u];
+            for (int i = 1; i < 16; ++i)
+                texels[i] = palette[(hi >> (4 * i)) & 15u];
+        }
+    };
+
+    // Per thread, direct mapped cache of decoded blocks. Neighbouring pixels mostly read the same blocks,
+    // so a bilinear lookup decodes about one block per 16 pixels instead of up to 4 blocks per pixel.
+    // The entries are tagged with the block address and the id of the image, which is never reused,
+    // so a new image allocated where a freed one was never hits the old entries.
+    class BlockCache
+    {
+    public:
+        // A new id for every block compressed image
+        static uint32_t CreateImageId();
+
+        template <TexelFormat format>
+        static const Vec4* GetBlock(const uint8_t* block, const uint32_t imageId)
+        {
+            if constexpr (Config::TextureBlockCacheSize == 0)
+            {
+                thread_local Vec4 texels[16];
+                BlockTraits<format>::Decode(block, texels);
+                return texels;
+            }
+            else
+            {
+                // Fibonacci hash of the block number
+                const uint32_t hash = (uint32_t)((uintptr_t)block / BlockTraits<format>::BlockSize) * 0x9E3779B1u;
+                Entry& entry = t_Entries[hash >> (32 - CacheBits)];
+                if (entry.Block != block || entry.ImageId != imageId)
+                {
+                    BlockTraits<format>::Decode(block, entry.Texels);
+                    entry.Block = block;
+                    entry.ImageId = imageId;
+                }
+                return entry.Texels;
+            }
+        }
+
+        // Texel x, y of an image of 4x4 blocks, blocksX per row
+        template <TexelFormat format>
+        static Vec4 GetTexel(const uint8_t* blocks, const int blocksX, const uint32_t imageId, const int x, const int y)
+        {
+            const uint8_t* block = blocks + ((y >> 2) * blocksX + (x >> 2)) * BlockTraits<format>::BlockSize;
+            return GetBlock<format>(block, imageId)[(y & 3) * 4 + (x & 3)];
+        }
+
+        // The 2x2 texels of a bilinear footprint (x0, y0), (x1, y0), (x0, y1), (x1, y1). Most of them share
+        // one block, which is then looked up once. The values are copied before the next lookup, which may
+        // decode into the same entry.
+        template <TexelFormat format>
+        static void GetQuad(const uint8_t* blocks, const int blocksX, const uint32_t imageId, const int x0, const int x1, const int y0, const int y1, Vec4 texels[4])
+        {
+            const bool sameX = (x0 >> 2) == (x1 >> 2);
+            const bool sameY = (y0 >> 2) == (y1 >> 2);
+            const Vec4* block = GetBlock<format>(blocks + ((y0 >> 2) * blocksX + (x0 >> 2)) * BlockTraits<format>::BlockSize, imageId);
+            texels[0] = block[(y0 & 3) * 4 + (x0 & 3)];
+            if (sameX)
+                texels[1] = block[(y0 & 3) * 4 + (x1 & 3)];
+            if (sameY)
+                texels[2] = block[(y1 & 3) * 4 + (x0 & 3)];
+            if (sameX && sameY)
+            {
+                texels[3] = block[(y1 & 3) * 4 + (x1 & 3)];
+                return;
+            }
+
+            if (!sameX)
+                texels[1] = GetTexel<format>(blocks, blocksX, imageId, x1, y0);
+            if (!sameY)
+                texels[2] = GetTexel<format>(blocks, blocksX, imageId, x0, y1);
+            texels[3] = GetTexel<format>(blocks, blocksX, imageId, x1, y1);
+        }
+
+    private:
+        static constexpr int CacheBits = std::countr_zero((uint32_t)std::max(Config::TextureBlockCacheSize, 1));
+        static_assert((Config::TextureBlockCacheSize & (Config::TextureBlockCacheSize - 1)) == 0, "TextureBlockCacheSize must be a power of two");
+
+        // Zero initialized like every thread_local, image id 0 is never used
+        struct Entry
+        {
+            Vec4 Texels[16];
+            const uint8_t* Block;
+            uint32_t ImageId;
+        };
+        static inline thread_local Entry t_Entries[std::max(Config::TextureBlockCacheSize, 1)];
+    };
+
+    // Encodes an image to 4x4 blocks, the partial blocks at the right and bottom edges repeat the last texels
+    template <TexelFormat format>
+    inline void EncodeBlocks(const Vec4* texels, const int width, const int height, std::vector<uint8_t>& blocks)
+    {
+        const int blocksX = (width + 3) / 4;
+        const int blocksY = (height + 3) / 4;
+        blocks.resize((size_t)blocksX * blocksY * BlockTraits<format>::BlockSize);
+        Vec4 blockTexels[16];
+        for (int by = 0; by < blocksY; ++by)
+        {
+            for (int bx = 0; bx < blocksX; ++bx)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    const int x = std::min(bx * 4 + (i & 3), width - 1);
+                    const int y = std::min(by * 4 + (i >> 2), height - 1);
+                    blockTexels[i] = texels[y * width + x];
+                }
+                BlockTraits<format>::Encode(blockTexels, &blocks[((size_t)by * blocksX + bx) * BlockTraits<format>::BlockSize]);
+            }
+        }
+    }
+
+}
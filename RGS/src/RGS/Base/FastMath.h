@@ -0,0 +1,372 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+
+#include <bit>
+#include <cstdint>
+
+namespace RGS::FastMath {
+
+    // Polynomial approximations of the libm functions used by the shaders and the sphere textures.
+    // The error bounds below are checked against libm by rgs-fastmath-test; the SIMD variants compute
+    // the same polynomials and stay within the same bounds.
+    //
+    //   Atan2    |abs error| < 2.5e-6 rad
+    //   Acos     |abs error| < 5.0e-7 rad
+    //   Sin, Cos |abs error| < 3.0e-7 for |x| <= 1000, the range reduction loses precision beyond that
+    //   Log2     |rel error| < 3.0e-7 for normal positive x
+    //   Exp2     |rel error| < 3.0e-7 for x in [-126, 127.5), saturates outside
+    //   Pow      |rel error| < 4.0e-6 for positive normal x and |y * log2(x)| < 64, 0 for x <= 0
+    //
+    // glibc's scalar sinf and powf are table based and about as fast as the scalar forms here, the
+    // gain is over slower CRTs and in the SIMD forms, which evaluate four values for the price of one.
+
+    namespace Detail {
+
+        inline thread_local bool t_Enabled = false;
+
+        // Half away from zero, without the call of std::round
+        inline int RoundToInt(const float x)
+        {
+            return (int)(x + std::copysign(0.5f, x));
+        }
+
+    }
+
+    // Whether RGS::Atan2, Acos, Sin, Cos, Pow and Pow5 use the approximations on this thread.
+    // The renderer sets it from Program::EnableFastMath around the fragment shading of a program.
+    inline bool IsEnabled() { return Detail::t_Enabled; }
+    inline void SetEnabled(const bool enabled) { Detail::t_Enabled = enabled; }
+
+    // Sets the mode of this thread until the end of the scope
+    class Scope
+    {
+    public:
+        Scope(const bool enabled)
+            : m_Previous(Detail::t_Enabled)
+        {
+            Detail::t_Enabled = enabled;
+        }
+        ~Scope() { Detail::t_Enabled = m_Previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        bool m_Previous;
+    };
+
+    // ---------------------------------------------------------------------
+    //                              Scalar
+    // ---------------------------------------------------------------------
+
+    inline float Atan2(const float y, const float x)
+    {
+        const float ax = std::abs(x);
+        const float ay = std::abs(y);
+        const float maxAxis = std::max(ax, ay);
+        if (maxAxis == 0.0f)
+            return 0.0f;
+
+        // atan on [0, 1], minimax polynomial in a^2
+        const float a = std::min(ax, ay) / maxAxis;
+        const float s = a * a;
+        float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+
+        if (ay > ax)
+            r = 0.5f * PI - r;
+        if (x < 0.0f)
+            r = PI - r;
+        return y < 0.0f ? -r : r;
+    }
+
+    inline float Acos(const float x)
+    {
+        // Abramowitz & Stegun 4.4.46
+        const float ax = std::min(std::abs(x), 1.0f);
+        float p = -0.0012624911f;
+        p = p * ax + 0.0066700901f;
+        p = p * ax - 0.0170881256f;
+        p = p * ax + 0.0308918810f;
+        p = p * ax - 0.0501743046f;
+        p = p * ax + 0.0889789874f;
+        p = p * ax - 0.2145988016f;
+        p = p * ax + 1.5707963050f;
+        const float r = std::sqrt(1.0f - ax) * p;
+        return x < 0.0f ? PI - r : r;
+    }
+
+    namespace Detail {
+
+        // 2PI split in a part with few mantissa bits and the rest (Cody & Waite), so that
+        // x - k * TwoPiHigh is exact and the reduction keeps its precision for large x
+        inline constexpr float TwoPiHigh = 6.28125f;
+        inline constexpr float TwoPiLow = 1.9353071795864769e-3f;
+
+        // x to [-PI, PI]
+        inline float ReduceTurns(const float x)
+        {
+            const float turns = (float)RoundToInt(x * (0.5f / PI));
+            return (x - turns * TwoPiHigh) - turns * TwoPiLow;
+        }
+
+        // x in [-PI, PI], folded to [-PI/2, PI/2] with sin(PI - x) = sin(x)
+        inline float SinReduced(float x)
+        {
+            const float folded = std::copysign(PI, x) - x;
+            x = std::abs(x) > 0.5f * PI ? folded : x;
+
+            const float x2 = x * x;
+            return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f + x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+        }
+
+    }
+
+    inline float Sin(const float x)
+    {
+        return Detail::SinReduced(Detail::ReduceTurns(x));
+    }
+
+    inline float Cos(const float x)
+    {
+        // cos(x) = sin(x + PI/2), shifted after the reduction where it costs no precision
+        const float r = Detail::ReduceTurns(x) + 0.5f * PI;
+        return Detail::SinReduced(r > PI ? r - 2.0f * PI : r);
+    }
+
+    inline float Log2(const float x)
+    {
+        // x = m * 2^e with m in [sqrt(2)/2, sqrt(2)), log2(m) = 2/ln2 * atanh((m - 1) / (m + 1))
+        const uint32_t bits = std::bit_cast<uint32_t>(x);
+        int exponent = (int)((bits >> 23) & 0xFFu) - 127;
+        float m = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u);
+        const bool large = m > 1.41421356f;
+        m = large ? m * 0.5f : m;
+        exponent += large ? 1 : 0;
+
+        const float t = (m - 1.0f) / (m + 1.0f);
+        const float t2 = t * t;
+        return (float)exponent + t * (2.88539008f + t2 * (0.961796694f + t2 * (0.577078016f + t2 * 0.412198583f)));
+    }
+
+    inline float Exp2(float x)
+    {
+        // 2^x = 2^n * 2^f with f in [-0.5, 0.5], polynomial from Cephes exp2f
+        x = std::min(std::max(x, -126.0f), 127.49f);
+        const int n = Detail::RoundToInt(x);
+        const float f = x - (float)n;
+        const float p = 1.0f + f * (6.931472028550421e-1f + f * (2.402264791363012e-1f + f * (5.550332471162809e-2f +
+                               f * (9.618437357674640e-3f + f * (1.339887440266574e-3f + f * 1.535336188319500e-4f)))));
+        return p * std::bit_cast<float>((uint32_t)(n + 127) << 23);
+    }
+
+    inline float Pow(const float x, const float y)
+    {
+        return x > 0.0f ? Exp2(y * Log2(x)) : 0.0f;
+    }
+
+    inline float Pow5(const float x)
+    {
+        const float x2 = x * x;
+        return x2 * x2 * x;
+    }
+
+    // ---------------------------------------------------------------------
+    //                                SIMD
+    // ---------------------------------------------------------------------
+#if RGS_SIMD_SSE
+    namespace Detail {
+
+        inline __m128 Select(const __m128 mask, const __m128 a, const __m128 b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        inline __m128 Abs(const __m128 x)
+        {
+            return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+        }
+
+        // Same rounding as RoundToInt (half away from zero)
+        inline __m128i RoundToInt(const __m128 x)
+        {
+            const __m128 half = _mm_or_ps(_mm_and_ps(x, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.5f));
+            return _mm_cvttps_epi32(_mm_add_ps(x, half));
+        }
+
+        inline __m128 Madd(const __m128 a, const __m128 b, const float c)
+        {
+            return _mm_add_ps(_mm_mul_ps(a, b), _mm_set1_ps(c));
+        }
+
+    }
+
+    inline __m128 Atan2(const __m128 y, const __m128 x)
+    {
+        using namespace Detail;
+        const __m128 ax = Abs(x);
+        const __m128 ay = Abs(y);
+        const __m128 maxAxis = _mm_max_ps(ax, ay);
+        // 0 / 0 is NaN, masked to 0 like the scalar early out
+        const __m128 a = _mm_and_ps(_mm_cmpneq_ps(maxAxis, _mm_setzero_ps()), _mm_div_ps(_mm_min_ps(ax, ay), maxAxis));
+        const __m128 s = _mm_mul_ps(a, a);
+
+        __m128 p = _mm_set1_ps(-0.01172120f);
+        p = Madd(p, s, 0.05265332f);
+        p = Madd(p, s, -0.11643287f);
+        p = Madd(p, s, 0.19354346f);
+        p = Madd(p, s, -0.33262347f);
+        p = Madd(p, s, 0.99997726f);
+        __m128 r = _mm_mul_ps(a, p);
+
+        r = Select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(0.5f * PI), r), r);
+        r = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+        return Select(_mm_cmplt_ps(y, _mm_setzero_ps()), _mm_sub_ps(_mm_setzero_ps(), r), r);
+    }
+
+    inline __m128 Acos(const __m128 x)
+    {
+        using namespace Detail;
+        const __m128 ax = _mm_min_ps(Abs(x), _mm_set1_ps(1.0f));
+        __m128 p = _mm_set1_ps(-0.0012624911f);
+        p = Madd(p, ax, 0.0066700901f);
+        p = Madd(p, ax, -0.0170881256f);
+        p = Madd(p, ax, 0.0308918810f);
+        p = Madd(p, ax, -0.0501743046f);
+        p = Madd(p, ax, 0.0889789874f);
+        p = Madd(p, ax, -0.2145988016f);
+        p = Madd(p, ax, 1.5707963050f);
+        const __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), ax)), p);
+        return Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+    }
+
+    namespace Detail {
+
+        inline __m128 ReduceTurns(const __m128 x)
+        {
+            const __m128 turns = _mm_cvtepi32_ps(RoundToInt(_mm_mul_ps(x, _mm_set1_ps(0.5f / PI))));
+            const __m128 high = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TwoPiHigh)));
+            return _mm_sub_ps(high, _mm_mul_ps(turns, _mm_set1_ps(TwoPiLow)));
+        }
+
+        inline __m128 SinReduced(__m128 x)
+        {
+            x = Select(_mm_cmpgt_ps(x, _mm_set1_ps(0.5f * PI)), _mm_sub_ps(_mm_set1_ps(PI), x), x);
+            x = Select(_mm_cmplt_ps(x, _mm_set1_ps(-0.5f * PI)), _mm_sub_ps(_mm_set1_ps(-PI), x), x);
+
+            const __m128 x2 = _mm_mul_ps(x, x);
+            __m128 p = _mm_set1_ps(-2.5052108e-8f);
+            p = Madd(p, x2, 2.7557319e-6f);
+            p = Madd(p, x2, -1.9841270e-4f);
+            p = Madd(p, x2, 8.3333333e-3f);
+            p = Madd(p, x2, -1.6666667e-1f);
+            p = Madd(p, x2, 1.0f);
+            return _mm_mul_ps(x, p);
+        }
+
+    }
+
+    inline __m128 Sin(const __m128 x)
+    {
+        return Detail::SinReduced(Detail::ReduceTurns(x));
+    }
+
+    inline __m128 Cos(const __m128 x)
+    {
+        using namespace Detail;
+        const __m128 r = _mm_add_ps(ReduceTurns(x), _mm_set1_ps(0.5f * PI));
+        return SinReduced(Select(_mm_cmpgt_ps(r, _mm_set1_ps(PI)), _mm_sub_ps(r, _mm_set1_ps(2.0f * PI)), r));
+    }
+
+    inline __m128 Log2(const __m128 x)
+    {
+        using namespace Detail;
+        const __m128i bits = _mm_castps_si128(x);
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)), _mm_set1_epi32(127)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+        const __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+        m = Select(large, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+        exponent = _mm_add_ps(exponent, _mm_and_ps(large, _mm_set1_ps(1.0f)));
+
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+        const __m128 t2 = _mm_mul_ps(t, t);
+        __m128 p = _mm_set1_ps(0.412198583f);
+        p = Madd(p, t2, 0.577078016f);
+        p = Madd(p, t2, 0.961796694f);
+        p = Madd(p, t2, 2.88539008f);
+        return _mm_add_ps(exponent, _mm_mul_ps(t, p));
+    }
+
+    inline __m128 Exp2(__m128 x)
+    {
+        using namespace Detail;
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.49f));
+        const __m128i n = RoundToInt(x);
+        const __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+
+        __m128 p = _mm_set1_ps(1.535336188319500e-4f);
+        p = Madd(p, f, 1.339887440266574e-3f);
+        p = Madd(p, f, 9.618437357674640e-3f);
+        p = Madd(p, f, 5.550332471162809e-2f);
+        p = Madd(p, f, 2.402264791363012e-1f);
+        p = Madd(p, f, 6.931472028550421e-1f);
+        p = Madd(p, f, 1.0f);
+        return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+    }
+
+    inline __m128 Pow(const __m128 x, const __m128 y)
+    {
+        const __m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+        return _mm_and_ps(positive, Exp2(_mm_mul_ps(y, Log2(x))));
+    }
+#endif
+
+    inline Vec3 Pow(const Vec3& v, const float exponent)
+    {
+#if RGS_SIMD_SSE
+        alignas(16) float res[4];
+        _mm_store_ps(res, Pow(_mm_set_ps(0.0f, v.Z, v.Y, v.X), _mm_set1_ps(exponent)));
+        return { res[0], res[1], res[2] };
+#else
+        return { Pow(v.X, exponent), Pow(v.Y, exponent), Pow(v.Z, exponent) };
+#endif
+    }
+
+}
+
+namespace RGS {
+
+    // libm or the FastMath approximation, depending on FastMath::IsEnabled() of the calling thread
+
+    inline float Atan2(const float y, const float x)
+    {
+        return FastMath::IsEnabled() ? FastMath::Atan2(y, x) : std::atan2(y, x);
+    }
+
+    inline float Acos(const float x)
+    {
+        return FastMath::IsEnabled() ? FastMath::Acos(x) : std::acos(x);
+    }
+
+    inline float Sin(const float x)
+    {
+        return FastMath::IsEnabled() ? FastMath::Sin(x) : std::sin(x);
+    }
+
+    inline float Cos(const float x)
+    {
+        return FastMath::IsEnabled() ? FastMath::Cos(x) : std::cos(x);
+    }
+
+    inline float Pow(const float x, const float y)
+    {
+        return FastMath::IsEnabled() ? FastMath::Pow(x, y) : std::pow(x, y);
+    }
+
+    // x^5 for the Fresnel terms
+    inline float Pow5(const float x)
+    {
+        return FastMath::IsEnabled() ? FastMath::Pow5(x) : std::pow(x, 5.0f);
+    }
+
+}
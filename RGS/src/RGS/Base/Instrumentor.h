@@ -1,102 +1,81 @@
 #pragma once
 #include "RGS/Config.h"
+#include "RGS/Platform.h"
 
-#include <sstream>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
-#include <mutex>
-#include <iostream>
-#include <queue>
-#include <condition_variable>
-#include <future>
+#include <vector>
 
 namespace RGS {
 
-    class ThreadPool {
+    // One timed scope, kept binary until the session is written out.
+    struct ProfileEvent
+    {
+        const char* Name;       // Must outlive the session, the macros only pass static strings.
+        uint64_t Start;         // Nanoseconds, steady clock.
+        uint64_t Duration;      // Nanoseconds.
+    };
+
+    // Preallocated ring of events written by a single thread without locks. 
+    // Once full, the oldest events are overwritten so a long capture keeps the most recent ones.
+    // The writer flags each push with SetWriting, so the reader can wait for it to be done with the ring.
+    class ProfileThreadBuffer
+    {
     public:
-        ThreadPool(size_t threadCount) 
-        {
-            for (size_t i = 0; i < threadCount; ++i)
-            {
-                m_Workers.emplace_back([this]()
-                {
-                    for (;;) 
-                    {
-                        std::function<void()> task;
-
-                        {
-                            std::unique_lock<std::mutex> lock(queueMutex);
-                            condition.wait(lock, [this] { return !m_Tasks.empty() || terminate; });
-                            if (terminate && m_Tasks.empty())
-                                return;
-                            task = std::move(m_Tasks.front());
-                            m_Tasks.pop();
-                        }
-
-                        task();
-                    }
-                });
-            }
-        }
+        ProfileThreadBuffer(uint32_t threadID, uint32_t capacity)
+            : m_ThreadID(threadID), m_Events(capacity) {}
 
-        ~ThreadPool() 
+        void Push(const ProfileEvent& event)
         {
-            {
-                std::unique_lock<std::mutex> lock(queueMutex);
-                terminate = true;
-            }
-            condition.notify_all();
-            for (std::thread& worker : m_Workers)
-                worker.join();
+            const uint64_t head = m_Head.load(std::memory_order_relaxed);
+            m_Events[head % m_Events.size()] = event;
+            m_Head.store(head + 1, std::memory_order_release);
         }
 
-        template<typename F, typename... Args>
-        auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type> 
-        {
-            using return_type = typename std::result_of<F(Args...)>::type;
-
-            auto task = std::make_shared<std::packaged_task<return_type()>>(
-                std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-            );
+        // Only meant to be called while the owning thread doesn't record (e.g. between sessions).
+        void Clear() { m_Head.store(0, std::memory_order_relaxed); }
 
-            std::future<return_type> res = task->get_future();
-            {
-                std::unique_lock<std::mutex> lock(queueMutex);
+        // Sequentially consistent, together with the recording flag of the Instrumentor either the writer sees
+        // the session stopped or the reader sees the write in progress.
+        void SetWriting(bool writing) { m_Writing.store(writing); }
+        bool IsWriting() const { return m_Writing.load(); }
 
-                if (terminate)
-                    throw std::runtime_error("enqueue on stopped ThreadPool");
+        // Number of events pushed so far, the events below it are visible to the thread that read it.
+        uint64_t GetHead() const { return m_Head.load(std::memory_order_acquire); }
+        uint64_t GetCount(uint64_t head) const { return std::min<uint64_t>(head, m_Events.size()); }
 
-                m_Tasks.emplace([task]() { (*task)(); });
-            }
-            condition.notify_one();
-            return res;
+        // i-th of the events retained at head, oldest first.
+        const ProfileEvent& GetEvent(uint64_t head, uint64_t i) const 
+        {
+            const uint64_t first = head - GetCount(head);
+            return m_Events[(first + i) % m_Events.size()];
         }
 
-    private:
-        std::vector<std::thread> m_Workers;
-        std::queue<std::function<void()>> m_Tasks;
-
-        std::mutex queueMutex;
-        std::condition_variable condition;
-        bool terminate = false;
-    };
+        // OS id of the owning thread
+        uint32_t GetThreadID() const { return m_ThreadID; }
+        const std::string& GetThreadName() const { return m_ThreadName; }
+        void SetThreadName(const std::string& name) { m_ThreadName = name; }
 
-
-    using FloatingPointMicroseconds = std::chrono::duration<double, std::micro>;
-
-    struct ProfileResult {
-        std::string Name;
-        FloatingPointMicroseconds Start;
-        std::chrono::microseconds ElapsedTime;
-       // std::thread::id ThreadID;
+    private:
+        uint32_t m_ThreadID;
+        std::string m_ThreadName;
+        std::vector<ProfileEvent> m_Events;
+        std::atomic<uint64_t> m_Head{ 0 };
+        std::atomic<bool> m_Writing{ false };
     };
 
     struct InstrumentationSession {
         std::string Name;
+        std::string Filepath;
+        uint64_t StartTime;
     };
 
     class Instrumentor
@@ -105,6 +84,11 @@ namespace RGS {
         Instrumentor(const Instrumentor&) = delete;
         Instrumentor(Instrumentor&&) = delete;
 
+        static uint64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
         void BeginSession(const std::string& name, const std::string& filepath = "results.json")
         {
             std::lock_guard lock(m_Mutex);
@@ -112,17 +96,12 @@ namespace RGS {
             {
                 InternalEndSession();
             }
-            m_OutputStream.open(filepath);
 
-            if (m_OutputStream.is_open()) 
-            {
-                m_CurrentSession = new InstrumentationSession({ name });
-                WriteHeader();
-            }
-            else 
-            {
-                std::cout << "Instrumentor could not open results file.";
-            }
+            for (auto& buffer : m_ThreadBuffers)
+                buffer->Clear();
+
+            m_CurrentSession = new InstrumentationSession({ name, filepath, Now() });
+            m_Recording.store(true, std::memory_order_release);
         }
 
         void EndSession() 
@@ -131,32 +110,25 @@ namespace RGS {
             InternalEndSession();
         }
 
-        void WriteProfileImpl(const ProfileResult& result) 
+        // Called from any thread, lock-free after the first event of that thread.
+        void WriteProfile(const char* name, uint64_t start, uint64_t end)
         {
-            std::stringstream json;
-
-            json << std::setprecision(3) << std::fixed;
-            json << ",{";
-            json << "\"cat\":\"function\",";
-            json << "\"dur\":" << (result.ElapsedTime.count()) << ',';
-            json << "\"name\":\"" << result.Name << "\",";
-            json << "\"ph\":\"X\",";
-            json << "\"pid\":0,";
-            json << "\"tid\": 0,";  // << result.ThreadID << ",";
-            json << "\"ts\":" << result.Start.count();
-            json << "}";
-
-            std::lock_guard lock(m_Mutex);
-            if (m_CurrentSession) 
-            {
-                m_OutputStream << json.str();
-                m_OutputStream.flush();
-            }
+            if (!m_Recording.load(std::memory_order_relaxed))
+                return;
+
+            // The session may have stopped since the check above, look again once the write is announced
+            ProfileThreadBuffer& buffer = GetThreadBuffer();
+            buffer.SetWriting(true);
+            if (m_Recording.load())
+                buffer.Push({ name, start, end - start });
+            buffer.SetWriting(false);
         }
 
-        void WriteProfile(const ProfileResult& result)
+        // Name shown for the calling thread in the trace viewer.
+        void SetThreadName(const std::string& name)
         {
-            m_ThreadPool.enqueue(std::bind(&Instrumentor::WriteProfileImpl, this, result));
+            std::lock_guard lock(m_Mutex);
+            GetThreadBuffer().SetThreadName(name);
         }
 
         static Instrumentor& Instance() 
@@ -167,31 +139,100 @@ namespace RGS {
 
     private:
         Instrumentor()
-            : m_CurrentSession(nullptr), m_ThreadPool(std::thread::hardware_concurrency()) {}
+            : m_CurrentSession(nullptr) {}
 
         ~Instrumentor() 
         {
             EndSession();
         }
 
-        void WriteHeader()
+        ProfileThreadBuffer& GetThreadBuffer()
+        {
+            // The registry keeps the buffer alive, so events of threads that already exited are still written out
+            thread_local ProfileThreadBuffer* buffer = RegisterThread();
+            return *buffer;
+        }
+
+        ProfileThreadBuffer* RegisterThread()
+        {
+            std::lock_guard lock(m_RegistryMutex);
+            m_ThreadBuffers.push_back(std::make_shared<ProfileThreadBuffer>(Platform::GetCurrentThreadID(), Config::ProfileBufferCapacity));
+            return m_ThreadBuffers.back().get();
+        }
+
+        // Converts the recorded events into the Chrome tracing JSON format (chrome://tracing, Perfetto).
+        void WriteSession()
         {
-            m_OutputStream << "{\"otherData\": {},\"traceEvents\":[{}";
-            m_OutputStream.flush();
+            std::ofstream outputStream(m_CurrentSession->Filepath);
+            if (!outputStream.is_open())
+            {
+                std::cout << "Instrumentor could not open results file." << std::endl;
+                return;
+            }
+
+            std::lock_guard lock(m_RegistryMutex);
+            outputStream << std::setprecision(3) << std::fixed;
+            outputStream << "{\"otherData\": {},\"traceEvents\":[{}";
+
+            uint64_t overwritten = 0;
+            for (const auto& buffer : m_ThreadBuffers)
+            {
+                if (!buffer->GetThreadName().empty())
+                {
+                    outputStream << ",{";
+                    outputStream << "\"name\":\"thread_name\",";
+                    outputStream << "\"ph\":\"M\",";
+                    outputStream << "\"pid\":0,";
+                    outputStream << "\"tid\":" << buffer->GetThreadID() << ',';
+                    outputStream << "\"args\":{\"name\":\"" << buffer->GetThreadName() << "\"}";
+                    outputStream << "}";
+                }
+
+                const uint64_t head = buffer->GetHead();
+                const uint64_t count = buffer->GetCount(head);
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    const ProfileEvent& event = buffer->GetEvent(head, i);
+                    if (event.Start < m_CurrentSession->StartTime)
+                        continue;
+
+                    outputStream << ",{";
+                    outputStream << "\"cat\":\"function\",";
+                    outputStream << "\"dur\":" << event.Duration * 1e-3 << ',';
+                    outputStream << "\"name\":\"" << event.Name << "\",";
+                    outputStream << "\"ph\":\"X\",";
+                    outputStream << "\"pid\":0,";
+                    outputStream << "\"tid\":" << buffer->GetThreadID() << ',';
+                    outputStream << "\"ts\":" << (event.Start - m_CurrentSession->StartTime) * 1e-3;
+                    outputStream << "}";
+                }
+                overwritten += head - count;
+            }
+
+            outputStream << "]}";
+            if (overwritten > 0)
+                std::cout << "Instrumentor: " << overwritten << " events were overwritten, consider a larger Config::ProfileBufferCapacity." << std::endl;
         }
 
-        void WriteFooter() 
+        // Once recording has stopped, no push starts anymore. Waits for those already started so the rings
+        // are read only after their last write.
+        void WaitForWriters()
         {
-            m_OutputStream << "]}";
-            m_OutputStream.flush();
+            std::lock_guard lock(m_RegistryMutex);
+            for (const auto& buffer : m_ThreadBuffers)
+            {
+                while (buffer->IsWriting())
+                    std::this_thread::yield();
+            }
         }
 
         void InternalEndSession() 
         {
             if (m_CurrentSession) 
             {
-                WriteFooter();
-                m_OutputStream.close();
+                m_Recording.store(false);
+                WaitForWriters();
+                WriteSession();
                 delete m_CurrentSession;
                 m_CurrentSession = nullptr;
             }
@@ -200,8 +241,10 @@ namespace RGS {
     private:
         std::mutex m_Mutex;
         InstrumentationSession* m_CurrentSession;
-        std::ofstream m_OutputStream;
-        ThreadPool m_ThreadPool;  // ThreadPool member for handling tasks
+        std::atomic<bool> m_Recording{ false };
+
+        std::mutex m_RegistryMutex;
+        std::vector<std::shared_ptr<ProfileThreadBuffer>> m_ThreadBuffers;
     };
 
     class InstrumentationTimer
@@ -210,22 +253,17 @@ namespace RGS {
         InstrumentationTimer(const char* name)
             : m_Name(name) 
         {
-            m_StartTimepoint = std::chrono::steady_clock::now();
+            m_StartTimepoint = Instrumentor::Now();
         }
 
         ~InstrumentationTimer() 
         {
-            auto endTimepoint = std::chrono::steady_clock::now();
-            auto highResStart = FloatingPointMicroseconds{ m_StartTimepoint.time_since_epoch() };
-            auto elapsedTime = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch() -
-                std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch();
-
-            Instrumentor::Instance().WriteProfile({ m_Name, highResStart, elapsedTime});
+            Instrumentor::Instance().WriteProfile(m_Name, m_StartTimepoint, Instrumentor::Now());
         }
 
     private:
         const char* m_Name;
-        std::chrono::time_point<std::chrono::steady_clock> m_StartTimepoint;
+        uint64_t m_StartTimepoint;
     };
 
     namespace InstrumentorUtils {
@@ -272,14 +310,17 @@ namespace RGS {
 
 #define RGS_PROFILE_BEGIN_SESSION(name, filepath) ::RGS::Instrumentor::Instance().BeginSession(name, filepath)
 #define RGS_PROFILE_END_SESSION() ::RGS::Instrumentor::Instance().EndSession()
-#define RGS_PROFILE_SCOPE_LINE2(name, line) constexpr auto fixedName##line = ::RGS::InstrumentorUtils::CleanupOutputString(name, "__cdecl ");\
+// The cleaned up name is static, the trace buffers keep the pointer until the session is written out
+#define RGS_PROFILE_SCOPE_LINE2(name, line) static constexpr auto fixedName##line = ::RGS::InstrumentorUtils::CleanupOutputString(name, "__cdecl ");\
                                                    ::RGS::InstrumentationTimer timer##line(fixedName##line.Data)
 #define RGS_PROFILE_SCOPE_LINE(name, line) RGS_PROFILE_SCOPE_LINE2(name, line)
 #define RGS_PROFILE_SCOPE(name) RGS_PROFILE_SCOPE_LINE(name, __LINE__)
 #define RGS_PROFILE_FUNCTION() RGS_PROFILE_SCOPE(RGS_FUNC_SIG)
+#define RGS_PROFILE_THREAD(name) ::RGS::Instrumentor::Instance().SetThreadName(name)
 #else
 #define RGS_PROFILE_BEGIN_SESSION(name, filepath)
 #define RGS_PROFILE_END_SESSION()
 #define RGS_PROFILE_SCOPE(name)
 #define RGS_PROFILE_FUNCTION()
+#define RGS_PROFILE_THREAD(name)
 #endif
\ No newline at end of file
@@ -1,155 +1,72 @@
 #include "Maths.h"
+#include "FastMath.h"
 #include "RGS/Base/Base.h"
 
 #include <cmath>
+#if RGS_SIMD_AVX
+    #include <immintrin.h>
+#endif
 
 namespace RGS {
 
-    Mat4::Mat4(const Vec4& v0, const Vec4& v1, const Vec4& v2, const Vec4& v3)
-    {
-        M[0][0] = v0.X; M[1][0] = v0.Y; M[2][0] = v0.Z; M[3][0] = v0.W;
-        M[0][1] = v1.X; M[1][1] = v1.Y; M[2][1] = v1.Z; M[3][1] = v1.W;
-        M[0][2] = v2.X; M[1][2] = v2.Y; M[2][2] = v2.Z; M[3][2] = v2.W;
-        M[0][3] = v3.X; M[1][3] = v3.Y; M[2][3] = v3.Z; M[3][3] = v3.W;
-    }
-
-    Vec2 operator+ (const Vec2& left, const Vec2& right)
-    {
-        return Vec2{ left.X + right.X, left.Y + right.Y };
-    }
-    Vec2 operator- (const Vec2& left, const Vec2& right)
-    {
-        return Vec2{ left.X - right.X, left.Y - right.Y };
-    }
-
-    Vec3 operator+ (const Vec3& left, const Vec3& right)
-    {
-        return Vec3{ left.X + right.X, left.Y + right.Y, left.Z + right.Z };
-    }
-    Vec3 operator- (const Vec3& left, const Vec3& right)
-    {
-        return left + (-1.0f * right);
-    }
-    Vec3 operator* (const float left, const Vec3& right)
-    {
-        return Vec3{ left * right.X, left * right.Y, left * right.Z };
-    }
-    Vec3 operator* (const Vec3& left, const float right)
-    {
-        return right * left;
-    }
-    Vec3 operator* (const Vec3& left, const Vec3& right)
-    {
-        return { left.X * right.X, left.Y * right.Y, left.Z * right.Z };
-    }
-    Vec3 operator/ (const Vec3& left, const float right)
-    {
-        ASSERT((right != 0));
-        return left * (1.0f / right);
-    }
-    Vec3 operator/ (const Vec3& left, const Vec3& right)
-    {
-        ASSERT((right.X != 0) && (right.Y != 0) && (right.Z != 0));
-        return left * Vec3{ 1.0f / right.X, 1.0f / right.Y, 1.0f / right.Z };
-    }
-    Vec3& operator*= (Vec3& left, const float right)
-    {
-        left = left * right;
-        return left;
-    }
-    Vec3& operator/= (Vec3& left, const float right)
-    {
-        ASSERT((right != 0));
-        left = left / right;
-        return left;
-    }
-    Vec3& operator+= (Vec3& left, const Vec3& right)
-    {
-        left = left + right;
-        return left;
-    }
-    Vec3 Cross(const Vec3& left, const Vec3& right)
-    {
-        float x = left.Y * right.Z - left.Z * right.Y;
-        float y = left.Z * right.X - left.X * right.Z;
-        float z = left.X * right.Y - left.Y * right.X;
-        return { x, y, z };
-    }
-    float Dot(const Vec3& left, const Vec3& right)
-    {
-        return left.X * right.X + left.Y * right.Y + left.Z * right.Z;
-    }
-
-    Vec4 operator+ (const Vec4& left, const Vec4& right)
-    {
-        return Vec4{ left.X + right.X, left.Y + right.Y, left.Z + right.Z, left.W + right.W };
-    }
-    Vec4 operator- (const Vec4& left, const Vec4& right)
-    {
-        return Vec4{ left.X - right.X, left.Y - right.Y, left.Z - right.Z, left.W - right.W };
-    }
-    Vec4 operator* (const float left, const Vec4& right)
-    {
-        return Vec4{ left * right.X, left * right.Y, left * right.Z, left * right.W };
-    }
-    Vec4 operator* (const Vec4& left, const float right)
-    {
-        return right * left;
-    }
-    Vec4 operator/ (const Vec4& left, const float right)
-    {
-        ASSERT(right != 0);
-        return left * (1.0f / right);
-    }
+#if RGS_SIMD_SSE
+    namespace SIMD {
 
-    Vec4& operator+= (Vec4& left, const Vec4& right)
-    {
-        left.X += right.X;
-        left.Y += right.Y;
-        left.Z += right.Z;
-        left.W += right.W;
-        return left;
-    }
+        // Columns of a row-major matrix, so that M * v is a sum of scaled columns
+        static void LoadColumns(const Mat4& mat4, __m128(&columns)[4])
+        {
+            columns[0] = _mm_load_ps(mat4.M[0]);
+            columns[1] = _mm_load_ps(mat4.M[1]);
+            columns[2] = _mm_load_ps(mat4.M[2]);
+            columns[3] = _mm_load_ps(mat4.M[3]);
+            _MM_TRANSPOSE4_PS(columns[0], columns[1], columns[2], columns[3]);
+        }
 
-    Vec4& operator-= (Vec4& left, const Vec4& right)
-    {
-        left.X -= right.X;
-        left.Y -= right.Y;
-        left.Z -= right.Z;
-        left.W -= right.W;
-        return left;
-    }
+        static __m128 Transform(const __m128(&columns)[4], const __m128 v)
+        {
+            __m128 res = _mm_mul_ps(columns[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+            res = _mm_add_ps(res, _mm_mul_ps(columns[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+            res = _mm_add_ps(res, _mm_mul_ps(columns[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+            res = _mm_add_ps(res, _mm_mul_ps(columns[3], _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+            return res;
+        }
 
-    Vec4 operator* (const Mat4& mat4, const Vec4& vec4)
-    {
-        Vec4 res;
-        res.X = mat4.M[0][0] * vec4.X + mat4.M[0][1] * vec4.Y + mat4.M[0][2] * vec4.Z + mat4.M[0][3] * vec4.W;
-        res.Y = mat4.M[1][0] * vec4.X + mat4.M[1][1] * vec4.Y + mat4.M[1][2] * vec4.Z + mat4.M[1][3] * vec4.W;
-        res.Z = mat4.M[2][0] * vec4.X + mat4.M[2][1] * vec4.Y + mat4.M[2][2] * vec4.Z + mat4.M[2][3] * vec4.W;
-        res.W = mat4.M[3][0] * vec4.X + mat4.M[3][1] * vec4.Y + mat4.M[3][2] * vec4.Z + mat4.M[3][3] * vec4.W;
-        return res;
     }
+#endif
 
-    Mat4 operator* (const Mat4& left, const Mat4& right)
+    void TransformPoints(const Mat4& mat4, const Vec4* in, Vec4* out, const size_t count)
     {
-        Mat4 res;
-        for (int i = 0; i < 4; i++)
+        size_t i = 0;
+#if RGS_SIMD_SSE
+        __m128 columns[4];
+        SIMD::LoadColumns(mat4, columns);
+#if RGS_SIMD_AVX
+        // Two points per iteration, every 128-bit lane holds one point and a copy of the columns
+        const __m256 columns2[4] = {
+            _mm256_insertf128_ps(_mm256_castps128_ps256(columns[0]), columns[0], 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(columns[1]), columns[1], 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(columns[2]), columns[2], 1),
+            _mm256_insertf128_ps(_mm256_castps128_ps256(columns[3]), columns[3], 1) };
+        for (; i + 2 <= count; i += 2)
         {
-            for (int j = 0; j < 4; j++)
-            {
-                for (int k = 0; k < 4; k++)
-                {
-                    res.M[i][j] += left.M[i][k] * right.M[k][j];
-                }
-            }
+            const __m256 v = _mm256_loadu_ps(&in[i].X);
+            __m256 res = _mm256_mul_ps(columns2[0], _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+            res = _mm256_add_ps(res, _mm256_mul_ps(columns2[1], _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+            res = _mm256_add_ps(res, _mm256_mul_ps(columns2[2], _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+            res = _mm256_add_ps(res, _mm256_mul_ps(columns2[3], _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm256_storeu_ps(&out[i].X, res);
         }
-        return res;
-    }
-
-    Mat4& operator*= (Mat4& left, const Mat4& right)
-    {
-        left = left * right;
-        return left;
+#endif
+        for (; i < count; ++i)
+        {
+            _mm_store_ps(&out[i].X, SIMD::Transform(columns, _mm_load_ps(&in[i].X)));
+        }
+#else
+        for (; i < count; ++i)
+        {
+            out[i] = mat4 * in[i];
+        }
+#endif
     }
 
     Mat4 Mat4Scale(const float sx, const float sy, const float sz)
@@ -266,46 +183,11 @@ namespace RGS {
         return m;
     }
 
-    Vec3 Normalize(const Vec3& v)
-    {
-        float len = (float)std::sqrt(v.X * v.X + v.Y * v.Y + v.Z * v.Z);
-        ASSERT((len != 0));
-        return v / len;
-    }
-
-    Vec3 Reflect(const Vec3& in, const Vec3& normal)
-    {
-        return -2 * Dot(in, normal) * normal + in;
-    }
-
-    float Clamp(const float val, const float min, const float max)
-    {
-        return std::max(min, std::min(val, max));
-    }
-
-    Vec3 Clamp(const Vec3& vec, const float min, const float max)
-    {
-        return Vec3
-        {
-            std::max(min, std::min(vec.X, max)),
-            std::max(min, std::min(vec.Y, max)),
-            std::max(min, std::min(vec.Z, max))
-        };
-    }
-
-    Vec4 Clamp(const Vec4& vec, const float min, const float max)
-    {
-        return Vec4
-        {
-            std::max(min, std::min(vec.X, max)),
-            std::max(min, std::min(vec.Y, max)),
-            std::max(min, std::min(vec.Z, max)),
-            std::max(min, std::min(vec.W, max))
-        };
-    }
-
     Vec3 Pow(const Vec3& vec, const float exponent)
     {
+        if (FastMath::IsEnabled())
+            return FastMath::Pow(vec, exponent);
+
         return Vec3
         {
             std::pow(vec.X, exponent),
@@ -314,44 +196,4 @@ namespace RGS {
         };
     }
 
-    float Length(const Vec3& v)
-    {
-        return (float)std::sqrt(v.X * v.X + v.Y * v.Y + v.Z * v.Z);
-    }
-
-    float Lerp(const float start, const float end, const float t)
-    {
-        return end * t + start * (1.0f - t);
-    }
-
-    Vec3 Lerp(const Vec3& start, const Vec3& end, const float t)
-    {
-        return end * t + start * (1.0f - t);
-    }
-
-    Vec4 Lerp(const Vec4& start, const Vec4& end, const float t)
-    {
-        return end * t + start * (1.0f - t);
-    }
-
-    unsigned char Float2UChar(const float f)
-    {
-        return static_cast<unsigned char>(f * 255.0f + 0.5f);
-    }
-
-    float UChar2Float(const unsigned char c)
-    {
-        return (float)c / 255.0f;
-    }
-
-    float Max(const float right, const float left)
-    {
-        return std::max<float>(right, left);
-    }
-
-    float Min(const float right, const float left)
-    {
-        return std::min<float>(right, left);
-    }
-
 }
\ No newline at end of file
@@ -1,9 +1,30 @@
 #pragma once
+#include "RGS/Config.h"
+#include "RGS/Base/Base.h"
+
 #include <cmath>
+#include <cstddef>
 #include <string>
 #include <iostream>
 #include <algorithm>
 
+// SSE is part of every x64 target, AVX only when the compiler is allowed to use it (RGS_ENABLE_AVX).
+// Single vector ops stay scalar: once inlined the compiler keeps them in registers and vectorizes loops over
+// them, which measured faster than per call SSE. Matrix products and batches use SIMD, doing the same
+// operations in the same order as the scalar code so the results are identical.
+#if RGS_ENABLE_SIMD && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define RGS_SIMD_SSE 1
+    #include <emmintrin.h>
+#else
+    #define RGS_SIMD_SSE 0
+#endif
+
+#if RGS_SIMD_SSE && defined(__AVX__)
+    #define RGS_SIMD_AVX 1
+#else
+    #define RGS_SIMD_AVX 0
+#endif
+
 namespace RGS {
 
     constexpr float PI = 3.14159265359f;
@@ -53,7 +74,8 @@ namespace RGS {
         }
     };
 
-    struct Vec4
+    // 16-byte aligned so that it loads into a single SSE register
+    struct alignas(16) Vec4
     {
         float X, Y, Z, W;
 
@@ -82,7 +104,7 @@ namespace RGS {
     };
 
     // 按行优先存储，第一列向量为 [0][0] [0][1] [0][2] [0][3] <=> 0, 4, 8, 12
-    struct Mat4
+    struct alignas(16) Mat4
     {
         float M[4][4];
 
@@ -115,37 +137,183 @@ namespace RGS {
         }
     };
 
-    Vec2 operator+ (const Vec2& left, const Vec2& right);
-    Vec2 operator- (const Vec2& left, const Vec2& right);
-
-    Vec3 operator+ (const Vec3& left, const Vec3& right);
-    Vec3 operator- (const Vec3& left, const Vec3& right);
-    Vec3 operator* (const float left, const Vec3& right);
-    Vec3 operator* (const Vec3& left, const float right);
-    Vec3 operator* (const Vec3& left, const Vec3& right);
-    Vec3 operator/ (const Vec3& left, const float right);
-    Vec3 operator/ (const Vec3& left, const Vec3& right);
-    Vec3& operator*= (Vec3& left, const float right);
-    Vec3& operator/= (Vec3& left, const float right);
-    Vec3& operator+= (Vec3& left, const Vec3& right);
-
-    float Dot(const Vec3& left, const Vec3& right);
-    Vec3 Cross(const Vec3& left, const Vec3& right);
-    Vec3 Normalize(const Vec3&);
-    Vec3 Reflect(const Vec3& in, const Vec3& normal);
-
-    Vec4 operator+ (const Vec4& left, const Vec4& right);
-    Vec4 operator- (const Vec4& left, const Vec4& right);
-    Vec4 operator* (const float left, const Vec4& right);
-    Vec4 operator* (const Vec4& left, const float right);
-    Vec4 operator/ (const Vec4& left, const float right);
-
-    Vec4& operator+= (Vec4& left, const Vec4& right);
-    Vec4& operator-= (Vec4& left, const Vec4& right);
-
-    Vec4 operator* (const Mat4& mat4, const Vec4& vec4);
-    Mat4 operator* (const Mat4& left, const Mat4& right);
-    Mat4& operator*= (Mat4& left, const Mat4& right);
+    inline Mat4::Mat4(const Vec4& v0, const Vec4& v1, const Vec4& v2, const Vec4& v3)
+    {
+        M[0][0] = v0.X; M[1][0] = v0.Y; M[2][0] = v0.Z; M[3][0] = v0.W;
+        M[0][1] = v1.X; M[1][1] = v1.Y; M[2][1] = v1.Z; M[3][1] = v1.W;
+        M[0][2] = v2.X; M[1][2] = v2.Y; M[2][2] = v2.Z; M[3][2] = v2.W;
+        M[0][3] = v3.X; M[1][3] = v3.Y; M[2][3] = v3.Z; M[3][3] = v3.W;
+    }
+
+    inline Vec2 operator+ (const Vec2& left, const Vec2& right)
+    {
+        return Vec2{ left.X + right.X, left.Y + right.Y };
+    }
+    inline Vec2 operator- (const Vec2& left, const Vec2& right)
+    {
+        return Vec2{ left.X - right.X, left.Y - right.Y };
+    }
+
+    inline Vec3 operator+ (const Vec3& left, const Vec3& right)
+    {
+        return Vec3{ left.X + right.X, left.Y + right.Y, left.Z + right.Z };
+    }
+    inline Vec3 operator- (const Vec3& left, const Vec3& right)
+    {
+        return Vec3{ left.X - right.X, left.Y - right.Y, left.Z - right.Z };
+    }
+    inline Vec3 operator* (const float left, const Vec3& right)
+    {
+        return Vec3{ left * right.X, left * right.Y, left * right.Z };
+    }
+    inline Vec3 operator* (const Vec3& left, const float right)
+    {
+        return Vec3{ left.X * right, left.Y * right, left.Z * right };
+    }
+    inline Vec3 operator* (const Vec3& left, const Vec3& right)
+    {
+        return Vec3{ left.X * right.X, left.Y * right.Y, left.Z * right.Z };
+    }
+    // Divisions multiply by the reciprocal
+    inline Vec3 operator/ (const Vec3& left, const float right)
+    {
+        ASSERT((right != 0));
+        return left * (1.0f / right);
+    }
+    inline Vec3 operator/ (const Vec3& left, const Vec3& right)
+    {
+        ASSERT((right.X != 0) && (right.Y != 0) && (right.Z != 0));
+        return left * Vec3{ 1.0f / right.X, 1.0f / right.Y, 1.0f / right.Z };
+    }
+    inline Vec3& operator*= (Vec3& left, const float right)
+    {
+        left = left * right;
+        return left;
+    }
+    inline Vec3& operator/= (Vec3& left, const float right)
+    {
+        left = left / right;
+        return left;
+    }
+    inline Vec3& operator+= (Vec3& left, const Vec3& right)
+    {
+        left = left + right;
+        return left;
+    }
+
+    inline float Dot(const Vec3& left, const Vec3& right)
+    {
+        return left.X * right.X + left.Y * right.Y + left.Z * right.Z;
+    }
+    inline Vec3 Cross(const Vec3& left, const Vec3& right)
+    {
+        float x = left.Y * right.Z - left.Z * right.Y;
+        float y = left.Z * right.X - left.X * right.Z;
+        float z = left.X * right.Y - left.Y * right.X;
+        return { x, y, z };
+    }
+    inline float Length(const Vec3& v)
+    {
+        return (float)std::sqrt(v.X * v.X + v.Y * v.Y + v.Z * v.Z);
+    }
+    inline Vec3 Normalize(const Vec3& v)
+    {
+        float len = Length(v);
+        ASSERT((len != 0));
+        return v / len;
+    }
+    inline Vec3 Reflect(const Vec3& in, const Vec3& normal)
+    {
+        return -2 * Dot(in, normal) * normal + in;
+    }
+
+    inline Vec4 operator+ (const Vec4& left, const Vec4& right)
+    {
+        return Vec4{ left.X + right.X, left.Y + right.Y, left.Z + right.Z, left.W + right.W };
+    }
+    inline Vec4 operator- (const Vec4& left, const Vec4& right)
+    {
+        return Vec4{ left.X - right.X, left.Y - right.Y, left.Z - right.Z, left.W - right.W };
+    }
+    inline Vec4 operator* (const float left, const Vec4& right)
+    {
+        return Vec4{ left * right.X, left * right.Y, left * right.Z, left * right.W };
+    }
+    inline Vec4 operator* (const Vec4& left, const float right)
+    {
+        return right * left;
+    }
+    inline Vec4 operator/ (const Vec4& left, const float right)
+    {
+        ASSERT(right != 0);
+        return left * (1.0f / right);
+    }
+
+    inline Vec4& operator+= (Vec4& left, const Vec4& right)
+    {
+        left = left + right;
+        return left;
+    }
+    inline Vec4& operator-= (Vec4& left, const Vec4& right)
+    {
+        left = left - right;
+        return left;
+    }
+
+    inline Vec4 operator* (const Mat4& mat4, const Vec4& vec4)
+    {
+        Vec4 res;
+        res.X = mat4.M[0][0] * vec4.X + mat4.M[0][1] * vec4.Y + mat4.M[0][2] * vec4.Z + mat4.M[0][3] * vec4.W;
+        res.Y = mat4.M[1][0] * vec4.X + mat4.M[1][1] * vec4.Y + mat4.M[1][2] * vec4.Z + mat4.M[1][3] * vec4.W;
+        res.Z = mat4.M[2][0] * vec4.X + mat4.M[2][1] * vec4.Y + mat4.M[2][2] * vec4.Z + mat4.M[2][3] * vec4.W;
+        res.W = mat4.M[3][0] * vec4.X + mat4.M[3][1] * vec4.Y + mat4.M[3][2] * vec4.Z + mat4.M[3][3] * vec4.W;
+        return res;
+    }
+
+    // mat4 * (point, 1), skips building the Vec4
+    inline Vec4 TransformPoint(const Mat4& mat4, const Vec3& point)
+    {
+        Vec4 res;
+        res.X = mat4.M[0][0] * point.X + mat4.M[0][1] * point.Y + mat4.M[0][2] * point.Z + mat4.M[0][3];
+        res.Y = mat4.M[1][0] * point.X + mat4.M[1][1] * point.Y + mat4.M[1][2] * point.Z + mat4.M[1][3];
+        res.Z = mat4.M[2][0] * point.X + mat4.M[2][1] * point.Y + mat4.M[2][2] * point.Z + mat4.M[2][3];
+        res.W = mat4.M[3][0] * point.X + mat4.M[3][1] * point.Y + mat4.M[3][2] * point.Z + mat4.M[3][3];
+        return res;
+    }
+
+    // out[i] = mat4 * in[i], the matrix is transposed into registers once for the whole batch. in and out may alias.
+    void TransformPoints(const Mat4& mat4, const Vec4* in, Vec4* out, const size_t count);
+
+    inline Mat4 operator* (const Mat4& left, const Mat4& right)
+    {
+        Mat4 res;
+#if RGS_SIMD_SSE
+        const __m128 rows[4] = { _mm_load_ps(right.M[0]), _mm_load_ps(right.M[1]), _mm_load_ps(right.M[2]), _mm_load_ps(right.M[3]) };
+        for (int i = 0; i < 4; i++)
+        {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(left.M[i][0]), rows[0]);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left.M[i][1]), rows[1]));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left.M[i][2]), rows[2]));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(left.M[i][3]), rows[3]));
+            _mm_store_ps(res.M[i], row);
+        }
+#else
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                res.M[i][j] = left.M[i][0] * right.M[0][j] + left.M[i][1] * right.M[1][j] +
+                              left.M[i][2] * right.M[2][j] + left.M[i][3] * right.M[3][j];
+            }
+        }
+#endif
+        return res;
+    }
+    inline Mat4& operator*= (Mat4& left, const Mat4& right)
+    {
+        left = left * right;
+        return left;
+    }
 
     Mat4 Mat4Scale(const float sx, const float sy, const float sz);
     Mat4 Mat4RotateX(const float angle);
@@ -164,21 +332,60 @@ namespace RGS {
     Mat4 Mat4Perspective(const float fovy, const float aspect, const float near, const float far);
     Mat4 Mat4LookAt(const Vec3& eye, const Vec3& target, const Vec3& up);
 
-    float Lerp(const float start, const float end, const float t);
-    Vec3 Lerp(const Vec3& start, const Vec3& end, const float t);
-    Vec4 Lerp(const Vec4& start, const Vec4& end, const float t);
+    inline float Lerp(const float start, const float end, const float t)
+    {
+        return end * t + start * (1.0f - t);
+    }
+    inline Vec3 Lerp(const Vec3& start, const Vec3& end, const float t)
+    {
+        return end * t + start * (1.0f - t);
+    }
+    inline Vec4 Lerp(const Vec4& start, const Vec4& end, const float t)
+    {
+        return end * t + start * (1.0f - t);
+    }
 
-    float Clamp(const float in, const float min, const float max);
-    Vec3 Clamp(const Vec3& vec, const float min, const float max);
-    Vec4 Clamp(const Vec4& vec, const float min, const float max);
+    inline float Clamp(const float val, const float min, const float max)
+    {
+        return std::max(min, std::min(val, max));
+    }
+    inline Vec3 Clamp(const Vec3& vec, const float min, const float max)
+    {
+        return Vec3
+        {
+            std::max(min, std::min(vec.X, max)),
+            std::max(min, std::min(vec.Y, max)),
+            std::max(min, std::min(vec.Z, max))
+        };
+    }
+    inline Vec4 Clamp(const Vec4& vec, const float min, const float max)
+    {
+        return Vec4
+        {
+            std::max(min, std::min(vec.X, max)),
+            std::max(min, std::min(vec.Y, max)),
+            std::max(min, std::min(vec.Z, max)),
+            std::max(min, std::min(vec.W, max))
+        };
+    }
 
     Vec3 Pow(const Vec3& vec, const float exponent);
 
-    float Length(const Vec3& v);
-
-    unsigned char Float2UChar(const float f);
-    float UChar2Float(const unsigned char c);
+    inline unsigned char Float2UChar(const float f)
+    {
+        return static_cast<unsigned char>(Clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    inline float UChar2Float(const unsigned char c)
+    {
+        return (float)c / 255.0f;
+    }
 
-    float Max(const float right, const float left);
-    float Min(const float right, const float left);
-}
\ No newline at end of file
+    inline float Max(const float right, const float left)
+    {
+        return std::max<float>(right, left);
+    }
+    inline float Min(const float right, const float left)
+    {
+        return std::min<float>(right, left);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "RGS/Config.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace RGS {
+
+    // Keeps the last N samples (e.g. frame times) and answers percentile queries over them.
+    // Adding is O(1), the percentiles sort a copy of the window, which is fine for a few hundred samples per query.
+    class RollingHistogram
+    {
+    public:
+        struct Percentiles
+        {
+            float P50 = 0.0f;
+            float P95 = 0.0f;
+            float P99 = 0.0f;
+            float Max = 0.0f;
+            float Mean = 0.0f;
+        };
+
+        explicit RollingHistogram(const uint32_t capacity = Config::TimingHistoryLength)
+            : m_Samples(capacity, 0.0f) {}
+
+        void Add(const float value)
+        {
+            m_Samples[m_Next] = value;
+            m_Next = (m_Next + 1) % (uint32_t)m_Samples.size();
+            m_Count = std::min(m_Count + 1, (uint32_t)m_Samples.size());
+        }
+
+        void Clear()
+        {
+            m_Next = 0;
+            m_Count = 0;
+        }
+
+        uint32_t GetCount() const { return m_Count; }
+        uint32_t GetCapacity() const { return (uint32_t)m_Samples.size(); }
+
+        // Raw ring buffer and the index of the oldest sample, e.g. for ImGui::PlotLines(..., values_offset).
+        const float* GetData() const { return m_Samples.data(); }
+        uint32_t GetOffset() const { return m_Count < m_Samples.size() ? 0 : m_Next; }
+
+        // Latest sample, 0 if there is none.
+        float GetLast() const
+        {
+            if (m_Count == 0)
+                return 0.0f;
+            return m_Samples[(m_Next + (uint32_t)m_Samples.size() - 1) % (uint32_t)m_Samples.size()];
+        }
+
+        Percentiles GetPercentiles() const
+        {
+            Percentiles result;
+            if (m_Count == 0)
+                return result;
+
+            std::vector<float> sorted(m_Samples.begin(), m_Samples.begin() + m_Count);
+            std::sort(sorted.begin(), sorted.end());
+
+            // Nearest-rank percentile
+            auto rank = [&sorted](const float p)
+            {
+                size_t index = (size_t)(p * (float)sorted.size() + 0.999f);
+                return sorted[std::clamp<size_t>(index, 1, sorted.size()) - 1];
+            };
+
+            float sum = 0.0f;
+            for (float sample : sorted)
+                sum += sample;
+
+            result.P50 = rank(0.50f);
+            result.P95 = rank(0.95f);
+            result.P99 = rank(0.99f);
+            result.Max = sorted.back();
+            result.Mean = sum / (float)sorted.size();
+            return result;
+        }
+
+    private:
+        std::vector<float> m_Samples;
+        uint32_t m_Next = 0;
+        uint32_t m_Count = 0;
+    };
+
+}
@@ -0,0 +1,237 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace RGS {
+
+    // Storage formats of the texture texels. The textures keep them as loaded and the samplers
+    // decode to float in registers, a texel is 1 to 8 bytes instead of a 12/16-byte Vec3/Vec4.
+    enum class TexelFormat
+    {
+        R8,             // unorm, decodes to (r, 0, 0, 0)
+        RG8,            // unorm, decodes to (r, g, 0, 0)
+        RGBA8,          // unorm, RGB images are stored with a = 0
+        RGBA16F,        // half floats, saturated to +-65504, NaN becomes 0
+        RGB9E5,         // HDR colors, three 9-bit mantissas with a shared 5-bit exponent, decodes to (r, g, b, 0)
+        // 4x4 blocks, see BlockCompression.h
+        BC1,            // RGB in 8 bytes, 0.5 byte per texel
+        BC3,            // RGBA, a BC4 alpha block and a BC1 color block
+        BC4,            // R in 8 bytes
+        BC5,            // RG, two BC4 blocks
+        BC6H,           // unsigned HDR RGB in 16 bytes, 1 byte per texel
+    };
+
+    constexpr bool IsBlockCompressed(const TexelFormat format)
+    {
+        return format == TexelFormat::BC1 || format == TexelFormat::BC3 || format == TexelFormat::BC4 ||
+               format == TexelFormat::BC5 || format == TexelFormat::BC6H;
+    }
+
+    template <TexelFormat format>
+    struct TexelTraits;
+
+    template <>
+    struct TexelTraits<TexelFormat::R8>
+    {
+        using storage_t = uint8_t;
+
+        static storage_t Encode(const Vec4& c) { return Float2UChar(c.X); }
+        static Vec4 Decode(const storage_t texel) { return { UChar2Float(texel), 0.0f, 0.0f, 0.0f }; }
+#if RGS_SIMD_SSE
+        static __m128 DecodeSIMD(const storage_t texel) { return _mm_set_ss(UChar2Float(texel)); }
+#endif
+    };
+
+    template <>
+    struct TexelTraits<TexelFormat::RG8>
+    {
+        struct storage_t { uint8_t R, G; };
+
+        static storage_t Encode(const Vec4& c) { return { Float2UChar(c.X), Float2UChar(c.Y) }; }
+        static Vec4 Decode(const storage_t texel) { return { UChar2Float(texel.R), UChar2Float(texel.G), 0.0f, 0.0f }; }
+#if RGS_SIMD_SSE
+        static __m128 DecodeSIMD(const storage_t texel) { return _mm_setr_ps(UChar2Float(texel.R), UChar2Float(texel.G), 0.0f, 0.0f); }
+#endif
+    };
+
+    template <>
+    struct TexelTraits<TexelFormat::RGBA8>
+    {
+        using storage_t = uint32_t;         // r in the low byte
+
+        static storage_t Encode(const Vec4& c)
+        {
+            return (uint32_t)Float2UChar(c.X) | ((uint32_t)Float2UChar(c.Y) << 8) |
+                   ((uint32_t)Float2UChar(c.Z) << 16) | ((uint32_t)Float2UChar(c.W) << 24);
+        }
+        static Vec4 Decode(const storage_t texel)
+        {
+            return { UChar2Float(texel & 0xFFu), UChar2Float((texel >> 8) & 0xFFu),
+                     UChar2Float((texel >> 16) & 0xFFu), UChar2Float(texel >> 24) };
+        }
+#if RGS_SIMD_SSE
+        static __m128 DecodeSIMD(const storage_t texel)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i bytes = _mm_cvtsi32_si128((int)texel);
+            const __m128i ints = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+            return _mm_div_ps(_mm_cvtepi32_ps(ints), _mm_set1_ps(255.0f));
+        }
+#endif
+    };
+
+    template <>
+    struct TexelTraits<TexelFormat::RGBA16F>
+    {
+        struct storage_t { uint16_t Channels[4]; };
+
+        static uint16_t EncodeHalf(const float value)
+        {
+            const uint32_t bits = std::bit_cast<uint32_t>(value);
+            const uint32_t sign = (bits >> 16) & 0x8000u;
+            const uint32_t abs = bits & 0x7FFFFFFFu;
+            if (abs > 0x7F800000u)                      // NaN
+                return 0;
+            if (abs >= 0x477FF000u)                     // rounds to 65536 or above
+                return (uint16_t)(sign | 0x7BFFu);
+            if (abs < 0x38800000u)                      // below 2^-14, denormal: the mantissa is value * 2^24
+                return (uint16_t)(sign | (uint32_t)std::lrint(std::bit_cast<float>(abs) * 16777216.0f));
+            // Rebias the exponent and round the mantissa to nearest even
+            const uint32_t rounded = abs + 0xFFFu + ((abs >> 13) & 1u);
+            return (uint16_t)(sign | ((rounded - 0x38000000u) >> 13));
+        }
+        // Moves exponent and mantissa into place and rescales by 2^112, which also normalizes the denormals
+        static float DecodeHalf(const uint16_t half)
+        {
+            const float abs = std::bit_cast<float>((uint32_t)(half & 0x7FFFu) << 13) * 0x1p112f;
+            return std::bit_cast<float>(std::bit_cast<uint32_t>(abs) | ((uint32_t)(half & 0x8000u) << 16));
+        }
+
+        static storage_t Encode(const Vec4& c) { return { { EncodeHalf(c.X), EncodeHalf(c.Y), EncodeHalf(c.Z), EncodeHalf(c.W) } }; }
+        static Vec4 Decode(const storage_t& texel)
+        {
+            return { DecodeHalf(texel.Channels[0]), DecodeHalf(texel.Channels[1]), DecodeHalf(texel.Channels[2]), DecodeHalf(texel.Channels[3]) };
+        }
+#if RGS_SIMD_SSE
+        static __m128 DecodeSIMD(const storage_t& texel)
+        {
+            const __m128i halves = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)texel.Channels), _mm_setzero_si128());
+            const __m128i abs = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)), 13);
+            const __m128i sign = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+            const __m128 value = _mm_mul_ps(_mm_castsi128_ps(abs), _mm_set1_ps(0x1p112f));
+            return _mm_or_ps(value, _mm_castsi128_ps(sign));
+        }
+#endif
+    };
+
+    template <>
+    struct TexelTraits<TexelFormat::RGB9E5>
+    {
+        using storage_t = uint32_t;         // r in bits 0-8, g 9-17, b 18-26, the exponent 27-31
+
+        static constexpr int MantissaBits = 9;
+        static constexpr int ExponentBias = 15;
+        static constexpr float MaxValue = 511.0f / 512.0f * 65536.0f;
+
+        // Rounds to nearest, the shared exponent is the one of the largest channel (EXT_texture_shared_exponent)
+        static storage_t Encode(const Vec4& c)
+        {
+            // Clamp to [0, MaxValue], NaN to 0
+            const float r = c.X > 0.0f ? Min(c.X, MaxValue) : 0.0f;
+            const float g = c.Y > 0.0f ? Min(c.Y, MaxValue) : 0.0f;
+            const float b = c.Z > 0.0f ? Min(c.Z, MaxValue) : 0.0f;
+            const float maxChannel = Max(r, Max(g, b));
+
+            int exponent = 0;
+            if (maxChannel > 0.0f)
+            {
+                std::frexp(maxChannel, &exponent);                  // maxChannel in [2^(exponent - 1), 2^exponent)
+                exponent = std::max(exponent, -ExponentBias) + ExponentBias;
+            }
+            float scale = std::ldexp(1.0f, MantissaBits + ExponentBias - exponent);
+            if ((uint32_t)(maxChannel * scale + 0.5f) == (1u << MantissaBits))
+            {
+                exponent++;
+                scale *= 0.5f;
+            }
+            return (uint32_t)(r * scale + 0.5f) | ((uint32_t)(g * scale + 0.5f) << 9) |
+                   ((uint32_t)(b * scale + 0.5f) << 18) | ((uint32_t)exponent << 27);
+        }
+        static Vec4 Decode(const storage_t texel)
+        {
+            // 2^(exponent - 15 - 9)
+            const float scale = std::bit_cast<float>(((texel >> 27) + 127u - ExponentBias - MantissaBits) << 23);
+            return { (float)(texel & 0x1FFu) * scale, (float)((texel >> 9) & 0x1FFu) * scale, (float)((texel >> 18) & 0x1FFu) * scale, 0.0f };
+        }
+#if RGS_SIMD_SSE
+        // The masked mantissas stay shifted and the shift is folded into the per lane scale
+        static __m128 DecodeSIMD(const storage_t texel)
+        {
+            const __m128i bits = _mm_and_si128(_mm_set1_epi32((int)texel), _mm_setr_epi32(0x1FF, 0x1FF << 9, 0x1FF << 18, 0));
+            const __m128 scale = _mm_set1_ps(std::bit_cast<float>(((texel >> 27) + 127u - ExponentBias - MantissaBits) << 23));
+            return _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_mul_ps(scale, _mm_setr_ps(1.0f, 0x1p-9f, 0x1p-18f, 0.0f)));
+        }
+#endif
+    };
+
+    // Index of texel (x, y) in an image stored as rows of 4x4 tiles with the texels of a tile in rows.
+    // A tile of 4-byte texels is one 64-byte cache line, so a bilinear footprint or a short walk in any
+    // direction touches one or two lines instead of one per row. The partial tiles at the right and
+    // bottom edges are padded, see TiledTexelCount.
+    // The index is the sum of a row and a column offset, so a bilinear footprint needs two of each.
+    inline int TiledRowOffset(const int y, const int width)
+    {
+        return (((y >> 2) * ((width + 3) >> 2)) << 4) + ((y & 3) << 2);
+    }
+
+    inline int TiledColumnOffset(const int x)
+    {
+        return ((x >> 2) << 4) + (x & 3);
+    }
+
+    inline int TiledTexelIndex(const int x, const int y, const int width)
+    {
+        return TiledRowOffset(y, width) + TiledColumnOffset(x);
+    }
+
+    inline int TiledTexelCount(const int width, const int height)
+    {
+        return ((width + 3) >> 2) * ((height + 3) >> 2) * 16;
+    }
+
+    // Bilinear blend of the texels t00, t10 (row y0) and t01, t11 (row y1), decoded in registers.
+    // The SSE and scalar paths do the same operations in the same order.
+    template <TexelFormat format>
+    inline Vec4 BilinearTexel(const typename TexelTraits<format>::storage_t& t00, const typename TexelTraits<format>::storage_t& t10,
+                              const typename TexelTraits<format>::storage_t& t01, const typename TexelTraits<format>::storage_t& t11,
+                              const float fracX, const float fracY)
+    {
+        using traits = TexelTraits<format>;
+        const float w00 = (1.0f - fracX) * (1.0f - fracY);
+        const float w10 = fracX * (1.0f - fracY);
+        const float w01 = (1.0f - fracX) * fracY;
+        const float w11 = fracX * fracY;
+#if RGS_SIMD_SSE
+        __m128 sum = _mm_mul_ps(traits::DecodeSIMD(t00), _mm_set1_ps(w00));
+        sum = _mm_add_ps(sum, _mm_mul_ps(traits::DecodeSIMD(t10), _mm_set1_ps(w10)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(traits::DecodeSIMD(t01), _mm_set1_ps(w01)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(traits::DecodeSIMD(t11), _mm_set1_ps(w11)));
+        Vec4 res;
+        _mm_store_ps(&res.X, sum);
+        return res;
+#else
+        const Vec4 c00 = traits::Decode(t00);
+        const Vec4 c10 = traits::Decode(t10);
+        const Vec4 c01 = traits::Decode(t01);
+        const Vec4 c11 = traits::Decode(t11);
+        return { c00.X * w00 + c10.X * w10 + c01.X * w01 + c11.X * w11,
+                 c00.Y * w00 + c10.Y * w10 + c01.Y * w01 + c11.Y * w11,
+                 c00.Z * w00 + c10.Z * w10 + c01.Z * w01 + c11.Z * w11,
+                 c00.W * w00 + c10.W * w10 + c01.W * w01 + c11.W * w11 };
+#endif
+    }
+
+}
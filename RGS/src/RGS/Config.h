@@ -1,9 +1,17 @@
 #pragma once
+#include <cstdint>
 
 #define RGS_PROFILE 0
 
 #define RGS_ENABLE_WIREFRAME_MODE 0
 
+#define RGS_ENABLE_JOBSYSTEM_STATS 1
+
+#define RGS_ENABLE_RENDER_STATS 1
+
+// SSE/AVX paths of the Vec4/Mat4 maths, 0 forces the scalar ones
+#define RGS_ENABLE_SIMD 1
+
 namespace RGS {
 	namespace Config
 	{
@@ -11,11 +19,47 @@ namespace RGS {
 		constexpr int IntegrateBRDFWidth = 512;
 		constexpr int LodTextureSphereMaxWidth = 2048;
 		constexpr int ConvDiffuseWidth = 256; 
+		// Largest face of a TextureCube built from an equirect image with the default size
+		constexpr int TextureCubeMaxFaceSize = 512;
+		// Decoded 4x4 blocks kept per thread by the block compressed textures, a power of two.
+		// 0 decodes the block on every fetch.
+		constexpr int TextureBlockCacheSize = 64;
+		// VirtualTextureSphere: texels per side of a page, every page also keeps a one texel border
+		constexpr int VirtualTexturePageSize = 128;
+		// Pages in RAM per VirtualTextureSphere, 512 pages of 129x129 RGB9E5 texels are 34 MB
+		constexpr int VirtualTexturePageCacheSize = 512;
+		// Mip levels up to this width are loaded whole and stay resident, they fill in for the missing pages
+		constexpr int VirtualTextureResidentWidth = 512;
+		// Page loads started per VirtualTextureSphere::Update, the coarse levels first
+		constexpr int VirtualTextureMaxLoadsPerUpdate = 64;
+		// Texture, TextureSphere and LodTextureSphere map a .rgstex file written next to the image instead of
+		// decoding it again, see TextureCache.h
+		constexpr bool TextureCacheEnabled = true;
 
 		// -----------------------------
 		//          Job System
 		// -----------------------------
 		constexpr bool LimitToSingleThread = false;
+		// Pixels per job group for background-priority draws. Kept small so that frame 
+		// jobs arriving in the meantime only wait for one short group per worker.
+		constexpr uint32_t BackgroundJobGroupSize = 64u;
+		// Default pixels per job group of the frame kernels, see Tuning for the per machine values.
+		constexpr uint32_t RasterizeJobGroupSize = 2048u;
+		constexpr uint32_t ResolveJobGroupSize = 1024u;
+		constexpr uint32_t BlitJobGroupSize = 2048u;
+		constexpr uint32_t PostProcessJobGroupSize = 2048u;
+		// Written by `rgs-bench --tune`, loaded at startup when present.
+		constexpr const char* TuningFilePath = "RGSTuning.ini";
+
+		// -----------------------------
+		//          Profile
+		// -----------------------------
+		// Events kept per thread while RGS_PROFILE is on, older ones are overwritten.
+		constexpr uint32_t ProfileBufferCapacity = 1u << 16;
+		// Samples kept by the rolling frame/stage/command timing histograms, about 10 s at 60 FPS.
+		constexpr uint32_t TimingHistoryLength = 600u;
+		// Delta time handed to the layers while replaying a recorded session, whatever the real frame time.
+		constexpr float ReplayTimeStep = 1.0f / 60.0f;
 
 	};
 }
\ No newline at end of file
@@ -1,29 +1,122 @@
 #include "JobSystem.h"
 #include "RGS/Config.h"
+#include "RGS/Base/Base.h"
+#include "RGS/Base/Instrumentor.h"
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <thread>
 #include <condition_variable>
+#include <iostream>
+#include <iomanip>
 
 namespace RGS::JobSystem {
 
+    static constexpr int s_PriorityCount = (int)JobPriority::Count;
+
     static uint32_t s_NumThreads = 0;
-    static ThreadSafeRingBuffer<std::function<void()>, 256> s_JobPool;    // a thread safe queue to put pending jobs onto the end (with a capacity of 256 jobs). A worker thread can grab a job from the beginning
+    static ThreadSafeRingBuffer<std::function<void()>, 256> s_JobPools[s_PriorityCount];    // one thread safe queue per priority to put pending jobs onto the end (with a capacity of 256 jobs). A worker thread can grab a job from the beginning
     static std::condition_variable s_WakeCondition;    // used in conjunction with the wakeMutex below. Worker threads just sleep when there is no job, and the main thread can wake them up
     static std::mutex s_WakeMutex;    // used in conjunction with the wakeCondition above
-    static uint64_t s_CurrentLabel = 0;
-    static std::atomic<uint64_t> s_FinishedLabel;
+    static std::atomic<uint32_t> s_QueuedJobs{ 0 };    // jobs pushed and not popped yet, the predicate the workers sleep on
+    static std::atomic<uint64_t> s_CurrentLabels[s_PriorityCount];     // jobs can be submitted from any thread (e.g. background bakes), so the labels are atomic
+    static std::atomic<uint64_t> s_FinishedLabels[s_PriorityCount];
+    static thread_local uint32_t s_ThreadIndex = 0;    // 0 for non-worker threads
+    static std::vector<std::thread> s_Workers;
+    static bool s_Running = false;    // guarded by s_WakeMutex
+#ifdef RGS_BUILD_DEBUG
+    static thread_local uint32_t s_RunningJobs[s_PriorityCount] = {};    // jobs the calling thread is inside of, per priority
+#endif
+
+#if RGS_ENABLE_JOBSYSTEM_STATS
+    // Counters are only ever added to, relaxed atomics are enough. Each thread gets its own 
+    // cache line so the workers don't invalidate each other's counters.
+    struct alignas(64) ThreadCounters
+    {
+        std::atomic<uint64_t> JobsExecuted{ 0 };
+        std::atomic<uint64_t> BusyTime{ 0 };
+        std::atomic<uint64_t> IdleTime{ 0 };
+        std::atomic<uint64_t> SpinTime{ 0 };
+        std::atomic<uint64_t> Wakeups{ 0 };
+        std::atomic<uint64_t> PushFailures{ 0 };
+    };
+
+    static std::unique_ptr<ThreadCounters[]> s_Counters;    // s_NumThreads + 1 entries, indexed by s_ThreadIndex
+    static std::atomic<uint64_t> s_MaxPendingJobs[s_PriorityCount];
+    static std::atomic<uint64_t> s_StatsStartTime{ 0 };
+    // Jobs the calling thread is inside of. A job run by a Wait inside another job is already part of the
+    // busy time of the outer one, only the outermost job of a thread is timed.
+    static thread_local uint32_t s_JobDepth = 0;
+
+    static inline uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static inline void AddCounter(std::atomic<uint64_t> ThreadCounters::* counter, uint64_t value)
+    {
+        (s_Counters[s_ThreadIndex].*counter).fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static inline void UpdateMaxPendingJobs(int priority)
+    {
+        const uint64_t pending = s_CurrentLabels[priority].load() - s_FinishedLabels[priority].load();
+        uint64_t max = s_MaxPendingJobs[priority].load(std::memory_order_relaxed);
+        while (pending > max && !s_MaxPendingJobs[priority].compare_exchange_weak(max, pending, std::memory_order_relaxed)) {}
+    }
+#endif
+
+    // Pops and executes one pending job, trying the queues from the highest priority down to lowestPriority.
+    // Returns false if there was no job to execute.
+    static bool ExecuteNext(JobPriority lowestPriority)
+    {
+        std::function<void()> job;
+        for (int priority = 0; priority <= (int)lowestPriority; ++priority)
+        {
+            if (s_JobPools[priority].pop_front(job))
+            {
+                s_QueuedJobs.fetch_sub(1);
+#ifdef RGS_BUILD_DEBUG
+                ++s_RunningJobs[priority];
+#endif
+#if RGS_ENABLE_JOBSYSTEM_STATS
+                const uint64_t start = s_JobDepth++ == 0 ? Now() : 0;
+                job();
+                if (--s_JobDepth == 0)
+                    AddCounter(&ThreadCounters::BusyTime, Now() - start);
+                AddCounter(&ThreadCounters::JobsExecuted, 1);
+#else
+                job();
+#endif
+#ifdef RGS_BUILD_DEBUG
+                --s_RunningJobs[priority];
+#endif
+                s_FinishedLabels[priority].fetch_add(1);
+                return true;
+            }
+        }
+        return false;
+    }
 
-    void Init()
+    void Init(uint32_t numThreads)
     {
         // Initialize the worker execution state to 0:
-        s_FinishedLabel.store(0);
+        for (int priority = 0; priority < s_PriorityCount; ++priority)
+        {
+            s_CurrentLabels[priority].store(0);
+            s_FinishedLabels[priority].store(0);
+        }
 
         if constexpr (Config::LimitToSingleThread)
         {
             s_NumThreads = 1u;
         }
+        else if (numThreads != 0)
+        {
+            s_NumThreads = numThreads;
+        }
         else
         {
             // Retrieve the number of hardware threads in this system:
@@ -32,27 +125,40 @@ namespace RGS::JobSystem {
             s_NumThreads = std::max(1u, numCores);
         }
 
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        s_Counters.reset(new ThreadCounters[s_NumThreads + 1]);
+        ResetStats();
+#endif
+
+        s_Running = true;
+
         // Create all our worker threads while immediately starting them:
         for (uint32_t threadID = 0; threadID < s_NumThreads; ++threadID)
         {
-            std::thread worker([] {
+            std::thread worker([threadID] {
 
-                std::function<void()> job; // the current job for the thread, it's empty at start.
+                s_ThreadIndex = threadID + 1;
+                RGS_PROFILE_THREAD("JobSystem Worker " + std::to_string(s_ThreadIndex));
 
-                // This is the infinite loop that a worker thread will do 
+                // This is the loop that a worker thread will do until Shutdown
                 while (true)
                 {
-                    if (s_JobPool.pop_front(job)) // try to grab a job from the jobPool queue
-                    {
-                        // It found a job, execute it:
-                        job(); // execute job
-                        s_FinishedLabel.fetch_add(1); // update worker label state
-                    }
-                    else
+                    // Frame jobs are always tried first, so a background job is only started 
+                    // when there is no frame work left in the queue
+                    if (!ExecuteNext(JobPriority::Background))
                     {
                         // no job, put thread to sleep
+#if RGS_ENABLE_JOBSYSTEM_STATS
+                        const uint64_t start = Now();
+#endif
                         std::unique_lock<std::mutex> lock(s_WakeMutex);
-                        s_WakeCondition.wait(lock);
+                        s_WakeCondition.wait(lock, [] { return !s_Running || s_QueuedJobs.load() > 0; });
+                        if (!s_Running)
+                            break;
+#if RGS_ENABLE_JOBSYSTEM_STATS
+                        AddCounter(&ThreadCounters::IdleTime, Now() - start);
+                        AddCounter(&ThreadCounters::Wakeups, 1);
+#endif
                     }
                 }
 
@@ -60,39 +166,130 @@ namespace RGS::JobSystem {
 
             // *****Here we could do platform specific thread setup...
 
-            worker.detach(); // forget about this thread, let it do it's job in the infinite loop that we created above
+            s_Workers.emplace_back(std::move(worker));
+        }
+    }
+
+    void Shutdown()
+    {
+        Wait(JobPriority::Background);
+        Wait(JobPriority::Frame);
+
+        {
+            std::lock_guard<std::mutex> lock(s_WakeMutex);
+            s_Running = false;
         }
+        s_WakeCondition.notify_all();
+
+        for (std::thread& worker : s_Workers)
+            worker.join();
+        s_Workers.clear();
     }
 
-    // This little helper function will not let the system to be deadlocked while the main thread is waiting for something
-    static inline void poll()
+    // This little helper function will not let the system to be deadlocked while the calling thread is waiting for something.
+    // It helps with pending work of the given priority (or higher) instead of only yielding. Lower priority work is never
+    // picked up here, so the main thread waiting on frame jobs can't get stuck inside a long background job. Whoever
+    // waits for work of a lower priority passes that priority, see Wait(const Context&).
+    static inline void poll(JobPriority priority)
     {
         s_WakeCondition.notify_one(); // wake one worker thread
-        std::this_thread::yield(); // allow this thread to be rescheduled
+        if (!ExecuteNext(priority))
+        {
+#if RGS_ENABLE_JOBSYSTEM_STATS
+            // Inside a job the spin is part of its busy time
+            const uint64_t start = s_JobDepth == 0 ? Now() : 0;
+            std::this_thread::yield(); // allow this thread to be rescheduled
+            if (s_JobDepth == 0)
+                AddCounter(&ThreadCounters::SpinTime, Now() - start);
+#else
+            std::this_thread::yield(); // allow this thread to be rescheduled
+#endif
+        }
     }
 
-    void Execute(const std::function<void()>& job)
+    // Pushes a job whose label was already counted, helping out while the queue is full.
+    static inline void Push(const std::function<void()>& job, JobPriority priority)
     {
-        s_CurrentLabel += 1;
+        s_QueuedJobs.fetch_add(1);    // before the job can be popped, so the count never wraps
+        while (!s_JobPools[(int)priority].push_back(job)) 
+        { 
+#if RGS_ENABLE_JOBSYSTEM_STATS
+            AddCounter(&ThreadCounters::PushFailures, 1);
+#endif
+            poll(priority); 
+        }
+
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        UpdateMaxPendingJobs((int)priority);
+#endif
+        {
+            // A worker checks the predicate under the mutex, taking it here orders the new job either before 
+            // its check or after it has gone to sleep, so the notify can't fall in between and get lost
+            std::lock_guard<std::mutex> lock(s_WakeMutex);
+        }
+        s_WakeCondition.notify_one(); // wake one thread
+    }
 
-        while (!s_JobPool.push_back(job)) { poll(); }
+    void Execute(const std::function<void()>& job, JobPriority priority)
+    {
+        s_CurrentLabels[(int)priority].fetch_add(1);
 
-        s_WakeCondition.notify_one();
+        Push(job, priority);
     }
 
-    bool IsBusy()
+    // Set in the counter of a context while its continuations are being collected,
+    // so Wait/IsBusy don't report it as done before the last job stops touching it.
+    static constexpr uint32_t s_ReleasingFlag = 1u << 31;
+
+    // Marks one job of the context as finished. The last one to finish releases the continuations.
+    static void Complete(Context& context)
     {
-        return s_FinishedLabel.load() < s_CurrentLabel;
+        uint32_t expected = context.Counter.load();
+        while (true)
+        {
+            if (expected == 1)
+            {
+                if (context.Counter.compare_exchange_weak(expected, s_ReleasingFlag))
+                    break;
+            }
+            else if (context.Counter.compare_exchange_weak(expected, expected - 1))
+            {
+                return;
+            }
+        }
+
+        std::vector<std::function<void()>> continuations;
+        {
+            std::lock_guard<std::mutex> lock(context.ContinuationLock);
+            continuations.swap(context.Continuations);
+        }
+        const JobPriority priority = context.Priority;
+
+        // The context must not be touched after this point, a continuation may destroy it
+        context.Counter.fetch_sub(s_ReleasingFlag);
+
+        for (auto& continuation : continuations)
+        {
+            Execute(continuation, priority);
+        }
     }
 
-    void Wait()
+    void Execute(Context& context, const std::function<void()>& job)
     {
-        while (IsBusy()) { poll(); }
+        context.Counter.fetch_add(1);
+        Execute([&context, job]()
+        {
+            job();
+            Complete(context);
+        }, context.Priority);
     }
 
-    void Dispatch(uint32_t jobCount,
-                  uint32_t groupSize,
-                  const std::function<void(JobDispatchArgs)>& job)
+    // Shared implementation of both Dispatch overloads, context may be null
+    static void DispatchGroups(uint32_t jobCount,
+                               uint32_t groupSize,
+                               const std::function<void(JobDispatchArgs)>& job,
+                               JobPriority priority,
+                               Context* context)
     {
         if (jobCount == 0 || groupSize == 0)
         {
@@ -102,13 +299,17 @@ namespace RGS::JobSystem {
         // Calculate the amount of job groups to dispatch (overestimate, or "ceil"):
         const uint32_t groupCount = (jobCount + groupSize - 1) / groupSize;
 
-        // The main thread label state is updated:
-        s_CurrentLabel += groupCount;
+        // The label state of this priority is updated:
+        s_CurrentLabels[(int)priority].fetch_add(groupCount);
+        if (context)
+        {
+            context->Counter.fetch_add(groupCount);
+        }
 
         for (uint32_t groupIndex = 0; groupIndex < groupCount; ++groupIndex)
         {
             // For each group, generate one real job:
-            auto jobGroup = [jobCount, groupSize, job, groupIndex]()
+            auto jobGroup = [jobCount, groupSize, job, groupIndex, context]()
             {
                 // Calculate the current group's offset into the jobs:
                 const uint32_t groupJobOffset = groupIndex * groupSize;
@@ -123,15 +324,181 @@ namespace RGS::JobSystem {
                     args.JobIndex = i;
                     job(args);
                 }
+
+                if (context)
+                {
+                    Complete(*context);
+                }
             };
 
             // Try to push a new job until it is pushed successfully:
-            while (!s_JobPool.push_back(jobGroup)) { poll(); }
+            Push(jobGroup, priority);
+        }
+    }
+
+    void Dispatch(Context& context,
+                  uint32_t jobCount,
+                  uint32_t groupSize,
+                  const std::function<void(JobDispatchArgs)>& job)
+    {
+        DispatchGroups(jobCount, groupSize, job, context.Priority, &context);
+    }
+
+    bool IsBusy(const Context& context)
+    {
+        return context.Counter.load() > 0;
+    }
+
+    void Wait(const Context& context)
+    {
+        // The priority of the context, not the one of the calling job: the jobs of the context may be queued
+        // behind every worker, and then only the waiters are left to run them
+        while (IsBusy(context)) { poll(context.Priority); }
+    }
 
-            s_WakeCondition.notify_one(); // wake one thread
+    void OnComplete(Context& context, const std::function<void()>& continuation)
+    {
+        // Hold a reference while registering, so the continuation can't be missed by a job finishing concurrently.
+        // The reference is never taken while the last job is releasing: its swap may already be done, and then the
+        // continuation would be pushed after it with nobody left to run it.
+        uint32_t expected = context.Counter.load();
+        while (true)
+        {
+            if (expected & s_ReleasingFlag)
+            {
+                std::this_thread::yield();
+                expected = context.Counter.load();
+            }
+            else if (context.Counter.compare_exchange_weak(expected, expected + 1))
+            {
+                break;
+            }
         }
+        {
+            std::lock_guard<std::mutex> lock(context.ContinuationLock);
+            context.Continuations.push_back(continuation);
+        }
+        Complete(context);
     }
 
-}
+    bool IsBusy(JobPriority priority)
+    {
+        return s_FinishedLabels[(int)priority].load() < s_CurrentLabels[(int)priority].load();
+    }
+
+    void Wait(JobPriority priority)
+    {
+#ifdef RGS_BUILD_DEBUG
+        // The calling job only counts as finished once it returns, it would wait for itself
+        ASSERT(s_RunningJobs[(int)priority] == 0, "Wait(priority) inside a job of that priority, wait on a Context instead");
+#endif
+        while (IsBusy(priority)) { poll(priority); }
+    }
 
+    void Dispatch(uint32_t jobCount,
+                  uint32_t groupSize,
+                  const std::function<void(JobDispatchArgs)>& job,
+                  JobPriority priority)
+    {
+        DispatchGroups(jobCount, groupSize, job, priority, nullptr);
+    }
 
+    uint32_t GetThreadCount()
+    {
+        return s_NumThreads;
+    }
+
+    uint32_t GetThreadIndex()
+    {
+        return s_ThreadIndex;
+    }
+
+    Stats GetStats()
+    {
+        Stats stats;
+        stats.Threads.resize(s_NumThreads + 1);
+        for (int priority = 0; priority < s_PriorityCount; ++priority)
+        {
+            stats.PendingJobs[priority] = s_CurrentLabels[priority].load() - s_FinishedLabels[priority].load();
+        }
+
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        if (!s_Counters)
+            return stats;
+
+        for (uint32_t i = 0; i <= s_NumThreads; ++i)
+        {
+            const ThreadCounters& counters = s_Counters[i];
+            WorkerStats& worker = stats.Threads[i];
+            worker.JobsExecuted = counters.JobsExecuted.load(std::memory_order_relaxed);
+            worker.BusyTime = counters.BusyTime.load(std::memory_order_relaxed);
+            worker.IdleTime = counters.IdleTime.load(std::memory_order_relaxed);
+            worker.SpinTime = counters.SpinTime.load(std::memory_order_relaxed);
+            worker.Wakeups = counters.Wakeups.load(std::memory_order_relaxed);
+            worker.PushFailures = counters.PushFailures.load(std::memory_order_relaxed);
+        }
+        for (int priority = 0; priority < s_PriorityCount; ++priority)
+        {
+            stats.MaxPendingJobs[priority] = s_MaxPendingJobs[priority].load(std::memory_order_relaxed);
+            stats.LockContentions[priority] = s_JobPools[priority].contention_count();
+        }
+        stats.Duration = Now() - s_StatsStartTime.load();
+#endif
+        return stats;
+    }
+
+    void ResetStats()
+    {
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        if (!s_Counters)
+            return;
+
+        for (uint32_t i = 0; i <= s_NumThreads; ++i)
+        {
+            ThreadCounters& counters = s_Counters[i];
+            counters.JobsExecuted.store(0, std::memory_order_relaxed);
+            counters.BusyTime.store(0, std::memory_order_relaxed);
+            counters.IdleTime.store(0, std::memory_order_relaxed);
+            counters.SpinTime.store(0, std::memory_order_relaxed);
+            counters.Wakeups.store(0, std::memory_order_relaxed);
+            counters.PushFailures.store(0, std::memory_order_relaxed);
+        }
+        for (int priority = 0; priority < s_PriorityCount; ++priority)
+        {
+            s_MaxPendingJobs[priority].store(0, std::memory_order_relaxed);
+            s_JobPools[priority].reset_contention_count();
+        }
+        s_StatsStartTime.store(Now());
+#endif
+    }
+
+    void PrintStats()
+    {
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        const Stats stats = GetStats();
+        const double duration = (double)std::max<uint64_t>(stats.Duration, 1);
+
+        std::cout << "[JobSystem] " << s_NumThreads << " workers, " << stats.Duration * 1e-9 << " s" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < stats.Threads.size(); ++i)
+        {
+            const WorkerStats& worker = stats.Threads[i];
+            std::cout << (i == 0 ? "  main   " : "  worker ") << std::setw(2) << i
+                      << "  jobs " << std::setw(10) << worker.JobsExecuted
+                      << "  busy " << std::setw(5) << 100.0 * worker.BusyTime / duration << "%"
+                      << "  idle " << std::setw(5) << 100.0 * worker.IdleTime / duration << "%"
+                      << "  spin " << std::setw(5) << 100.0 * worker.SpinTime / duration << "%"
+                      << "  wakeups " << worker.Wakeups
+                      << "  push failures " << worker.PushFailures << std::endl;
+        }
+        for (int priority = 0; priority < s_PriorityCount; ++priority)
+        {
+            std::cout << (priority == (int)JobPriority::Frame ? "  Frame      " : "  Background ")
+                      << " max pending " << stats.MaxPendingJobs[priority]
+                      << "  lock contentions " << stats.LockContentions[priority] << std::endl;
+        }
+        std::cout << std::defaultfloat;
+#endif
+    }
+
+}
@@ -1,9 +1,23 @@
 #pragma once
+#include "RGS/Config.h"
+
 #include <functional>
 #include <mutex>
+#include <atomic>
+#include <vector>
 
 namespace RGS::JobSystem {
 
+    // Priority classes of the job queues. Workers always drain the Frame queue before
+    // touching the Background queue, so background work only fills idle worker time
+    // and yields to frame work at the next job boundary.
+    enum class JobPriority
+    {
+        Frame,          // Frame-critical work such as rasterization, resolve and present.
+        Background,     // Long-running work such as IBL bakes that must not cause frame hitches.
+        Count
+    };
+
     struct JobDispatchArgs
     {
         // The index of the current job being executed.
@@ -12,27 +26,108 @@ namespace RGS::JobSystem {
         uint32_t GroupIndex;
     };
 
+    // Tracks one batch of jobs independently of the global labels, so a caller can wait for
+    // (or co_await, see RGS/Task.h) its own work while other jobs of the same priority keep running.
+    struct Context
+    {
+        // Number of jobs of this context that have not finished yet.
+        std::atomic<uint32_t> Counter{ 0 };
+        // Queue the jobs of this context are pushed onto.
+        JobPriority Priority = JobPriority::Frame;
+
+        // Callbacks registered by OnComplete, run once Counter drops to zero.
+        std::mutex ContinuationLock;
+        std::vector<std::function<void()>> Continuations;
+    };
+
+    // Counters of one thread, see GetStats. Times are in nanoseconds.
+    struct WorkerStats
+    {
+        uint64_t JobsExecuted = 0;
+        uint64_t BusyTime = 0;          // Spent inside jobs, jobs run by a Wait inside a job are part of the outer one.
+        uint64_t IdleTime = 0;          // Spent asleep on the wake condition (workers only).
+        uint64_t SpinTime = 0;          // Spent in Wait outside of jobs without finding a job to help with.
+        uint64_t Wakeups = 0;           // Times a worker was woken up from sleep.
+        uint64_t PushFailures = 0;      // Pushes that had to be retried because the queue was full.
+    };
+
+    struct Stats
+    {
+        // Index 0 accumulates all non-worker threads (main thread, bake drivers...), worker i is at index i.
+        std::vector<WorkerStats> Threads;
+        // Jobs submitted but not finished yet, current and highest value seen.
+        uint64_t PendingJobs[(int)JobPriority::Count] = {};
+        uint64_t MaxPendingJobs[(int)JobPriority::Count] = {};
+        // Pushes and pops that found the queue mutex already taken.
+        uint64_t LockContentions[(int)JobPriority::Count] = {};
+        // Nanoseconds since Init or the last ResetStats, the base for utilization.
+        uint64_t Duration = 0;
+    };
+
     // Initializes internal resources such as worker threads. 
     // This function should be called once at the start of the application.
-    void Init();
+    // numThreads = 0 starts one worker per hardware thread.
+    void Init(uint32_t numThreads = 0);
 
-    // Adds a job to the job queue for asynchronous execution. 
+    // Finishes all pending jobs and joins the worker threads. Init may be called again afterwards.
+    // Must be called before exit, workers still asleep on the wake condition would block the static destructors.
+    void Shutdown();
+
+    // Adds a job to the job queue of the given priority for asynchronous execution. 
     // Any available idle thread will pick up and execute this job.
-    void Execute(const std::function<void()>& job);
+    void Execute(const std::function<void()>& job, JobPriority priority = JobPriority::Frame);
 
     /**
     * @brief Divides jobs into groups and dispatches them across threads for asynchronous execution.
     * @param jobCount    The total number of jobs to be processed.
     * @param groupSize   The number of jobs each thread will process in a group.
     * @param job         A function that takes JobDispatchArgs and defines the job to be executed.
+    * @param priority    The queue the job groups are pushed onto.
     */
-    void Dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(JobDispatchArgs)>& job);
+    void Dispatch(uint32_t jobCount, 
+                  uint32_t groupSize, 
+                  const std::function<void(JobDispatchArgs)>& job, 
+                  JobPriority priority = JobPriority::Frame);
+
+    // Same as above, but the jobs are pushed onto the queue of the context and tracked by its counter.
+    void Execute(Context& context, const std::function<void()>& job);
+    void Dispatch(Context& context, 
+                  uint32_t jobCount, 
+                  uint32_t groupSize, 
+                  const std::function<void(JobDispatchArgs)>& job);
 
-    // Checks whether any threads are currently busy processing jobs.
-    bool IsBusy();
+    // Checks whether any jobs of the given priority are still pending or running.
+    bool IsBusy(JobPriority priority = JobPriority::Frame);
 
-    // Blocks the calling thread until all worker threads have completed their jobs and become idle.
-    void Wait();
+    // Blocks the calling thread until all jobs of the given priority have completed.
+    // While waiting, the calling thread helps by executing jobs of that priority (or higher), lower ones are left
+    // to the workers. Never call it from a job of that priority, the job itself is one of those it waits for.
+    void Wait(JobPriority priority = JobPriority::Frame);
+
+    // Checks whether any jobs of the context are still pending or running.
+    bool IsBusy(const Context& context);
+
+    // Blocks the calling thread until all jobs of the context have completed. While waiting, the calling thread
+    // helps with jobs down to the priority of the context, so a Frame job may wait on a Background context even
+    // when every worker is inside such a job: the waiters run the background jobs themselves.
+    void Wait(const Context& context);
+
+    // Schedules continuation as a job of the context's priority once all jobs of the context 
+    // have completed (right away if the context is idle). Does not block the calling thread.
+    void OnComplete(Context& context, const std::function<void()>& continuation);
+
+    // Number of worker threads.
+    uint32_t GetThreadCount();
+
+    // 1-based index of the calling worker thread, 0 if it is not a worker.
+    uint32_t GetThreadIndex();
+
+    // Snapshot of the counters, all zero unless RGS_ENABLE_JOBSYSTEM_STATS is set.
+    Stats GetStats();
+    void ResetStats();
+
+    // Prints a per-thread summary of GetStats to std::cout.
+    void PrintStats();
 
     template<typename T, size_t capacity>
     class ThreadSafeRingBuffer
@@ -44,7 +139,7 @@ namespace RGS::JobSystem {
         inline bool push_back(const T& item)
         {
             bool result = false;
-            lock.lock();
+            acquire_lock();
             size_t next = (head + 1) % capacity;
             if (next != tail)
             {
@@ -62,7 +157,7 @@ namespace RGS::JobSystem {
         inline bool pop_front(T& item)
         {
             bool result = false;
-            lock.lock();
+            acquire_lock();
             if (tail != head)
             {
                 item = data[tail];
@@ -73,7 +168,24 @@ namespace RGS::JobSystem {
             return result;
         }
 
+        // Number of times push_back or pop_front had to wait for another thread holding the lock.
+        inline uint64_t contention_count() const { return contentions.load(std::memory_order_relaxed); }
+        inline void reset_contention_count() { contentions.store(0, std::memory_order_relaxed); }
+
     private:
+        inline void acquire_lock()
+        {
+#if RGS_ENABLE_JOBSYSTEM_STATS
+            if (!lock.try_lock())
+            {
+                contentions.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+            }
+#else
+            lock.lock();
+#endif
+        }
+
         // Array to store the items in the buffer.
         T data[capacity];
         // Index pointing to the head of the buffer (where new items are added).
@@ -82,6 +194,8 @@ namespace RGS::JobSystem {
         size_t tail = 0;
         // Mutex for ensuring thread-safe access to the buffer.
         std::mutex lock;
+        // Contended lock acquisitions, only counted with RGS_ENABLE_JOBSYSTEM_STATS.
+        std::atomic<uint64_t> contentions{ 0 };
 
     };
 
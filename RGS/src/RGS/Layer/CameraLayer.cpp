@@ -2,6 +2,10 @@
 
 #include "Application.h"
 #include "RGS/Render/Framebuffer.h"
+#include "RGS/Render/Pipeline.h"
+#include "RGS/Render/FrameTimings.h"
+#include "RGS/JobSystem.h"
+#include "RGS/Session.h"
 
 #include <imgui.h>
 
@@ -22,6 +26,10 @@ namespace RGS {
 
     void CameraLayer::OnUpdate(float t) 
     {
+        // The recorded poses are applied in OnReplay
+        if (Application::Instance().IsReplaying())
+            return;
+
         Window& window = Application::Instance().GetWindow();
         constexpr float speed = 1.0f;
         if (window.GetKey(RGS_KEY_SPACE) == RGS_PRESS)
@@ -50,6 +58,16 @@ namespace RGS {
 
     }
     
+    void CameraLayer::OnRecord(SessionFrame& frame)
+    {
+        frame.SetCamera(m_Camera);
+    }
+
+    void CameraLayer::OnReplay(const SessionFrame& frame)
+    {
+        frame.ApplyCamera(m_Camera);
+    }
+
     void CameraLayer::OnImGuiRender(float t)
     {
         ImGui::Begin(m_DebugName.c_str());
@@ -58,7 +76,151 @@ namespace RGS {
         ImGui::DragFloat3("Camera Dir", (float*)&m_Camera.Dir, 0.1f);
         ImGuiIO& io = ImGui::GetIO();
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
-        ImGui::Text("Total Faces: %d", Renderer::s_FaceCount);
+
+        const RollingHistogram& frameTimes = FrameTimings::GetFrameTimes();
+        RollingHistogram::Percentiles framePercentiles = frameTimes.GetPercentiles();
+        ImGui::Text("Frame p50 %.2f ms, p95 %.2f ms, p99 %.2f ms", framePercentiles.P50, framePercentiles.P95, framePercentiles.P99);
+        if (ImGui::CollapsingHeader("Frame Timings"))
+        {
+            ImGui::PlotLines("Frame (ms)", frameTimes.GetData(), (int)frameTimes.GetCount(), (int)frameTimes.GetOffset(),
+                             nullptr, 0.0f, framePercentiles.Max, ImVec2(0, 60));
+
+            if (ImGui::BeginTable("FrameTimings", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Name");
+                ImGui::TableSetupColumn("Last");
+                ImGui::TableSetupColumn("Mean");
+                ImGui::TableSetupColumn("p50");
+                ImGui::TableSetupColumn("p95");
+                ImGui::TableSetupColumn("p99");
+                ImGui::TableSetupColumn("Max");
+                ImGui::TableHeadersRow();
+
+                auto row = [](const std::string& name, const RollingHistogram& histogram)
+                {
+                    RollingHistogram::Percentiles p = histogram.GetPercentiles();
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%s", name.c_str());
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", histogram.GetLast());
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", p.Mean);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", p.P50);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", p.P95);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", p.P99);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", p.Max);
+                };
+
+                row("Frame", frameTimes);
+                for (int stage = 0; stage < (int)RenderStage::Count; ++stage)
+                {
+                    const FrameTimings::StageTimings& timings = FrameTimings::GetStageTimings((RenderStage)stage);
+                    const std::string stageName = Pipeline::GetStageName((RenderStage)stage);
+                    row(stageName, timings.Total);
+                    row(stageName + " Execute", timings.Execute);
+                    row(stageName + " Wait", timings.Wait);
+                }
+                for (const auto& [name, histogram] : FrameTimings::GetCommandTimings())
+                {
+                    row("Command " + name, histogram);
+                }
+                ImGui::EndTable();
+            }
+
+            if (ImGui::Button("Export CSV"))
+            {
+                if (FrameTimings::ExportCSV("FrameTimings.csv"))
+                    std::cout << "已导出 FrameTimings.csv" << std::endl;
+                else
+                    std::cout << "写入失败: FrameTimings.csv" << std::endl;
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Reset Timings"))
+                FrameTimings::Clear();
+        }
+
+#if RGS_ENABLE_RENDER_STATS
+        const FrameStats& frameStats = Pipeline::GetFrameStats();
+        ImGui::Text("Total Faces: %llu", (unsigned long long)frameStats.Total[RenderCounter::TrianglesSubmitted]);
+        if (ImGui::CollapsingHeader("Render Stats"))
+        {
+            constexpr int stageCount = (int)RenderStage::Count;
+            if (ImGui::BeginTable("RenderStats", stageCount + 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Counter");
+                for (int stage = 0; stage < stageCount; ++stage)
+                    ImGui::TableSetupColumn(Pipeline::GetStageName((RenderStage)stage));
+                ImGui::TableSetupColumn("Total");
+                ImGui::TableHeadersRow();
+                for (int i = 0; i < (int)RenderCounter::Count; ++i)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%s", RenderCounters::GetName((RenderCounter)i));
+                    for (int stage = 0; stage < stageCount; ++stage)
+                    {
+                        ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)frameStats.Stages[stage].Values[i]);
+                    }
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)frameStats.Total.Values[i]);
+                }
+                ImGui::EndTable();
+            }
+
+            for (size_t i = 0; i < frameStats.Draws.size(); ++i)
+            {
+                const DrawStats& draw = frameStats.Draws[i];
+                if (ImGui::TreeNode((void*)(intptr_t)i, "%s (%s)", draw.Name.c_str(), Pipeline::GetStageName(draw.Stage)))
+                {
+                    for (int j = 0; j < (int)RenderCounter::Count; ++j)
+                        ImGui::Text("%s: %llu", RenderCounters::GetName((RenderCounter)j), (unsigned long long)draw.Counters.Values[j]);
+                    ImGui::TreePop();
+                }
+            }
+        }
+#endif
+
+#if RGS_ENABLE_JOBSYSTEM_STATS
+        if (ImGui::CollapsingHeader("JobSystem"))
+        {
+            const JobSystem::Stats stats = JobSystem::GetStats();
+            const double duration = (double)std::max<uint64_t>(stats.Duration, 1);
+
+            ImGui::Text("Pending Jobs: Frame %llu (max %llu), Background %llu (max %llu)",
+                (unsigned long long)stats.PendingJobs[0], (unsigned long long)stats.MaxPendingJobs[0],
+                (unsigned long long)stats.PendingJobs[1], (unsigned long long)stats.MaxPendingJobs[1]);
+            ImGui::Text("Lock Contentions: Frame %llu, Background %llu",
+                (unsigned long long)stats.LockContentions[0], (unsigned long long)stats.LockContentions[1]);
+
+            if (ImGui::BeginTable("JobSystemStats", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Thread");
+                ImGui::TableSetupColumn("Jobs");
+                ImGui::TableSetupColumn("Busy");
+                ImGui::TableSetupColumn("Idle");
+                ImGui::TableSetupColumn("Spin");
+                ImGui::TableSetupColumn("Wakeups");
+                ImGui::TableSetupColumn("Push Fails");
+                ImGui::TableHeadersRow();
+                for (size_t i = 0; i < stats.Threads.size(); ++i)
+                {
+                    const JobSystem::WorkerStats& worker = stats.Threads[i];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    if (i == 0)
+                        ImGui::Text("main");
+                    else
+                        ImGui::Text("%d", (int)i);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)worker.JobsExecuted);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f%%", 100.0 * worker.BusyTime / duration);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f%%", 100.0 * worker.IdleTime / duration);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f%%", 100.0 * worker.SpinTime / duration);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)worker.Wakeups);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)worker.PushFailures);
+                }
+                ImGui::EndTable();
+            }
+
+            if (ImGui::Button("Reset JobSystem Stats"))
+                JobSystem::ResetStats();
+        }
+#endif
         ImGui::End();
     }
 
@@ -22,6 +22,8 @@ namespace RGS {
         virtual void OnDetach()  override;
         virtual void OnUpdate(float t) override;
         virtual void OnImGuiRender(float t) override;
+        virtual void OnRecord(SessionFrame& frame) override;
+        virtual void OnReplay(const SessionFrame& frame) override;
 
         const Camera& GetCamera() const { return m_Camera; }
 
@@ -9,6 +9,7 @@
 #include "RGS/Render/Mesh.h"
 #include "RGS/Render/Pipeline.h"
 #include "RGS/Render/RenderCommand.h"
+#include "RGS/Session.h"
 
 #include "RGS/Shader/SkyboxShader.h"
 #include "RGS/Shader/IBLPBRShader.h"
@@ -20,36 +21,35 @@
 
 namespace RGS {
 
-    IBLPBRLayer::~IBLPBRLayer()
-    {
-        if (m_IrradianceMap)
-            delete m_IrradianceMap;
-        if (m_PrefilterEnvMap)
-            delete m_PrefilterEnvMap;
-        if (m_BrdfLUT)
-            delete m_BrdfLUT;
-        if (m_SkyboxTex)
-            delete m_SkyboxTex;
-
-        m_IrradianceMap = nullptr;
-        m_PrefilterEnvMap = nullptr;
-        m_BrdfLUT = nullptr;
-        m_SkyboxTex = nullptr;
-    }
-
     void IBLPBRLayer::OnAttach()
     {
-        m_IrradianceMap = new TextureSphere("Assets\\diffuse_conv.hdr");
-        m_PrefilterEnvMap = new LodTextureSphere({ "Assets\\prefilter\\prefilter-800x400-0.00.hdr",
-                                                   "Assets\\prefilter\\prefilter-640x320-0.25.hdr",
-                                                   "Assets\\prefilter\\prefilter-480x240-0.50.hdr",
-                                                   "Assets\\prefilter\\prefilter-320x160-0.75.hdr",
-                                                   "Assets\\prefilter\\prefilter-160x80-1.00.hdr" });
-        m_BrdfLUT = new Texture("Assets\\brdf.jpg");
-        m_SkyboxTex = new TextureSphere("Assets\\hdr\\newport_loft.hdr");
-        m_SkyboxPath = m_SkyboxTex->GetPath();
-        m_IrradianceMapPath = m_IrradianceMap->GetPath();
-        m_PrefilterEnvMapDir = m_PrefilterEnvMap->GetPath();
+        // All in parallel, the first frames draw with grey 1x1 maps
+        const Vec3 grey = { 0.5f, 0.5f, 0.5f };
+        const std::shared_ptr<TextureSphere> spherePlaceholder = AssetManager::CreatePlaceholderTextureSphere(grey);
+        const std::shared_ptr<TextureCube> cubePlaceholder = AssetManager::CreatePlaceholderTextureCube(grey);
+
+        const std::string irradiancePath = "Assets\\diffuse_conv.hdr";
+        m_IrradianceMap.Load(m_Assets, irradiancePath, [irradiancePath]() { return TextureSphere::LoadTextureSphere(irradiancePath); },
+                             spherePlaceholder, cubePlaceholder);
+
+        const std::vector<std::string> prefilterPaths = { "Assets\\prefilter\\prefilter-800x400-0.00.hdr",
+                                                          "Assets\\prefilter\\prefilter-640x320-0.25.hdr",
+                                                          "Assets\\prefilter\\prefilter-480x240-0.50.hdr",
+                                                          "Assets\\prefilter\\prefilter-320x160-0.75.hdr",
+                                                          "Assets\\prefilter\\prefilter-160x80-1.00.hdr" };
+        m_PrefilterEnvMap.Load(m_Assets, "Assets\\prefilter", [prefilterPaths]() { return LodTextureSphere::LoadLodTextureSphere(prefilterPaths); },
+                               AssetManager::CreatePlaceholderLodTextureSphere(grey), cubePlaceholder);
+
+        // (1, 0) is a smooth surface seen head-on, the specular is F0
+        m_BrdfLUT = m_Assets.LoadTexture("Assets\\brdf.jpg", AssetManager::CreatePlaceholderTexture({ 1.0f, 0.0f, 0.0f }));
+
+        const std::string skyboxPath = "Assets\\hdr\\newport_loft.hdr";
+        m_Skybox.Load(m_Assets, skyboxPath, [skyboxPath]() { return TextureSphere::LoadTextureSphere(skyboxPath); },
+                      spherePlaceholder, cubePlaceholder);
+
+        m_SkyboxPath = m_Skybox.GetPath();
+        m_IrradianceMapPath = m_IrradianceMap.GetPath();
+        m_PrefilterEnvMapDir = m_PrefilterEnvMap.GetPath();
 
         m_IBLPBRUniforms = std::make_shared<IBLPBRUniforms>();
         m_IBLPBRUniforms->Albedo = { 1.0f, 1.0f, 1.0f };
@@ -57,10 +57,6 @@ namespace RGS {
         m_IBLPBRUniforms->Metallic = 0.85f;
         m_IBLPBRUniforms->Roughness = 0.275f;
 
-        m_IBLPBRUniforms->BrdfLUT = m_BrdfLUT;
-        m_IBLPBRUniforms->IrradianceMap = m_IrradianceMap;
-        m_IBLPBRUniforms->PrefilterMap = m_PrefilterEnvMap;
-
         m_IBLPBRUniforms->LightPos = { 10.0f, 10.0f, 10.0f };
         m_IBLPBRUniforms->LightColor = { 1000.0f, 500.0f, 400.0f };
 
@@ -74,28 +70,53 @@ namespace RGS {
 
     void IBLPBRLayer::OnDetach()
     {
-        if (m_IrradianceMap)
-            delete m_IrradianceMap;
-        if (m_PrefilterEnvMap)
-            delete m_PrefilterEnvMap;
-        if (m_BrdfLUT)
-            delete m_BrdfLUT;
-        if (m_SkyboxTex)
-            delete m_SkyboxTex;
-
-        m_IrradianceMap = nullptr;
-        m_PrefilterEnvMap = nullptr;
-        m_BrdfLUT = nullptr;
-        m_SkyboxTex = nullptr;
+        m_Assets.Wait();
+        m_Assets.Update();
+        m_BrdfLUT.reset();
+        m_Skybox = {};
+        m_IrradianceMap = {};
+        m_PrefilterEnvMap = {};
+        m_VirtualSkybox.reset();
     }
 
     void IBLPBRLayer::OnUpdate(float t)
     {
+        // The last frame is done: publish the finished loads and swap in the reloaded maps
+        m_LoadingAssets = m_Assets.Update();
+        if (m_Skybox.SwapNext(m_SkyboxPath))
+        {
+            // Loaded again from the new image the next time it is enabled
+            m_VirtualSkybox.reset();
+            m_UseVirtualSkybox = false;
+        }
+        m_IrradianceMap.SwapNext(m_IrradianceMapPath);
+        m_PrefilterEnvMap.SwapNext(m_PrefilterEnvMapDir);
+        if (m_VirtualSkybox && m_VirtualSkybox->GetState() == AssetState::Failed)
+        {
+            m_VirtualSkybox.reset();
+            m_UseVirtualSkybox = false;
+        }
+
         if (!m_Running)
             return;
 
+        if (m_MSAALevel != (int)m_Framebuffer->GetMSAA())
+        {
+            uint32_t width = m_Framebuffer->GetWidth();
+            uint32_t height = m_Framebuffer->GetHeight();
+            m_Framebuffer = Framebuffer::Create(width, height, (MSAA)m_MSAALevel);
+        }
+
+        // Start loading the pages the last frame was missing
+        VirtualTextureSphere* virtualSkybox = m_VirtualSkybox ? m_VirtualSkybox->Get() : nullptr;
+        if (virtualSkybox)
+            m_VirtualSkyboxMissing = virtualSkybox->Update();
+
         m_Pipeline.BeginFrame();
 
+        const bool debugView = m_DebugView != 0;
+        m_Framebuffer->EnableDebugCounters(debugView, m_DebugView == (int)DebugCounter::ShaderCycles + 1);
+
         m_Pipeline.AddCommand(RenderCommand::Clear(*m_Framebuffer), RenderStage::BeginFrame);
         m_Pipeline.AddCommand(RenderCommand::ClearDepth(*m_Framebuffer), RenderStage::BeginFrame);
 
@@ -111,19 +132,28 @@ namespace RGS {
         m_IBLPBRUniforms->ModelMatrix = Mat4Identity();
         m_IBLPBRUniforms->MVP = camera.ProjectionMat4() * view;
         m_IBLPBRUniforms->NormalMatrix = normalToWorld;
+        m_IBLPBRUniforms->BrdfLUT = m_BrdfLUT->Get();
+        m_IBLPBRUniforms->IrradianceMap = m_IrradianceMap.Map->Get();
+        m_IBLPBRUniforms->PrefilterMap = m_PrefilterEnvMap.Map->Get();
+        m_IBLPBRUniforms->IrradianceCube = m_UseCubeMaps ? m_IrradianceMap.Cube->Get() : nullptr;
+        m_IBLPBRUniforms->PrefilterCube = m_UseCubeMaps ? m_PrefilterEnvMap.Cube->Get() : nullptr;
         RenderSphere(*m_Framebuffer);
 
         // RenderSkybox
         switch (m_SkyboxTexIndex)
         {
         case 0:
-            RenderSkybox(*m_Framebuffer, m_SkyboxTex);
+            if (m_UseVirtualSkybox && virtualSkybox)
+                RenderSkybox(*m_Framebuffer, nullptr, nullptr, 0.0f, nullptr, virtualSkybox);
+            else
+                RenderSkybox(*m_Framebuffer, m_Skybox.Map->Get(), nullptr, 0.0f, m_UseCubeMaps ? m_Skybox.Cube->Get() : nullptr);
             break;
         case 1:
-            RenderSkybox(*m_Framebuffer, m_IrradianceMap);
+            RenderSkybox(*m_Framebuffer, m_IrradianceMap.Map->Get(), nullptr, 0.0f, m_UseCubeMaps ? m_IrradianceMap.Cube->Get() : nullptr);
             break;
         case 2:
-            RenderSkybox(*m_Framebuffer, nullptr, m_PrefilterEnvMap, m_IBLPBRUniforms->Roughness);
+            RenderSkybox(*m_Framebuffer, nullptr, m_PrefilterEnvMap.Map->Get(), m_IBLPBRUniforms->Roughness,
+                         m_UseCubeMaps ? m_PrefilterEnvMap.Cube->Get() : nullptr);
             break;
         default:
             break;
@@ -133,10 +163,19 @@ namespace RGS {
             RenderQuad(*m_Framebuffer, { 0.0f, 0.0f, 1.3f });
 
         m_Pipeline.AddCommand(RenderCommand::ResolveParallel(*m_Framebuffer, true), RenderStage::EndFrame);
-        m_Pipeline.AddCommand(RenderCommand::BlitToScreen(*m_Framebuffer), RenderStage::EndFrame);
+        m_Pipeline.AddCommand(RenderCommand::PostProcess(*m_Framebuffer, m_PostProcess), RenderStage::EndFrame);
+        if (debugView)
+            m_Pipeline.AddCommand(RenderCommand::ResolveHeatmap(*m_Framebuffer, (DebugCounter)(m_DebugView - 1), (uint32_t)m_HeatmapMax), RenderStage::EndFrame);
+        m_Pipeline.AddCommand(RenderCommand::BlitToScreen(*m_Framebuffer, Application::Instance().GetFramebuffer()), RenderStage::EndFrame);
 
         m_Pipeline.EndFrame();
 
+        if (m_SaveHeatmap)
+        {
+            SaveHeatmap();
+            m_SaveHeatmap = false;
+        }
+
     }
 
     void IBLPBRLayer::OnImGuiRender(float t)
@@ -147,19 +186,51 @@ namespace RGS {
         {
             ImGui::Checkbox("Draw Quad", &m_DrawQuad);
 
-            static int msaaLevel = 3;
-            ImGui::DragInt("MSAA Level", &msaaLevel, 0.05f, 1, 8);
-            if (msaaLevel != (int)m_Framebuffer->GetMSAA())
-            {   
-                uint32_t width = m_Framebuffer->GetWidth();
-                uint32_t height = m_Framebuffer->GetHeight();
-                m_Framebuffer = Framebuffer::Create(width, height, (MSAA)msaaLevel);
-            }   
+            ImGui::DragInt("MSAA Level", &m_MSAALevel, 0.05f, 1, 8);
+            ImGui::Checkbox("Fast Math", &m_FastMath);
+            ImGui::Checkbox("Cube Maps", &m_UseCubeMaps);
+
+            ImGui::Spacing();
+            const char* toneMaps[] = { "None", "Reinhard", "ACES" };
+            const char* encodings[] = { "Linear", "Gamma 2.2", "sRGB" };
+            int toneMap = (int)m_PostProcess.ToneMap;
+            int encoding = (int)m_PostProcess.Encoding;
+            if (ImGui::Combo("Tone Map", &toneMap, toneMaps, IM_ARRAYSIZE(toneMaps)))
+                m_PostProcess.ToneMap = (ToneMapOperator)toneMap;
+            if (ImGui::Combo("Encoding", &encoding, encodings, IM_ARRAYSIZE(encodings)))
+                m_PostProcess.Encoding = (OutputEncoding)encoding;
+            ImGui::DragFloat("Exposure", &m_PostProcess.Exposure, 0.01f, 0.0f, 16.0f);
 
             ImGui::Text("Skybox Tex: ");
             ImGui::RadioButton("Skybox", &m_SkyboxTexIndex, 0); ImGui::SameLine();
             ImGui::RadioButton("Irradiance", &m_SkyboxTexIndex, 1); ImGui::SameLine();
             ImGui::RadioButton("Prefilter", &m_SkyboxTexIndex, 2);
+            if (ImGui::Checkbox("Virtual Texture", &m_UseVirtualSkybox) && m_UseVirtualSkybox && !m_VirtualSkybox)
+            {
+                // Builds the tile file on first use, the regular skybox is drawn until then
+                const std::string path = m_Skybox.Map->GetPath();
+                m_VirtualSkybox = m_Assets.Load<VirtualTextureSphere>(path, [path]() { return VirtualTextureSphere::LoadVirtualTextureSphere(path); }, nullptr);
+            }
+            if (m_VirtualSkybox && m_VirtualSkybox->Get())
+            {
+                const VirtualTextureSphere* virtualSkybox = m_VirtualSkybox->Get();
+                ImGui::Text("%dx%d, %.1f MB, %d pages missing", virtualSkybox->GetWidth(), virtualSkybox->GetHeight(),
+                            virtualSkybox->GetMemorySize() / (1024.0 * 1024.0), m_VirtualSkyboxMissing);
+            }
+            if (m_LoadingAssets > 0)
+                ImGui::Text("Loading %d assets", m_LoadingAssets);
+
+            ImGui::Spacing();
+            const char* debugViews[] = { "Final", "Overdraw", "Depth Rejects", "Shader Cycles" };
+            ImGui::Combo("Debug View", &m_DebugView, debugViews, IM_ARRAYSIZE(debugViews));
+            if (m_DebugView != 0)
+            {
+                const DebugCounter counter = (DebugCounter)(m_DebugView - 1);
+                ImGui::DragInt("Heatmap Max (0 = Auto)", &m_HeatmapMax, 1.0f, 0, 1 << 30);
+                ImGui::Text("Frame Max: %u", m_Framebuffer->GetMaxDebugCounter(counter));
+                if (ImGui::Button("Save Heatmap"))
+                    m_SaveHeatmap = true;
+            }
 
             constexpr float speed = 0.005f;
             ImGui::Spacing();
@@ -186,7 +257,26 @@ namespace RGS {
         ImGui::End();
     }
 
-    void IBLPBRLayer::RenderSkybox(Framebuffer& framebuffer, TextureSphere* skyboxTex, LodTextureSphere* lodSkyboxTex, float roughness)
+    void IBLPBRLayer::OnRecord(SessionFrame& frame)
+    {
+        frame.Roughness = m_IBLPBRUniforms->Roughness;
+        frame.Metallic = m_IBLPBRUniforms->Metallic;
+        frame.MSAALevel = (uint8_t)m_Framebuffer->GetMSAA();
+        frame.SkyboxIndex = (uint8_t)m_SkyboxTexIndex;
+        frame.DrawQuad = m_DrawQuad;
+    }
+
+    void IBLPBRLayer::OnReplay(const SessionFrame& frame)
+    {
+        m_IBLPBRUniforms->Roughness = frame.Roughness;
+        m_IBLPBRUniforms->Metallic = frame.Metallic;
+        m_MSAALevel = frame.MSAALevel;
+        m_SkyboxTexIndex = frame.SkyboxIndex;
+        m_DrawQuad = frame.DrawQuad != 0;
+    }
+
+    void IBLPBRLayer::RenderSkybox(Framebuffer& framebuffer, TextureSphere* skyboxTex, LodTextureSphere* lodSkyboxTex, float roughness, TextureCube* skyboxCube,
+                                   VirtualTextureSphere* virtualSkyboxTex)
     {
         static bool firstLoop = true;
         static std::shared_ptr<Mesh<IBLPBRVertex>> boxMesh;
@@ -199,6 +289,9 @@ namespace RGS {
             program->EnableDoubleSided = true;
             firstLoop = false;
         }
+        program->EnableFastMath = m_FastMath;
+        // The virtual texture picks its LOD from the derivatives
+        program->EnableDerivatives = virtualSkyboxTex != nullptr;
 
         // Uniforms
         std::shared_ptr<SkyboxUniforms> uniforms = std::make_shared<SkyboxUniforms>();
@@ -210,9 +303,13 @@ namespace RGS {
         uniforms->MVP = camera.ProjectionMat4() * view;
         uniforms->SkyboxTex = skyboxTex;
         uniforms->LodSkyboxTex = lodSkyboxTex;
+        uniforms->SkyboxCube = skyboxCube;
+        uniforms->VirtualSkyboxTex = virtualSkyboxTex;
         uniforms->Lod = roughness;
 
-        m_Pipeline.AddCommand(RenderCommand::Draw(framebuffer, program, boxMesh, uniforms, framebuffer.GetMSAA()), RenderStage::Geometry);
+        auto command = RenderCommand::Draw(framebuffer, program, boxMesh, uniforms, framebuffer.GetMSAA());
+        command->SetName("Skybox");
+        m_Pipeline.AddCommand(std::move(command), RenderStage::Geometry);
     }
 
     void IBLPBRLayer::RenderSphere(Framebuffer& framebuffer)
@@ -226,6 +323,7 @@ namespace RGS {
             program = std::make_shared<Program<IBLPBRVertex, IBLPBRUniforms, IBLPBRVaryings>>(IBLPBRVertexShader, IBLPBRFragmentShader);
             firstLoop = false;
         }
+        program->EnableFastMath = m_FastMath;
 
         for (int i = 0; i < 1; ++i)
         {
@@ -241,7 +339,9 @@ namespace RGS {
             normalToWorld.M[2][3] = 0.0f;
             m_IBLPBRUniforms->NormalMatrix = normalToWorld;
 
-            m_Pipeline.AddCommand(RenderCommand::Draw(framebuffer, program, sphereMesh, m_IBLPBRUniforms, framebuffer.GetMSAA()), RenderStage::Geometry);
+            auto command = RenderCommand::Draw(framebuffer, program, sphereMesh, m_IBLPBRUniforms, framebuffer.GetMSAA());
+            command->SetName("Sphere");
+            m_Pipeline.AddCommand(std::move(command), RenderStage::Geometry);
         }
     }
 
@@ -266,56 +366,31 @@ namespace RGS {
         const Camera& camera = CameraLayer::Get().GetCamera();
         mvp = camera.ProjectionMat4() * camera.ViewMat4() * mvp;
         m_FlatColorUniforms->MVP = mvp;
-        m_Pipeline.AddCommand(RenderCommand::Draw(framebuffer, program, quadMesh, m_FlatColorUniforms, framebuffer.GetMSAA()), RenderStage::Transparent);
+        auto command = RenderCommand::Draw(framebuffer, program, quadMesh, m_FlatColorUniforms, framebuffer.GetMSAA());
+        command->SetName("Quad");
+        m_Pipeline.AddCommand(std::move(command), RenderStage::Transparent);
     }
 
     void IBLPBRLayer::OnValidate()
     {
-        if (m_SkyboxPath != m_SkyboxTex->GetPath())
+        // Loaded in the background, OnUpdate swaps them in with their cubes
+        if (m_SkyboxPath != m_Skybox.GetPath())
         {
-            TextureSphere* tex = TextureSphere::LoadTextureSphere(m_SkyboxPath);
-            if (tex == nullptr)
-            {
-                m_SkyboxPath = m_SkyboxTex->GetPath();
-                std::cout << "加载失败" << std::endl;
-            }
-            else
-            {
-                delete m_SkyboxTex;
-                m_SkyboxTex = tex;
-            }
+            const std::string path = m_SkyboxPath;
+            m_Skybox.LoadNext(m_Assets, path, [path]() { return TextureSphere::LoadTextureSphere(path); });
         }
 
-        if (m_IrradianceMapPath != m_IrradianceMap->GetPath())
+        if (m_IrradianceMapPath != m_IrradianceMap.GetPath())
         {
-            TextureSphere* tex = TextureSphere::LoadTextureSphere(m_IrradianceMapPath);
-            if (tex == nullptr)
-            {
-                m_IrradianceMapPath = m_IrradianceMap->GetPath();
-                std::cout << "加载失败" << std::endl;
-            }
-            else
-            {
-                delete m_IrradianceMap;
-                m_IrradianceMap = tex;
-                m_IBLPBRUniforms->IrradianceMap = m_IrradianceMap;
-            }
+            const std::string path = m_IrradianceMapPath;
+            m_IrradianceMap.LoadNext(m_Assets, path, [path]() { return TextureSphere::LoadTextureSphere(path); });
         }
 
-        if (m_PrefilterEnvMapDir != m_PrefilterEnvMap->GetPath())
+        if (m_PrefilterEnvMapDir != m_PrefilterEnvMap.GetPath())
         {
-            LodTextureSphere* tex = LodTextureSphere::LoadLodTextureSphere(m_PrefilterEnvMapDir, LodTextureSphere::LoadType::Directory);
-            if (tex == nullptr)
-            {
-                m_PrefilterEnvMapDir = m_PrefilterEnvMap->GetPath();
-                std::cout << "加载失败" << std::endl;
-            }
-            else
-            {
-                delete m_PrefilterEnvMap;
-                m_PrefilterEnvMap = tex;
-                m_IBLPBRUniforms->PrefilterMap = m_PrefilterEnvMap;
-            }
+            const std::string dir = m_PrefilterEnvMapDir;
+            m_PrefilterEnvMap.LoadNext(m_Assets, dir,
+                [dir]() { return LodTextureSphere::LoadLodTextureSphere(dir, LodTextureSphere::LoadType::Directory); });
         }
     }
 
@@ -326,4 +401,18 @@ namespace RGS {
         if (str[str.size() - 1] == '"')
             str.erase(str.size() - 1, str.size());
     }
+    void IBLPBRLayer::SaveHeatmap()
+    {
+        const char* names[] = { "overdraw", "depth_rejects", "shader_cycles" };
+        std::string path = std::string("heatmap_") + names[m_DebugView - 1] + ".png";
+
+        int width = (int)m_Framebuffer->GetWidth();
+        int height = (int)m_Framebuffer->GetHeight();
+        auto data = m_Framebuffer->GetRGBColorData();
+        stbi_flip_vertically_on_write(true);
+        if (stbi_write_png(path.c_str(), width, height, 3, data.get(), width * 3) == 0)
+            std::cout << "写入失败" << std::endl;
+        else
+            std::cout << "Saved heatmap to " << path << std::endl;
+    }
 }
@@ -1,14 +1,20 @@
 #pragma once
 #include "Layer.h"
 
+#include "RGS/AssetManager.h"
 #include "RGS/Texture.h"
+#include "RGS/VirtualTexture.h"
 #include "RGS/Shader/IBLPBRShader.h"
 #include "RGS/Shader/FlatColorShader.h"
 #include "RGS/Render/Framebuffer.h"
 #include "RGS/Render/Pipeline.h"
+#include "RGS/Render/PostProcess.h"
 
 #include <string>
 #include <memory>
+#include <functional>
+#include <tuple>
+#include <utility>
 
 namespace RGS {
 
@@ -17,33 +23,110 @@ namespace RGS {
     public:
         IBLPBRLayer(std::string name)
             : Layer(name){}
-        virtual ~IBLPBRLayer() override;
 
         virtual void OnAttach() override;
         virtual void OnDetach() override;
         virtual void OnUpdate(float t) override;
         virtual void OnImGuiRender(float t) override;
+        virtual void OnRecord(SessionFrame& frame) override;
+        virtual void OnReplay(const SessionFrame& frame) override;
 
     private:
-        Texture* m_BrdfLUT;
-
-        TextureSphere* m_SkyboxTex = nullptr;
+        // One of the three maps with its cubemap. Apply loads a next pair, which replaces the current one
+        // once both are loaded, so the map and the cube change in the same frame.
+        template <typename map_t>
+        struct EnvironmentMap
+        {
+            AssetHandle<map_t> Map;
+            AssetHandle<TextureCube> Cube;
+            AssetHandle<map_t> NextMap;
+            AssetHandle<TextureCube> NextCube;
+
+            // Of the last map asked for
+            const std::string& GetPath() const { return (NextMap ? NextMap : Map)->GetPath(); }
+
+            // The map and its cube from one job, the cube is built from the loaded map instead of decoding the file again
+            void Load(AssetManager& assets, const std::string& path, std::function<map_t*()> loader,
+                      std::shared_ptr<map_t> placeholder, std::shared_ptr<TextureCube> cubePlaceholder)
+            {
+                std::tie(Map, Cube) = LoadPair(assets, path, std::move(loader), std::move(placeholder), std::move(cubePlaceholder));
+            }
+            void LoadNext(AssetManager& assets, const std::string& path, std::function<map_t*()> loader)
+            {
+                std::tie(NextMap, NextCube) = LoadPair(assets, path, std::move(loader), nullptr, nullptr);
+            }
+
+            // Between two frames. Returns true when the next pair was swapped in. When one of its loads failed
+            // the pair is dropped and path, the text field, shows the current map again.
+            bool SwapNext(std::string& path)
+            {
+                if (!NextMap || NextMap->IsLoading() || NextCube->IsLoading())
+                    return false;
+                const bool loaded = NextMap->GetState() == AssetState::Ready && NextCube->GetState() == AssetState::Ready;
+                if (loaded)
+                {
+                    Map = std::move(NextMap);
+                    Cube = std::move(NextCube);
+                }
+                else
+                {
+                    path = Map->GetPath();
+                }
+                NextMap.reset();
+                NextCube.reset();
+                return loaded;
+            }
+
+        private:
+            static std::pair<AssetHandle<map_t>, AssetHandle<TextureCube>> LoadPair(AssetManager& assets, const std::string& path,
+                std::function<map_t*()> loader, std::shared_ptr<map_t> placeholder, std::shared_ptr<TextureCube> cubePlaceholder)
+            {
+                return assets.Load<map_t, TextureCube>(path, std::move(loader), std::move(placeholder),
+                                                       [](const map_t& map) { return new TextureCube(map); }, std::move(cubePlaceholder));
+            }
+        };
+
+        // Every texture loads on the JobSystem, the frames draw with placeholders until they are in
+        AssetManager m_Assets;
+        int m_LoadingAssets = 0;
+
+        AssetHandle<Texture> m_BrdfLUT;
+
+        EnvironmentMap<TextureSphere> m_Skybox;
         std::string m_SkyboxPath;
 
-        LodTextureSphere* m_PrefilterEnvMap;
+        EnvironmentMap<LodTextureSphere> m_PrefilterEnvMap;
         std::string m_PrefilterEnvMapDir;
 
-        TextureSphere* m_IrradianceMap;
+        EnvironmentMap<TextureSphere> m_IrradianceMap;
         std::string m_IrradianceMapPath;
 
+        bool m_UseCubeMaps = false;
+
+        // The skybox streamed from its tile file instead of m_Skybox, loaded when first enabled
+        AssetHandle<VirtualTextureSphere> m_VirtualSkybox;
+        bool m_UseVirtualSkybox = false;
+        int m_VirtualSkyboxMissing = 0;
+
         std::shared_ptr<IBLPBRUniforms> m_IBLPBRUniforms;
         std::shared_ptr<FlatColorUniforms> m_FlatColorUniforms;
 
         bool m_DrawQuad = false;
         bool m_Running = true;
         int m_SkyboxTexIndex = 0;
+        int m_MSAALevel = 3;
+        bool m_FastMath = false;
+        PostProcessSettings m_PostProcess;
+
+        // Heatmap debug view, 0 is the final image, otherwise the DebugCounter + 1
+        int m_DebugView = 0;
+        int m_HeatmapMax = 0;
+        bool m_SaveHeatmap = false;
+
+        void SaveHeatmap();
 
-        void RenderSkybox(Framebuffer& framebuffer, TextureSphere* skyboxTex, LodTextureSphere* lodSkyboxTex = nullptr, float roughness = 0.0f);
+        void RenderSkybox(Framebuffer& framebuffer, TextureSphere* skyboxTex, LodTextureSphere* lodSkyboxTex = nullptr, float roughness = 0.0f, TextureCube* skyboxCube = nullptr,
+                          VirtualTextureSphere* virtualSkyboxTex = nullptr);
         void RenderSphere(Framebuffer& framebuffer);
         void RenderQuad(Framebuffer& framebuffer, const Vec3 pos = Vec3{0.0f, 0.0f, 0.0f}, const float sx = 1.0f, const float sy = 1.0f, const float rx = 0.0f, const float ry = 0.0f, const float rz = 0.0f);
 
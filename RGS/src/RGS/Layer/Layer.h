@@ -4,6 +4,8 @@
 
 namespace RGS {
 
+	struct SessionFrame;
+
 	class Layer
 	{
 	public:
@@ -16,6 +18,10 @@ namespace RGS {
 		virtual void OnUpdate(float t) {}
 		virtual void OnImGuiRender(float t) {}
 
+		// Session recording: write the state that affects this frame, or restore it before OnUpdate
+		virtual void OnRecord(SessionFrame& frame) {}
+		virtual void OnReplay(const SessionFrame& frame) {}
+
 		const std::string& GetName() const { return m_DebugName; }
 	protected:
 		std::string m_DebugName;
@@ -6,6 +6,7 @@
 #include "RGS/Texture.h"
 #include "RGS/Timer.h"
 #include "RGS/Config.h"
+#include "RGS/JobSystem.h"
 #include "RGS/Shader/BRDFShader.h"
 #include "RGS/Shader/ConvSkyShader.h"
 
@@ -16,7 +17,6 @@
 #include <imgui.h>
 #include <misc/cpp/imgui_stdlib.h>
 
-#include <thread>
 #include <windows.h>
 #ifdef _WIN32
     #include <direct.h> // For _mkdir on Windows
@@ -26,6 +26,20 @@
 
 namespace RGS {
 
+    // Runs a bake and clears its running flag once it finished (or failed).
+    static Task<void> RunTool(Task<void> tool, std::atomic<bool>& running)
+    {
+        try
+        {
+            co_await tool;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "执行失败: " << e.what() << std::endl;
+        }
+        running = false;
+    }
+
     void ToolLayer::OnImGuiRender(float t)
     {
         ImGui::Begin(m_DebugName.c_str());
@@ -41,69 +55,53 @@ namespace RGS {
             m_SkyboxPath.erase(m_SkyboxPath.size() - 1, m_SkyboxPath.size());
 
         /* Convolute */
-        if (ImGui::Button(m_ConvoluteDiffuseButtonName.c_str()) && !m_Convoluting)
+        if (ImGui::Button(m_Convoluting ? "Convoluting..." : "ConvoluteDiffuse") && !m_Convoluting)
         {
             m_Convoluting = true;
-            m_ConvoluteDiffuseButtonName = "Convoluting...";
-            std::thread work{ [&]() {
-                ConvoluteDiffuse(m_SkyboxPath, m_ConvDiffuseSaveDir);
-                m_Convoluting = false;
-                m_ConvoluteDiffuseButtonName = "ConvoluteDiffuse";
-            } };
-            work.detach();
+            Spawn(RunTool(ConvoluteDiffuse(m_SkyboxPath, m_ConvDiffuseSaveDir), m_Convoluting));
         }
 
         /* Prefilter */
-        if (ImGui::Button(m_PrefilterEnvMapButtonName.c_str()) && !m_Prefiltering)
+        if (ImGui::Button(m_Prefiltering ? "Prefiltering..." : "PrefilterEnvMap") && !m_Prefiltering)
         {
             m_Prefiltering = true;
-            m_PrefilterEnvMapButtonName = "Prefiltering...";
-            std::thread work{ [&]() {
-                PrefilterEnvMap(m_SkyboxPath);
-                m_Prefiltering = false;
-                m_PrefilterEnvMapButtonName = "PrefilterEnvMap";
-            }};
-            work.detach();
+            Spawn(RunTool(PrefilterEnvMap(m_SkyboxPath), m_Prefiltering));
         }
         
         /* Integrate */
-        if (ImGui::Button(m_IntegrateBRDFButtonName.c_str()) && !m_Integrating)
+        if (ImGui::Button(m_Integrating ? "Integrating..." : "IntegrateBRDF") && !m_Integrating)
         {
             m_Integrating = true;
-            m_IntegrateBRDFButtonName = "Integrating...";
-;
-            std::thread work{ [&]() {
-                IntegrateBRDF(m_BRDFLutSaveDir);
-                m_Integrating = false;
-                m_IntegrateBRDFButtonName = "IntegrateBRDF";
-            }};
-            work.detach();
+            Spawn(RunTool(IntegrateBRDF(m_BRDFLutSaveDir), m_Integrating));
         }
 
         ImGui::End();
     }
 
-    void ToolLayer::ConvoluteDiffuse(std::string skyboxPath, std::string saveDir)
+    Task<void> ToolLayer::ConvoluteDiffuse(std::string skyboxPath, std::string saveDir)
     {
         if (auto index = skyboxPath.rfind(".hdr");
             index == std::string::npos || index + 4 != skyboxPath.size())
         {
             std::cout << "非法后缀" << std::endl;
-            return;
+            co_return;
         }
         auto index = skyboxPath.rfind("\\");
         if (index == std::string::npos)
         {
             std::cout << "加载失败" << std::endl;
-            return;
+            co_return;
         }
 
-        TextureSphere* tex = TextureSphere::LoadTextureSphere(skyboxPath);
+        // Decode the HDR on a worker, the coroutine continues there
+        std::unique_ptr<TextureSphere> tex(co_await JobSystem::ExecuteAsync([skyboxPath]()
+        {
+            return TextureSphere::LoadTextureSphere(skyboxPath);
+        }, JobSystem::JobPriority::Background));
         if (tex == nullptr)
         {
             std::cout << "加载失败" << std::endl;
-            delete tex;
-            return;
+            co_return;
         }
 
         Timer timer;
@@ -117,13 +115,15 @@ namespace RGS {
 
         auto framebuffer = Framebuffer::Create(width, height);
 
+        JobSystem::Context context;
+        context.Priority = JobSystem::JobPriority::Background;
 
         auto program = std::make_shared<Program<ConvSkyVertex, ConvSkyUniforms, ConvSkyVaryings>>(ConvSkyVertexShader, ConvSkyFragmentShader);
-        program->EnableJobSystem = false;
+        program->JobContext = &context;
 
         auto uniforms = std::make_shared<ConvSkyUniforms> ();
         uniforms->MVP = Mat4Perspective(90.0f / 360.0f * 2.0f * PI, 1, 0.1f, 100.0f) * Mat4Identity();
-        uniforms->SkyboxTex = tex;
+        uniforms->SkyboxTex = tex.get();
 
 
         Triangle<ConvSkyVertex> tri;
@@ -136,28 +136,31 @@ namespace RGS {
         tri.Vertex[1].ModelPos = { 5, 5, -5, 1 };
         tri.Vertex[2].ModelPos = { -5, 5, -5, 1 };
         Renderer::DrawTriangle(*framebuffer, program, tri, uniforms);
+        co_await context;
 
-        stbi_flip_vertically_on_write(true);
-        stbi_write_hdr(savePath.c_str(), width, height, 3, framebuffer->GetRawColorData());
-        delete tex;
+        co_await JobSystem::ExecuteAsync([&]()
+        {
+            stbi_flip_vertically_on_write(true);
+            stbi_write_hdr(savePath.c_str(), width, height, 3, framebuffer->GetRawColorData());
+        }, JobSystem::JobPriority::Background);
 
         double duration = timer.GetDuration();
         std::cout << "Complete ConvDiffuse in " << duration / 1000. << "s" << std::endl;
     }
 
-    void ToolLayer::PrefilterEnvMap(std::string skyboxPath)
+    Task<void> ToolLayer::PrefilterEnvMap(std::string skyboxPath)
     {
         if (auto index = skyboxPath.rfind(".hdr");
             index == std::string::npos || index + 4 != skyboxPath.size())
         {
             std::cout << "非法后缀" << std::endl;
-            return;
+            co_return;
         }
         auto index = skyboxPath.rfind("\\");
         if (index == std::string::npos)
         {
             std::cout << "加载失败" << std::endl;
-            return;
+            co_return;
         }
 
         std::string prefilterEnvMapDir = skyboxPath.substr(index + 1, skyboxPath.size() - index - 5);
@@ -169,26 +172,35 @@ namespace RGS {
         if (ret == -1)
         {
             std::cout << "创建目录失败" << std::endl;
-            return;
+            co_return;
         }
 #else
     mkdir(prefilterEnvMapDir.c_str());
 #endif
 
-        std::unique_ptr<LodTextureSphere> skybox(new LodTextureSphere(skyboxPath));
-        
-        for (int i = 4; i >= 0; --i)
+        std::unique_ptr<LodTextureSphere> skybox(co_await JobSystem::ExecuteAsync([skyboxPath]()
+        {
+            return new LodTextureSphere(skyboxPath);
+        }, JobSystem::JobPriority::Background));
+
+        Timer timer;
+
+        // All five roughness levels are rendered into one context, so their jobs interleave on the workers
+        constexpr int levelCount = 5;
+        JobSystem::Context context;
+        context.Priority = JobSystem::JobPriority::Background;
+
+        std::unique_ptr<Framebuffer> framebuffers[levelCount];
+        for (int i = levelCount - 1; i >= 0; --i)
         {
             float roughness = 0.25f * (float)i;
-            int width = Config::PrefilterEnvMapMinWidth * (5 - i);
+            int width = Config::PrefilterEnvMapMinWidth * (levelCount - i);
             int height = width / 2;
 
-            Timer timer;
-
-            auto framebuffer = Framebuffer::Create(width, height);
+            framebuffers[i] = Framebuffer::Create(width, height);
 
             auto program = std::make_shared<Program<PrefilterVertex, PrefilterUniforms, PrefilterVaryings>>(PrefilterVertexShader, PrefilterFragmentShader);
-            program->EnableJobSystem = false;
+            program->JobContext = &context;
 
             auto uniforms = std::make_shared<PrefilterUniforms>() ;
             uniforms->MVP = Mat4Perspective(90.0f / 360.0f * 2.0f * PI, 1, 0.1f, 100.0f) * Mat4Identity();
@@ -199,30 +211,39 @@ namespace RGS {
             tri.Vertex[0].ModelPos = { -5, -5, -5, 1 };
             tri.Vertex[1].ModelPos = { 5, -5, -5, 1 };
             tri.Vertex[2].ModelPos = { -5, 5, -5, 1 };
-            Renderer::DrawTriangle(*framebuffer, program, tri, uniforms);
+            Renderer::DrawTriangle(*framebuffers[i], program, tri, uniforms);
 
             tri.Vertex[0].ModelPos = { 5, -5, -5, 1 };
             tri.Vertex[1].ModelPos = { 5, 5, -5, 1 };
             tri.Vertex[2].ModelPos = { -5, 5, -5, 1 };
-            Renderer::DrawTriangle(*framebuffer, program, tri, uniforms);
+            Renderer::DrawTriangle(*framebuffers[i], program, tri, uniforms);
+        }
+        co_await context;
 
-            stbi_flip_vertically_on_write(true);
+        for (int i = levelCount - 1; i >= 0; --i)
+        {
             std::string path{ prefilterEnvMapDir };
             path.append("\\");
             path.append(std::to_string(i));
             path.append(".hdr");
-            stbi_write_hdr(path.c_str(), width, height, 3, framebuffer->GetRawColorData());
 
-            m_Prefiltering = false;
-            m_PrefilterEnvMapButtonName = "Prefilter";
-            double duration = timer.GetDuration();
-            std::cout << "Complete PrefilterEnvMap in " << duration / 1000. << "s" << std::endl;
+            co_await JobSystem::ExecuteAsync([&]()
+            {
+                stbi_flip_vertically_on_write(true);
+                stbi_write_hdr(path.c_str(), framebuffers[i]->GetWidth(), framebuffers[i]->GetHeight(), 3, framebuffers[i]->GetRawColorData());
+            }, JobSystem::JobPriority::Background);
             std::cout << " - Path: " << path << std::endl;
         }
+
+        double duration = timer.GetDuration();
+        std::cout << "Complete PrefilterEnvMap in " << duration / 1000. << "s" << std::endl;
     }
 
-    void ToolLayer::IntegrateBRDF(std::string saveDir)
+    Task<void> ToolLayer::IntegrateBRDF(std::string saveDir)
     {
+        // Continue on a worker right away, the write check and the draws would otherwise run on the UI thread
+        co_await JobSystem::Schedule(JobSystem::JobPriority::Background);
+
         std::string path = saveDir + "\\brdf.jpg";
         int width = Config::IntegrateBRDFWidth;
         int height = width;
@@ -231,14 +252,17 @@ namespace RGS {
         if (ret == 0)
         {
             std::cout << "写入失败" << std::endl;
-            return;
+            co_return;
         }
 
         Timer timer;
 
+        JobSystem::Context context;
+        context.Priority = JobSystem::JobPriority::Background;
+
         auto framebuffer = Framebuffer::Create(width, height);
         auto program = std::make_shared<Program<BRDFVertex, BRDFUniforms, BRDFVaryings>>(BRDFVertexShader, BRDFFragmentShader);
-        program->EnableJobSystem = false;
+        program->JobContext = &context;
         auto uniforms = std::make_shared<BRDFUniforms>();
         uniforms->MVP = Mat4Perspective(90.0f / 360.0f * 2.0f * PI, 1, 0.1f, 100.0f) * Mat4Identity();
         
@@ -251,10 +275,14 @@ namespace RGS {
         tri.Vertex[1].ModelPos = { 5, 5, -5, 1 };
         tri.Vertex[2].ModelPos = { -5, 5, -5, 1 };
         Renderer::DrawTriangle(*framebuffer, program, tri, uniforms);
+        co_await context;
         
-        auto buf = framebuffer->GetRGBColorData();
-        stbi_flip_vertically_on_write(true);
-        ret = stbi_write_jpg(path.c_str(), width, height, 3, buf.get(), 100);
+        ret = co_await JobSystem::ExecuteAsync([&]()
+        {
+            auto buf = framebuffer->GetRGBColorData();
+            stbi_flip_vertically_on_write(true);
+            return stbi_write_jpg(path.c_str(), width, height, 3, buf.get(), 100);
+        }, JobSystem::JobPriority::Background);
         if (ret == 0)
         {
             std::cout << "写入失败" << std::endl;
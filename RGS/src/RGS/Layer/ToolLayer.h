@@ -1,7 +1,9 @@
 #pragma once 
 #include "Layer.h"
 #include "RGS/Texture.h"
+#include "RGS/Task.h"
 #include <string>
+#include <atomic>
 
 namespace RGS {
 
@@ -19,23 +21,21 @@ namespace RGS {
 
 	private:
 		// Convolute Diffuse
-		std::string m_ConvoluteDiffuseButtonName = "ConvoluteDiffuse";
-		bool m_Convoluting = false;
+		std::atomic<bool> m_Convoluting = false;
 		std::string m_SkyboxPath = ".\\Assets\\hdr\\container_free_hdr\\Container_Free\\container_free_Ref.hdr";
 		std::string m_ConvDiffuseSaveDir = ".\\Assets";
 
 		// Prefilter EnvMap
-		std::string m_PrefilterEnvMapButtonName = "PrefilterEnvMap";
-		bool m_Prefiltering = false;
+		std::atomic<bool> m_Prefiltering = false;
 
 		// Integrate BRDF
-		std::string m_IntegrateBRDFButtonName = "IntegrateBRDF";
-		bool m_Integrating = false;
+		std::atomic<bool> m_Integrating = false;
 		std::string m_BRDFLutSaveDir = ".\\Assets";
 
-		void ConvoluteDiffuse(std::string skyboxPath, std::string saveDir);
-		void PrefilterEnvMap(std::string skyboxPath);
-		void IntegrateBRDF(std::string saveDir);
+		// Bakes run as coroutines on Background jobs, loading, rendering and writing without blocking a thread
+		Task<void> ConvoluteDiffuse(std::string skyboxPath, std::string saveDir);
+		Task<void> PrefilterEnvMap(std::string skyboxPath);
+		Task<void> IntegrateBRDF(std::string saveDir);
 	};
 
 }
\ No newline at end of file
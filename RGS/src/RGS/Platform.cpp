@@ -1,7 +1,16 @@
 #include "rgspch.h"
 #include "Platform.h"
 #include "RGS/Window.h"
-#include <windows.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
 
 namespace RGS {
     
@@ -17,9 +26,22 @@ namespace RGS {
 
     void Platform::PollInputEvents() 
     {
+#ifdef _WIN32
         WindowsPollInputEventsImpl();
+#endif
+        // Headless windows have no input events
+    }
+
+    uint32_t Platform::GetCurrentThreadID()
+    {
+#ifdef _WIN32
+        return (uint32_t)::GetCurrentThreadId();
+#else
+        return (uint32_t)syscall(SYS_gettid);
+#endif
     }
 
+#ifdef _WIN32
     void Platform::WindowsPollInputEventsImpl()
     {
         MSG message;
@@ -29,6 +51,83 @@ namespace RGS {
             DispatchMessage(&message);
         }
     }
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (data == nullptr)
+        {
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
 
-}
+        m_File = file;
+        m_Mapping = mapping;
+        m_Data = (const uint8_t*)data;
+        m_Size = (size_t)size.QuadPart;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle((HANDLE)m_Mapping);
+        if (m_File)
+            CloseHandle((HANDLE)m_File);
+        m_Data = nullptr;
+        m_Mapping = nullptr;
+        m_File = nullptr;
+        m_Size = 0;
+    }
+#else
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat info;
+        void* data = MAP_FAILED;
+        if (fstat(file, &info) == 0 && info.st_size > 0)
+            data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // The mapping keeps the file alive
+        close(file);
+        if (data == MAP_FAILED)
+            return false;
+
+        m_Data = (const uint8_t*)data;
+        m_Size = (size_t)info.st_size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            munmap((void*)m_Data, m_Size);
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+#endif
 
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace RGS {
     class Platform {
@@ -7,9 +10,41 @@ namespace RGS {
         static void Terminate();
         static void PollInputEvents();
 
+        // Id the OS gives the calling thread, the one debuggers and system profilers show
+        static uint32_t GetCurrentThreadID();
+
     private:
+#ifdef _WIN32
         static void WindowsPollInputEventsImpl();
+#endif
     };
-}
 
+    // Read-only view of a whole file mapped into the address space. The OS reads the pages on
+    // first access and may drop them again, so the file costs no RAM until it is touched.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // false when the file can't be opened or is empty
+        bool Open(const std::string& path);
+        void Close();
+
+        bool IsOpen() const { return m_Data != nullptr; }
+        const uint8_t* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#endif
+    };
+}
 
@@ -0,0 +1,89 @@
+#include "rgspch.h"
+#include "FrameTimings.h"
+
+#include <fstream>
+
+namespace RGS {
+
+    static RollingHistogram s_FrameTimes;
+    static FrameTimings::StageTimings s_StageTimings[(int)RenderStage::Count];
+    static std::map<std::string, RollingHistogram> s_CommandTimings;
+
+    void FrameTimings::AddFrameTime(const float ms)
+    {
+        s_FrameTimes.Add(ms);
+    }
+
+    void FrameTimings::AddStageTime(const RenderStage stage, const float executeMs, const float waitMs)
+    {
+        StageTimings& timings = s_StageTimings[(int)stage];
+        timings.Execute.Add(executeMs);
+        timings.Wait.Add(waitMs);
+        timings.Total.Add(executeMs + waitMs);
+    }
+
+    void FrameTimings::AddCommandTime(const std::string& name, const float ms)
+    {
+        auto it = s_CommandTimings.find(name);
+        if (it == s_CommandTimings.end())
+            it = s_CommandTimings.emplace(name, RollingHistogram()).first;
+        it->second.Add(ms);
+    }
+
+    const RollingHistogram& FrameTimings::GetFrameTimes()
+    {
+        return s_FrameTimes;
+    }
+
+    const FrameTimings::StageTimings& FrameTimings::GetStageTimings(const RenderStage stage)
+    {
+        return s_StageTimings[(int)stage];
+    }
+
+    const std::map<std::string, RollingHistogram>& FrameTimings::GetCommandTimings()
+    {
+        return s_CommandTimings;
+    }
+
+    void FrameTimings::Clear()
+    {
+        s_FrameTimes.Clear();
+        for (StageTimings& timings : s_StageTimings)
+        {
+            timings.Execute.Clear();
+            timings.Wait.Clear();
+            timings.Total.Clear();
+        }
+        s_CommandTimings.clear();
+    }
+
+    bool FrameTimings::ExportCSV(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file.is_open())
+            return false;
+
+        auto writeRow = [&file](const std::string& name, const RollingHistogram& histogram)
+        {
+            RollingHistogram::Percentiles p = histogram.GetPercentiles();
+            file << name << ',' << histogram.GetCount() << ','
+                 << p.Mean << ',' << p.P50 << ',' << p.P95 << ',' << p.P99 << ',' << p.Max << '\n';
+        };
+
+        file << "name,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+        writeRow("Frame", s_FrameTimes);
+        for (int stage = 0; stage < (int)RenderStage::Count; ++stage)
+        {
+            const std::string stageName = std::string("Stage/") + Pipeline::GetStageName((RenderStage)stage);
+            writeRow(stageName + "/Execute", s_StageTimings[stage].Execute);
+            writeRow(stageName + "/Wait", s_StageTimings[stage].Wait);
+            writeRow(stageName + "/Total", s_StageTimings[stage].Total);
+        }
+        for (const auto& [name, histogram] : s_CommandTimings)
+        {
+            writeRow("Command/" + name, histogram);
+        }
+        return true;
+    }
+
+}
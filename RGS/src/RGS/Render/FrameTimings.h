@@ -0,0 +1,37 @@
+#pragma once
+#include "RGS/Base/RollingHistogram.h"
+#include "Pipeline.h"
+
+#include <map>
+#include <string>
+
+namespace RGS {
+
+    // Rolling CPU timings (in ms) of the frames, the pipeline stages and the render commands.
+    // Always compiled in, every sample is a couple of clock reads on the main thread.
+    class FrameTimings
+    {
+    public:
+        struct StageTimings
+        {
+            RollingHistogram Execute;   // Issuing the commands of the stage.
+            RollingHistogram Wait;      // JobSystem::Wait at the stage boundary, i.e. finishing their jobs.
+            RollingHistogram Total;
+        };
+
+        static void AddFrameTime(const float ms);
+        static void AddStageTime(const RenderStage stage, const float executeMs, const float waitMs);
+        // Commands only issue their jobs, so for draws this is the vertex stage and the dispatch.
+        static void AddCommandTime(const std::string& name, const float ms);
+
+        static const RollingHistogram& GetFrameTimes();
+        static const StageTimings& GetStageTimings(const RenderStage stage);
+        static const std::map<std::string, RollingHistogram>& GetCommandTimings();
+
+        static void Clear();
+
+        // One row per histogram: name, sample count, mean, p50, p95, p99 and max.
+        static bool ExportCSV(const std::string& path);
+    };
+
+}
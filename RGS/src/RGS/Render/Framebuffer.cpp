@@ -1,6 +1,8 @@
 #include "rgspch.h"
 #include "Framebuffer.h"
+#include "PostProcess.h"
 #include "RGS/JobSystem.h"
+#include "RGS/Tuning.h"
 
 namespace RGS {
 
@@ -175,6 +177,13 @@ namespace RGS {
     {
         std::fill(m_ColorBuffer, m_ColorBuffer + m_PixelSize, color);
         std::fill(m_RawColorBuffer, m_RawColorBuffer + m_RawPixelSize, color);
+
+        if (m_DebugCounters)
+        {
+            const uint32_t size = (uint32_t)DebugCounter::Count * m_PixelSize;
+            for (uint32_t i = 0; i < size; ++i)
+                m_DebugCounters[i].store(0, std::memory_order_relaxed);
+        }
     }
 
     void Framebuffer::ClearDepth(float depth)
@@ -218,7 +227,7 @@ namespace RGS {
     {
         RGS_PROFILE_FUNCTION();
         uint32_t jobCount = m_PixelSize;
-        constexpr uint32_t groupSize = 1024u;
+        const uint32_t groupSize = Tuning::GetGroupSize(TunedKernel::Resolve);
         JobSystem::Dispatch(jobCount, groupSize, [this](JobSystem::JobDispatchArgs args)
         {
             uint32_t idx = args.JobIndex;
@@ -239,6 +248,23 @@ namespace RGS {
             JobSystem::Wait();
     }
 
+    void Framebuffer::PostProcess(const PostProcessSettings& settings, const bool wait)
+    {
+        RGS_PROFILE_FUNCTION();
+        const EncodingLUT& lut = EncodingLUT::Get(settings.Encoding);
+        const uint32_t groupSize = Tuning::GetGroupSize(TunedKernel::PostProcess);
+        JobSystem::Dispatch(m_PixelSize, groupSize, [this, &lut, settings](JobSystem::JobDispatchArgs args)
+        {
+            const Vec3 color = m_ColorBuffer[args.JobIndex] * settings.Exposure;
+            m_ColorBuffer[args.JobIndex] = { lut.Encode(ToneMap(color.X, settings.ToneMap)),
+                                             lut.Encode(ToneMap(color.Y, settings.ToneMap)),
+                                             lut.Encode(ToneMap(color.Z, settings.ToneMap)) };
+        });
+
+        if (wait)
+            JobSystem::Wait();
+    }
+
     void Framebuffer::Blit(const Framebuffer& srcFramebuffer, bool copyColor, bool copyDepth)
     {
         RGS_PROFILE_FUNCTION();
@@ -293,5 +319,62 @@ namespace RGS {
         }
     }
 
-}
+    void Framebuffer::EnableDebugCounters(const bool enable, const bool timeShaders)
+    {
+        m_TimeShaders = enable && timeShaders;
+        if (!enable)
+        {
+            m_DebugCounters.reset();
+        }
+        else if (!m_DebugCounters)
+        {
+            // value-initialized, i.e. all zero
+            m_DebugCounters.reset(new std::atomic<uint32_t>[(uint32_t)DebugCounter::Count * m_PixelSize]());
+        }
+    }
+
+    uint32_t Framebuffer::GetMaxDebugCounter(const DebugCounter counter) const
+    {
+        if (!m_DebugCounters)
+            return 0;
+
+        uint32_t maxValue = 0;
+        const std::atomic<uint32_t>* plane = &m_DebugCounters[(uint32_t)counter * m_PixelSize];
+        for (uint32_t i = 0; i < m_PixelSize; ++i)
+            maxValue = std::max(maxValue, plane[i].load(std::memory_order_relaxed));
+        return maxValue;
+    }
 
+    // black -> blue -> cyan -> green -> yellow -> red
+    static Vec3 HeatmapColor(float t)
+    {
+        static const Vec3 ramp[] = {
+            { 0.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f },
+            { 0.0f, 1.0f, 1.0f },
+            { 0.0f, 1.0f, 0.0f },
+            { 1.0f, 1.0f, 0.0f },
+            { 1.0f, 0.0f, 0.0f },
+        };
+        constexpr int segments = sizeof(ramp) / sizeof(ramp[0]) - 1;
+
+        t = Clamp(t, 0.0f, 1.0f) * segments;
+        int index = std::min((int)t, segments - 1);
+        return Lerp(ramp[index], ramp[index + 1], t - (float)index);
+    }
+
+    void Framebuffer::ResolveHeatmap(const DebugCounter counter, const uint32_t maxValue)
+    {
+        RGS_PROFILE_FUNCTION();
+        if (!m_DebugCounters)
+            return;
+
+        const uint32_t scale = maxValue > 0 ? maxValue : std::max(GetMaxDebugCounter(counter), 1u);
+        const std::atomic<uint32_t>* plane = &m_DebugCounters[(uint32_t)counter * m_PixelSize];
+        for (uint32_t i = 0; i < m_PixelSize; ++i)
+        {
+            m_ColorBuffer[i] = HeatmapColor((float)plane[i].load(std::memory_order_relaxed) / (float)scale);
+        }
+    }
+
+}
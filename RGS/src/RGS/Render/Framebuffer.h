@@ -2,7 +2,21 @@
 #include "RGS/Base/Maths.h"
 #include "MSAASettings.h"
 
+#include <atomic>
+#include <memory>
+
 namespace RGS {
+
+    struct PostProcessSettings;
+
+    // Per-pixel counters accumulated while drawing, for the heatmap debug view.
+    enum class DebugCounter
+    {
+        FragmentsShaded,    // Fragment shader invocations, i.e. overdraw.
+        DepthRejects,       // Covered samples rejected by the early depth test.
+        ShaderCycles,       // Time spent in the fragment shader, see ReadCycleCounter.
+        Count
+    };
     
     class Framebuffer 
     {
@@ -35,6 +49,29 @@ namespace RGS {
         void Blit(const Framebuffer& srcFramebuffer, bool copyColor = true, bool copyDepth = false);
         void Resolve();
         void ResolveParallel(const bool wait = true);
+        // Tonemaps and encodes the resolved (linear HDR) colors in place, see PostProcessSettings
+        void PostProcess(const PostProcessSettings& settings, const bool wait = true);
+
+        // Allocates (or frees) the debug counters. Timing the fragment shader is optional as it costs 
+        // two timestamps per fragment. The counters are cleared together with the color buffer.
+        void EnableDebugCounters(const bool enable, const bool timeShaders = false);
+        bool HasDebugCounters() const { return m_DebugCounters != nullptr; }
+        bool IsTimingShaders() const { return m_TimeShaders; }
+
+        // Safe to call from concurrent draws.
+        void AddDebugCounter(const int x, const int y, const DebugCounter counter, const uint32_t value)
+        {
+            m_DebugCounters[(uint32_t)counter * m_PixelSize + GetPixelIndex(x, y)].fetch_add(value, std::memory_order_relaxed);
+        }
+        uint32_t GetDebugCounter(const int x, const int y, const DebugCounter counter) const
+        {
+            return m_DebugCounters[(uint32_t)counter * m_PixelSize + GetPixelIndex(x, y)].load(std::memory_order_relaxed);
+        }
+        uint32_t GetMaxDebugCounter(const DebugCounter counter) const;
+
+        // Replaces the resolved color buffer by a false-color heatmap of the counter. 
+        // Values are scaled by maxValue, or by the largest value of the frame if it is 0.
+        void ResolveHeatmap(const DebugCounter counter, const uint32_t maxValue = 0);
 
     private:
 
@@ -60,6 +97,9 @@ namespace RGS {
 
         Vec3* m_RawColorBuffer;         // Pointer to the MSAA color buffer.
         float* m_RawDepthBuffer;        // Pointer to the MSAA depth buffer.
+
+        std::unique_ptr<std::atomic<uint32_t>[]> m_DebugCounters;    // DebugCounter::Count planes of m_PixelSize counters, null when disabled.
+        bool m_TimeShaders = false;                                  // Whether ShaderCycles is accumulated.
     };
 
 }
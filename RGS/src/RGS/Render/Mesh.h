@@ -4,6 +4,9 @@
 #include <vector>
 #include <memory>
 #include <iterator>
+#include <string>
+#include <fstream>
+#include <sstream>
 
 namespace RGS {
 
@@ -38,6 +41,8 @@ namespace RGS {
         static std::shared_ptr<Mesh<VertexBase3D>> CreateSphereMesh();
         static std::shared_ptr<Mesh<VertexBase3D>> CreateBoxMesh();
         static std::shared_ptr<Mesh<VertexBase3D>> CreateQuadMesh();
+        // Positions and normals of a Wavefront .obj, polygons are fanned into triangles. nullptr if it can't be read.
+        static std::shared_ptr<Mesh<VertexBase3D>> LoadObjMesh(const std::string& path);
     };
 
     template<typename vertex_t>
@@ -244,4 +249,83 @@ namespace RGS {
 
         return mesh;
     }
-}
+
+    template<typename vertex_t>
+    std::shared_ptr<Mesh<VertexBase3D>> Mesh<vertex_t>::LoadObjMesh(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return nullptr;
+
+        auto mesh = std::make_shared<Mesh<VertexBase3D>>();
+
+        std::vector<Vec3> positions;
+        std::vector<Vec3> normals;
+
+        // 1-based, negative indices count from the end
+        auto resolve = [](int index, size_t count) { return index > 0 ? index - 1 : (int)count + index; };
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            std::string type;
+            stream >> type;
+            if (type == "v")
+            {
+                Vec3 position;
+                stream >> position.X >> position.Y >> position.Z;
+                positions.push_back(position);
+            }
+            else if (type == "vn")
+            {
+                Vec3 normal;
+                stream >> normal.X >> normal.Y >> normal.Z;
+                normals.push_back(normal);
+            }
+            else if (type == "f")
+            {
+                // v, v/vt, v//vn or v/vt/vn
+                std::vector<std::pair<int, int>> corners;
+                std::string corner;
+                while (stream >> corner)
+                {
+                    int posIndex = 0, normalIndex = 0;
+                    size_t firstSlash = corner.find('/');
+                    posIndex = std::stoi(corner.substr(0, firstSlash));
+                    if (firstSlash != std::string::npos)
+                    {
+                        size_t secondSlash = corner.find('/', firstSlash + 1);
+                        if (secondSlash != std::string::npos && secondSlash + 1 < corner.size())
+                            normalIndex = std::stoi(corner.substr(secondSlash + 1));
+                    }
+                    corners.emplace_back(resolve(posIndex, positions.size()), 
+                                         normalIndex != 0 ? resolve(normalIndex, normals.size()) : -1);
+                }
+
+                for (size_t i = 2; i < corners.size(); ++i)
+                {
+                    const std::pair<int, int> triCorners[3] = { corners[0], corners[i - 1], corners[i] };
+                    Triangle<VertexBase3D> tri;
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        if (triCorners[j].first < 0 || triCorners[j].first >= (int)positions.size())
+                            return nullptr;
+                        tri.Vertex[j].ModelPos = Vec4(positions[triCorners[j].first], 1.0f);
+                    }
+
+                    const Vec3 faceNormal = Normalize(Cross(Vec3(tri.Vertex[1].ModelPos - tri.Vertex[0].ModelPos),
+                                                            Vec3(tri.Vertex[2].ModelPos - tri.Vertex[0].ModelPos)));
+                    for (int j = 0; j < 3; ++j)
+                    {
+                        const int normalIndex = triCorners[j].second;
+                        tri.Vertex[j].ModelNormal = (normalIndex >= 0 && normalIndex < (int)normals.size()) ? normals[normalIndex] : faceNormal;
+                    }
+                    mesh->Triangles.emplace_back(tri);
+                }
+            }
+        }
+
+        return mesh;
+    }
+}
\ No newline at end of file
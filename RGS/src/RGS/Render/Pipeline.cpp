@@ -1,24 +1,44 @@
 #include "rgspch.h"
 #include "Pipeline.h"
-#include "Application.h"
+#include "FrameTimings.h"
+#include "RGS/JobSystem.h"
+#include "RGS/Timer.h"
 
 namespace RGS {
 
+#if RGS_ENABLE_RENDER_STATS
+    static FrameStats s_FrameStats;
+#endif
+
     void Pipeline::BeginFrame()
     {
         m_BeginFrameQueue.clear();
         m_GeometryQueue.clear();
         m_TransparentQueue.clear();
         m_EndFrameQueue.clear();
+#if RGS_ENABLE_RENDER_STATS
+        m_UsedCommandStats = 0;
+#endif
     }
 
     void Pipeline::EndFrame()
     {
         FlushCommandQueue();
+#if RGS_ENABLE_RENDER_STATS
+        // Every command has been recorded and released
+        m_UsedCommandStats = 0;
+#endif
     }
 
     void Pipeline::AddCommand(std::unique_ptr<RenderCommand> command, RenderStage stage)
     {
+#if RGS_ENABLE_RENDER_STATS
+        if (m_UsedCommandStats == m_CommandStats.size())
+            m_CommandStats.emplace_back(std::make_unique<RenderStats>());
+        RenderStats* stats = m_CommandStats[m_UsedCommandStats++].get();
+        stats->Reset();
+        command->SetStats(stats);
+#endif
         switch (stage)
         {
         case RenderStage::BeginFrame:
@@ -38,42 +58,91 @@ namespace RGS {
         }
     }
 
+    const char* Pipeline::GetStageName(RenderStage stage)
+    {
+        switch (stage)
+        {
+        case RenderStage::BeginFrame:   return "BeginFrame";
+        case RenderStage::Geometry:     return "Geometry";
+        case RenderStage::Transparent:  return "Transparent";
+        case RenderStage::EndFrame:     return "EndFrame";
+        default:                        return "Unknown";
+        }
+    }
+
+#if RGS_ENABLE_RENDER_STATS
+    const FrameStats& Pipeline::GetFrameStats()
+    {
+        return s_FrameStats;
+    }
+
+    void Pipeline::ResetFrameStats()
+    {
+        // Cleared rather than replaced, the draws of the next frame reuse the storage
+        s_FrameStats.Draws.clear();
+        for (RenderCounters& stage : s_FrameStats.Stages)
+            stage = RenderCounters();
+        s_FrameStats.Total = RenderCounters();
+    }
+#endif
+
+    void Pipeline::RecordStats(const std::vector<std::unique_ptr<RenderCommand>>& queue, RenderStage stage)
+    {
+#if RGS_ENABLE_RENDER_STATS
+        for (auto& command : queue)
+        {
+            RenderCounters counters = command->GetStats();
+            s_FrameStats.Stages[(int)stage] += counters;
+            s_FrameStats.Total += counters;
+            s_FrameStats.Draws.push_back({ command->GetName(), stage, counters });
+        }
+#endif
+    }
+
+    void Pipeline::ExecuteQueue(std::vector<std::unique_ptr<RenderCommand>>& queue, RenderStage stage)
+    {
+        // The draws only set up their triangles and bin them, so the command times don't include the rasterization
+        TileBinner* previous = TileBinner::GetCurrent();
+        TileBinner::SetCurrent(&m_Binner);
+        double executeTime = 0.0;
+        for (auto& command : queue)
+        {
+            Timer commandTimer;
+            command->Excecute();
+            double commandTime = commandTimer.GetDuration();
+            FrameTimings::AddCommandTime(command->GetName(), (float)commandTime);
+            executeTime += commandTime;
+        }
+        TileBinner::SetCurrent(previous);
+
+        // Every tile runs the triangles covering it in command order, the draws of a stage overlap freely
+        Timer waitTimer;
+        m_Binner.Rasterize();
+        JobSystem::Wait();
+        FrameTimings::AddStageTime(stage, (float)executeTime, (float)waitTimer.GetDuration());
+
+        // The queue is only cleared once its jobs have finished, the jobs write to the stats of their command
+        RecordStats(queue, stage);
+        queue.clear();
+    }
+
     void Pipeline::FlushCommandQueue()
     {
         {
             RGS_PROFILE_SCOPE("m_BeginFrameQueue");
-            for (auto& command : m_BeginFrameQueue)
-            {
-                command->Excecute();
-            }
-            m_BeginFrameQueue.clear();
-            JobSystem::Wait();
+            ExecuteQueue(m_BeginFrameQueue, RenderStage::BeginFrame);
         }
 
         {
             RGS_PROFILE_SCOPE("m_GeometryQueue");   
-            for (auto& command : m_GeometryQueue)
-            {
-                command->Excecute();
-            }
-            m_GeometryQueue.clear();
-            JobSystem::Wait();
+            ExecuteQueue(m_GeometryQueue, RenderStage::Geometry);
         }
 
         {
             RGS_PROFILE_SCOPE("m_TransparentQueue");
-            for (auto& command : m_TransparentQueue)
-            {
-                command->Excecute();
-                JobSystem::Wait();
-            }
-            m_TransparentQueue.clear();
+            ExecuteQueue(m_TransparentQueue, RenderStage::Transparent);
         }
-        for (auto& command : m_EndFrameQueue)
-        {
-            command->Excecute();
-        }
-        m_EndFrameQueue.clear();
+        ExecuteQueue(m_EndFrameQueue, RenderStage::EndFrame);
     }
 
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 #include "RenderCommand.h"
+#include "TileBinner.h"
 
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace RGS
 {
@@ -13,8 +15,26 @@ namespace RGS
         Geometry,
         Transparent,
         EndFrame,
+        Count
     };
 
+#if RGS_ENABLE_RENDER_STATS
+    struct DrawStats
+    {
+        std::string Name;
+        RenderStage Stage;
+        RenderCounters Counters;
+    };
+
+    // Counters of all commands flushed by any Pipeline since the last ResetFrameStats.
+    struct FrameStats
+    {
+        std::vector<DrawStats> Draws;
+        RenderCounters Stages[(int)RenderStage::Count];
+        RenderCounters Total;
+    };
+#endif
+
     class Pipeline
     {
     public:
@@ -23,13 +43,33 @@ namespace RGS
 
         void AddCommand(std::unique_ptr<RenderCommand> command, RenderStage stage);
 
+        static const char* GetStageName(RenderStage stage);
+
+#if RGS_ENABLE_RENDER_STATS
+        static const FrameStats& GetFrameStats();
+        // Called once at the start of every frame
+        static void ResetFrameStats();
+#endif
+
     private:
         void FlushCommandQueue();
+        // Executes the commands, rasterizes the triangles their draws binned, waits for their jobs and records their timings and stats.
+        void ExecuteQueue(std::vector<std::unique_ptr<RenderCommand>>& queue, RenderStage stage);
+        // Adds the counters of the commands to the frame stats, their jobs must have finished.
+        void RecordStats(const std::vector<std::unique_ptr<RenderCommand>>& queue, RenderStage stage);
 
         std::vector<std::unique_ptr<RenderCommand>> m_BeginFrameQueue;
         std::vector<std::unique_ptr<RenderCommand>> m_GeometryQueue;
         std::vector<std::unique_ptr<RenderCommand>> m_TransparentQueue;
         std::vector<std::unique_ptr<RenderCommand>> m_EndFrameQueue;
+        // The draws of a stage add their triangles here, each tile is then rasterized by one job
+        TileBinner m_Binner;
+#if RGS_ENABLE_RENDER_STATS
+        // One per command added since the queues were last emptied, kept across frames so a command
+        // doesn't allocate its thread slots
+        std::vector<std::unique_ptr<RenderStats>> m_CommandStats;
+        size_t m_UsedCommandStats = 0;
+#endif
     };
 
 }
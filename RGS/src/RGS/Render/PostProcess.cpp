@@ -0,0 +1,65 @@
+#include "rgspch.h"
+#include "PostProcess.h"
+
+#include <cmath>
+
+namespace RGS {
+
+    const char* PostProcessSettings::GetName(const ToneMapOperator toneMap)
+    {
+        switch (toneMap)
+        {
+        case ToneMapOperator::None:         return "None";
+        case ToneMapOperator::Reinhard:     return "Reinhard";
+        case ToneMapOperator::ACES:         return "ACES";
+        default:                            return "Unknown";
+        }
+    }
+
+    const char* PostProcessSettings::GetName(const OutputEncoding encoding)
+    {
+        switch (encoding)
+        {
+        case OutputEncoding::Linear:        return "Linear";
+        case OutputEncoding::Gamma22:       return "Gamma 2.2";
+        case OutputEncoding::SRGB:          return "sRGB";
+        default:                            return "Unknown";
+        }
+    }
+
+    const EncodingLUT& EncodingLUT::Get(const OutputEncoding encoding)
+    {
+        static const EncodingLUT luts[(int)OutputEncoding::Count] = { EncodingLUT(OutputEncoding::Linear),
+                                                                      EncodingLUT(OutputEncoding::Gamma22),
+                                                                      EncodingLUT(OutputEncoding::SRGB) };
+        return luts[(int)encoding];
+    }
+
+    EncodingLUT::EncodingLUT(const OutputEncoding encoding)
+    {
+        for (int i = 0; i < SegmentCount; ++i)
+        {
+            const float begin = std::bit_cast<float>(MinBits + ((uint32_t)i << FractionBits));
+            const float end = std::bit_cast<float>(MinBits + ((uint32_t)(i + 1) << FractionBits));
+            m_Base[i] = EncodeExact(begin, encoding);
+            m_Slope[i] = EncodeExact(end, encoding) - m_Base[i];
+        }
+        m_MinSlope = EncodeExact(MinValue, encoding) / MinValue;
+        m_One = EncodeExact(1.0f, encoding);
+    }
+
+    float EncodingLUT::EncodeExact(const float c, const OutputEncoding encoding)
+    {
+        const double x = Clamp(c, 0.0f, 1.0f);
+        switch (encoding)
+        {
+        case OutputEncoding::Gamma22:
+            return (float)std::pow(x, 1.0 / 2.2);
+        case OutputEncoding::SRGB:
+            return (float)(x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055);
+        default:
+            return (float)x;
+        }
+    }
+
+}
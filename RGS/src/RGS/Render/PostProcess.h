@@ -0,0 +1,92 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+
+#include <bit>
+#include <cstdint>
+
+namespace RGS {
+
+    enum class ToneMapOperator
+    {
+        None,           // Clamps to [0, 1]
+        Reinhard,       // c / (c + 1)
+        ACES,           // Narkowicz's fit of the ACES filmic curve
+        Count
+    };
+
+    enum class OutputEncoding
+    {
+        Linear,
+        Gamma22,        // c^(1/2.2), what the shaders used to apply themselves
+        SRGB,           // The piecewise sRGB transfer function
+        Count
+    };
+
+    // The shaders write linear HDR colors, this maps them to the displayed [0, 1] values once per pixel
+    // after the resolve (RenderCommand::PostProcess in the EndFrame stage).
+    struct PostProcessSettings
+    {
+        ToneMapOperator ToneMap = ToneMapOperator::Reinhard;
+        OutputEncoding Encoding = OutputEncoding::Gamma22;
+        float Exposure = 1.0f;
+
+        static const char* GetName(const ToneMapOperator toneMap);
+        static const char* GetName(const OutputEncoding encoding);
+    };
+
+    inline float ToneMap(const float c, const ToneMapOperator toneMap)
+    {
+        switch (toneMap)
+        {
+        case ToneMapOperator::Reinhard:
+            return c / (c + 1.0f);
+        case ToneMapOperator::ACES:
+            return Clamp((c * (2.51f * c + 0.03f)) / (c * (2.43f * c + 0.59f) + 0.14f), 0.0f, 1.0f);
+        default:
+            return Clamp(c, 0.0f, 1.0f);
+        }
+    }
+
+    // Piecewise linear table of an encoding over [0, 1]. The segments are indexed by the float exponent
+    // and the top mantissa bits, so they get shorter towards 0 where the curves are steep.
+    // The error against the exact curve stays below 1e-4, a 40th of an 8-bit step.
+    class EncodingLUT
+    {
+    public:
+        // Shared tables, built on first use
+        static const EncodingLUT& Get(const OutputEncoding encoding);
+
+        explicit EncodingLUT(const OutputEncoding encoding);
+
+        // c in [0, 1], clamped otherwise
+        float Encode(const float c) const
+        {
+            if (!(c > MinValue))
+                return c > 0.0f ? c * m_MinSlope : 0.0f;
+            if (c >= 1.0f)
+                return m_One;
+
+            const uint32_t offset = std::bit_cast<uint32_t>(c) - MinBits;
+            const uint32_t index = offset >> FractionBits;
+            const float t = (float)(offset & FractionMask) * (1.0f / (float)(1u << FractionBits));
+            return m_Base[index] + m_Slope[index] * t;
+        }
+
+        static float EncodeExact(const float c, const OutputEncoding encoding);
+
+    private:
+        static constexpr int MinExponent = -26;                                  // below 2^-26 the curve is a line through 0
+        static constexpr int MantissaBits = 4;                                   // 16 segments per octave
+        static constexpr int FractionBits = 23 - MantissaBits;
+        static constexpr uint32_t FractionMask = (1u << FractionBits) - 1u;
+        static constexpr uint32_t MinBits = (uint32_t)(127 + MinExponent) << 23;
+        static constexpr float MinValue = 1.0f / (float)(1u << -MinExponent);
+        static constexpr int SegmentCount = -MinExponent << MantissaBits;
+
+        float m_Base[SegmentCount];
+        float m_Slope[SegmentCount];
+        float m_MinSlope;
+        float m_One;
+    };
+
+}
@@ -1,13 +1,11 @@
 #include "rgspch.h"
 #include "RenderCommand.h"
 
-#include "Application.h"
-
 namespace RGS {
     
     std::unique_ptr<RenderCommand> RenderCommand::Clear(Framebuffer& framebuffer, Vec4 color)
     {
-        std::unique_ptr<RenderCommand> command(new RenderCommand());
+        std::unique_ptr<RenderCommand> command(new RenderCommand("Clear"));
         command->m_Self = [=, &framebuffer]() 
         {
             framebuffer.Clear(color);
@@ -17,7 +15,7 @@ namespace RGS {
     
     std::unique_ptr<RenderCommand> RenderCommand::ClearDepth(Framebuffer& framebuffer, float depth)
     {
-        std::unique_ptr<RenderCommand> command(new RenderCommand());
+        std::unique_ptr<RenderCommand> command(new RenderCommand("ClearDepth"));
         command->m_Self = [=, &framebuffer]() 
         {
             framebuffer.ClearDepth(depth);
@@ -27,7 +25,7 @@ namespace RGS {
 
     std::unique_ptr<RenderCommand> RenderCommand::ResolveParallel(Framebuffer& framebuffer, const bool wait)
     {
-        std::unique_ptr<RenderCommand> command(new RenderCommand());
+        std::unique_ptr<RenderCommand> command(new RenderCommand("ResolveParallel"));
         command->m_Self = [=, &framebuffer]()
         {
             framebuffer.ResolveParallel();
@@ -35,21 +33,48 @@ namespace RGS {
         return command;
     }
 
-    std::unique_ptr<RenderCommand> RenderCommand::BlitToScreen(Framebuffer& framebuffer)
+    std::unique_ptr<RenderCommand> RenderCommand::PostProcess(Framebuffer& framebuffer, const PostProcessSettings& settings)
     {
-        std::unique_ptr<RenderCommand> command(new RenderCommand());
+        std::unique_ptr<RenderCommand> command(new RenderCommand("PostProcess"));
         command->m_Self = [=, &framebuffer]()
         {
-            Application::Instance().GetFramebuffer().Blit(framebuffer);
+            framebuffer.PostProcess(settings);
+        };
+        return command;
+    }
+
+    std::unique_ptr<RenderCommand> RenderCommand::BlitToScreen(Framebuffer& framebuffer, Framebuffer& screen)
+    {
+        std::unique_ptr<RenderCommand> command(new RenderCommand("BlitToScreen"));
+        command->m_Self = [=, &framebuffer, &screen]()
+        {
+            screen.Blit(framebuffer);
+        };
+        return command;
+    }
+
+    std::unique_ptr<RenderCommand> RenderCommand::ResolveHeatmap(Framebuffer& framebuffer, const DebugCounter counter, const uint32_t maxValue)
+    {
+        std::unique_ptr<RenderCommand> command(new RenderCommand("ResolveHeatmap"));
+        command->m_Self = [=, &framebuffer]()
+        {
+            framebuffer.ResolveHeatmap(counter, maxValue);
         };
         return command;
     }
 
     void RenderCommand::Excecute()
     {
+#if RGS_ENABLE_RENDER_STATS
+        RenderStats* previous = RenderStats::GetCurrent();
+        RenderStats::SetCurrent(m_Stats);
+        m_Self();
+        RenderStats::SetCurrent(previous);
+#else
         m_Self();
+#endif
     }
 
-    RenderCommand::RenderCommand()
-        : m_Self(nullptr) { }
+    RenderCommand::RenderCommand(const char* name)
+        : m_Self(nullptr), m_Name(name) {}
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "Renderer.h"
 #include "Framebuffer.h"
+#include "RenderStats.h"
+#include "PostProcess.h"
 #include "RGS/Base/Maths.h"
 #include "RGS/Shader/ShaderBase.h"
 
@@ -19,7 +21,7 @@ namespace RGS {
                                                    std::shared_ptr<uniforms_t> uniforms)
         {
 
-            std::unique_ptr<RenderCommand> command(new RenderCommand());
+            std::unique_ptr<RenderCommand> command(new RenderCommand("Draw"));
             command->m_Self = [=, &framebuffer]()
             {
                 Renderer::Draw(framebuffer, program, mesh, uniforms);
@@ -34,7 +36,7 @@ namespace RGS {
                                                    std::shared_ptr<uniforms_t> uniforms,
                                                    const MSAA msaa)
         {
-            std::unique_ptr<RenderCommand> command(new RenderCommand());
+            std::unique_ptr<RenderCommand> command(new RenderCommand("Draw"));
             command->m_Self = [=, &framebuffer]()
             {
                 Renderer::Draw(framebuffer, program, mesh, uniforms, msaa);
@@ -46,14 +48,34 @@ namespace RGS {
         static std::unique_ptr<RenderCommand> ClearDepth(Framebuffer& framebuffer, float depth = 1.0f);
        
         static std::unique_ptr<RenderCommand> ResolveParallel(Framebuffer& framebuffer, const bool wait = true);
-        static std::unique_ptr<RenderCommand> BlitToScreen(Framebuffer& framebuffer);
+        // Tonemaps and encodes the resolved colors, between the resolve and the blit
+        static std::unique_ptr<RenderCommand> PostProcess(Framebuffer& framebuffer, const PostProcessSettings& settings = {});
+        // Copies the color of framebuffer into screen, the framebuffer presented by the window
+        static std::unique_ptr<RenderCommand> BlitToScreen(Framebuffer& framebuffer, Framebuffer& screen);
+        static std::unique_ptr<RenderCommand> ResolveHeatmap(Framebuffer& framebuffer, const DebugCounter counter, const uint32_t maxValue = 0);
 
         void Excecute();
+
+        // Shown next to the stats of this command, e.g. "Skybox"
+        void SetName(const std::string& name) { m_Name = name; }
+        const std::string& GetName() const { return m_Name; }
+
+#if RGS_ENABLE_RENDER_STATS
+        // Counters of the draws issued by this command, complete once its jobs have finished.
+        // Empty until the command is added to a Pipeline.
+        RenderCounters GetStats() const { return m_Stats ? m_Stats->Collect() : RenderCounters(); }
+        // Set by the Pipeline the command is added to, which owns the stats and reuses them every frame
+        void SetStats(RenderStats* stats) { m_Stats = stats; }
+#endif
       
     private:
-        RenderCommand();
+        RenderCommand(const char* name);
 
         std::function<void()> m_Self;
+        std::string m_Name;
+#if RGS_ENABLE_RENDER_STATS
+        RenderStats* m_Stats = nullptr;
+#endif
     };
 
 }
\ No newline at end of file
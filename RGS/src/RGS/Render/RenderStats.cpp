@@ -0,0 +1,77 @@
+#include "RenderStats.h"
+#include "RGS/JobSystem.h"
+
+namespace RGS {
+
+    static thread_local RenderStats* s_CurrentStats = nullptr;
+
+    const char* RenderCounters::GetName(RenderCounter counter)
+    {
+        switch (counter)
+        {
+        case RenderCounter::TrianglesSubmitted:  return "Triangles Submitted";
+        case RenderCounter::FrustumCulled:       return "Frustum Culled";
+        case RenderCounter::TrianglesClipped:    return "Triangles Clipped";
+        case RenderCounter::ZeroAreaCulled:      return "Zero Area Culled";
+        case RenderCounter::BackFaceCulled:      return "Back Face Culled";
+        case RenderCounter::TrianglesRasterized: return "Triangles Rasterized";
+        case RenderCounter::PixelsTested:        return "Pixels Tested";
+        case RenderCounter::SamplesCovered:      return "Samples Covered";
+        case RenderCounter::EarlyDepthRejects:   return "Early Depth Rejects";
+        case RenderCounter::FragmentsShaded:     return "Fragments Shaded";
+        case RenderCounter::Discards:            return "Discards";
+        default:                                 return "Unknown";
+        }
+    }
+
+    RenderStats::RenderStats()
+        : m_SlotCount(JobSystem::GetThreadCount() + 1), m_Slots(new Slot[JobSystem::GetThreadCount() + 1]) {}
+
+    RenderCounters RenderStats::Collect() const
+    {
+        RenderCounters counters;
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            for (int j = 0; j < (int)RenderCounter::Count; ++j)
+            {
+                counters.Values[j] += m_Slots[i].Values[j].load(std::memory_order_relaxed);
+            }
+        }
+        return counters;
+    }
+
+    void RenderStats::Reset()
+    {
+        const uint32_t slotCount = JobSystem::GetThreadCount() + 1;
+        if (slotCount != m_SlotCount)
+        {
+            m_SlotCount = slotCount;
+            m_Slots.reset(new Slot[slotCount]);
+            return;
+        }
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            for (int j = 0; j < (int)RenderCounter::Count; ++j)
+            {
+                m_Slots[i].Values[j].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    RenderStats* RenderStats::GetCurrent()
+    {
+        return s_CurrentStats;
+    }
+
+    void RenderStats::SetCurrent(RenderStats* stats)
+    {
+        s_CurrentStats = stats;
+    }
+
+    uint32_t RenderStats::GetLocalSlotIndex() const
+    {
+        const uint32_t index = JobSystem::GetThreadIndex();
+        return index < m_SlotCount ? index : 0;
+    }
+
+}
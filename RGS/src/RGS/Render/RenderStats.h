@@ -0,0 +1,83 @@
+#pragma once
+#include "RGS/Config.h"
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace RGS {
+
+    enum class RenderCounter
+    {
+        TrianglesSubmitted,     // Triangles passed to DrawTriangle.
+        FrustumCulled,          // Triangles entirely outside of the view frustum.
+        TrianglesClipped,       // Triangles crossing the frustum that had to be clipped.
+        ZeroAreaCulled,         // Triangles (after clipping) without any area on screen.
+        BackFaceCulled,         // Triangles (after clipping) facing away from the camera.
+        TrianglesRasterized,    // Triangles (after clipping) that were traversed.
+        PixelsTested,           // Pixels of the bounding boxes tested for coverage.
+        SamplesCovered,         // Samples inside of a triangle.
+        EarlyDepthRejects,      // Covered samples rejected by the early depth test.
+        FragmentsShaded,        // Fragment shader invocations.
+        Discards,               // Fragments discarded by the fragment shader.
+        Count
+    };
+
+    struct RenderCounters
+    {
+        uint64_t Values[(int)RenderCounter::Count] = {};
+
+        uint64_t& operator[](RenderCounter counter) { return Values[(int)counter]; }
+        uint64_t operator[](RenderCounter counter) const { return Values[(int)counter]; }
+
+        RenderCounters& operator+=(const RenderCounters& other)
+        {
+            for (int i = 0; i < (int)RenderCounter::Count; ++i)
+                Values[i] += other.Values[i];
+            return *this;
+        }
+
+        static const char* GetName(RenderCounter counter);
+    };
+
+    // Counters of one draw (or any other unit of work), split into one slot per JobSystem thread
+    // so the rasterization jobs never write to a shared cache line. 
+    class RenderStats
+    {
+    public:
+        RenderStats();
+
+        // Adds to the slot of the calling thread. A worker is the only writer of its slot, so a relaxed 
+        // load and store is enough. Slot 0 is shared by all non-worker threads and needs a real atomic add.
+        inline void Add(RenderCounter counter, uint64_t value)
+        {
+            const uint32_t index = GetLocalSlotIndex();
+            std::atomic<uint64_t>& slot = m_Slots[index].Values[(int)counter];
+            if (index == 0)
+                slot.fetch_add(value, std::memory_order_relaxed);
+            else
+                slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        // Sums all thread slots. Exact once the jobs of the draw have finished.
+        RenderCounters Collect() const;
+        // Zeroes the counters for the next use, the slots follow the current JobSystem thread count
+        void Reset();
+
+        // Stats the draws issued from the calling thread are recorded into, may be null.
+        static RenderStats* GetCurrent();
+        static void SetCurrent(RenderStats* stats);
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> Values[(int)RenderCounter::Count] = {};
+        };
+
+        uint32_t GetLocalSlotIndex() const;
+
+        uint32_t m_SlotCount;
+        std::unique_ptr<Slot[]> m_Slots;
+    };
+
+}
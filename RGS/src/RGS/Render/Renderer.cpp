@@ -34,14 +34,12 @@ namespace RGS {
         return weights[0] >= -EPSILON && weights[1] >= -EPSILON && weights[2] >= -EPSILON;
     }
 
-    bool Renderer::IsBackFacing(const Vec4& a, const Vec4& b, const Vec4& c)
+    float Renderer::GetSignedArea(const Vec4& a, const Vec4& b, const Vec4& c)
     {
-        // 逆时针为正面（可见）
         // (b.X - a.X) * (c.Y - b.Y) - (b.Y - a.Y) * (c.X - b.X)
-        float signedArea = a.X * b.Y - a.Y * b.X +
-                           b.X * c.Y - b.Y * c.X +
-                           c.X * a.Y - c.Y * a.X;
-        return signedArea <= 0;
+        return a.X * b.Y - a.Y * b.X +
+               b.X * c.Y - b.Y * c.X +
+               c.X * a.Y - c.Y * a.X;
     }
 
     bool Renderer::PassDepthTest(const float writeDepth, const float fDepth, const DepthFuncType depthFunc)
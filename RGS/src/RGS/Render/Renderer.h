@@ -3,11 +3,16 @@
 
 #include "Mesh.h"
 #include "Framebuffer.h"
+#include "RenderStats.h"
+#include "TileBinner.h"
 
 #include "RGS/Base/Base.h"
 #include "RGS/Base/Maths.h"
+#include "RGS/Base/FastMath.h"
 #include "RGS/Shader/ShaderBase.h"
 #include "RGS/JobSystem.h"
+#include "RGS/Timer.h"
+#include "RGS/Tuning.h"
 
 #include <algorithm>
 #include <type_traits>
@@ -57,6 +62,18 @@ namespace RGS {
         bool EnableDepthTest = true;
         bool EnableWriteDepth = true;
         bool EnableJobSystem = true;
+        // Shade the fragments with the FastMath approximations instead of libm
+        bool EnableFastMath = false;
+        // Interpolate the varyings one pixel right and one below as well, so the fragment shader can
+        // use Ddx/Ddy (texture LODs). Costs two more varyings interpolations per pixel.
+        bool EnableDerivatives = false;
+
+        // Queue used for the rasterization jobs of this program. 
+        // Offline work (e.g. IBL bakes) should use Background so it never delays a frame.
+        JobSystem::JobPriority Priority = JobSystem::JobPriority::Frame;
+        // If set, the rasterization jobs are tracked by this context (and use its priority instead), 
+        // so the caller can wait for or co_await just its own draws.
+        JobSystem::Context* JobContext = nullptr;
 
         DepthFuncType DepthFunc = DepthFuncType::LESS;
 
@@ -72,8 +89,8 @@ namespace RGS {
 
     class Renderer
     {
-    public:
-        inline static uint32_t s_FaceCount = 0;
+        // Microbenchmarks and tests reach the individual stages through this
+        friend struct RendererKernels;
 
     private:
         static constexpr int RGS_MAX_VARYINGS = 9;
@@ -98,7 +115,7 @@ namespace RGS {
         static bool IsVertexVisible(const Vec4& clipPos);
         static bool IsInsidePlane(const Vec4& clipPos, const Plane plane);
         static bool IsInsideTriangle(float(&weights)[3]);
-        static bool IsBackFacing(const Vec4& a, const Vec4& b, const Vec4& c);
+        static float GetSignedArea(const Vec4& a, const Vec4& b, const Vec4& c);
         static bool PassDepthTest(const float writeDepth, const float fDepth, const DepthFuncType depthFunc);
 
         static float GetIntersectRatio(const Vec4& prev, const Vec4& curr, const Plane plane);
@@ -263,17 +280,39 @@ namespace RGS {
                                  const uniforms_t& uniforms,
                                  const bool(&coverage)[(int)msaa],
                                  const bool(&depthOcclusion)[(int)msaa],
-                                 const bool isEdge)
+                                 const bool isEdge,
+                                 RenderStats* stats)
         {
             /* Pixel Shading */
             bool discard = false;
             Vec4 color{ 0.0f, 0.0f, 0.0f, 0.0f };
-            color = program.FragmentShader(discard, varyings, uniforms);
+            if (framebuffer.HasDebugCounters())
+            {
+                const bool timeShader = framebuffer.IsTimingShaders();
+                const uint64_t start = timeShader ? ReadCycleCounter() : 0;
+                color = program.FragmentShader(discard, varyings, uniforms);
+                if (timeShader)
+                    framebuffer.AddDebugCounter(x, y, DebugCounter::ShaderCycles, (uint32_t)(ReadCycleCounter() - start));
+                framebuffer.AddDebugCounter(x, y, DebugCounter::FragmentsShaded, 1);
+            }
+            else
+            {
+                color = program.FragmentShader(discard, varyings, uniforms);
+            }
+#if RGS_ENABLE_RENDER_STATS
+            if (stats)
+            {
+                stats->Add(RenderCounter::FragmentsShaded, 1);
+                if (discard)
+                    stats->Add(RenderCounter::Discards, 1);
+            }
+#endif
             if (discard)
             {
                 return;
             }
-            color = Clamp(color, 0.0f, 1.0f);
+            // The color buffer is float, values above 1 are kept for the post-process stage
+            color = { Max(color.X, 0.0f), Max(color.Y, 0.0f), Max(color.Z, 0.0f), Clamp(color.W, 0.0f, 1.0f) };
 
             /* Blend */
             if (program.EnableBlend)
@@ -340,7 +379,8 @@ namespace RGS {
                                          const uniforms_t& uniforms,
                                          const Vec4(&fragCoords)[3], 
                                          uint32_t fWidth, 
-                                         uint32_t fHeight)
+                                         uint32_t fHeight,
+                                         RenderStats* stats)
         {
             /* Varyings Setup */
             ScreenWeights screenWeights;
@@ -385,6 +425,17 @@ namespace RGS {
             }
 #endif
 
+#if RGS_ENABLE_RENDER_STATS
+            if (stats)
+            {
+                uint64_t samplesCovered = 0;
+                for (int i = 0; i < (int)msaa; ++i)
+                    samplesCovered += coverage[i];
+                stats->Add(RenderCounter::PixelsTested, 1);
+                stats->Add(RenderCounter::SamplesCovered, samplesCovered);
+            }
+#endif
+
             if (!isInsideTriangle)
                 return;
 
@@ -414,28 +465,87 @@ namespace RGS {
                 }
             }
 
+#if RGS_ENABLE_RENDER_STATS
+            if (stats)
+            {
+                uint64_t depthRejects = 0;
+                for (int i = 0; i < (int)msaa; ++i)
+                    depthRejects += coverage[i] && depthOcclusion[i];
+                stats->Add(RenderCounter::EarlyDepthRejects, depthRejects);
+            }
+#endif
+            if (framebuffer.HasDebugCounters())
+            {
+                uint32_t depthRejects = 0;
+                for (int i = 0; i < (int)msaa; ++i)
+                    depthRejects += coverage[i] && depthOcclusion[i];
+                if (depthRejects > 0)
+                    framebuffer.AddDebugCounter(x, y, DebugCounter::DepthRejects, depthRejects);
+            }
+
+            /* Derivatives */
+            varyings_t rightVaryings, downVaryings;
+            if (program.EnableDerivatives)
+            {
+                CalculateWeights(screenWeights, weights, fragCoords, { screenPoint.X + 1.0f, screenPoint.Y });
+                LerpVaryings(rightVaryings, varyings, weights.W, fWidth, fHeight);
+                CalculateWeights(screenWeights, weights, fragCoords, { screenPoint.X, screenPoint.Y + 1.0f });
+                LerpVaryings(downVaryings, varyings, weights.W, fWidth, fHeight);
+                Derivatives::Detail::t_Right = &rightVaryings;
+                Derivatives::Detail::t_Down = &downVaryings;
+            }
+
             /* Pixel Processing */
             ProcessPixel<vertex_t, uniforms_t, varyings_t, msaa>(
-                framebuffer, x, y, program, pixVaryings, uniforms, coverage, depthOcclusion, isOutsideTriangle); // isOutside && isInside => edge
+                framebuffer, x, y, program, pixVaryings, uniforms, coverage, depthOcclusion, isOutsideTriangle, stats); // isOutside && isInside => edge
+
+            if (program.EnableDerivatives)
+            {
+                Derivatives::Detail::t_Right = nullptr;
+                Derivatives::Detail::t_Down = nullptr;
+            }
         }
 
         template<typename vertex_t, typename uniforms_t, typename varyings_t, MSAA msaa>
         static void RasterizeTriangle(Framebuffer& framebuffer,
                                       const Program<vertex_t, uniforms_t, varyings_t>& program,
                                       const varyings_t(&varyings)[3],
-                                      const uniforms_t& uniforms)
+                                      const uniforms_t& uniforms,
+                                      RenderStats* stats)
         {
+            // 逆时针为正面（可见）
+            float signedArea = GetSignedArea(varyings[0].NdcPos, varyings[1].NdcPos, varyings[2].NdcPos);
+
+            /* Zero Area Culling */
+            // Degenerate triangles can't cover any sample, but would still traverse their bounding box
+            if (signedArea == 0.0f)
+            {
+#if RGS_ENABLE_RENDER_STATS
+                if (stats)
+                    stats->Add(RenderCounter::ZeroAreaCulled, 1);
+#endif
+                return;
+            }
+
             /* Back Face Culling */
             if (!program.EnableDoubleSided)
             {
-                bool isBackFacing = false;
-                isBackFacing = IsBackFacing(varyings[0].NdcPos, varyings[1].NdcPos, varyings[2].NdcPos);
+                bool isBackFacing = signedArea < 0.0f;
                 if (isBackFacing)
                 {
+#if RGS_ENABLE_RENDER_STATS
+                    if (stats)
+                        stats->Add(RenderCounter::BackFaceCulled, 1);
+#endif
                     return;
                 }
             }
 
+#if RGS_ENABLE_RENDER_STATS
+            if (stats)
+                stats->Add(RenderCounter::TrianglesRasterized, 1);
+#endif
+
             /* Bounding Box Setup */
             Vec4 fragCoords[3];
             fragCoords[0] = varyings[0].FragPos;
@@ -446,7 +556,25 @@ namespace RGS {
             BoundingBox bBox = GetBoundingBox(fragCoords, fWidth, fHeight);
 
             /* Triangle Traversal */
-            if (program.EnableJobSystem)
+            if (TileBinner* binner = TileBinner::GetCurrent())
+            {
+                // Inside a Pipeline stage: rasterized later by the job of every tile it covers, in submission order.
+                // The command keeps the program and the uniforms alive until the stage has been rasterized.
+                binner->Add(bBox.MinX, bBox.MaxX, bBox.MinY, bBox.MaxY,
+                            [=, &framebuffer, &program, &uniforms](const int minX, const int maxX, const int minY, const int maxY)
+                {
+                    FastMath::Scope fastMath(program.EnableFastMath);
+                    for (int y = minY; y <= maxY; y++)
+                    {
+                        for (int x = minX; x <= maxX; x++)
+                        {
+                            SetupAndProcessPixel<vertex_t, uniforms_t, varyings_t, msaa>(
+                                framebuffer, x, y, program, varyings, uniforms, fragCoords, fWidth, fHeight, stats);
+                        }
+                    }
+                });
+            }
+            else if (program.EnableJobSystem)
             {
                 int minX = bBox.MinX;
                 int minY = bBox.MinY;
@@ -454,25 +582,33 @@ namespace RGS {
                 uint32_t bHeight = bBox.MaxY - minY + 1u;
                 uint32_t jobCount = bWidth * bHeight;
 
-                //TODO: Config
-                constexpr uint32_t groupSize = 2048u;
-                JobSystem::Dispatch(jobCount, groupSize, [=, &framebuffer](JobSystem::JobDispatchArgs args)
+                const JobSystem::JobPriority priority = program.JobContext ? program.JobContext->Priority : program.Priority;
+                const uint32_t groupSize = priority == JobSystem::JobPriority::Background ? 
+                                           Config::BackgroundJobGroupSize : Tuning::GetGroupSize(TunedKernel::Rasterize);
+                auto job = [=, &framebuffer](JobSystem::JobDispatchArgs args)
                 {
                     int x = args.JobIndex % bWidth + minX;
                     int y = args.JobIndex / bWidth + minY;
+                    FastMath::Scope fastMath(program.EnableFastMath);
                     SetupAndProcessPixel<vertex_t, uniforms_t, varyings_t, msaa>(
-                        framebuffer, x, y, program, varyings, uniforms, fragCoords, fWidth, fHeight);
+                        framebuffer, x, y, program, varyings, uniforms, fragCoords, fWidth, fHeight, stats);
 
-                });
+                };
+
+                if (program.JobContext)
+                    JobSystem::Dispatch(*program.JobContext, jobCount, groupSize, job);
+                else
+                    JobSystem::Dispatch(jobCount, groupSize, job, priority);
             }
             else // Single-threaded for loop
             {
+                FastMath::Scope fastMath(program.EnableFastMath);
                 for (int y = bBox.MinY; y <= bBox.MaxY; y++)
                 {
                     for (int x = bBox.MinX; x <= bBox.MaxX; x++)
                     {
                         SetupAndProcessPixel<vertex_t, uniforms_t, varyings_t, msaa>(
-                            framebuffer, x, y, program, varyings, uniforms, fragCoords, fWidth, fHeight);
+                            framebuffer, x, y, program, varyings, uniforms, fragCoords, fWidth, fHeight, stats);
 
                     }
                 }
@@ -487,7 +623,6 @@ namespace RGS {
                                  const Triangle<vertex_t>& triangle,
                                  std::shared_ptr<uniforms_t> uniforms)
         {
-            s_FaceCount++;
             static_assert(std::is_base_of_v<VertexBase, vertex_t>, "vertex_t 必须继承自 RGS::VertexBase");
             static_assert(std::is_base_of_v<VaryingsBase, varyings_t>, "varyings_t 必须继承自 RGS::VaryingsBase");
 
@@ -499,7 +634,25 @@ namespace RGS {
             }
 
             /* Clipping */
+#if RGS_ENABLE_RENDER_STATS
+            RenderStats* stats = RenderStats::GetCurrent();
+            const bool isFullyVisible = IsVertexVisible(varyings[0].ClipPos) && 
+                                        IsVertexVisible(varyings[1].ClipPos) && 
+                                        IsVertexVisible(varyings[2].ClipPos);
+#else
+            RenderStats* stats = nullptr;
+#endif
             int vertexNum = Clip(varyings);
+#if RGS_ENABLE_RENDER_STATS
+            if (stats)
+            {
+                stats->Add(RenderCounter::TrianglesSubmitted, 1);
+                if (vertexNum < 3)
+                    stats->Add(RenderCounter::FrustumCulled, 1);
+                else if (!isFullyVisible)
+                    stats->Add(RenderCounter::TrianglesClipped, 1);
+            }
+#endif
 
             /* Screen Mapping */
             CaculateNdcPos(varyings, vertexNum);
@@ -515,7 +668,7 @@ namespace RGS {
                 triVaryings[1] = varyings[i + 1];
                 triVaryings[2] = varyings[i + 2];
 
-                RasterizeTriangle<vertex_t, uniforms_t, varyings_t, msaa>(framebuffer, *program, triVaryings, *uniforms);
+                RasterizeTriangle<vertex_t, uniforms_t, varyings_t, msaa>(framebuffer, *program, triVaryings, *uniforms, stats);
             }
         }
 
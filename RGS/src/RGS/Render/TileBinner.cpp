@@ -0,0 +1,84 @@
+#include "TileBinner.h"
+#include "RGS/Tuning.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace RGS {
+
+    static thread_local TileBinner* s_CurrentBinner = nullptr;
+
+    void TileBinner::Add(const int minX, const int maxX, const int minY, const int maxY, RasterizeFunc rasterize)
+    {
+        if (maxX < minX || maxY < minY)
+            return;
+        m_Triangles.push_back({ minX, maxX, minY, maxY, std::move(rasterize) });
+    }
+
+    void TileBinner::Rasterize()
+    {
+        if (m_Triangles.empty())
+            return;
+
+        // Square tiles of about as many pixels as a tuned rasterization job group
+        const int tileSize = std::max(1, (int)std::sqrt((double)Tuning::GetGroupSize(TunedKernel::Rasterize)));
+        int maxX = 0;
+        int maxY = 0;
+        for (const BinnedTriangle& triangle : m_Triangles)
+        {
+            maxX = std::max(maxX, triangle.MaxX);
+            maxY = std::max(maxY, triangle.MaxY);
+        }
+        const int tileCountX = maxX / tileSize + 1;
+        const int tileCountY = maxY / tileSize + 1;
+        if (m_Tiles.size() < (size_t)(tileCountX * tileCountY))
+            m_Tiles.resize(tileCountX * tileCountY);
+
+        for (uint32_t i = 0; i < (uint32_t)m_Triangles.size(); ++i)
+        {
+            const BinnedTriangle& triangle = m_Triangles[i];
+            for (int tileY = triangle.MinY / tileSize; tileY <= triangle.MaxY / tileSize; ++tileY)
+            {
+                for (int tileX = triangle.MinX / tileSize; tileX <= triangle.MaxX / tileSize; ++tileX)
+                {
+                    const uint32_t tileIndex = tileY * tileCountX + tileX;
+                    if (m_Tiles[tileIndex].empty())
+                        m_UsedTiles.push_back(tileIndex);
+                    m_Tiles[tileIndex].push_back(i);
+                }
+            }
+        }
+
+        JobSystem::Dispatch(m_Jobs, (uint32_t)m_UsedTiles.size(), 1u, [this, tileSize, tileCountX](JobSystem::JobDispatchArgs args)
+        {
+            const uint32_t tileIndex = m_UsedTiles[args.JobIndex];
+            const int tileMinX = (int)(tileIndex % tileCountX) * tileSize;
+            const int tileMinY = (int)(tileIndex / tileCountX) * tileSize;
+            const int tileMaxX = tileMinX + tileSize - 1;
+            const int tileMaxY = tileMinY + tileSize - 1;
+            for (const uint32_t index : m_Tiles[tileIndex])
+            {
+                const BinnedTriangle& triangle = m_Triangles[index];
+                triangle.Rasterize(std::max(tileMinX, triangle.MinX), std::min(tileMaxX, triangle.MaxX),
+                                   std::max(tileMinY, triangle.MinY), std::min(tileMaxY, triangle.MaxY));
+            }
+        });
+        JobSystem::Wait(m_Jobs);
+
+        for (const uint32_t tileIndex : m_UsedTiles)
+            m_Tiles[tileIndex].clear();
+        m_UsedTiles.clear();
+        m_Triangles.clear();
+    }
+
+    TileBinner* TileBinner::GetCurrent()
+    {
+        return s_CurrentBinner;
+    }
+
+    void TileBinner::SetCurrent(TileBinner* binner)
+    {
+        s_CurrentBinner = binner;
+    }
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "RGS/JobSystem.h"
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+namespace RGS {
+
+    // Triangles of the draws of one pipeline stage, sorted by screen tile. Every tile is rasterized by a single job
+    // that runs its triangles in the order they were added, so two fragments of a sample never race on its depth
+    // and color, within a draw or across draws, and the image doesn't depend on the number of threads.
+    class TileBinner
+    {
+    public:
+        // Rasterizes one triangle, restricted to the pixels [minX, maxX] x [minY, maxY]
+        using RasterizeFunc = std::function<void(const int minX, const int maxX, const int minY, const int maxY)>;
+
+        // [minX, maxX] x [minY, maxY] is the bounding box of the triangle on screen. Whatever rasterize refers
+        // to must stay alive until Rasterize has returned.
+        void Add(const int minX, const int maxX, const int minY, const int maxY, RasterizeFunc rasterize);
+
+        // Runs one job per tile with triangles and waits for them, then drops the triangles
+        void Rasterize();
+
+        // Draws issued from the calling thread are added here instead of being rasterized right away, may be null.
+        static TileBinner* GetCurrent();
+        static void SetCurrent(TileBinner* binner);
+
+    private:
+        struct BinnedTriangle
+        {
+            int MinX, MaxX, MinY, MaxY;
+            RasterizeFunc Rasterize;
+        };
+
+        std::vector<BinnedTriangle> m_Triangles;
+        // Indices into m_Triangles per tile, row major. Kept across frames so the bins don't reallocate.
+        std::vector<std::vector<uint32_t>> m_Tiles;
+        std::vector<uint32_t> m_UsedTiles;
+        JobSystem::Context m_Jobs;
+    };
+
+}
@@ -0,0 +1,85 @@
+#include "rgspch.h"
+#include "Session.h"
+
+#include <type_traits>
+#include <cstring>
+
+namespace RGS {
+
+    static_assert(std::is_trivially_copyable_v<SessionFrame>, "SessionFrame 会被直接写入文件");
+
+    static constexpr char s_Magic[4] = { 'R', 'G', 'S', 'S' };
+    static constexpr uint32_t s_Version = 1;
+
+    // File layout: magic, version, frame size, then the frames until the end of the file
+    struct SessionHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint32_t FrameSize;
+    };
+
+    void SessionFrame::SetCamera(const Camera& camera)
+    {
+        CameraPos = camera.Pos;
+        CameraDir = camera.Dir;
+        CameraRight = camera.Right;
+    }
+
+    void SessionFrame::ApplyCamera(Camera& camera) const
+    {
+        camera.Pos = { CameraPos, 1.0f };
+        camera.Dir = { CameraDir, 0.0f };
+        camera.Right = { CameraRight, 0.0f };
+    }
+
+    bool SessionRecorder::Open(const std::string& path)
+    {
+        m_File.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_File.is_open())
+            return false;
+
+        SessionHeader header;
+        std::memcpy(header.Magic, s_Magic, sizeof(s_Magic));
+        header.Version = s_Version;
+        header.FrameSize = sizeof(SessionFrame);
+        m_File.write((const char*)&header, sizeof(header));
+        m_FrameCount = 0;
+        return m_File.good();
+    }
+
+    void SessionRecorder::Record(const SessionFrame& frame)
+    {
+        if (!m_File.is_open())
+            return;
+        m_File.write((const char*)&frame, sizeof(frame));
+        m_File.flush();
+        m_FrameCount++;
+    }
+
+    void SessionRecorder::Close()
+    {
+        m_File.close();
+    }
+
+    bool SessionPlayer::Load(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        SessionHeader header;
+        file.read((char*)&header, sizeof(header));
+        if (!file || std::memcmp(header.Magic, s_Magic, sizeof(s_Magic)) != 0 
+                  || header.Version != s_Version || header.FrameSize != sizeof(SessionFrame))
+            return false;
+
+        m_Frames.clear();
+        SessionFrame frame;
+        while (file.read((char*)&frame, sizeof(frame)))
+            m_Frames.push_back(frame);
+        m_Current = 0;
+        return !m_Frames.empty();
+    }
+
+}
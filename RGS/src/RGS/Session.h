@@ -0,0 +1,68 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+#include "RGS/Render/Renderer.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+namespace RGS {
+
+    // Everything that changes the rendered image of one frame of an interactive session.
+    // Stored as is, so keep it trivially copyable and bump s_Version when the layout changes.
+    struct SessionFrame
+    {
+        float DeltaTime = 0.0f;         // Recorded wall-clock delta, replays use a fixed step instead.
+
+        Vec3 CameraPos;
+        Vec3 CameraDir;
+        Vec3 CameraRight;
+
+        float Roughness = 0.0f;
+        float Metallic = 0.0f;
+        uint8_t MSAALevel = 1;
+        uint8_t SkyboxIndex = 0;        // 0 skybox, 1 irradiance, 2 prefilter
+        uint8_t DrawQuad = 0;
+        uint8_t Padding = 0;
+
+        void SetCamera(const Camera& camera);
+        // Aspect and Up are left untouched
+        void ApplyCamera(Camera& camera) const;
+    };
+
+    // Appends frames to a .rgss file, flushed every frame so a crash keeps what was recorded.
+    class SessionRecorder
+    {
+    public:
+        bool Open(const std::string& path);
+        void Record(const SessionFrame& frame);
+        void Close();
+
+        bool IsOpen() const { return m_File.is_open(); }
+        uint32_t GetFrameCount() const { return m_FrameCount; }
+
+    private:
+        std::ofstream m_File;
+        uint32_t m_FrameCount = 0;
+    };
+
+    class SessionPlayer
+    {
+    public:
+        bool Load(const std::string& path);
+
+        uint32_t GetFrameCount() const { return (uint32_t)m_Frames.size(); }
+        const SessionFrame& GetFrame(const uint32_t index) const { return m_Frames[index]; }
+
+        // Steps through the frames once, nullptr at the end
+        const SessionFrame* Next() { return m_Current < m_Frames.size() ? &m_Frames[m_Current++] : nullptr; }
+        bool IsFinished() const { return m_Current >= m_Frames.size(); }
+        void Rewind() { m_Current = 0; }
+
+    private:
+        std::vector<SessionFrame> m_Frames;
+        size_t m_Current = 0;
+    };
+
+}
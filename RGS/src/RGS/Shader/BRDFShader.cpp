@@ -1,4 +1,5 @@
 #include "BRDFShader.h"
+#include "RGS/Base/FastMath.h"
 
 namespace RGS {
 
@@ -35,8 +36,8 @@ namespace RGS {
 
         // from spherical coordinates to cartesian coordinates - halfway Vector
         Vec3 H;
-        H.X = cos(phi) * sinTheta;
-        H.Y = sin(phi) * sinTheta;
+        H.X = Cos(phi) * sinTheta;
+        H.Y = Sin(phi) * sinTheta;
         H.Z = cosTheta;
 
         // from tangent-space H Vector to world-space sample Vector
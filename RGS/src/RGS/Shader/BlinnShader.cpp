@@ -1,4 +1,5 @@
 #include "BlinnShader.h"
+#include "RGS/Base/FastMath.h"
 
 namespace RGS {
 
@@ -27,14 +28,16 @@ namespace RGS {
         float _Speclur = 8.0f;
         if (uniforms.Diffuse && uniforms.Specular)
         {
-            Vec2 texCoord = varyings.TexCoord;
-            _Color = uniforms.Diffuse->Sample(texCoord) * 0.7f;
-            _Speclur = uniforms.Specular->Sample(texCoord).X * 16.0f;
+            const Vec2 texCoord = varyings.TexCoord;
+            const Vec2 ddx = Ddx(varyings, varyings.TexCoord);
+            const Vec2 ddy = Ddy(varyings, varyings.TexCoord);
+            _Color = uniforms.Diffuse->Sample(uniforms.Sampler, texCoord, uniforms.Diffuse->ComputeLod(ddx, ddy)) * 0.7f;
+            _Speclur = uniforms.Specular->Sample(uniforms.Sampler, texCoord, uniforms.Specular->ComputeLod(ddx, ddy)).X * 16.0f;
         }
 
         Vec3 ambient = _Color * 0.5f;
         Vec3 diffuse = std::max(0.0f, Dot(worldNormal, lightDir)) * _Color;
-        Vec3 speculur = (float)pow(std::max(0.0f, Dot(halfDir, worldNormal)), _Speclur) * _Color;
+        Vec3 speculur = Pow(std::max(0.0f, Dot(halfDir, worldNormal)), _Speclur) * _Color;
 
         return { ambient + diffuse + speculur, 1.0f };
     }
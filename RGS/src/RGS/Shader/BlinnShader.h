@@ -25,6 +25,8 @@ namespace RGS {
 
         Texture* Diffuse = nullptr;
         Texture* Specular = nullptr;
+        // The LOD comes from the derivatives of TexCoord, draw with Program::EnableDerivatives
+        RepeatTrilinearSampler Sampler;
     };
 
     void BlinnVertexShader(BlinnVaryings& varyings, const BlinnVertex& vertex, const BlinnUniforms& uniforms);
@@ -1,4 +1,5 @@
 #include "ConvSkyShader.h"
+#include "RGS/Base/FastMath.h"
 
 namespace RGS {
 
@@ -7,9 +8,9 @@ namespace RGS {
         Vec3 res{ 0.0f };
         float phi = uv.X * 2 * PI - PI;
         float theta = (1.0f - uv.Y) * PI;
-        res.Z = sin(phi) * sin(theta);
-        res.X = cos(phi) * sin(theta);
-        res.Y = cos(theta);
+        res.Z = Sin(phi) * Sin(theta);
+        res.X = Cos(phi) * Sin(theta);
+        res.Y = Cos(theta);
 
         return res;
     }
@@ -41,11 +42,12 @@ namespace RGS {
             for (float theta = 0.0; theta < 0.5 * PI; theta += sampleDelta)
             {
                 // spherical to cartesian (in tangent space)
-                Vec3 tangentSample = Vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+                Vec3 tangentSample = Vec3(Sin(theta) * Cos(phi), Cos(theta), Sin(theta) * Sin(phi));
                 // tangent space to world
                 Vec3 sampleVec = tangentSample.X * worldX + tangentSample.Y * worldY + tangentSample.Z * worldZ;
 
-                irradiance += uniforms.SkyboxTex->Sample(sampleVec) * cos(theta) * sin(theta);
+                const Vec3 color = uniforms.SkyboxCube ? uniforms.SkyboxCube->Sample(sampleVec) : uniforms.SkyboxTex->Sample(sampleVec);
+                irradiance += color * Cos(theta) * Sin(theta);
                 nrSamples++;
             }
         }
@@ -107,8 +109,8 @@ namespace RGS {
 
         // from spherical coordinates to cartesian coordinates - halfway Vector
         Vec3 H;
-        H.X = cos(phi) * sinTheta;
-        H.Y = sin(phi) * sinTheta;
+        H.X = Cos(phi) * sinTheta;
+        H.Y = Sin(phi) * sinTheta;
         H.Z = cosTheta;
 
         // from tangent-space H Vector to world-space sample Vector
@@ -161,7 +163,8 @@ namespace RGS {
                 float mipLevel = roughness * 4.0f;
 
                 //prefilteredColor += textureLod(environmentMap, L, mipLevel).rgb * NdotL;
-                prefilteredColor += uniforms.SkyboxTex->Sample(L, mipLevel) * NdotL;
+                const Vec3 color = uniforms.SkyboxCube ? uniforms.SkyboxCube->Sample(L, mipLevel) : uniforms.SkyboxTex->Sample(L, mipLevel);
+                prefilteredColor += color * NdotL;
                 totalWeight += NdotL;
             }
         }
@@ -14,6 +14,7 @@ namespace RGS {
     struct ConvSkyUniforms : public UniformsBase
     {
         TextureSphere* SkyboxTex;
+        TextureCube* SkyboxCube = nullptr;      // used instead of SkyboxTex when set
     };
 
     using PrefilterVertex = ConvSkyVertex;
@@ -23,6 +24,7 @@ namespace RGS {
     struct PrefilterUniforms : public UniformsBase
     {
         LodTextureSphere* SkyboxTex;
+        TextureCube* SkyboxCube = nullptr;      // used instead of SkyboxTex when set
         float Roughness = 0.5f;
     };
 
@@ -1,4 +1,5 @@
 #include "IBLPBRShader.h"
+#include "RGS/Base/FastMath.h"
 
 namespace RGS {
 
@@ -49,7 +50,7 @@ namespace RGS {
     // ----------------------------------------------------------------------------
     static Vec3 fresnelSchlick(float cosTheta, Vec3 F0)
     {
-        return F0 + (1.0 - F0) * pow(Clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+        return F0 + (1.0 - F0) * Pow5(Clamp(1.0 - cosTheta, 0.0, 1.0));
     }
     // ----------------------------------------------------------------------------
     static Vec3 fresnelSchlickRoughness(float cosTheta, Vec3 F0, float roughness)
@@ -58,7 +59,7 @@ namespace RGS {
         v.X = Max(v.X, F0.X);
         v.Y = Max(v.Y, F0.Y);
         v.Z = Max(v.Z, F0.Z);
-        Vec3 color = F0 + ((v - F0) * std::pow(Clamp(1.0 - cosTheta, 0.0f, 1.0f), 5.0f));
+        Vec3 color = F0 + ((v - F0) * Pow5(Clamp(1.0 - cosTheta, 0.0f, 1.0f)));
         return color;
     }
 
@@ -124,25 +125,20 @@ namespace RGS {
         Vec3 kD = 1.0 - kS;
         kD *= 1.0 - uniforms.Metallic;
 
-        Vec3 irradiance = uniforms.IrradianceMap->Sample(varyings.TexPos);
+        Vec3 irradiance = uniforms.IrradianceCube ? uniforms.IrradianceCube->Sample(varyings.TexPos) : uniforms.IrradianceMap->Sample(varyings.TexPos);
         Vec3 diffuse = irradiance * uniforms.Albedo;
 
         // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
         constexpr float Max_REFLECTION_LOD = 4.0;
-        Vec3 prefilteredColor = uniforms.PrefilterMap->Sample(R, roughness * 4.0f); 
+        Vec3 prefilteredColor = uniforms.PrefilterCube ? uniforms.PrefilterCube->Sample(R, roughness * 4.0f) : uniforms.PrefilterMap->Sample(R, roughness * 4.0f);
         Vec2 brdf = uniforms.BrdfLUT->Sample( Vec2(Max(NoV, 0.0), roughness));
         Vec3 specular = prefilteredColor * (F * brdf.X + brdf.Y);
 
         Vec3 ambient = (kD * diffuse + specular)* uniforms.Ao;
 
+        // Linear HDR, tonemapped and gamma corrected by the post-process stage
         Vec3 color = ambient + Lo;
 
-        // HDR tonemapping
-        color = color / (color + Vec3(1.0f));
-        // gamma correct
-        constexpr float gamma = 1.0f / 2.2f;
-        color = Pow(color, gamma);
-
         return Vec4{ color, 1.0f };
     }
 
@@ -29,6 +29,9 @@ namespace RGS {
         TextureSphere* IrradianceMap;
         LodTextureSphere* PrefilterMap;
         Texture* BrdfLUT;
+        // Used instead of IrradianceMap/PrefilterMap when set
+        TextureCube* IrradianceCube = nullptr;
+        TextureCube* PrefilterCube = nullptr;
     };
 
     void IBLPBRVertexShader(IBLPBRVaryings& varyings, const IBLPBRVertex& vertex, const IBLPBRUniforms& uniforms);
@@ -1,4 +1,5 @@
 #include "PBRShader.h"
+#include "RGS/Base/FastMath.h"
 
 namespace RGS {
 
@@ -51,15 +52,12 @@ namespace RGS {
     // ----------------------------------------------------------------------------
     static Vec3 fresnelSchlick(float cosTheta, Vec3 F0)
     {
-        return F0 + (Vec3{ 1.0f, 1.0f, 1.0f } - F0) * pow(Clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+        return F0 + (Vec3{ 1.0f, 1.0f, 1.0f } - F0) * Pow5(Clamp(1.0 - cosTheta, 0.0, 1.0));
     }
 
     static Vec3 GammaCorrection(const Vec3& v)
     {
-        float x = pow(v.X, 1.0f / 2.2f);
-        float y = pow(v.Y, 1.0f / 2.2f);
-        float z = pow(v.Z, 1.0f / 2.2f);
-        return { x, y, z };
+        return Pow(v, 1.0f / 2.2f);
     }
 
     Vec4 PBRFragmentShader(bool& discard, const PBRVaryings& varyings, const PBRUniforms& uniforms)
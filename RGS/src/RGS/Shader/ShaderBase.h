@@ -35,5 +35,37 @@ namespace RGS {
         Mat4 MVP;
         operator const std::string() const { return (std::string)MVP; }
     };
+
+    namespace Derivatives::Detail {
+        // The varyings one pixel right of and below the fragment being shaded, set by the renderer
+        // for the programs with EnableDerivatives. nullptr otherwise.
+        inline thread_local const void* t_Right = nullptr;
+        inline thread_local const void* t_Down = nullptr;
+
+        template<typename varyings_t, typename T>
+        const T& Neighbour(const void* neighbour, const varyings_t& varyings, const T& member)
+        {
+            const size_t offset = (const char*)&member - (const char*)&varyings;
+            return *(const T*)((const char*)neighbour + offset);
+        }
+    }
+
+    // Screen-space derivatives of a member of the fragment's varyings, e.g. Ddx(varyings, varyings.TexCoord).
+    // Forward differences like a 2x2 quad, zero unless the program has EnableDerivatives.
+    template<typename varyings_t, typename T>
+    T Ddx(const varyings_t& varyings, const T& member)
+    {
+        if (Derivatives::Detail::t_Right == nullptr)
+            return member - member;
+        return Derivatives::Detail::Neighbour(Derivatives::Detail::t_Right, varyings, member) - member;
+    }
+
+    template<typename varyings_t, typename T>
+    T Ddy(const varyings_t& varyings, const T& member)
+    {
+        if (Derivatives::Detail::t_Down == nullptr)
+            return member - member;
+        return Derivatives::Detail::Neighbour(Derivatives::Detail::t_Down, varyings, member) - member;
+    }
 }
 
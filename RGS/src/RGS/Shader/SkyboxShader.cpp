@@ -20,7 +20,18 @@ namespace RGS {
     {
         discard = false;
         Vec3 envColor;
-        if (uniforms.SkyboxTex != nullptr)
+        if (uniforms.VirtualSkyboxTex != nullptr)
+        {
+            const Vec3 ddx = Ddx(varyings, varyings.TexPos);
+            const Vec3 ddy = Ddy(varyings, varyings.TexPos);
+            const float lod = Max(uniforms.Lod, uniforms.VirtualSkyboxTex->ComputeLod(varyings.TexPos, ddx, ddy));
+            envColor = uniforms.VirtualSkyboxTex->Sample(varyings.TexPos, lod);
+        }
+        else if (uniforms.SkyboxCube != nullptr)
+        {
+            envColor = uniforms.SkyboxCube->Sample(varyings.TexPos, uniforms.Lod);
+        }
+        else if (uniforms.SkyboxTex != nullptr)
         {
             envColor = uniforms.SkyboxTex->Sample(Normalize(varyings.TexPos));
         }
@@ -28,9 +39,7 @@ namespace RGS {
         {
             envColor = uniforms.LodSkyboxTex->Sample(Normalize(varyings.TexPos), uniforms.Lod);
         }
-        envColor = envColor / (envColor + Vec3{ 1.0f });
-        constexpr float gamma = 1.0f / 2.2f;
-        envColor = Pow(envColor, gamma);
+        // Linear HDR, see PostProcessSettings
         return { envColor , 1.0f};
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "ShaderBase.h"
+#include "RGS/VirtualTexture.h"
 
 namespace RGS {
 
@@ -14,6 +15,10 @@ namespace RGS {
     {
         TextureSphere* SkyboxTex;
         LodTextureSphere* LodSkyboxTex = nullptr;
+        // Used instead of the two above when set, Lod picks its mip level
+        TextureCube* SkyboxCube = nullptr;
+        // Used instead of the three above when set, at the larger of Lod and the pixel footprint (EnableDerivatives)
+        VirtualTextureSphere* VirtualSkyboxTex = nullptr;
         float Lod = 0.0f;
     };
 
@@ -0,0 +1,347 @@
+#pragma once
+#include "RGS/JobSystem.h"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <condition_variable>
+#include <type_traits>
+#include <iostream>
+
+namespace RGS {
+
+    template<typename T = void>
+    class Task;
+
+    namespace Detail {
+
+        struct TaskPromiseBase
+        {
+            // Coroutine resumed once the task finishes, i.e. whoever co_awaited it
+            std::coroutine_handle<> Continuation = std::noop_coroutine();
+            std::exception_ptr Exception;
+
+            // On finish, transfer straight to the awaiting coroutine instead of growing the stack
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+
+                template<typename promise_t>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> handle) noexcept
+                {
+                    return handle.promise().Continuation;
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            // Tasks are lazy: nothing runs until the task is awaited (or spawned)
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() { Exception = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase
+        {
+            std::optional<T> Value;
+
+            Task<T> get_return_object();
+
+            template<typename U>
+            void return_value(U&& value) { Value.emplace(std::forward<U>(value)); }
+
+            T GetResult()
+            {
+                if (Exception)
+                    std::rethrow_exception(Exception);
+                return std::move(*Value);
+            }
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void> get_return_object();
+
+            void return_void() {}
+
+            void GetResult()
+            {
+                if (Exception)
+                    std::rethrow_exception(Exception);
+            }
+        };
+
+        // Fire-and-forget coroutine, owns its frame and frees it when done
+        struct DetachedTask
+        {
+            struct promise_type
+            {
+                DetachedTask get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+    }
+
+    // Awaitable unit of work running on the JobSystem workers.
+    // The coroutine continues on whichever thread completed the last thing it co_awaited.
+    template<typename T>
+    class Task
+    {
+    public:
+        using promise_type = Detail::TaskPromise<T>;
+        using handle_t = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(handle_t handle)
+            : m_Handle(handle) {}
+        Task(Task&& other) noexcept
+            : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_Handle)
+                    m_Handle.destroy();
+                m_Handle = std::exchange(other.m_Handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task()
+        {
+            if (m_Handle)
+                m_Handle.destroy();
+        }
+
+        bool IsReady() const { return !m_Handle || m_Handle.done(); }
+
+        auto operator co_await() noexcept
+        {
+            struct Awaiter
+            {
+                handle_t Handle;
+
+                bool await_ready() const noexcept { return !Handle || Handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    Handle.promise().Continuation = awaiting;
+                    return Handle;
+                }
+
+                T await_resume() { return Handle.promise().GetResult(); }
+            };
+            return Awaiter{ m_Handle };
+        }
+
+    private:
+        handle_t m_Handle = nullptr;
+
+        template<typename U>
+        friend U SyncWait(Task<U> task);
+    };
+
+    namespace Detail {
+
+        template<typename T>
+        inline Task<T> TaskPromise<T>::get_return_object() { return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) }; }
+
+        inline Task<void> TaskPromise<void>::get_return_object() { return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) }; }
+
+        inline DetachedTask RunDetached(Task<void> task)
+        {
+            try
+            {
+                co_await task;
+            }
+            catch (const std::exception& e)
+            {
+                std::cout << "Task 异常: " << e.what() << std::endl;
+            }
+        }
+
+        struct SyncWaitState
+        {
+            std::mutex Lock;
+            std::condition_variable Condition;
+            bool Done = false;
+        };
+
+        template<typename T>
+        inline DetachedTask SignalWhenDone(Task<T>& task, SyncWaitState& state)
+        {
+            try
+            {
+                co_await task;
+            }
+            catch (...)
+            {
+                // Rethrown by SyncWait
+            }
+
+            // Notify while holding the lock, the state lives on the stack of the waiting thread
+            std::lock_guard<std::mutex> lock(state.Lock);
+            state.Done = true;
+            state.Condition.notify_all();
+        }
+
+    }
+
+    // Starts the task on the calling thread and lets it finish on its own.
+    // Exceptions escaping the task are printed and dropped.
+    inline void Spawn(Task<void> task)
+    {
+        Detail::RunDetached(std::move(task));
+    }
+
+    // Starts the task and blocks the calling thread until it finished, returning its result.
+    // Must not be called from a job: the blocked worker can't help to finish the task.
+    template<typename T>
+    T SyncWait(Task<T> task)
+    {
+        Detail::SyncWaitState state;
+        Detail::SignalWhenDone(task, state);
+        {
+            std::unique_lock<std::mutex> lock(state.Lock);
+            state.Condition.wait(lock, [&state]() { return state.Done; });
+        }
+        return task.m_Handle.promise().GetResult();
+    }
+
+}
+
+namespace RGS::JobSystem {
+
+    // co_await Schedule(priority) moves the coroutine onto a worker of the given priority.
+    struct ScheduleAwaiter
+    {
+        JobPriority Priority;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const
+        {
+            Execute([handle]() { handle.resume(); }, Priority);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    inline ScheduleAwaiter Schedule(JobPriority priority = JobPriority::Frame)
+    {
+        return ScheduleAwaiter{ priority };
+    }
+
+    // co_await ExecuteAsync(func, priority) runs func as a single job (file I/O, image decoding...)
+    // and continues the coroutine on the same worker with its return value.
+    template<typename func_t>
+    class ExecuteAwaiter
+    {
+    public:
+        using result_t = std::invoke_result_t<func_t&>;
+
+        ExecuteAwaiter(func_t func, JobPriority priority)
+            : m_Func(std::move(func)), m_Priority(priority) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            // The awaiter lives in the suspended coroutine frame until handle.resume()
+            Execute([this, handle]()
+            {
+                try
+                {
+                    if constexpr (std::is_void_v<result_t>)
+                        m_Func();
+                    else
+                        m_Result.emplace(m_Func());
+                }
+                catch (...)
+                {
+                    m_Exception = std::current_exception();
+                }
+                handle.resume();
+            }, m_Priority);
+        }
+
+        result_t await_resume()
+        {
+            if (m_Exception)
+                std::rethrow_exception(m_Exception);
+            if constexpr (!std::is_void_v<result_t>)
+                return std::move(*m_Result);
+        }
+
+    private:
+        using storage_t = std::conditional_t<std::is_void_v<result_t>, bool, result_t>;
+
+        func_t m_Func;
+        JobPriority m_Priority;
+        std::optional<storage_t> m_Result;
+        std::exception_ptr m_Exception;
+    };
+
+    template<typename func_t>
+    inline ExecuteAwaiter<std::decay_t<func_t>> ExecuteAsync(func_t&& func, JobPriority priority = JobPriority::Frame)
+    {
+        return ExecuteAwaiter<std::decay_t<func_t>>(std::forward<func_t>(func), priority);
+    }
+
+    // co_await on a context suspends until all of its jobs completed, without blocking a thread.
+    struct ContextAwaiter
+    {
+        Context& Ctx;
+
+        bool await_ready() const { return !IsBusy(Ctx); }
+        void await_suspend(std::coroutine_handle<> handle) const
+        {
+            OnComplete(Ctx, [handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    inline ContextAwaiter operator co_await(Context& context)
+    {
+        return ContextAwaiter{ context };
+    }
+
+    // co_await DispatchAsync(...) is Dispatch on a private context followed by co_await on it.
+    class DispatchAwaiter
+    {
+    public:
+        DispatchAwaiter(uint32_t jobCount, uint32_t groupSize, std::function<void(JobDispatchArgs)> job, JobPriority priority)
+            : m_JobCount(jobCount), m_GroupSize(groupSize), m_Job(std::move(job))
+        {
+            m_Context.Priority = priority;
+        }
+
+        bool await_ready() const noexcept { return m_JobCount == 0; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            Dispatch(m_Context, m_JobCount, m_GroupSize, m_Job);
+            OnComplete(m_Context, [handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        Context m_Context;
+        uint32_t m_JobCount;
+        uint32_t m_GroupSize;
+        std::function<void(JobDispatchArgs)> m_Job;
+    };
+
+    inline DispatchAwaiter DispatchAsync(uint32_t jobCount,
+                                         uint32_t groupSize,
+                                         std::function<void(JobDispatchArgs)> job,
+                                         JobPriority priority = JobPriority::Frame)
+    {
+        return DispatchAwaiter(jobCount, groupSize, std::move(job), priority);
+    }
+
+}
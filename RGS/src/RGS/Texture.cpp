@@ -2,143 +2,305 @@
 #include "Texture.h"
 
 #include "RGS/Config.h"
+#include "RGS/TextureCache.h"
+#include "RGS/Base/FastMath.h"
 
 #include <stb_image.h>
 #include <stb_image_resize2.h>
+#include <cstring>
+#include <cmath>
+#include <bit>
+#include <algorithm>
 
 namespace RGS {
 
-    Texture::Texture(const std::string& path)
-        :m_Path(path)
+    static TexelFormat GetTextureFormat(const int channels, const TextureStorage storage)
     {
-        int width, height, channels;
-        stbi_set_flip_vertically_on_load(true);
-        stbi_uc* data = nullptr;
-        data = stbi_load(m_Path.c_str(), &width, &height, &channels, 0);
-        ASSERT((data) && (width > 0) && (height > 0) && (channels > 0));
+        if (storage == TextureStorage::Compressed)
+            return channels == 1 ? TexelFormat::BC4 : (channels == 2 ? TexelFormat::BC5 : (channels == 3 ? TexelFormat::BC1 : TexelFormat::BC3));
+        return channels == 1 ? TexelFormat::R8 : (channels == 2 ? TexelFormat::RG8 : TexelFormat::RGBA8);
+    }
 
-        m_Height = height;
-        m_Width = width;
-        m_Channels = channels;
-        int size = height * width;
-        m_Data = new Vec4[size];
+    // Bytes of a width x height level as Texture::Build and TextureSphere::SetTexels encode it
+    // A sphere lookup reads a single nearest texel, there is no 2x2 footprint for the 4x4 tiles to keep in fewer
+    // cache lines and the tile addressing only measured slower. Tiled spheres are stored in rows.
+    static TextureStorage GetSphereStorage(const TextureStorage storage)
+    {
+        return storage == TextureStorage::Tiled ? TextureStorage::Linear : storage;
+    }
 
-        if (channels == 4)
+    static size_t GetLevelSize(const TexelFormat format, const TextureStorage storage, const int width, const int height)
+    {
+        const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+        const size_t texels = storage == TextureStorage::Tiled ? (size_t)TiledTexelCount(width, height) : (size_t)width * height;
+        switch (format)
         {
-            for (int i = 0; i < size; i++)
-            {
-                m_Data[i].X = UChar2Float(data[i * 4]);
-                m_Data[i].Y = UChar2Float(data[i * 4 + 1]);
-                m_Data[i].Z = UChar2Float(data[i * 4 + 2]);
-                m_Data[i].W = UChar2Float(data[i * 4 + 3]);
-            }
+        case TexelFormat::R8:       return texels * sizeof(TexelTraits<TexelFormat::R8>::storage_t);
+        case TexelFormat::RG8:      return texels * sizeof(TexelTraits<TexelFormat::RG8>::storage_t);
+        case TexelFormat::RGBA8:    return texels * sizeof(TexelTraits<TexelFormat::RGBA8>::storage_t);
+        case TexelFormat::RGBA16F:  return texels * sizeof(TexelTraits<TexelFormat::RGBA16F>::storage_t);
+        case TexelFormat::RGB9E5:   return texels * sizeof(TexelTraits<TexelFormat::RGB9E5>::storage_t);
+        case TexelFormat::BC1:      return blocks * BlockTraits<TexelFormat::BC1>::BlockSize;
+        case TexelFormat::BC3:      return blocks * BlockTraits<TexelFormat::BC3>::BlockSize;
+        case TexelFormat::BC4:      return blocks * BlockTraits<TexelFormat::BC4>::BlockSize;
+        case TexelFormat::BC5:      return blocks * BlockTraits<TexelFormat::BC5>::BlockSize;
+        default:                    return blocks * BlockTraits<TexelFormat::BC6H>::BlockSize;
         }
-        else if (channels == 3)
+    }
+
+    // Whether a cache entry holds what the loader would build: format in storage, one level or, with mips,
+    // the chain of halved levels down to 1x1. Guards the samplers against a damaged or foreign file.
+    static bool IsValidEntry(const TextureCache::Entry& entry, const TexelFormat format, const TextureStorage storage, const bool mips)
+    {
+        if (entry.Format != format || entry.Storage != storage || (!mips && entry.Levels.size() != 1))
+            return false;
+        int width = entry.Levels[0].Width;
+        int height = entry.Levels[0].Height;
+        for (const TextureCache::Level& level : entry.Levels)
         {
-            for (int i = 0; i < size; i++)
-            {
-                m_Data[i].X = UChar2Float(data[i * 3]);
-                m_Data[i].Y = UChar2Float(data[i * 3 + 1]);
-                m_Data[i].Z = UChar2Float(data[i * 3 + 2]);
-                m_Data[i].W = 0.0f;
-            }
+            if (level.Width != width || level.Height != height || level.Size != GetLevelSize(format, storage, width, height))
+                return false;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
         }
-        else if (channels == 2)
+        return !mips || (entry.Levels.back().Width == 1 && entry.Levels.back().Height == 1);
+    }
+
+    Texture::Texture(const std::string& path, TextureStorage storage)
+    {
+        if (Init(path, storage))
+            return;
+
+        // A black texel in the requested storage, the samplers stay in bounds
+        std::cout << "加载失败: " << path << std::endl;
+        m_Channels = 4;
+        m_Width = 1;
+        m_Height = 1;
+        m_Format = GetTextureFormat(m_Channels, storage);
+        Build({ Vec4{ 0.0f, 0.0f, 0.0f, 0.0f } }, 1, 1);
+    }
+
+    Texture* Texture::LoadTexture(const std::string& path, TextureStorage storage)
+    {
+        Texture* res = new Texture();
+        if (!res->Init(path, storage))
         {
-            for (int i = 0; i < size; i++)
-            {
-                m_Data[i].X = UChar2Float(data[i * 2]);
-                m_Data[i].Y = UChar2Float(data[i * 2 + 1]);
-                m_Data[i].Z = 0.0f;
-                m_Data[i].W = 0.0f;
-            }
+            std::cout << "加载失败" << std::endl;
+            delete res;
+            return nullptr;
         }
-        else if (channels == 1)
+        return res;
+    }
+
+    bool Texture::Init(const std::string& path, TextureStorage storage)
+    {
+        m_Path = path;
+        m_Storage = storage;
+        if (LoadCached())
+            return true;
+
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(true);
+        stbi_uc* data = nullptr;
+        data = stbi_load(m_Path.c_str(), &width, &height, &channels, 0);
+        if (data == nullptr || width <= 0 || height <= 0 || channels <= 0)
         {
-            for (int i = 0; i < size; i++)
-            {
-                m_Data[i].X = UChar2Float(data[i]);
-                m_Data[i].Y = 0.0f;
-                m_Data[i].Z = 0.0f;
-                m_Data[i].W = 0.0f;
-            }
+            stbi_image_free(data);
+            return false;
+        }
+
+        m_Height = height;
+        m_Width = width;
+        m_Channels = channels;
+        m_Format = GetTextureFormat(channels, storage);
+
+        // Missing channels are 0, the 8-bit values round trip exactly through the float copy
+        int size = height * width;
+        std::vector<Vec4> texels(size);
+        for (int i = 0; i < size; i++)
+        {
+            const stbi_uc* texel = data + i * channels;
+            texels[i].X = UChar2Float(texel[0]);
+            texels[i].Y = channels > 1 ? UChar2Float(texel[1]) : 0.0f;
+            texels[i].Z = channels > 2 ? UChar2Float(texel[2]) : 0.0f;
+            texels[i].W = channels > 3 ? UChar2Float(texel[3]) : 0.0f;
         }
 
         stbi_image_free(data);
+        Build(std::move(texels), width, height);
+        StoreCached();
+        return true;
     }
     
-    Texture::Texture(const Framebuffer& framebuffer)
+    Texture::Texture(const Framebuffer& framebuffer, TextureStorage storage)
+        :m_Storage(storage)
     {
         int width = framebuffer.GetWidth();
         int height = framebuffer.GetHeight();
-        ASSERT((width > 0) && (height > 0));
+        ASSERT((width > 0) && (height > 0) && (storage != TextureStorage::Compressed));
 
         m_Channels = 4;
         m_Width = width;
         m_Height = height;
+        m_Format = TexelFormat::RGBA16F;
         int size = m_Height * m_Width;
-        m_Data = new Vec4[size];
+        std::vector<Vec4> texels(size);
         for (int i = 0; i < size; i++)
         {
             Vec3 val = framebuffer.GetColor(i);
-            m_Data[i] = { val, 1.0f };
+            texels[i] = { val, 1.0f };
         }
+        Build(std::move(texels), width, height);
     }
-    
-    Texture::~Texture()
+
+    // The padding of the partial tiles stays zero, the samplers never address it
+    template <TexelFormat format>
+    static void EncodeTexels(const std::vector<Vec4>& texels, const int width, const int height, const bool tiled, std::vector<uint8_t>& dst)
     {
-        delete[] m_Data;
-        m_Data = nullptr;
+        using storage_t = typename TexelTraits<format>::storage_t;
+        dst.assign((tiled ? TiledTexelCount(width, height) : width * height) * sizeof(storage_t), 0);
+        storage_t* out = (storage_t*)dst.data();
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+                out[tiled ? TiledTexelIndex(x, y, width) : y * width + x] = TexelTraits<format>::Encode(texels[y * width + x]);
+        }
     }
-    
-    // TODO: 采样模式支持
-    Vec4 Texture::Sample(const Vec2 texCoords) const
+
+    // Every level halves the previous one, resampled from its float copy with the default filter of stb_image_resize2
+    // and only then encoded, so the rounding errors don't add up along the chain.
+    // The four channels are filtered independently, W is not treated as alpha.
+    void Texture::Build(std::vector<Vec4> texels, int width, int height)
     {
-        float u = Clamp(texCoords.X, 0.0f, 1.0f);
-        float v = Clamp(texCoords.Y, 0.0f, 1.0f);
+        m_Levels.clear();
+        const bool tiled = m_Storage == TextureStorage::Tiled;
+        while (true)
+        {
+            Level& level = m_Levels.emplace_back();
+            level.Width = width;
+            level.Height = height;
+            switch (m_Format)
+            {
+            case TexelFormat::R8:       EncodeTexels<TexelFormat::R8>(texels, width, height, tiled, level.Texels); break;
+            case TexelFormat::RG8:      EncodeTexels<TexelFormat::RG8>(texels, width, height, tiled, level.Texels); break;
+            case TexelFormat::RGBA16F:  EncodeTexels<TexelFormat::RGBA16F>(texels, width, height, tiled, level.Texels); break;
+            case TexelFormat::BC1:      EncodeBlocks<TexelFormat::BC1>(texels.data(), width, height, level.Texels); break;
+            case TexelFormat::BC3:      EncodeBlocks<TexelFormat::BC3>(texels.data(), width, height, level.Texels); break;
+            case TexelFormat::BC4:      EncodeBlocks<TexelFormat::BC4>(texels.data(), width, height, level.Texels); break;
+            case TexelFormat::BC5:      EncodeBlocks<TexelFormat::BC5>(texels.data(), width, height, level.Texels); break;
+            default:                    EncodeTexels<TexelFormat::RGBA8>(texels, width, height, tiled, level.Texels); break;
+            }
+            level.Data = level.Texels.data();
+            level.Size = level.Texels.size();
+            if (IsBlockCompressed(m_Format))
+                level.ImageId = BlockCache::CreateImageId();
+
+            if (width == 1 && height == 1)
+                break;
+
+            const int mipWidth = std::max(width / 2, 1);
+            const int mipHeight = std::max(height / 2, 1);
+            std::vector<Vec4> mip(mipWidth * mipHeight);
+            stbir_resize_float_linear((const float*)texels.data(), width, height, 0,
+                                      (float*)mip.data(), mipWidth, mipHeight, 0, stbir_pixel_layout::STBIR_4CHANNEL);
+            texels = std::move(mip);
+            width = mipWidth;
+            height = mipHeight;
+        }
+    }
 
-        u = u * (m_Width - 1) + 0.5f;
-        v = v * (m_Height - 1) + 0.5f;
+    bool Texture::LoadCached()
+    {
+        TextureCache::Entry entry;
+        if (!TextureCache::Load(TextureCache::GetCachePath(m_Path, "tex", m_Storage), m_Path, entry) ||
+            entry.Channels < 1 || entry.Channels > 4 || !IsValidEntry(entry, GetTextureFormat(entry.Channels, m_Storage), m_Storage, true))
+            return false;
 
-        int x = floor(u);
-        int y = floor(v);
-        float fracX = fmod(u, 1.0f);
-        float fracY = fmod(v, 1.0f);
+        m_Width = entry.Levels[0].Width;
+        m_Height = entry.Levels[0].Height;
+        m_Channels = entry.Channels;
+        m_Format = entry.Format;
+        m_Levels.resize(entry.Levels.size());
+        for (size_t i = 0; i < m_Levels.size(); i++)
+        {
+            Level& level = m_Levels[i];
+            level.Width = entry.Levels[i].Width;
+            level.Height = entry.Levels[i].Height;
+            level.Data = entry.Levels[i].Data;
+            level.Size = entry.Levels[i].Size;
+            if (IsBlockCompressed(m_Format))
+                level.ImageId = BlockCache::CreateImageId();
+        }
+        m_File = std::move(entry.File);
+        return true;
+    }
 
-        int index0 = y * m_Width + x;
-        int index1 = y * m_Width + (x + 1 == m_Width ? x : x + 1);
-        int index2 = (y + 1 == m_Height ? y : y + 1) * m_Width + x;
-        int index3 = (y + 1 == m_Height ? y : y + 1) * m_Width + (x + 1 == m_Width ? x : x + 1);
+    void Texture::StoreCached() const
+    {
+        TextureCache::Entry entry{ m_Format, m_Storage, m_Channels, {}, nullptr };
+        for (const Level& level : m_Levels)
+            entry.Levels.push_back({ level.Width, level.Height, level.Data, level.Size });
+        TextureCache::Store(TextureCache::GetCachePath(m_Path, "tex", m_Storage), m_Path, entry);
+    }
 
-        Vec4 res{ 0.0f, 0.0f, 0.0f, 0.0f };
-        res += m_Data[index0] * (1.0f - fracX) * (1.0f - fracY);
-        res += m_Data[index1] * fracX * (1.0f - fracY);
-        res += m_Data[index2] * (1.0f - fracX)* fracY;
-        res += m_Data[index3] * fracX * fracY;
-        return res;
+    Vec4 Texture::Sample(const Vec2 texCoords) const
+    {
+        return Sample(ClampBilinearSampler{}, texCoords);
+    }
+
+    float Texture::ComputeLod(const Vec2 ddx, const Vec2 ddy) const
+    {
+        const float dxU = ddx.X * m_Width;
+        const float dxV = ddx.Y * m_Height;
+        const float dyU = ddy.X * m_Width;
+        const float dyV = ddy.Y * m_Height;
+        const float footprint = Max(dxU * dxU + dxV * dxV, dyU * dyU + dyV * dyV);
+        return 0.5f * std::log2(footprint);
     }
     
+    // The HDR textures keep 4 bytes per texel instead of a 12-byte Vec3
+    static uint32_t* EncodeRGB9E5(const Vec3* data, const int size)
+    {
+        uint32_t* res = new uint32_t[size];
+        for (int i = 0; i < size; i++)
+            res[i] = TexelTraits<TexelFormat::RGB9E5>::Encode({ data[i], 0.0f });
+        return res;
+    }
+
+    static std::vector<Vec3> DecodeRGB9E5(const uint32_t* data, const int size)
+    {
+        std::vector<Vec3> res(size);
+        for (int i = 0; i < size; i++)
+            res[i] = TexelTraits<TexelFormat::RGB9E5>::Decode(data[i]);
+        return res;
+    }
+
     Vec3 TextureSphere::Sample(const Vec3& v3) const
     {
         // https://blog.csdn.net/masilejfoaisegjiae/article/details/105804301
         Vec3 dir = Normalize(v3);
-        float phi = atan2(dir.Z, dir.X);
-        float theta = acos(dir.Y);
+        float phi = Atan2(dir.Z, dir.X);
+        float theta = Acos(dir.Y);
         float u = phi / (2 * PI) + 0.5f;
         float v = 1.0f - theta / PI;
 
         int x = u * (m_Width - 1) + 0.5f;
         int y = v * (m_Height - 1) + 0.5f;
 
-        int index = y * m_Width + x;
-        return m_Data[index];
+        if (m_Format == TexelFormat::BC6H)
+            return BlockCache::GetTexel<TexelFormat::BC6H>((const uint8_t*)m_Data, (m_Width + 3) / 4, m_ImageId, x, y);
+
+        return TexelTraits<TexelFormat::RGB9E5>::Decode(m_Data[y * m_Width + x]);
     }
 
-    TextureSphere::TextureSphere(const std::string& path)
+    TextureSphere::TextureSphere(const std::string& path, TextureStorage storage)
         :m_Path(path)
     {
+        if (LoadCached(storage))
+            return;
+
         int width, height, channels;
-        stbi_set_flip_vertically_on_load(true);
+        stbi_set_flip_vertically_on_load_thread(true);
         float* data;
         data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
         ASSERT((data) && (width > 0) && (height > 0) && (channels == 3));
@@ -149,53 +311,128 @@ namespace RGS {
         m_PixelSize = height * width;
 
         // stb_image.h 自动将 HDR 值映射到一个浮点数列表：默认情况下，每个通道32位，每个颜色 3 个通道
-        int size = height * width;
-        m_Data = new Vec3[size];
-        memcpy(m_Data, data, size * sizeof(Vec3));
+        SetTexels((const Vec3*)data, storage);
         stbi_image_free(data);
+        StoreCached();
     }
 
-    TextureSphere::TextureSphere(const Framebuffer& framebuffer)
+    TextureSphere::TextureSphere(const Framebuffer& framebuffer, TextureStorage storage)
     {
         m_Width = framebuffer.GetWidth();
         m_Height = framebuffer.GetHeight();
         m_Channels = 3;
         int size = m_Height * m_Width;
         m_PixelSize = size;
-        m_Data = new Vec3[size];
-        memcpy(m_Data, framebuffer.GetRawColorData(), size * sizeof(Vec3));
+        SetTexels((const Vec3*)framebuffer.GetRawColorData(), storage);
     }
    
     TextureSphere::~TextureSphere()
     {
-        delete[] m_Data;
+        if (!m_File)
+            delete[] m_Data;
         m_Data = nullptr;
     }
 
-    TextureSphere* TextureSphere::LoadTextureSphere(const std::string& path)
+    TextureSphere* TextureSphere::LoadTextureSphere(const std::string& path, TextureStorage storage)
     {
+        TextureSphere* res = new TextureSphere();
+        res->m_Path = path;
+        if (res->LoadCached(storage))
+            return res;
+
         int width, height, channels;
         float* data;
-        stbi_set_flip_vertically_on_load(true);
+        stbi_set_flip_vertically_on_load_thread(true);
         data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
 
         if (data == nullptr || width <= 0 || height <= 0 || channels != 3)
         {
             std::cout << "加载失败" << std::endl;
+            stbi_image_free(data);
+            delete res;
             return nullptr;
         }
 
-        TextureSphere* res = new TextureSphere();
-
         res->m_Height = height;
         res->m_Width = width;
         res->m_Channels = channels;
         res->m_PixelSize = height * width;
 
-        int size = height * width;
-        res->m_Data = new Vec3[size];
-        memcpy(res->m_Data, data, size * sizeof(Vec3));
+        res->SetTexels((const Vec3*)data, storage);
         stbi_image_free(data);
+        res->StoreCached();
+        return res;
+    }
+
+    void TextureSphere::SetTexels(const Vec3* texels, const TextureStorage storage)
+    {
+        const int size = m_Width * m_Height;
+        m_Storage = GetSphereStorage(storage);
+        if (m_Storage == TextureStorage::Linear)
+        {
+            m_Format = TexelFormat::RGB9E5;
+            m_Data = EncodeRGB9E5(texels, size);
+            return;
+        }
+
+        std::vector<Vec4> rgba(size);
+        for (int i = 0; i < size; i++)
+            rgba[i] = { texels[i], 0.0f };
+        std::vector<uint8_t> blocks;
+        EncodeBlocks<TexelFormat::BC6H>(rgba.data(), m_Width, m_Height, blocks);
+
+        m_Format = TexelFormat::BC6H;
+        uint32_t* data = new uint32_t[blocks.size() / sizeof(uint32_t)];
+        memcpy(data, blocks.data(), blocks.size());
+        m_Data = data;
+        m_ImageId = BlockCache::CreateImageId();
+    }
+
+    size_t TextureSphere::GetDataSize() const
+    {
+        return GetLevelSize(m_Format, m_Storage, m_Width, m_Height);
+    }
+
+    bool TextureSphere::LoadCached(TextureStorage storage)
+    {
+        storage = GetSphereStorage(storage);
+        const TexelFormat format = storage == TextureStorage::Compressed ? TexelFormat::BC6H : TexelFormat::RGB9E5;
+        TextureCache::Entry entry;
+        if (!TextureCache::Load(TextureCache::GetCachePath(m_Path, "sphere", storage), m_Path, entry) ||
+            entry.Channels != 3 || !IsValidEntry(entry, format, storage, false))
+            return false;
+
+        m_Width = entry.Levels[0].Width;
+        m_Height = entry.Levels[0].Height;
+        m_Channels = entry.Channels;
+        m_PixelSize = m_Width * m_Height;
+        m_Format = format;
+        m_Storage = storage;
+        m_Data = (const uint32_t*)entry.Levels[0].Data;
+        if (format == TexelFormat::BC6H)
+            m_ImageId = BlockCache::CreateImageId();
+        m_File = std::move(entry.File);
+        return true;
+    }
+
+    void TextureSphere::StoreCached() const
+    {
+        TextureCache::Entry entry{ m_Format, m_Storage, m_Channels, {}, nullptr };
+        entry.Levels.push_back({ m_Width, m_Height, (const uint8_t*)m_Data, GetDataSize() });
+        TextureCache::Store(TextureCache::GetCachePath(m_Path, "sphere", m_Storage), m_Path, entry);
+    }
+
+    std::vector<Vec3> TextureSphere::DecodeTexels() const
+    {
+        if (m_Storage == TextureStorage::Linear)
+            return DecodeRGB9E5(m_Data, m_Width * m_Height);
+
+        std::vector<Vec3> res(m_Width * m_Height);
+        for (int y = 0; y < m_Height; y++)
+        {
+            for (int x = 0; x < m_Width; x++)
+                res[y * m_Width + x] = BlockCache::GetTexel<TexelFormat::BC6H>((const uint8_t*)m_Data, (m_Width + 3) / 4, m_ImageId, x, y);
+        }
         return res;
     }
 
@@ -203,30 +440,25 @@ namespace RGS {
     {
         ASSERT(paths.size() == 5);
 
-        stbi_set_flip_vertically_on_load(true);
-        int width, height, channels, size;
-        float* data;
         for (int i = 0; i < 5; i++)
         {
-            data = stbi_loadf(paths[i].c_str(), &width, &height, &channels, 0);
-            ASSERT((data) && (width > 0) && (height > 0) && (channels == 3));
-            size = height * width;
-
-            m_Data[i].Height = height;
-            m_Data[i].Width = width;
-            m_Data[i].Channels = channels;
-            m_Data[i].PixelSize = size;
-            // stb_image.h 自动将 HDR 值映射到一个浮点数列表：默认情况下，每个通道32位，每个颜色 3 个通道
-            m_Data[i].ColorData = new Vec3[size];
-            memcpy(m_Data[i].ColorData, data, size * sizeof(Vec3));
+            if (i < (int)paths.size() && LoadLevel(i, paths[i]))
+                continue;
 
-            stbi_image_free(data);
+            // A black texel in place of the level keeps the lookups in bounds
+            std::cout << "加载失败: " << (i < (int)paths.size() ? paths[i] : std::to_string(i)) << std::endl;
+            Data& data = m_Data[i];
+            data.Width = 1;
+            data.Height = 1;
+            data.Channels = 3;
+            data.PixelSize = 1;
+            data.ColorData = new uint32_t[1]{ 0 };
         }
     }
 
     LodTextureSphere::LodTextureSphere(std::string path)
     {
-        stbi_set_flip_vertically_on_load(true);
+        stbi_set_flip_vertically_on_load_thread(true);
         int in_width, in_height, in_channels;
         float* in_data;
        
@@ -242,12 +474,11 @@ namespace RGS {
             float* data = stbir_resize_float_linear(in_data, in_width, in_height, 0,
                                                     nullptr, width, height, 0, stbir_pixel_layout::STBIR_RGB);
             int size = width * height;
-            m_Data[i].ColorData = new Vec3[size];
+            m_Data[i].ColorData = EncodeRGB9E5((const Vec3*)data, size);
             m_Data[i].Height = height;
             m_Data[i].Width = width;
             m_Data[i].Channels = 3;
             m_Data[i].PixelSize = size;
-            memcpy(m_Data[i].ColorData, data, size * sizeof(Vec3));
             stbi_image_free(data);
 
             width /= 2;
@@ -257,14 +488,70 @@ namespace RGS {
         stbi_image_free(in_data);
     }
 
+    LodTextureSphere::LodTextureSphere(const Framebuffer& framebuffer)
+    {
+        const int width = framebuffer.GetWidth();
+        const int height = framebuffer.GetHeight();
+        for (Data& data : m_Data)
+        {
+            data.Width = width;
+            data.Height = height;
+            data.Channels = 3;
+            data.PixelSize = width * height;
+            data.ColorData = EncodeRGB9E5((const Vec3*)framebuffer.GetRawColorData(), data.PixelSize);
+        }
+    }
+
     LodTextureSphere::~LodTextureSphere()
     {
-        for (auto data : m_Data)
+        for (const Data& data : m_Data)
         {
-            delete data.ColorData;
+            if (!data.File)
+                delete[] data.ColorData;
         }
     }
 
+    bool LodTextureSphere::LoadLevel(const int level, const std::string& path)
+    {
+        Data& data = m_Data[level];
+        const std::string cachePath = TextureCache::GetCachePath(path, "sphere", TextureStorage::Linear);
+        TextureCache::Entry entry;
+        if (TextureCache::Load(cachePath, path, entry) && entry.Channels == 3 &&
+            IsValidEntry(entry, TexelFormat::RGB9E5, TextureStorage::Linear, false))
+        {
+            data.Width = entry.Levels[0].Width;
+            data.Height = entry.Levels[0].Height;
+            data.Channels = entry.Channels;
+            data.PixelSize = data.Width * data.Height;
+            data.ColorData = (const uint32_t*)entry.Levels[0].Data;
+            data.File = std::move(entry.File);
+            return true;
+        }
+
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(true);
+        float* texels = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
+        if (texels == nullptr || width <= 0 || height <= 0 || channels != 3)
+        {
+            stbi_image_free(texels);
+            return false;
+        }
+
+        int size = height * width;
+        data.Height = height;
+        data.Width = width;
+        data.Channels = channels;
+        data.PixelSize = size;
+        // stb_image.h 自动将 HDR 值映射到一个浮点数列表：默认情况下，每个通道32位，每个颜色 3 个通道
+        data.ColorData = EncodeRGB9E5((const Vec3*)texels, size);
+        stbi_image_free(texels);
+
+        entry = { TexelFormat::RGB9E5, TextureStorage::Linear, channels, {}, nullptr };
+        entry.Levels.push_back({ width, height, (const uint8_t*)data.ColorData, (size_t)size * sizeof(uint32_t) });
+        TextureCache::Store(cachePath, path, entry);
+        return true;
+    }
+
     LodTextureSphere* LodTextureSphere::LoadLodTextureSphere(const std::string& path, LoadType loadType)
     {
         if (loadType == LoadType::SingleFile)
@@ -273,9 +560,6 @@ namespace RGS {
         }
         else if (loadType == LoadType::Directory)
         {
-            stbi_set_flip_vertically_on_load(true);
-            int width, height, channels, size;
-            float* data;
             LodTextureSphere* res = new LodTextureSphere();
             res->m_Path = path;
             for (int i = 0; i < 5; i++)
@@ -285,24 +569,14 @@ namespace RGS {
                 loadPath.append(std::to_string(i));
                 loadPath.append(".hdr");
 
-                data = stbi_loadf(loadPath.c_str(), &width, &height, &channels, 0);
-
-                ASSERT((data) && (width > 0) && (height > 0) && (channels == 3));
-                if (!((data) && (width > 0) && (height > 0) && (channels == 3)))
+                const bool loaded = res->LoadLevel(i, loadPath);
+                ASSERT(loaded);
+                if (!loaded)
                 {
                     std::cout << "加载失败" << std::endl;
-                    stbi_image_free(data);
                     delete res;
                     return nullptr;
                 }
-                size = height * width;
-                res->m_Data[i].Height = height;
-                res->m_Data[i].Width = width;
-                res->m_Data[i].Channels = channels;
-                res->m_Data[i].PixelSize = size;
-                res->m_Data[i].ColorData = new Vec3[size];
-                memcpy(res->m_Data[i].ColorData, data, size * sizeof(Vec3));
-                stbi_image_free(data);
             }
             return res;
         }
@@ -310,6 +584,22 @@ namespace RGS {
         return nullptr;
     }
 
+    LodTextureSphere* LodTextureSphere::LoadLodTextureSphere(const std::vector<std::string>& paths)
+    {
+        ASSERT(paths.size() == 5);
+        LodTextureSphere* res = new LodTextureSphere();
+        for (int i = 0; i < 5; i++)
+        {
+            if (!res->LoadLevel(i, paths[i]))
+            {
+                std::cout << "加载失败" << std::endl;
+                delete res;
+                return nullptr;
+            }
+        }
+        return res;
+    }
+
 
     // TODO: 似乎有xy偏移
     Vec3 LodTextureSphere::Sample(const Vec3& v3, float lod) const
@@ -319,8 +609,8 @@ namespace RGS {
         float frac = fmod(lod, 1.0f);
 
         Vec3 dir = Normalize(v3);
-        float phi = atan2(dir.Z, dir.X);
-        float theta = acos(dir.Y);
+        float phi = Atan2(dir.Z, dir.X);
+        float theta = Acos(dir.Y);
         float u = phi / (2.0f * PI) + 0.5f;
         float v = 1.0f - theta / PI;
 
@@ -404,7 +694,391 @@ namespace RGS {
         return { 0.0f, 0.0f, 0.0f };
     }
 
-}
+    void LodTextureSphere::Sample4(const float x[4], const float y[4], const float z[4], const float lod[4], Vec3 out[4]) const
+    {
+#if RGS_SIMD_SSE
+        for (int i = 0; i < 4; i++)
+            ASSERT((lod[i] >= 0) && (lod[i] <= (float)4));
 
+        // Normalize
+        __m128 dirX = _mm_loadu_ps(x);
+        __m128 dirY = _mm_loadu_ps(y);
+        __m128 dirZ = _mm_loadu_ps(z);
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, dirX), _mm_mul_ps(dirY, dirY)), _mm_mul_ps(dirZ, dirZ)));
+        const __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), length);
+        dirX = _mm_mul_ps(dirX, scale);
+        dirY = _mm_mul_ps(dirY, scale);
+        dirZ = _mm_mul_ps(dirZ, scale);
 
+        __m128 phi, theta;
+        if (FastMath::IsEnabled())
+        {
+            phi = FastMath::Atan2(dirZ, dirX);
+            theta = FastMath::Acos(dirY);
+        }
+        else
+        {
+            alignas(16) float dx[4], dy[4], dz[4], phis[4], thetas[4];
+            _mm_store_ps(dx, dirX);
+            _mm_store_ps(dy, dirY);
+            _mm_store_ps(dz, dirZ);
+            for (int i = 0; i < 4; i++)
+            {
+                phis[i] = Atan2(dz[i], dx[i]);
+                thetas[i] = Acos(dy[i]);
+            }
+            phi = _mm_load_ps(phis);
+            theta = _mm_load_ps(thetas);
+        }
+        const __m128 u = _mm_add_ps(_mm_div_ps(phi, _mm_set1_ps(2.0f * PI)), _mm_set1_ps(0.5f));
+        const __m128 v = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_div_ps(theta, _mm_set1_ps(PI)));
+
+        // The lod is not negative, so fmod(lod, 1) is lod - floor(lod). The lanes at level 4 blend it with itself at 0.
+        const __m128 lods = _mm_loadu_ps(lod);
+        const __m128i number = Detail::FloorToInt(lods);
+        alignas(16) int numbers[4];
+        alignas(16) float frac[4];
+        _mm_store_si128((__m128i*)numbers, number);
+        _mm_store_ps(frac, _mm_sub_ps(lods, _mm_cvtepi32_ps(number)));
+
+        const __m128i one = _mm_set1_epi32(1);
+        Vec4 colors[2][4];
+        for (int level = 0; level < 2; level++)
+        {
+            alignas(16) int widths[4], heights[4];
+            const uint32_t* data[4];
+            for (int i = 0; i < 4; i++)
+            {
+                const Data& levelData = m_Data[std::min(numbers[i] + level, 4)];
+                widths[i] = levelData.Width;
+                heights[i] = levelData.Height;
+                data[i] = levelData.ColorData;
+            }
+            const __m128i width = _mm_load_si128((const __m128i*)widths);
+            const __m128i height = _mm_load_si128((const __m128i*)heights);
+
+            const __m128 fu = _mm_add_ps(_mm_mul_ps(u, _mm_cvtepi32_ps(_mm_sub_epi32(width, one))), _mm_set1_ps(0.5f));
+            const __m128 fv = _mm_add_ps(_mm_mul_ps(v, _mm_cvtepi32_ps(_mm_sub_epi32(height, one))), _mm_set1_ps(0.5f));
+            const __m128i x0 = Detail::FloorToInt(fu);
+            const __m128i y0 = Detail::FloorToInt(fv);
+            const __m128 fracX = _mm_sub_ps(fu, _mm_cvtepi32_ps(x0));
+            const __m128 fracY = _mm_sub_ps(fv, _mm_cvtepi32_ps(y0));
 
+            // GetColor takes the coordinates modulo the size, they are at most one texel past the last one
+            auto wrap = [](const __m128i i, const __m128i size)
+            {
+                return _mm_sub_epi32(i, _mm_andnot_si128(_mm_cmpgt_epi32(size, i), size));
+            };
+            const __m128i column0 = wrap(x0, width);
+            const __m128i column1 = wrap(_mm_add_epi32(x0, one), width);
+            const __m128i row0 = Detail::MulInt(wrap(y0, height), width);
+            const __m128i row1 = Detail::MulInt(wrap(_mm_add_epi32(y0, one), height), width);
+
+            alignas(16) int i00[4], i10[4], i01[4], i11[4];
+            alignas(16) float fx[4], fy[4], gx[4], gy[4];
+            _mm_store_si128((__m128i*)i00, _mm_add_epi32(row0, column0));
+            _mm_store_si128((__m128i*)i10, _mm_add_epi32(row0, column1));
+            _mm_store_si128((__m128i*)i01, _mm_add_epi32(row1, column0));
+            _mm_store_si128((__m128i*)i11, _mm_add_epi32(row1, column1));
+            _mm_store_ps(fx, fracX);
+            _mm_store_ps(fy, fracY);
+            _mm_store_ps(gx, _mm_sub_ps(_mm_set1_ps(1.0f), fracX));
+            _mm_store_ps(gy, _mm_sub_ps(_mm_set1_ps(1.0f), fracY));
+
+            // Same order as Sample: color * weightX * weightY summed from 0
+            using traits = TexelTraits<TexelFormat::RGB9E5>;
+            for (int i = 0; i < 4; i++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(traits::DecodeSIMD(data[i][i00[i]]), _mm_set1_ps(gx[i])), _mm_set1_ps(gy[i])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(traits::DecodeSIMD(data[i][i10[i]]), _mm_set1_ps(fx[i])), _mm_set1_ps(gy[i])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(traits::DecodeSIMD(data[i][i01[i]]), _mm_set1_ps(gx[i])), _mm_set1_ps(fy[i])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_mul_ps(traits::DecodeSIMD(data[i][i11[i]]), _mm_set1_ps(fx[i])), _mm_set1_ps(fy[i])));
+                _mm_store_ps(&colors[level][i].X, sum);
+            }
+        }
+
+        for (int i = 0; i < 4; i++)
+            out[i] = Lerp((Vec3)colors[0][i], (Vec3)colors[1][i], frac[i]);
+#else
+        for (int i = 0; i < 4; i++)
+            out[i] = Sample({ x[i], y[i], z[i] }, lod[i]);
+#endif
+    }
+
+    // Bilinear, in the u/v mapping of TextureSphere::Sample
+    static Vec3 SampleEquirect(const Vec3* data, const int width, const int height, const Vec3& dir)
+    {
+        const double length = std::sqrt((double)dir.X * dir.X + (double)dir.Y * dir.Y + (double)dir.Z * dir.Z);
+        const double phi = std::atan2((double)dir.Z, (double)dir.X);
+        const double theta = std::acos(Clamp((float)(dir.Y / length), -1.0f, 1.0f));
+        const float u = (float)(phi / (2.0 * PI) + 0.5) * (width - 1);
+        const float v = (float)(1.0 - theta / PI) * (height - 1);
+
+        const int x0 = std::clamp((int)u, 0, width - 1);
+        const int y0 = std::clamp((int)v, 0, height - 1);
+        const int x1 = std::min(x0 + 1, width - 1);
+        const int y1 = std::min(y0 + 1, height - 1);
+        const float fracX = Clamp(u - x0, 0.0f, 1.0f);
+        const float fracY = Clamp(v - y0, 0.0f, 1.0f);
+
+        const Vec3 c0 = Lerp(data[y0 * width + x0], data[y0 * width + x1], fracX);
+        const Vec3 c1 = Lerp(data[y1 * width + x0], data[y1 * width + x1], fracX);
+        return Lerp(c0, c1, fracY);
+    }
+
+    static int GetDefaultFaceSize(const int width)
+    {
+        return std::min((int)std::bit_ceil((uint32_t)std::max(width / 4, 1)), Config::TextureCubeMaxFaceSize);
+    }
+
+    TextureCube::TextureCube(const std::string& path, int faceSize)
+        :m_Path(path)
+    {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(true);
+        float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
+        ASSERT((data) && (width > 0) && (height > 0) && (channels == 3));
+
+        const int size = faceSize == 0 ? GetDefaultFaceSize(width) : faceSize;
+        AddMipChain(ResampleEquirect((const Vec3*)data, width, height, size), size);
+        stbi_image_free(data);
+    }
+
+    TextureCube::TextureCube(const TextureSphere& sphere, int faceSize)
+        :m_Path(sphere.m_Path)
+    {
+        const std::vector<Vec3> equirect = sphere.DecodeTexels();
+        const int size = faceSize == 0 ? GetDefaultFaceSize(sphere.m_Width) : faceSize;
+        AddMipChain(ResampleEquirect(equirect.data(), sphere.m_Width, sphere.m_Height, size), size);
+    }
+
+    TextureCube::TextureCube(const LodTextureSphere& lodSphere)
+        :m_Path(lodSphere.m_Path)
+    {
+        for (const LodTextureSphere::Data& data : lodSphere.m_Data)
+        {
+            const std::vector<Vec3> equirect = DecodeRGB9E5(data.ColorData, data.Width * data.Height);
+            const int size = std::max(data.Width / 4, 1);
+            AddLevel(ResampleEquirect(equirect.data(), data.Width, data.Height, size), size);
+        }
+    }
+
+    TextureCube* TextureCube::LoadTextureCube(const std::string& path, int faceSize)
+    {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(true);
+        float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
+
+        if (data == nullptr || width <= 0 || height <= 0 || channels != 3)
+        {
+            std::cout << "加载失败" << std::endl;
+            stbi_image_free(data);
+            return nullptr;
+        }
+
+        TextureCube* res = new TextureCube();
+        res->m_Path = path;
+        const int size = faceSize == 0 ? GetDefaultFaceSize(width) : faceSize;
+        res->AddMipChain(ResampleEquirect((const Vec3*)data, width, height, size), size);
+        stbi_image_free(data);
+        return res;
+    }
+
+    TextureCube::FaceCoords TextureCube::GetFaceCoords(const Vec3& dir)
+    {
+        const float absX = std::abs(dir.X);
+        const float absY = std::abs(dir.Y);
+        const float absZ = std::abs(dir.Z);
+
+        FaceCoords coords;
+        float major, s, t;
+        if (absX >= absY && absX >= absZ)
+        {
+            coords.Face = dir.X >= 0.0f ? 0 : 1;
+            major = absX;
+            s = dir.X >= 0.0f ? -dir.Z : dir.Z;
+            t = -dir.Y;
+        }
+        else if (absY >= absZ)
+        {
+            coords.Face = dir.Y >= 0.0f ? 2 : 3;
+            major = absY;
+            s = dir.X;
+            t = dir.Y >= 0.0f ? dir.Z : -dir.Z;
+        }
+        else
+        {
+            coords.Face = dir.Z >= 0.0f ? 4 : 5;
+            major = absZ;
+            s = dir.Z >= 0.0f ? dir.X : -dir.X;
+            t = -dir.Y;
+        }
+
+        if (!(major > 0.0f))
+            return { 0, 0.5f, 0.5f };
+
+        // The only divide of the lookup
+        const float scale = 0.5f / major;
+        coords.U = s * scale + 0.5f;
+        coords.V = t * scale + 0.5f;
+        return coords;
+    }
+
+    // Inverse of GetFaceCoords, u/v outside [0, 1] point into the neighbouring faces
+    Vec3 TextureCube::GetFaceDir(const int face, const float u, const float v)
+    {
+        const float s = u * 2.0f - 1.0f;
+        const float t = v * 2.0f - 1.0f;
+        switch (face)
+        {
+        case 0:  return { 1.0f, -t, -s };
+        case 1:  return { -1.0f, -t, s };
+        case 2:  return { s, 1.0f, t };
+        case 3:  return { s, -1.0f, -t };
+        case 4:  return { s, -t, 1.0f };
+        default: return { -s, -t, -1.0f };
+        }
+    }
+
+    Vec3 TextureCube::SampleLevel(const Level& level, const FaceCoords& coords)
+    {
+        // Texel i of the face is at (i + 0.5) / Size and lives at i + 1 behind the border
+        const float x = coords.U * level.Size + 0.5f;
+        const float y = coords.V * level.Size + 0.5f;
+        const int x0 = std::clamp((int)x, 0, level.Size);
+        const int y0 = std::clamp((int)y, 0, level.Size);
+        const float fracX = x - x0;
+        const float fracY = y - y0;
+
+        const uint32_t* row0 = &level.Texels[(coords.Face * level.Stride + y0) * level.Stride + x0];
+        const uint32_t* row1 = row0 + level.Stride;
+        return BilinearTexel<TexelFormat::RGB9E5>(row0[0], row0[1], row1[0], row1[1], fracX, fracY);
+    }
+
+    Vec3 TextureCube::Sample(const Vec3& v3) const
+    {
+        return SampleLevel(m_Levels[0], GetFaceCoords(v3));
+    }
+
+    Vec3 TextureCube::Sample(const Vec3& v3, float lod) const
+    {
+        lod = Clamp(lod, 0.0f, (float)(m_Levels.size() - 1));
+        const int number = (int)lod;
+        const float frac = lod - number;
+
+        const FaceCoords coords = GetFaceCoords(v3);
+        const Vec3 c0 = SampleLevel(m_Levels[number], coords);
+        if (frac == 0.0f)
+            return c0;
+        return Lerp(c0, SampleLevel(m_Levels[number + 1], coords), frac);
+    }
+
+    std::vector<Vec3> TextureCube::ResampleEquirect(const Vec3* equirect, const int width, const int height, const int faceSize)
+    {
+        ASSERT(equirect && width > 0 && height > 0 && faceSize > 0);
+
+        const int stride = faceSize + 2;
+        std::vector<Vec3> texels(6 * stride * stride);
+        for (int face = 0; face < 6; ++face)
+        {
+            for (int y = 0; y < faceSize; ++y)
+            {
+                Vec3* row = &texels[(face * stride + y + 1) * stride + 1];
+                for (int x = 0; x < faceSize; ++x)
+                {
+                    const Vec3 dir = GetFaceDir(face, (x + 0.5f) / faceSize, (y + 0.5f) / faceSize);
+                    row[x] = SampleEquirect(equirect, width, height, dir);
+                }
+            }
+        }
+        FillBorder(texels, faceSize);
+        return texels;
+    }
+
+    // 2x2 box filter, size is the one of the source
+    std::vector<Vec3> TextureCube::Downsample(const std::vector<Vec3>& source, const int sourceSize)
+    {
+        const int sourceStride = sourceSize + 2;
+        const int size = sourceSize / 2;
+        const int stride = size + 2;
+        std::vector<Vec3> texels(6 * stride * stride);
+        for (int face = 0; face < 6; ++face)
+        {
+            for (int y = 0; y < size; ++y)
+            {
+                const Vec3* src0 = &source[(face * sourceStride + 2 * y + 1) * sourceStride + 1];
+                const Vec3* src1 = src0 + sourceStride;
+                Vec3* row = &texels[(face * stride + y + 1) * stride + 1];
+                for (int x = 0; x < size; ++x)
+                    row[x] = (src0[2 * x] + src0[2 * x + 1] + src1[2 * x] + src1[2 * x + 1]) * 0.25f;
+            }
+        }
+        FillBorder(texels, size);
+        return texels;
+    }
+
+    // A border texel copies the texel of the neighbouring face that touches it across the edge. The direction
+    // is taken just past the edge so the coordinate along the edge is kept, the fetch clamps onto the first row.
+    void TextureCube::FillBorder(std::vector<Vec3>& texels, const int size)
+    {
+        const int stride = size + 2;
+        auto fetch = [&](const int face, float x, float y)
+        {
+            x = Clamp(x, 0.0f, (float)(size - 1));
+            y = Clamp(y, 0.0f, (float)(size - 1));
+            const int x0 = (int)x;
+            const int y0 = (int)y;
+            const int x1 = std::min(x0 + 1, size - 1);
+            const int y1 = std::min(y0 + 1, size - 1);
+            const Vec3* faceTexels = &texels[(face * stride + 1) * stride + 1];
+            const Vec3 c0 = Lerp(faceTexels[y0 * stride + x0], faceTexels[y0 * stride + x1], x - x0);
+            const Vec3 c1 = Lerp(faceTexels[y1 * stride + x0], faceTexels[y1 * stride + x1], x - x0);
+            return Lerp(c0, c1, y - y0);
+        };
+
+        auto borderCoord = [&](const int i)
+        {
+            constexpr float epsilon = 1e-4f;
+            return i < 0 ? -epsilon : (i >= size ? 1.0f + epsilon : (i + 0.5f) / size);
+        };
+
+        for (int face = 0; face < 6; ++face)
+        {
+            for (int y = -1; y <= size; ++y)
+            {
+                for (int x = -1; x <= size; ++x)
+                {
+                    if (x >= 0 && x < size && y >= 0 && y < size)
+                        continue;
+
+                    const FaceCoords coords = GetFaceCoords(GetFaceDir(face, borderCoord(x), borderCoord(y)));
+                    texels[(face * stride + y + 1) * stride + x + 1] = fetch(coords.Face, coords.U * size - 0.5f, coords.V * size - 0.5f);
+                }
+            }
+        }
+    }
+
+    void TextureCube::AddLevel(const std::vector<Vec3>& texels, const int size)
+    {
+        Level& level = m_Levels.emplace_back();
+        level.Size = size;
+        level.Stride = size + 2;
+        level.Texels.resize(texels.size());
+        for (size_t i = 0; i < texels.size(); ++i)
+            level.Texels[i] = TexelTraits<TexelFormat::RGB9E5>::Encode({ texels[i], 0.0f });
+    }
+
+    // Down to 1x1, every level is filtered from the float copy of the previous one
+    void TextureCube::AddMipChain(std::vector<Vec3> texels, int size)
+    {
+        AddLevel(texels, size);
+        while (size > 1)
+        {
+            texels = Downsample(texels, size);
+            size /= 2;
+            AddLevel(texels, size);
+        }
+    }
+
+}
@@ -1,35 +1,502 @@
 #pragma once
 #include "RGS/Base/Maths.h"
+#include "RGS/Base/TexelFormat.h"
+#include "RGS/Base/BlockCompression.h"
 #include "RGS/Render/Framebuffer.h"
+#include "RGS/Platform.h"
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <algorithm>
 
 namespace RGS {
 
+    enum class WrapMode
+    {
+        Repeat,
+        Clamp,
+        Mirror,
+    };
+
+    enum class FilterMode
+    {
+        Nearest,        // nearest texel of the nearest level
+        Bilinear,       // of the nearest level
+        Trilinear,      // bilinear in the two levels around the LOD, blended
+    };
+
+    // Memory layout of the texels, chosen per texture when it is loaded
+    enum class TextureStorage
+    {
+        Linear,         // rows
+        Tiled,          // rows of 4x4 tiles, see TiledTexelIndex; same values, fewer cache lines per footprint. Texture only
+        Compressed,     // lossy 4x4 blocks, see BlockCompression.h
+    };
+
+    // Sampler state. The modes are template parameters, so every combination compiles its own
+    // Texture::Sample without branches on them; the LOD bias and clamp are plain values.
+    template <WrapMode wrap = WrapMode::Clamp, FilterMode filter = FilterMode::Bilinear>
+    struct Sampler
+    {
+        static constexpr WrapMode Wrap = wrap;
+        static constexpr FilterMode Filter = filter;
+
+        float LodBias = 0.0f;
+        float MinLod = 0.0f;
+        float MaxLod = 1000.0f;
+    };
+
+    using ClampBilinearSampler = Sampler<WrapMode::Clamp, FilterMode::Bilinear>;
+    using RepeatTrilinearSampler = Sampler<WrapMode::Repeat, FilterMode::Trilinear>;
+
+#if RGS_SIMD_SSE
+    // SSE2 integer helpers of the batched samplers (Sample4, Sample8)
+    namespace Detail {
+
+        // Lane by lane the same as Texture::FloorToInt
+        inline __m128i FloorToInt(const __m128 x)
+        {
+            const __m128i i = _mm_cvttps_epi32(x);
+            return _mm_add_epi32(i, _mm_castps_si128(_mm_cmplt_ps(x, _mm_cvtepi32_ps(i))));
+        }
+
+        inline __m128i SelectInt(const __m128i mask, const __m128i a, const __m128i b)
+        {
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+
+        inline __m128i ClampInt(const __m128i i, const int min, const int max)
+        {
+            const __m128i low = _mm_set1_epi32(min);
+            const __m128i high = _mm_set1_epi32(max);
+            const __m128i res = SelectInt(_mm_cmplt_epi32(i, low), low, i);
+            return SelectInt(_mm_cmpgt_epi32(res, high), high, res);
+        }
+
+        // Low 32 bits of the products, SSE2 has no _mm_mullo_epi32
+        inline __m128i MulInt(const __m128i a, const __m128i b)
+        {
+            const __m128i even = _mm_mul_epu32(a, b);
+            const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+
+    }
+#endif
+
     class Texture
     {
     public:
-        Texture(const std::string& path);
-        Texture(const Framebuffer& framebuffer);
-        ~Texture();
+        // Both build the full mip pyramid down to 1x1 with stb_image_resize2. Images keep their 8-bit
+        // channels (R8, RG8 or RGBA8), framebuffers are stored as RGBA16F.
+        // Compressed encodes the images to BC4, BC5, BC1 or BC3 by channel count instead. There is no block
+        // format for the RGBA16F framebuffers, they are Linear or Tiled.
+        // An image that can't be loaded is printed and leaves a black 1x1 texture, LoadTexture returns nullptr instead.
+        Texture(const std::string& path, TextureStorage storage = TextureStorage::Linear);
+        Texture(const Framebuffer& framebuffer, TextureStorage storage = TextureStorage::Linear);
+        ~Texture() = default;
 
+        // Clamped bilinear in level 0
         Vec4 Sample(const Vec2 texCoords) const;
 
+        // lod is log2 of the texels per pixel, see ComputeLod. It is biased and clamped by the sampler.
+        template <typename sampler_t>
+        Vec4 Sample(const sampler_t& sampler, const Vec2 texCoords, float lod = 0.0f) const
+        {
+            if (m_Storage == TextureStorage::Tiled)
+            {
+                switch (m_Format)
+                {
+                case TexelFormat::R8:       return SampleFormat<TexelFormat::R8, true>(sampler, texCoords, lod);
+                case TexelFormat::RG8:      return SampleFormat<TexelFormat::RG8, true>(sampler, texCoords, lod);
+                case TexelFormat::RGBA16F:  return SampleFormat<TexelFormat::RGBA16F, true>(sampler, texCoords, lod);
+                default:                    return SampleFormat<TexelFormat::RGBA8, true>(sampler, texCoords, lod);
+                }
+            }
+            switch (m_Format)
+            {
+            case TexelFormat::R8:       return SampleFormat<TexelFormat::R8, false>(sampler, texCoords, lod);
+            case TexelFormat::RG8:      return SampleFormat<TexelFormat::RG8, false>(sampler, texCoords, lod);
+            case TexelFormat::RGBA16F:  return SampleFormat<TexelFormat::RGBA16F, false>(sampler, texCoords, lod);
+            case TexelFormat::BC1:      return SampleFormat<TexelFormat::BC1, false>(sampler, texCoords, lod);
+            case TexelFormat::BC3:      return SampleFormat<TexelFormat::BC3, false>(sampler, texCoords, lod);
+            case TexelFormat::BC4:      return SampleFormat<TexelFormat::BC4, false>(sampler, texCoords, lod);
+            case TexelFormat::BC5:      return SampleFormat<TexelFormat::BC5, false>(sampler, texCoords, lod);
+            default:                    return SampleFormat<TexelFormat::RGBA8, false>(sampler, texCoords, lod);
+            }
+        }
+
+        // Four lookups in one call, the texture coordinates in SoA form. The wrapping, the texel addresses and the
+        // weights are computed for the four lanes in SSE registers, then every lane decodes and filters its texels
+        // in one register; the results are the same as four Sample calls. lod is shared by the lanes like by the
+        // 2x2 quad of a GPU. The block compressed formats and the scalar builds fall back to Sample lane by lane.
+        template <typename sampler_t>
+        void Sample4(const sampler_t& sampler, const float u[4], const float v[4], Vec4 out[4], float lod = 0.0f) const
+        {
+#if RGS_SIMD_SSE
+            const __m128 u4 = _mm_loadu_ps(u);
+            const __m128 v4 = _mm_loadu_ps(v);
+            if (m_Storage == TextureStorage::Tiled)
+            {
+                switch (m_Format)
+                {
+                case TexelFormat::R8:       SampleFormat4<TexelFormat::R8, true>(sampler, u4, v4, out, lod); return;
+                case TexelFormat::RG8:      SampleFormat4<TexelFormat::RG8, true>(sampler, u4, v4, out, lod); return;
+                case TexelFormat::RGBA16F:  SampleFormat4<TexelFormat::RGBA16F, true>(sampler, u4, v4, out, lod); return;
+                default:                    SampleFormat4<TexelFormat::RGBA8, true>(sampler, u4, v4, out, lod); return;
+                }
+            }
+            if (!IsBlockCompressed(m_Format))
+            {
+                switch (m_Format)
+                {
+                case TexelFormat::R8:       SampleFormat4<TexelFormat::R8, false>(sampler, u4, v4, out, lod); return;
+                case TexelFormat::RG8:      SampleFormat4<TexelFormat::RG8, false>(sampler, u4, v4, out, lod); return;
+                case TexelFormat::RGBA16F:  SampleFormat4<TexelFormat::RGBA16F, false>(sampler, u4, v4, out, lod); return;
+                default:                    SampleFormat4<TexelFormat::RGBA8, false>(sampler, u4, v4, out, lod); return;
+                }
+            }
+#endif
+            for (int i = 0; i < 4; i++)
+                out[i] = Sample(sampler, { u[i], v[i] }, lod);
+        }
+
+        // Clamped bilinear in level 0
+        void Sample4(const float u[4], const float v[4], Vec4 out[4]) const
+        {
+            Sample4(ClampBilinearSampler{}, u, v, out);
+        }
+
+        // Two batches of four, without AVX2 there are no 8-lane integer ops
+        template <typename sampler_t>
+        void Sample8(const sampler_t& sampler, const float u[8], const float v[8], Vec4 out[8], float lod = 0.0f) const
+        {
+            Sample4(sampler, u, v, out, lod);
+            Sample4(sampler, u + 4, v + 4, out + 4, lod);
+        }
+
+        void Sample8(const float u[8], const float v[8], Vec4 out[8]) const
+        {
+            Sample8(ClampBilinearSampler{}, u, v, out);
+        }
+
+        // LOD of the pixel footprint from the screen-space derivatives of the texture coordinates (Ddx/Ddy)
+        float ComputeLod(const Vec2 ddx, const Vec2 ddy) const;
+
         int GetWidth() { return m_Width; }
         int GetHeight() { return m_Height; }
+        int GetLevelCount() const { return (int)m_Levels.size(); }
+        TexelFormat GetFormat() const { return m_Format; }
+        TextureStorage GetStorage() const { return m_Storage; }
+
+        // nullptr when the image can't be loaded
+        static Texture* LoadTexture(const std::string& path, TextureStorage storage = TextureStorage::Linear);
+
+    protected:
+        Texture() = default;
+
+        bool Init(const std::string& path, TextureStorage storage);
+
+        struct Level
+        {
+            int Width, Height;
+            std::vector<uint8_t> Texels;    // in m_Format, rows of 4x4 tiles or blocks unless m_Storage is Linear
+            const uint8_t* Data = nullptr;  // Texels.data(), or the level in m_File when Texels is empty
+            size_t Size = 0;                // bytes at Data
+            uint32_t ImageId = 0;           // tag of the decoded blocks in BlockCache
+
+            template <TexelFormat format>
+            const typename TexelTraits<format>::storage_t* GetTexels() const
+            {
+                return (const typename TexelTraits<format>::storage_t*)Data;
+            }
+        };
+
+        // Mips from the full resolution level in float, every level encoded to m_Format
+        void Build(std::vector<Vec4> texels, int width, int height);
+
+        // The levels of m_Path in the .rgstex file, false when it has none for m_Storage
+        bool LoadCached();
+        void StoreCached() const;
+
+        template <TexelFormat format, bool tiled, typename sampler_t>
+        Vec4 SampleFormat(const sampler_t& sampler, const Vec2 texCoords, float lod) const
+        {
+            lod = Clamp(lod + sampler.LodBias, sampler.MinLod, sampler.MaxLod);
+            lod = Clamp(lod, 0.0f, (float)(m_Levels.size() - 1));
+            if constexpr (sampler_t::Filter == FilterMode::Trilinear)
+            {
+                const int number = (int)lod;
+                const float frac = lod - number;
+                const Vec4 c0 = SampleBilinear<format, tiled, sampler_t::Wrap>(m_Levels[number], texCoords);
+                if (frac == 0.0f)
+                    return c0;
+                return Lerp(c0, SampleBilinear<format, tiled, sampler_t::Wrap>(m_Levels[number + 1], texCoords), frac);
+            }
+            else if constexpr (sampler_t::Filter == FilterMode::Bilinear)
+            {
+                return SampleBilinear<format, tiled, sampler_t::Wrap>(m_Levels[(int)(lod + 0.5f)], texCoords);
+            }
+            else
+            {
+                return SampleNearest<format, tiled, sampler_t::Wrap>(m_Levels[(int)(lod + 0.5f)], texCoords);
+            }
+        }
+
+        static int FloorToInt(const float x)
+        {
+            const int i = (int)x;
+            return i - (x < (float)i);
+        }
+
+        // Texture coordinate into [0, 1]
+        template <WrapMode wrap>
+        static float WrapCoord(const float u)
+        {
+            if constexpr (wrap == WrapMode::Repeat)
+            {
+                return u - (float)FloorToInt(u);
+            }
+            else if constexpr (wrap == WrapMode::Mirror)
+            {
+                const float t = u - 2.0f * (float)FloorToInt(u * 0.5f);
+                return t > 1.0f ? 2.0f - t : t;
+            }
+            else
+            {
+                return Clamp(u, 0.0f, 1.0f);
+            }
+        }
+
+        // Neighbour texel index, at most one texel outside of [0, size)
+        template <WrapMode wrap>
+        static int WrapTexel(const int i, const int size)
+        {
+            if constexpr (wrap == WrapMode::Repeat)
+                return i < 0 ? i + size : (i >= size ? i - size : i);
+            else
+                return i < 0 ? 0 : (i >= size ? size - 1 : i);
+        }
+
+        // The texel index is RowOffset(y) + ColumnOffset(x) in both layouts
+        template <bool tiled>
+        static int RowOffset(const Level& level, const int y)
+        {
+            if constexpr (tiled)
+                return TiledRowOffset(y, level.Width);
+            else
+                return y * level.Width;
+        }
+
+        template <bool tiled>
+        static int ColumnOffset(const int x)
+        {
+            if constexpr (tiled)
+                return TiledColumnOffset(x);
+            else
+                return x;
+        }
+
+        template <TexelFormat format, bool tiled, WrapMode wrap>
+        static Vec4 SampleNearest(const Level& level, const Vec2 texCoords)
+        {
+            const int x = std::min((int)(WrapCoord<wrap>(texCoords.X) * level.Width), level.Width - 1);
+            const int y = std::min((int)(WrapCoord<wrap>(texCoords.Y) * level.Height), level.Height - 1);
+            if constexpr (IsBlockCompressed(format))
+            {
+                return BlockCache::GetTexel<format>(level.Data, (level.Width + 3) / 4, level.ImageId, x, y);
+            }
+            else
+            {
+                const auto& texel = level.GetTexels<format>()[RowOffset<tiled>(level, y) + ColumnOffset<tiled>(x)];
+#if RGS_SIMD_SSE
+                Vec4 res;
+                _mm_store_ps(&res.X, TexelTraits<format>::DecodeSIMD(texel));
+                return res;
+#else
+                return TexelTraits<format>::Decode(texel);
+#endif
+            }
+        }
+
+        template <TexelFormat format, bool tiled, WrapMode wrap>
+        static Vec4 SampleBilinear(const Level& level, const Vec2 texCoords)
+        {
+            // Texel centers are at (i + 0.5) / size
+            const float u = WrapCoord<wrap>(texCoords.X) * level.Width - 0.5f;
+            const float v = WrapCoord<wrap>(texCoords.Y) * level.Height - 0.5f;
+            const int x = FloorToInt(u);
+            const int y = FloorToInt(v);
+
+            if constexpr (IsBlockCompressed(format))
+            {
+                const int x0 = WrapTexel<wrap>(x, level.Width), x1 = WrapTexel<wrap>(x + 1, level.Width);
+                const int y0 = WrapTexel<wrap>(y, level.Height), y1 = WrapTexel<wrap>(y + 1, level.Height);
+                const float fracX = u - x;
+                const float fracY = v - y;
+                Vec4 c[4];
+                BlockCache::GetQuad<format>(level.Data, (level.Width + 3) / 4, level.ImageId, x0, x1, y0, y1, c);
+                return c[0] * ((1.0f - fracX) * (1.0f - fracY)) + c[1] * (fracX * (1.0f - fracY)) +
+                       c[2] * ((1.0f - fracX) * fracY) + c[3] * (fracX * fracY);
+            }
+            else
+            {
+                const auto* row0 = level.GetTexels<format>() + RowOffset<tiled>(level, WrapTexel<wrap>(y, level.Height));
+                const auto* row1 = level.GetTexels<format>() + RowOffset<tiled>(level, WrapTexel<wrap>(y + 1, level.Height));
+                const int x0 = ColumnOffset<tiled>(WrapTexel<wrap>(x, level.Width));
+                const int x1 = ColumnOffset<tiled>(WrapTexel<wrap>(x + 1, level.Width));
+                return BilinearTexel<format>(row0[x0], row0[x1], row1[x0], row1[x1], u - x, v - y);
+            }
+        }
+
+#if RGS_SIMD_SSE
+        // The batched forms of the functions above, lane by lane the same operations
+
+        template <TexelFormat format, bool tiled, typename sampler_t>
+        void SampleFormat4(const sampler_t& sampler, const __m128 u, const __m128 v, Vec4 out[4], float lod) const
+        {
+            lod = Clamp(lod + sampler.LodBias, sampler.MinLod, sampler.MaxLod);
+            lod = Clamp(lod, 0.0f, (float)(m_Levels.size() - 1));
+            if constexpr (sampler_t::Filter == FilterMode::Trilinear)
+            {
+                const int number = (int)lod;
+                const float frac = lod - number;
+                SampleBilinear4<format, tiled, sampler_t::Wrap>(m_Levels[number], u, v, out);
+                if (frac == 0.0f)
+                    return;
+                Vec4 c1[4];
+                SampleBilinear4<format, tiled, sampler_t::Wrap>(m_Levels[number + 1], u, v, c1);
+                for (int i = 0; i < 4; i++)
+                    out[i] = Lerp(out[i], c1[i], frac);
+            }
+            else if constexpr (sampler_t::Filter == FilterMode::Bilinear)
+            {
+                SampleBilinear4<format, tiled, sampler_t::Wrap>(m_Levels[(int)(lod + 0.5f)], u, v, out);
+            }
+            else
+            {
+                SampleNearest4<format, tiled, sampler_t::Wrap>(m_Levels[(int)(lod + 0.5f)], u, v, out);
+            }
+        }
+
+        template <WrapMode wrap>
+        static __m128 WrapCoord4(const __m128 u)
+        {
+            if constexpr (wrap == WrapMode::Repeat)
+            {
+                return _mm_sub_ps(u, _mm_cvtepi32_ps(Detail::FloorToInt(u)));
+            }
+            else if constexpr (wrap == WrapMode::Mirror)
+            {
+                const __m128 t = _mm_sub_ps(u, _mm_mul_ps(_mm_set1_ps(2.0f), _mm_cvtepi32_ps(Detail::FloorToInt(_mm_mul_ps(u, _mm_set1_ps(0.5f))))));
+                const __m128 mirrored = _mm_cmpgt_ps(t, _mm_set1_ps(1.0f));
+                return _mm_or_ps(_mm_and_ps(mirrored, _mm_sub_ps(_mm_set1_ps(2.0f), t)), _mm_andnot_ps(mirrored, t));
+            }
+            else
+            {
+                // std::max(0, std::min(u, 1)) including the NaN cases
+                return _mm_max_ps(_mm_min_ps(_mm_set1_ps(1.0f), u), _mm_setzero_ps());
+            }
+        }
+
+        template <WrapMode wrap>
+        static __m128i WrapTexel4(const __m128i i, const int size)
+        {
+            if constexpr (wrap == WrapMode::Repeat)
+            {
+                const __m128i sizes = _mm_set1_epi32(size);
+                const __m128i below = _mm_and_si128(_mm_cmplt_epi32(i, _mm_setzero_si128()), sizes);
+                const __m128i above = _mm_and_si128(_mm_cmpgt_epi32(i, _mm_set1_epi32(size - 1)), sizes);
+                return _mm_sub_epi32(_mm_add_epi32(i, below), above);
+            }
+            else
+            {
+                return Detail::ClampInt(i, 0, size - 1);
+            }
+        }
+
+        template <bool tiled>
+        static __m128i RowOffset4(const Level& level, const __m128i y)
+        {
+            if constexpr (tiled)
+            {
+                const __m128i tileRows = Detail::MulInt(_mm_srli_epi32(y, 2), _mm_set1_epi32((level.Width + 3) >> 2));
+                return _mm_add_epi32(_mm_slli_epi32(tileRows, 4), _mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(3)), 2));
+            }
+            else
+            {
+                return Detail::MulInt(y, _mm_set1_epi32(level.Width));
+            }
+        }
+
+        template <bool tiled>
+        static __m128i ColumnOffset4(const __m128i x)
+        {
+            if constexpr (tiled)
+                return _mm_add_epi32(_mm_slli_epi32(_mm_srli_epi32(x, 2), 4), _mm_and_si128(x, _mm_set1_epi32(3)));
+            else
+                return x;
+        }
+
+        template <TexelFormat format, bool tiled, WrapMode wrap>
+        static void SampleNearest4(const Level& level, const __m128 u, const __m128 v, Vec4 out[4])
+        {
+            const __m128i x = Detail::ClampInt(_mm_cvttps_epi32(_mm_mul_ps(WrapCoord4<wrap>(u), _mm_set1_ps((float)level.Width))), 0, level.Width - 1);
+            const __m128i y = Detail::ClampInt(_mm_cvttps_epi32(_mm_mul_ps(WrapCoord4<wrap>(v), _mm_set1_ps((float)level.Height))), 0, level.Height - 1);
+            alignas(16) int index[4];
+            _mm_store_si128((__m128i*)index, _mm_add_epi32(RowOffset4<tiled>(level, y), ColumnOffset4<tiled>(x)));
+
+            const auto* texels = level.GetTexels<format>();
+            for (int i = 0; i < 4; i++)
+                _mm_store_ps(&out[i].X, TexelTraits<format>::DecodeSIMD(texels[index[i]]));
+        }
+
+        template <TexelFormat format, bool tiled, WrapMode wrap>
+        static void SampleBilinear4(const Level& level, const __m128 u, const __m128 v, Vec4 out[4])
+        {
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 fu = _mm_sub_ps(_mm_mul_ps(WrapCoord4<wrap>(u), _mm_set1_ps((float)level.Width)), half);
+            const __m128 fv = _mm_sub_ps(_mm_mul_ps(WrapCoord4<wrap>(v), _mm_set1_ps((float)level.Height)), half);
+            const __m128i x = Detail::FloorToInt(fu);
+            const __m128i y = Detail::FloorToInt(fv);
+            const __m128i one = _mm_set1_epi32(1);
+
+            alignas(16) int x0[4], x1[4], y0[4], y1[4];
+            alignas(16) float fracX[4], fracY[4];
+            _mm_store_si128((__m128i*)x0, ColumnOffset4<tiled>(WrapTexel4<wrap>(x, level.Width)));
+            _mm_store_si128((__m128i*)x1, ColumnOffset4<tiled>(WrapTexel4<wrap>(_mm_add_epi32(x, one), level.Width)));
+            _mm_store_si128((__m128i*)y0, RowOffset4<tiled>(level, WrapTexel4<wrap>(y, level.Height)));
+            _mm_store_si128((__m128i*)y1, RowOffset4<tiled>(level, WrapTexel4<wrap>(_mm_add_epi32(y, one), level.Height)));
+            _mm_store_ps(fracX, _mm_sub_ps(fu, _mm_cvtepi32_ps(x)));
+            _mm_store_ps(fracY, _mm_sub_ps(fv, _mm_cvtepi32_ps(y)));
+
+            const auto* texels = level.GetTexels<format>();
+            for (int i = 0; i < 4; i++)
+            {
+                const auto* row0 = texels + y0[i];
+                const auto* row1 = texels + y1[i];
+                out[i] = BilinearTexel<format>(row0[x0[i]], row0[x1[i]], row1[x0[i]], row1[x1[i]], fracX[i], fracY[i]);
+            }
+        }
+#endif
 
     protected:
         int m_Width, m_Height, m_Channels;
         std::string m_Path;
-        Vec4* m_Data;
+        TexelFormat m_Format;
+        TextureStorage m_Storage;
+        std::vector<Level> m_Levels;        // 0 is the full resolution
+        std::shared_ptr<MappedFile> m_File; // the .rgstex file the levels point into, null when they own their texels
     };
 
     class TextureSphere 
     {
     public:
-        TextureSphere(const std::string& path);
-        TextureSphere(const Framebuffer& framebuffer);
+        // RGB9E5 texels in rows, Compressed stores BC6H blocks instead. Tiled is stored in rows too, a lookup reads
+        // one texel and has no footprint the tiles could keep in fewer cache lines.
+        TextureSphere(const std::string& path, TextureStorage storage = TextureStorage::Linear);
+        TextureSphere(const Framebuffer& framebuffer, TextureStorage storage = TextureStorage::Linear);
         ~TextureSphere();
 
         Vec3 Sample(const Vec3& v3) const;
@@ -39,25 +506,56 @@ namespace RGS {
 
         std::string GetPath() { return m_Path; }
 
-        static TextureSphere* LoadTextureSphere(const std::string& path);
+        TextureStorage GetStorage() const { return m_Storage; }
+
+        static TextureSphere* LoadTextureSphere(const std::string& path, TextureStorage storage = TextureStorage::Linear);
 
     protected:
         TextureSphere() = default;
 
+        void SetTexels(const Vec3* texels, TextureStorage storage);
+        std::vector<Vec3> DecodeTexels() const;
+        // Bytes at m_Data
+        size_t GetDataSize() const;
+
+        // Like Texture::LoadCached
+        bool LoadCached(TextureStorage storage);
+        void StoreCached() const;
+
+        friend class TextureCube;
+
     protected:
         int m_Width, m_Height, m_Channels, m_PixelSize;
         std::string m_Path;
-        Vec3* m_Data;
+        TexelFormat m_Format = TexelFormat::RGB9E5;
+        TextureStorage m_Storage = TextureStorage::Linear;
+        const uint32_t* m_Data = nullptr;   // RGB9E5 texels, or BC6H blocks of 4 words
+        uint32_t m_ImageId = 0;             // BC6H, tag of the decoded blocks in BlockCache
+        std::shared_ptr<MappedFile> m_File; // m_Data points into it when set, owned otherwise
     };
 
     class LodTextureSphere
     {
     public:
+        // The five levels, one that can't be loaded is printed and left a black 1x1 level
         LodTextureSphere(std::vector<std::string> paths);
         LodTextureSphere(std::string paths);
+        // Every level a copy of the framebuffer, e.g. a stand-in while the prefiltered maps load
+        LodTextureSphere(const Framebuffer& framebuffer);
         ~LodTextureSphere();
         Vec3 Sample(const Vec3& v3, float lod) const;
 
+        // Four lookups in one call, the directions and LODs in SoA form. Normalization, the equirectangular
+        // mapping, the texel addresses and the weights are computed for the four lanes in SSE registers (the
+        // angles with libm lane by lane unless FastMath is enabled), then every lane filters its eight texels in
+        // one register. The results are the same as four Sample calls.
+        void Sample4(const float x[4], const float y[4], const float z[4], const float lod[4], Vec3 out[4]) const;
+        void Sample8(const float x[8], const float y[8], const float z[8], const float lod[8], Vec3 out[8]) const
+        {
+            Sample4(x, y, z, lod, out);
+            Sample4(x + 4, y + 4, z + 4, lod + 4, out + 4);
+        }
+
         Vec3 GetColor(int x, int y, int lod) const
         {
             const Data& data = m_Data[lod];
@@ -65,7 +563,7 @@ namespace RGS {
             int height = data.Height;
             x %= width;
             y %= height;
-            return data.ColorData[y * width + x];
+            return TexelTraits<TexelFormat::RGB9E5>::Decode(data.ColorData[y * width + x]);
         }
 
         enum class LoadType
@@ -75,6 +573,8 @@ namespace RGS {
         };
 
         static LodTextureSphere* LoadLodTextureSphere(const std::string& path, LoadType loadType);
+        // The five levels, nullptr when one can't be loaded
+        static LodTextureSphere* LoadLodTextureSphere(const std::vector<std::string>& paths);
 
 
         std::string GetPath() { return m_Path; }
@@ -82,14 +582,80 @@ namespace RGS {
 
         LodTextureSphere() = default;
 
+        // The RGB9E5 texels of the HDR image at path, the same .rgstex entry as a linear TextureSphere of it
+        bool LoadLevel(int level, const std::string& path);
+
+        friend class TextureCube;
+
         std::string m_Path;
 
         struct Data
         {
             int Width, Height, Channels, PixelSize;
-            Vec3* ColorData;
+            const uint32_t* ColorData = nullptr;    // RGB9E5
+            std::shared_ptr<MappedFile> File;       // ColorData points into it when set, owned otherwise
         };
         Data m_Data[5]; // 0 ��Ϊ���
     };
 
-}
\ No newline at end of file
+    // Six square faces in the +X, -X, +Y, -Y, +Z, -Z order of the graphics APIs, built from equirectangular
+    // images at load time. A lookup picks the face by the major axis of the direction and divides by it,
+    // no normalize and no atan2/acos. Every face keeps a one texel border copied from its neighbours, so
+    // the bilinear footprint never leaves the face and the filtering is seamless across the edges.
+    class TextureCube
+    {
+    public:
+        // faceSize 0 picks the power of two above a quarter of the width, capped by Config::TextureCubeMaxFaceSize.
+        // The mip chain is box filtered down to 1x1.
+        TextureCube(const std::string& path, int faceSize = 0);
+        TextureCube(const TextureSphere& sphere, int faceSize = 0);
+        // Keeps the prefiltered levels as they are, a quarter of their width each, instead of a box filtered chain
+        TextureCube(const LodTextureSphere& lodSphere);
+
+        // Bilinear in level 0
+        Vec3 Sample(const Vec3& v3) const;
+        // Trilinear, lod is clamped to [0, GetLevelCount() - 1]
+        Vec3 Sample(const Vec3& v3, float lod) const;
+
+        int GetFaceSize() const { return m_Levels[0].Size; }
+        int GetLevelCount() const { return (int)m_Levels.size(); }
+
+        std::string GetPath() const { return m_Path; }
+
+        static TextureCube* LoadTextureCube(const std::string& path, int faceSize = 0);
+
+    protected:
+        TextureCube() = default;
+
+        struct Level
+        {
+            int Size;                       // of the face, without the border
+            int Stride;                     // Size + 2
+            std::vector<uint32_t> Texels;   // 6 faces of Stride x Stride, RGB9E5
+        };
+
+        struct FaceCoords
+        {
+            int Face;
+            float U, V;                     // [0, 1] on the face
+        };
+
+        static FaceCoords GetFaceCoords(const Vec3& dir);
+        static Vec3 GetFaceDir(int face, float u, float v);
+
+        static Vec3 SampleLevel(const Level& level, const FaceCoords& coords);
+
+        // The levels are built in float, 6 faces of (size + 2)^2 with the border filled, and encoded by AddLevel
+        static std::vector<Vec3> ResampleEquirect(const Vec3* equirect, int width, int height, int faceSize);
+        static std::vector<Vec3> Downsample(const std::vector<Vec3>& source, int sourceSize);
+        static void FillBorder(std::vector<Vec3>& texels, int size);
+
+        void AddLevel(const std::vector<Vec3>& texels, int size);
+        void AddMipChain(std::vector<Vec3> texels, int size);
+
+    protected:
+        std::string m_Path;
+        std::vector<Level> m_Levels;
+    };
+
+}
@@ -0,0 +1,189 @@
+#include "rgspch.h"
+#include "TextureCache.h"
+
+#include "RGS/Config.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace RGS {
+
+    namespace TextureCache {
+
+        // The header, one FileLevel per level, then the texels of every level at a 64-byte aligned offset
+        struct FileHeader
+        {
+            char Magic[4];
+            uint32_t Version;
+            uint64_t SourceSize;
+            int64_t SourceTime;
+            uint64_t SourceHash;
+            uint32_t Format;                // TexelFormat
+            uint32_t Storage;               // TextureStorage
+            int32_t Channels;
+            int32_t LevelCount;
+        };
+
+        struct FileLevel
+        {
+            int32_t Width, Height;
+            uint64_t Offset, Size;
+        };
+
+        static constexpr char FileMagic[4] = { 'R', 'G', 'T', 'X' };
+        static constexpr uint32_t FileVersion = 1;
+        static constexpr uint64_t DataAlignment = 64;
+        // Far more than the levels of the largest image, bounds what a damaged header can ask for
+        static constexpr int32_t MaxLevelCount = 32;
+
+        bool GetSourceStamp(const std::string& path, uint64_t& size, int64_t& time)
+        {
+            std::error_code error;
+            size = (uint64_t)std::filesystem::file_size(path, error);
+            if (error)
+                return false;
+            time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+            return !error;
+        }
+
+        uint64_t Hash(const uint8_t* data, const size_t size)
+        {
+            constexpr uint64_t prime = 0x100000001B3ull;
+            uint64_t hash = 0xCBF29CE484222325ull;
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                memcpy(&word, data + i, sizeof(word));
+                hash = (hash ^ word) * prime;
+            }
+            for (; i < size; ++i)
+                hash = (hash ^ data[i]) * prime;
+            return hash;
+        }
+
+        // 0 when the file can't be read
+        static uint64_t HashFile(const std::string& path)
+        {
+            MappedFile file;
+            if (!file.Open(path))
+                return 0;
+            return Hash(file.GetData(), file.GetSize());
+        }
+
+        std::string GetCachePath(const std::string& path, const char* kind, const TextureStorage storage)
+        {
+            const char* suffix = storage == TextureStorage::Tiled ? "-tiled" : (storage == TextureStorage::Compressed ? "-bc" : "");
+            return path + "." + kind + suffix + ".rgstex";
+        }
+
+        bool Load(const std::string& cachePath, const std::string& sourcePath, Entry& entry)
+        {
+            if (!Config::TextureCacheEnabled)
+                return false;
+
+            auto file = std::make_shared<MappedFile>();
+            if (!file->Open(cachePath) || file->GetSize() < sizeof(FileHeader))
+                return false;
+
+            FileHeader header;
+            memcpy(&header, file->GetData(), sizeof(header));
+            if (memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 || header.Version != FileVersion ||
+                header.LevelCount <= 0 || header.LevelCount > MaxLevelCount ||
+                file->GetSize() < sizeof(FileHeader) + header.LevelCount * sizeof(FileLevel))
+                return false;
+
+            // A missing source keeps the entry, the texture can still be loaded from it
+            uint64_t sourceSize;
+            int64_t sourceTime;
+            if (GetSourceStamp(sourcePath, sourceSize, sourceTime) && (sourceSize != header.SourceSize || sourceTime != header.SourceTime))
+            {
+                // Touched, copied or checked out again: the hash tells whether the content changed
+                if (sourceSize != header.SourceSize || HashFile(sourcePath) != header.SourceHash)
+                    return false;
+                // Same content, the new time spares the next loads the hash. Best effort, the mapping only reads
+                std::fstream stamp(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+                stamp.seekp(offsetof(FileHeader, SourceTime));
+                stamp.write((const char*)&sourceTime, sizeof(sourceTime));
+            }
+
+            entry.Format = (TexelFormat)header.Format;
+            entry.Storage = (TextureStorage)header.Storage;
+            entry.Channels = header.Channels;
+            entry.Levels.resize(header.LevelCount);
+            const FileLevel* levels = (const FileLevel*)(file->GetData() + sizeof(FileHeader));
+            for (int32_t i = 0; i < header.LevelCount; ++i)
+            {
+                FileLevel level;
+                memcpy(&level, &levels[i], sizeof(level));
+                if (level.Width <= 0 || level.Height <= 0 || level.Offset % DataAlignment != 0 ||
+                    level.Offset > file->GetSize() || level.Size > file->GetSize() - level.Offset)
+                    return false;
+                entry.Levels[i] = { level.Width, level.Height, file->GetData() + level.Offset, (size_t)level.Size };
+            }
+            entry.File = std::move(file);
+            return true;
+        }
+
+        bool Store(const std::string& cachePath, const std::string& sourcePath, const Entry& entry)
+        {
+            if (!Config::TextureCacheEnabled)
+                return false;
+
+            FileHeader header{};
+            memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+            header.Version = FileVersion;
+            if (!GetSourceStamp(sourcePath, header.SourceSize, header.SourceTime))
+                return false;
+            header.SourceHash = HashFile(sourcePath);
+            header.Format = (uint32_t)entry.Format;
+            header.Storage = (uint32_t)entry.Storage;
+            header.Channels = entry.Channels;
+            header.LevelCount = (int32_t)entry.Levels.size();
+
+            std::vector<FileLevel> levels(entry.Levels.size());
+            uint64_t offset = sizeof(FileHeader) + levels.size() * sizeof(FileLevel);
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                offset = (offset + DataAlignment - 1) / DataAlignment * DataAlignment;
+                levels[i] = { entry.Levels[i].Width, entry.Levels[i].Height, offset, entry.Levels[i].Size };
+                offset += entry.Levels[i].Size;
+            }
+
+            // The thread in the name too, two loads of the same image may store at the same time
+            const std::string tempPath = cachePath + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                                         "-" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+            std::ofstream file(tempPath, std::ios::binary);
+            if (!file.is_open())
+                return false;
+            file.write((const char*)&header, sizeof(header));
+            file.write((const char*)levels.data(), levels.size() * sizeof(FileLevel));
+            uint64_t written = sizeof(FileHeader) + levels.size() * sizeof(FileLevel);
+            const char padding[DataAlignment] = {};
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                file.write(padding, levels[i].Offset - written);
+                file.write((const char*)entry.Levels[i].Data, entry.Levels[i].Size);
+                written = levels[i].Offset + levels[i].Size;
+            }
+
+            const bool good = file.good();
+            file.close();
+            std::error_code error;
+            if (good)
+                std::filesystem::rename(tempPath, cachePath, error);
+            if (!good || error)
+            {
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+            return true;
+        }
+    }
+
+}
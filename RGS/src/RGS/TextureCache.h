@@ -0,0 +1,52 @@
+#pragma once
+#include "RGS/Texture.h"
+#include "RGS/Platform.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RGS {
+
+    // .rgstex files keep the texels of a loaded texture in their final in-memory layout, every level in its
+    // TexelFormat and TextureStorage, next to the source image. Texture, TextureSphere and LodTextureSphere write
+    // one the first time they decode an image and map it on the next loads, pointing their levels straight into
+    // the mapping: no decode, no encode and no copy.
+    // An entry is used while the size and time of the source are the ones it was built from or, when they
+    // changed, while the content hash of the source still matches. Otherwise the texture decodes the image and
+    // writes the entry again.
+    namespace TextureCache {
+
+        struct Level
+        {
+            int Width, Height;
+            const uint8_t* Data;            // into File once loaded
+            size_t Size;                    // bytes
+        };
+
+        struct Entry
+        {
+            TexelFormat Format;
+            TextureStorage Storage;
+            int Channels;
+            std::vector<Level> Levels;
+            std::shared_ptr<MappedFile> File;
+        };
+
+        // Size and time of a file, false when it doesn't exist
+        bool GetSourceStamp(const std::string& path, uint64_t& size, int64_t& time);
+        // 64-bit FNV-1a over 8-byte words, the tail byte by byte
+        uint64_t Hash(const uint8_t* data, size_t size);
+
+        // path + "." + kind + the storage suffix + ".rgstex", the kind tells the texture classes apart
+        std::string GetCachePath(const std::string& path, const char* kind, TextureStorage storage);
+
+        // false when Config::TextureCacheEnabled is off or the file is missing, damaged or out of date.
+        // The callers check the level sizes against their format.
+        bool Load(const std::string& cachePath, const std::string& sourcePath, Entry& entry);
+        // Written next to the final file and renamed, concurrent loads never see a partial entry
+        bool Store(const std::string& cachePath, const std::string& sourcePath, const Entry& entry);
+    }
+
+}
@@ -1,6 +1,13 @@
 #pragma once
 #include <chrono>
 #include <string>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
 
 namespace RGS {
 
@@ -16,4 +23,15 @@ namespace RGS {
 	private:
 		std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTimepoint;
 	};
+
+	// Cheap timestamp for measuring very short spans (e.g. a single fragment shader call).
+	// CPU cycles on x86, nanoseconds elsewhere, so only compare values with each other.
+	inline uint64_t ReadCycleCounter()
+	{
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
 }
\ No newline at end of file
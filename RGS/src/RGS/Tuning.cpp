@@ -0,0 +1,87 @@
+#include "rgspch.h"
+#include "Tuning.h"
+
+#include <fstream>
+
+namespace RGS {
+
+    static const char* s_KernelNames[(int)TunedKernel::Count] = { "RasterizeGroupSize", "ResolveGroupSize", "BlitGroupSize", "PostProcessGroupSize" };
+
+    void Tuning::SetGroupSize(const TunedKernel kernel, const uint32_t groupSize)
+    {
+        ASSERT(groupSize > 0);
+        s_GroupSizes[(int)kernel] = groupSize;
+    }
+
+    uint32_t Tuning::GetDefaultGroupSize(const TunedKernel kernel)
+    {
+        switch (kernel)
+        {
+        case TunedKernel::Rasterize:    return Config::RasterizeJobGroupSize;
+        case TunedKernel::Resolve:      return Config::ResolveJobGroupSize;
+        case TunedKernel::Blit:         return Config::BlitJobGroupSize;
+        case TunedKernel::PostProcess:  return Config::PostProcessJobGroupSize;
+        default:                        return 1u;
+        }
+    }
+
+    const char* Tuning::GetName(const TunedKernel kernel)
+    {
+        return s_KernelNames[(int)kernel];
+    }
+
+    void Tuning::Reset()
+    {
+        for (int i = 0; i < (int)TunedKernel::Count; ++i)
+            s_GroupSizes[i] = GetDefaultGroupSize((TunedKernel)i);
+    }
+
+    bool Tuning::Load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            const size_t separator = line.find('=');
+            if (separator == std::string::npos)
+                continue;
+
+            std::string name = line.substr(0, separator);
+            name.erase(std::remove_if(name.begin(), name.end(), [](unsigned char c) { return std::isspace(c); }), name.end());
+            for (int i = 0; i < (int)TunedKernel::Count; ++i)
+            {
+                if (name != s_KernelNames[i])
+                    continue;
+
+                try
+                {
+                    const unsigned long value = std::stoul(line.substr(separator + 1));
+                    if (value > 0 && value <= UINT32_MAX)
+                        s_GroupSizes[i] = (uint32_t)value;
+                }
+                catch (const std::exception&)
+                {
+                    std::cout << "Tuning: 无效的值 " << line << std::endl;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool Tuning::Save(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file.is_open())
+            return false;
+
+        file << "# Job group sizes, written by rgs-bench --tune\n";
+        for (int i = 0; i < (int)TunedKernel::Count; ++i)
+            file << s_KernelNames[i] << " = " << s_GroupSizes[i] << '\n';
+        return file.good();
+    }
+
+}
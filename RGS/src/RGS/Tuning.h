@@ -0,0 +1,42 @@
+#pragma once
+#include "RGS/Config.h"
+
+#include <string>
+#include <cstdint>
+
+namespace RGS {
+
+    enum class TunedKernel : int
+    {
+        Rasterize = 0,      // Pixels per screen tile of a Pipeline stage, or of a triangle's bounding box per job group outside of one
+        Resolve,            // Pixels per group of Framebuffer::ResolveParallel
+        Blit,               // Pixels per group of Window::DrawFramebuffer
+        PostProcess,        // Pixels per group of Framebuffer::PostProcess
+        Count
+    };
+
+    // Job group sizes of the parallel kernels. They start at the Config defaults and can be overridden
+    // by a file written by `rgs-bench --tune`, the best values depend on the core count and caches.
+    class Tuning
+    {
+    public:
+        static uint32_t GetGroupSize(const TunedKernel kernel) { return s_GroupSizes[(int)kernel]; }
+        static void SetGroupSize(const TunedKernel kernel, const uint32_t groupSize);
+        static uint32_t GetDefaultGroupSize(const TunedKernel kernel);
+        static const char* GetName(const TunedKernel kernel);
+
+        static void Reset();
+
+        // "name = value" per line, '#' starts a comment. Unknown names are ignored, missing ones keep their value.
+        // Call at startup before rendering, the values aren't synchronized with the workers.
+        static bool Load(const std::string& path);
+        static bool Save(const std::string& path);
+
+    private:
+        static inline uint32_t s_GroupSizes[(int)TunedKernel::Count] = { Config::RasterizeJobGroupSize, 
+                                                                         Config::ResolveJobGroupSize,
+                                                                         Config::BlitJobGroupSize,
+                                                                         Config::PostProcessJobGroupSize };
+    };
+
+}
@@ -0,0 +1,393 @@
+#include "rgspch.h"
+#include "VirtualTexture.h"
+
+#include "RGS/Base/FastMath.h"
+#include "RGS/Base/TexelFormat.h"
+#include "RGS/TextureCache.h"
+
+#include <stb_image.h>
+#include <stb_image_resize2.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace RGS {
+
+    // Tile file: the header, one TileFileLevel per level, then the pages of every level in rows.
+    // The source size and time detect a changed image.
+    struct TileFileHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint64_t SourceSize;
+        int64_t SourceTime;
+        int32_t PageSize;
+        int32_t LevelCount;
+    };
+
+    struct TileFileLevel
+    {
+        int32_t Width, Height, PagesX, PagesY;
+        uint64_t Offset;
+    };
+
+    static constexpr char TileFileMagic[4] = { 'R', 'G', 'V', 'T' };
+    static constexpr uint32_t TileFileVersion = 1;
+
+    VirtualTextureSphere::~VirtualTextureSphere()
+    {
+        // The jobs write into the slots
+        Wait();
+    }
+
+    VirtualTextureSphere* VirtualTextureSphere::LoadVirtualTextureSphere(const std::string& path, const std::string& tilePath, int pageCacheSize)
+    {
+        VirtualTextureSphere* res = new VirtualTextureSphere();
+        if (!res->Init(path, tilePath, pageCacheSize))
+        {
+            std::cout << "加载失败" << std::endl;
+            delete res;
+            return nullptr;
+        }
+        return res;
+    }
+
+    bool VirtualTextureSphere::Init(const std::string& path, const std::string& tilePath, int pageCacheSize)
+    {
+        ASSERT(pageCacheSize > 0);
+        m_Path = path;
+        m_Loads.Priority = JobSystem::JobPriority::Background;
+
+        const std::string file = tilePath.empty() ? path + ".rgsvt" : tilePath;
+        if (!OpenTileFile(path, file) && !(BuildTileFile(path, file) && OpenTileFile(path, file)))
+            return false;
+
+        // The resident levels are copied out of the file once
+        size_t residentTexels = 0;
+        for (const Level& level : m_Levels)
+            residentTexels += level.Resident ? (size_t)level.PagesX * level.PagesY * PageTexelCount : 0;
+        m_ResidentTexels = std::make_unique<uint32_t[]>(residentTexels);
+
+        uint32_t* resident = m_ResidentTexels.get();
+        for (Level& level : m_Levels)
+        {
+            if (!level.Resident)
+                continue;
+            for (int i = 0; i < level.PagesX * level.PagesY; ++i)
+            {
+                std::memcpy(resident, m_File.GetData() + level.Pages[i].Offset, PageTexelCount * sizeof(uint32_t));
+                level.Pages[i].Texels.store(resident, std::memory_order_relaxed);
+                resident += PageTexelCount;
+            }
+        }
+
+        m_SlotCount = pageCacheSize;
+        m_SlotTexels = std::make_unique<uint32_t[]>((size_t)m_SlotCount * PageTexelCount);
+        m_Slots = std::make_unique<Slot[]>(m_SlotCount);
+        return true;
+    }
+
+    bool VirtualTextureSphere::OpenTileFile(const std::string& path, const std::string& tilePath)
+    {
+        m_Levels.clear();
+        if (!m_File.Open(tilePath))
+            return false;
+
+        const uint8_t* data = m_File.GetData();
+        const size_t size = m_File.GetSize();
+        TileFileHeader header;
+        if (size < sizeof(header))
+            return false;
+        std::memcpy(&header, data, sizeof(header));
+
+        uint64_t sourceSize = 0;
+        int64_t sourceTime = 0;
+        const bool stale = TextureCache::GetSourceStamp(path, sourceSize, sourceTime) && (sourceSize != header.SourceSize || sourceTime != header.SourceTime);
+        if (std::memcmp(header.Magic, TileFileMagic, sizeof(TileFileMagic)) != 0 || header.Version != TileFileVersion ||
+            header.PageSize != PageSize || header.LevelCount <= 0 || stale ||
+            size < sizeof(header) + header.LevelCount * sizeof(TileFileLevel))
+        {
+            m_File.Close();
+            return false;
+        }
+
+        for (int i = 0; i < header.LevelCount; ++i)
+        {
+            TileFileLevel fileLevel;
+            std::memcpy(&fileLevel, data + sizeof(header) + i * sizeof(TileFileLevel), sizeof(fileLevel));
+            const size_t pageCount = (size_t)fileLevel.PagesX * fileLevel.PagesY;
+            if (fileLevel.Width <= 0 || fileLevel.Height <= 0 || pageCount == 0 ||
+                fileLevel.Offset + pageCount * PageTexelCount * sizeof(uint32_t) > size)
+            {
+                m_Levels.clear();
+                m_File.Close();
+                return false;
+            }
+
+            Level level;
+            level.Width = fileLevel.Width;
+            level.Height = fileLevel.Height;
+            level.PagesX = fileLevel.PagesX;
+            level.PagesY = fileLevel.PagesY;
+            // The last level is always resident, it is the fallback of every lookup
+            level.Resident = level.Width <= Config::VirtualTextureResidentWidth || i == header.LevelCount - 1;
+            level.Pages = std::make_unique<Page[]>(pageCount);
+            for (size_t page = 0; page < pageCount; ++page)
+                level.Pages[page].Offset = fileLevel.Offset + page * PageTexelCount * sizeof(uint32_t);
+            m_Levels.push_back(std::move(level));
+        }
+        return true;
+    }
+
+    bool VirtualTextureSphere::BuildTileFile(const std::string& path, const std::string& tilePath)
+    {
+        TileFileHeader header;
+        std::memcpy(header.Magic, TileFileMagic, sizeof(TileFileMagic));
+        header.Version = TileFileVersion;
+        header.PageSize = PageSize;
+        if (!TextureCache::GetSourceStamp(path, header.SourceSize, header.SourceTime))
+            return false;
+
+        stbi_set_flip_vertically_on_load_thread(true);
+        int width, height, channels;
+        float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 3);
+        if (data == nullptr || width <= 0 || height <= 0)
+        {
+            stbi_image_free(data);
+            return false;
+        }
+
+        // Halved down to the first level that fits in one page row
+        std::vector<TileFileLevel> levels;
+        uint64_t offset = sizeof(header);
+        for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        {
+            TileFileLevel level = { w, h, (w + PageSize - 1) / PageSize, (h + PageSize - 1) / PageSize, 0 };
+            levels.push_back(level);
+            if (w <= PageSize)
+                break;
+        }
+        header.LevelCount = (int32_t)levels.size();
+        offset += levels.size() * sizeof(TileFileLevel);
+        for (TileFileLevel& level : levels)
+        {
+            level.Offset = offset;
+            offset += (uint64_t)level.PagesX * level.PagesY * PageTexelCount * sizeof(uint32_t);
+        }
+
+        // Written next to the final file and renamed, so concurrent builds and readers never see a partial file.
+        // The thread in the name too, two builds of the same image may start at the same time
+        const std::string tempPath = tilePath + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                                     "-" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file.is_open())
+        {
+            stbi_image_free(data);
+            return false;
+        }
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)levels.data(), levels.size() * sizeof(TileFileLevel));
+
+        std::vector<uint32_t> page(PageTexelCount);
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            const TileFileLevel& level = levels[i];
+            const Vec3* texels = (const Vec3*)data;
+            for (int pageY = 0; pageY < level.PagesY; ++pageY)
+            {
+                for (int pageX = 0; pageX < level.PagesX; ++pageX)
+                {
+                    // Wraps around like LodTextureSphere::GetColor, past the image and in the border
+                    for (int y = 0; y < PageStride; ++y)
+                    {
+                        const int srcY = (pageY * PageSize + y) % level.Height;
+                        for (int x = 0; x < PageStride; ++x)
+                        {
+                            const int srcX = (pageX * PageSize + x) % level.Width;
+                            page[y * PageStride + x] = TexelTraits<TexelFormat::RGB9E5>::Encode({ texels[srcY * level.Width + srcX], 0.0f });
+                        }
+                    }
+                    file.write((const char*)page.data(), PageTexelCount * sizeof(uint32_t));
+                }
+            }
+
+            if (i + 1 < levels.size())
+            {
+                float* next = stbir_resize_float_linear(data, level.Width, level.Height, 0,
+                                                        nullptr, levels[i + 1].Width, levels[i + 1].Height, 0, stbir_pixel_layout::STBIR_RGB);
+                stbi_image_free(data);
+                data = next;
+                if (data == nullptr)
+                    break;
+            }
+        }
+        stbi_image_free(data);
+
+        const bool written = data != nullptr && file.good();
+        file.close();
+        std::error_code error;
+        if (written)
+            std::filesystem::rename(tempPath, tilePath, error);
+        if (!written || error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    size_t VirtualTextureSphere::GetMemorySize() const
+    {
+        size_t size = (size_t)m_SlotCount * (PageTexelCount * sizeof(uint32_t) + sizeof(Slot));
+        for (const Level& level : m_Levels)
+        {
+            const size_t pageCount = (size_t)level.PagesX * level.PagesY;
+            size += pageCount * sizeof(Page) + (level.Resident ? pageCount * PageTexelCount * sizeof(uint32_t) : 0);
+        }
+        return size;
+    }
+
+    Vec3 VirtualTextureSphere::SampleLevel(const float u, const float v, int level) const
+    {
+        for (; level < (int)m_Levels.size(); ++level)
+        {
+            const Level& data = m_Levels[level];
+            float u0 = u * (data.Width - 1);
+            float v0 = v * (data.Height - 1);
+            int x = floor(u0);
+            int y = floor(v0);
+            float fracX = fmod(u0, 1.0f);
+            float fracY = fmod(v0, 1.0f);
+
+            // Stamped whether it is there or not: Update loads the missing ones and keeps the used ones
+            Page& page = data.Pages[(y / PageSize) * data.PagesX + x / PageSize];
+            if (page.LastUsed.load(std::memory_order_relaxed) != m_Frame)
+                page.LastUsed.store(m_Frame, std::memory_order_relaxed);
+            const uint32_t* texels = page.Texels.load(std::memory_order_acquire);
+            if (texels == nullptr)
+                continue;
+
+            const uint32_t* texel = texels + (y % PageSize) * PageStride + x % PageSize;
+            auto color = [](const uint32_t t) -> Vec3 { return TexelTraits<TexelFormat::RGB9E5>::Decode(t); };
+            Vec3 res{ 0.0f, 0.0f, 0.0f };
+            res += color(texel[0]) * (1.0f - fracX) * (1.0f - fracY);
+            res += color(texel[1]) * fracX * (1.0f - fracY);
+            res += color(texel[PageStride]) * (1.0f - fracX) * fracY;
+            res += color(texel[PageStride + 1]) * fracX * fracY;
+            return res;
+        }
+        // The last level is resident
+        ASSERT(false);
+        return { 0.0f, 0.0f, 0.0f };
+    }
+
+    Vec3 VirtualTextureSphere::Sample(const Vec3& v3, float lod) const
+    {
+        lod = Clamp(lod, 0.0f, (float)(m_Levels.size() - 1));
+        int number = (int)lod;
+        float frac = lod - (float)number;
+
+        Vec3 dir = Normalize(v3);
+        float phi = Atan2(dir.Z, dir.X);
+        float theta = Acos(dir.Y);
+        float u = phi / (2.0f * PI) + 0.5f;
+        float v = 1.0f - theta / PI;
+
+        Vec3 c0 = SampleLevel(u, v, number);
+        // Lerp would return c0 exactly, the next level isn't touched (nor streamed in)
+        if (frac == 0.0f)
+            return c0;
+        Vec3 c1 = SampleLevel(u, v, number + 1);
+        return Lerp(c0, c1, frac);
+    }
+
+    float VirtualTextureSphere::ComputeLod(const Vec3& dir, const Vec3& ddx, const Vec3& ddy) const
+    {
+        // The angle between neighbouring pixels in texels of level 0, 2 PI around the equator
+        const float texelsPerRadian = (float)m_Levels[0].Width / (2.0f * PI);
+        const float footprint = Max(Dot(ddx, ddx), Dot(ddy, ddy)) / Dot(dir, dir) * texelsPerRadian * texelsPerRadian;
+        return 0.5f * std::log2(footprint);
+    }
+
+    int VirtualTextureSphere::Update()
+    {
+        // Coarse levels first, a missing page of them also holds up the finer ones
+        std::vector<Page*> missing;
+        for (int level = (int)m_Levels.size() - 1; level >= 0; --level)
+        {
+            const Level& data = m_Levels[level];
+            if (data.Resident)
+                continue;
+            for (int i = 0; i < data.PagesX * data.PagesY; ++i)
+            {
+                Page& page = data.Pages[i];
+                if (page.LastUsed.load(std::memory_order_relaxed) == m_Frame && page.Texels.load(std::memory_order_relaxed) == nullptr)
+                    missing.push_back(&page);
+            }
+        }
+
+        int loads = 0;
+        for (Page* page : missing)
+        {
+            if (page->Slot != -1)
+                continue;       // loading
+            if (loads == Config::VirtualTextureMaxLoadsPerUpdate)
+                break;
+
+            // A free slot, otherwise the least recently used one the last frame didn't need
+            int slot = -1;
+            uint32_t oldest = 0;
+            for (int i = 0; i < m_SlotCount; ++i)
+            {
+                const Slot& candidate = m_Slots[i];
+                if (candidate.Owner == nullptr)
+                {
+                    slot = i;
+                    break;
+                }
+                const uint32_t age = m_Frame - candidate.Owner->LastUsed.load(std::memory_order_relaxed);
+                if (age > oldest && !candidate.Loading.load(std::memory_order_acquire))
+                {
+                    slot = i;
+                    oldest = age;
+                }
+            }
+            // Every page in the cache is in use, the rest keeps using the coarser levels
+            if (slot == -1)
+                break;
+
+            Slot& target = m_Slots[slot];
+            if (target.Owner != nullptr)
+            {
+                target.Owner->Texels.store(nullptr, std::memory_order_relaxed);
+                target.Owner->Slot = -1;
+            }
+            target.Owner = page;
+            target.Loading.store(true, std::memory_order_relaxed);
+            page->Slot = slot;
+            loads++;
+
+            uint32_t* texels = m_SlotTexels.get() + (size_t)slot * PageTexelCount;
+            const uint8_t* source = m_File.GetData() + page->Offset;
+            JobSystem::Execute(m_Loads, [page, texels, source, &target]()
+            {
+                std::memcpy(texels, source, PageTexelCount * sizeof(uint32_t));
+                page->Texels.store(texels, std::memory_order_release);
+                target.Loading.store(false, std::memory_order_release);
+            });
+        }
+
+        m_Frame++;
+        return (int)missing.size();
+    }
+
+    void VirtualTextureSphere::Wait()
+    {
+        JobSystem::Wait(m_Loads);
+    }
+
+}
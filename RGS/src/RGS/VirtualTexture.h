@@ -0,0 +1,105 @@
+#pragma once
+#include "RGS/Base/Maths.h"
+#include "RGS/Config.h"
+#include "RGS/JobSystem.h"
+#include "RGS/Platform.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RGS {
+
+    // Equirectangular HDR environment of any resolution in a fixed amount of RAM. The mip chain, from the source
+    // size down to one page, is kept in a tile file of RGB9E5 pages that is built on first use and memory-mapped
+    // afterwards. The levels up to Config::VirtualTextureResidentWidth are loaded whole, the pages of the larger
+    // ones go through a cache of pageCacheSize slots.
+    // A lookup whose page is missing records the request and filters the finest level below that is there instead.
+    // Update, between two frames, then evicts the least recently used slots and loads the requested pages on
+    // background jobs.
+    class VirtualTextureSphere
+    {
+    public:
+        ~VirtualTextureSphere();
+
+        VirtualTextureSphere(const VirtualTextureSphere&) = delete;
+        VirtualTextureSphere& operator=(const VirtualTextureSphere&) = delete;
+
+        // Bilinear around the texel TextureSphere::Sample picks and linear between two levels like LodTextureSphere.
+        // lod 0 is the source resolution, clamped to the levels.
+        Vec3 Sample(const Vec3& v3, float lod) const;
+        // LOD of a lookup in direction dir from the screen-space derivatives of the direction
+        float ComputeLod(const Vec3& dir, const Vec3& ddx, const Vec3& ddy) const;
+
+        // Between two frames, never while a draw samples the texture. Starts loading the pages the last frame
+        // asked for and returns how many were missing, the ones still loading included.
+        int Update();
+        // Waits for the loads started by Update
+        void Wait();
+
+        int GetWidth() const { return m_Levels[0].Width; }
+        int GetHeight() const { return m_Levels[0].Height; }
+        int GetLevelCount() const { return (int)m_Levels.size(); }
+        // Bytes of the resident levels, the page slots and the page tables, only the tables grow with the source
+        size_t GetMemorySize() const;
+        std::string GetPath() const { return m_Path; }
+
+        // Writes the tile file of the image at path, false when the image can't be loaded or the file written.
+        // The only step that holds the whole image in memory.
+        static bool BuildTileFile(const std::string& path, const std::string& tilePath);
+
+        // tilePath is path + ".rgsvt" when empty, it is rebuilt when the image is newer. nullptr when neither
+        // the tile file nor the image can be read, there is no usable empty state.
+        static VirtualTextureSphere* LoadVirtualTextureSphere(const std::string& path, const std::string& tilePath = std::string(),
+                                                              int pageCacheSize = Config::VirtualTexturePageCacheSize);
+
+    protected:
+        VirtualTextureSphere() = default;
+
+        bool Init(const std::string& path, const std::string& tilePath, int pageCacheSize);
+        bool OpenTileFile(const std::string& path, const std::string& tilePath);
+
+        // Bilinear lookup in the first level from level on whose page is loaded
+        Vec3 SampleLevel(float u, float v, int level) const;
+
+        // Pages are PageSize + 1 texels wide and high, the last column and row repeat the first ones of the
+        // neighbours, so the bilinear footprint never leaves its page
+        static constexpr int PageSize = Config::VirtualTexturePageSize;
+        static constexpr int PageStride = PageSize + 1;
+        static constexpr size_t PageTexelCount = (size_t)PageStride * PageStride;
+
+        struct Page
+        {
+            std::atomic<const uint32_t*> Texels{ nullptr };     // RGB9E5, null until loaded
+            std::atomic<uint32_t> LastUsed{ 0 };                // last frame a lookup wanted the page
+            int Slot = -1;                                      // -1 when missing or resident, only Update writes it
+            uint64_t Offset = 0;                                // in the tile file
+        };
+
+        struct Level
+        {
+            int Width, Height, PagesX, PagesY;
+            bool Resident;
+            std::unique_ptr<Page[]> Pages;
+        };
+
+        struct Slot
+        {
+            Page* Owner = nullptr;
+            std::atomic<bool> Loading{ false };
+        };
+
+        std::string m_Path;
+        MappedFile m_File;
+        std::vector<Level> m_Levels;
+        std::unique_ptr<uint32_t[]> m_ResidentTexels;
+        std::unique_ptr<uint32_t[]> m_SlotTexels;
+        std::unique_ptr<Slot[]> m_Slots;
+        int m_SlotCount = 0;
+        uint32_t m_Frame = 1;                                   // stamped into Page::LastUsed, advanced by Update
+        JobSystem::Context m_Loads;
+    };
+
+}
@@ -1,7 +1,12 @@
 #include "rgspch.h"
 
 #include "Window.h"
-#include "Windows/WindowsWindow.h"
+#include "Headless/HeadlessWindow.h"
+#ifdef _WIN32
+    #include "Windows/WindowsWindow.h"
+#endif
+
+#include <cstring>
 
 namespace RGS {
 
@@ -14,18 +19,26 @@ namespace RGS {
 
     void Window::Init() 
     {
+#ifdef _WIN32
         WindowsWindow::Init();
+#endif
     }
     
     void Window::Terminate() 
     {
+#ifdef _WIN32
         WindowsWindow::Terminate();
+#endif
     }
 
     Window* Window::Create(const char* title, const int width, const int height)
     {
         ASSERT((width > 0) && (height > 0));
+#ifdef _WIN32
         return new WindowsWindow(title, width, height);
+#else
+        return new HeadlessWindow(title, width, height);
+#endif
     }
 
     void Window::Reset()
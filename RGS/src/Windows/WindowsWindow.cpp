@@ -5,6 +5,7 @@
 #include "RGS/Base/Base.h"
 #include "RGS/Render/Framebuffer.h"
 #include "RGS/JobSystem.h"
+#include "RGS/Tuning.h"
 
 #include <windows.h>
 #include <algorithm>
@@ -149,7 +150,7 @@ namespace RGS {
         const uint32_t height = (std::min)((uint32_t)m_Height, fHeight);
 
         uint32_t jobCount = width * height;
-        constexpr uint32_t groupSize = 2048u;
+        const uint32_t groupSize = Tuning::GetGroupSize(TunedKernel::Blit);
         JobSystem::Dispatch(jobCount, groupSize, [=, &framebuffer](JobSystem::JobDispatchArgs args)
         {
             int x = args.JobIndex % width;
@@ -0,0 +1,3 @@
+#include <string.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "rgspch.h"
+#include "RGS/Base/FastMath.h"
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+
+namespace RGS::Test {
+
+    // One approximation swept over its domain against the double precision libm function
+    struct ErrorCase
+    {
+        const char* Name;
+        std::function<float(float, float)> Fast;
+        std::function<double(double, double)> Reference;
+        float MinX, MaxX;
+        float MinY, MaxY;                   // second argument, MinY == MaxY for unary functions
+        bool Relative;                      // bound on the relative instead of the absolute error
+        bool LogScale;                      // sweep x geometrically, MinX > 0
+        double Bound;                       // the documented error in FastMath.h
+    };
+
+    struct ErrorResult
+    {
+        uint64_t Samples = 0;
+        double MaxAbsError = 0.0;
+        double MaxRelError = 0.0;
+        float WorstX = 0.0f, WorstY = 0.0f;
+    };
+
+    static ErrorResult Sweep(const ErrorCase& test, const uint32_t stepsX, const uint32_t stepsY)
+    {
+        ErrorResult result;
+        double worst = -1.0;
+        for (uint32_t j = 0; j < stepsY; ++j)
+        {
+            const float y = stepsY > 1 ? test.MinY + (test.MaxY - test.MinY) * (float)j / (float)(stepsY - 1) : test.MinY;
+            for (uint32_t i = 0; i < stepsX; ++i)
+            {
+                const double t = (double)i / (double)(stepsX - 1);
+                const float x = test.LogScale ? (float)(test.MinX * std::pow((double)test.MaxX / test.MinX, t))
+                                              : (float)(test.MinX + (test.MaxX - test.MinX) * t);
+
+                const double expected = test.Reference(x, y);
+                const double actual = test.Fast(x, y);
+                const double absError = std::abs(actual - expected);
+                const double relError = expected != 0.0 ? absError / std::abs(expected) : absError;
+
+                result.Samples++;
+                result.MaxAbsError = std::max(result.MaxAbsError, absError);
+                result.MaxRelError = std::max(result.MaxRelError, relError);
+                const double error = test.Relative ? relError : absError;
+                if (error > worst)
+                {
+                    worst = error;
+                    result.WorstX = x;
+                    result.WorstY = y;
+                }
+            }
+        }
+        return result;
+    }
+
+#if RGS_SIMD_SSE
+    // The SIMD variants, one lane at a time
+    static float Lane(const __m128 v)
+    {
+        return _mm_cvtss_f32(v);
+    }
+#endif
+
+    static std::vector<ErrorCase> CreateCases()
+    {
+        std::vector<ErrorCase> cases;
+        auto add = [&](const char* name, auto fast, auto reference, float minX, float maxX, float minY, float maxY, bool relative, bool logScale, double bound)
+        {
+            cases.push_back({ name, fast, reference, minX, maxX, minY, maxY, relative, logScale, bound });
+        };
+
+        auto atan2Ref = [](double x, double y) { return std::atan2(y, x); };
+        auto acosRef = [](double x, double) { return std::acos(x); };
+        auto sinRef = [](double x, double) { return std::sin(x); };
+        auto cosRef = [](double x, double) { return std::cos(x); };
+        auto log2Ref = [](double x, double) { return std::log2(x); };
+        auto exp2Ref = [](double x, double) { return std::exp2(x); };
+        auto powRef = [](double x, double y) { return std::pow(x, y); };
+        auto pow5Ref = [](double x, double) { return std::pow(x, 5.0); };
+
+        add("Atan2", [](float x, float y) { return FastMath::Atan2(y, x); }, atan2Ref, -1.0f, 1.0f, -1.0f, 1.0f, false, false, 2.5e-6);
+        add("Acos", [](float x, float) { return FastMath::Acos(x); }, acosRef, -1.0f, 1.0f, 0.0f, 0.0f, false, false, 5.0e-7);
+        add("Sin", [](float x, float) { return FastMath::Sin(x); }, sinRef, -1000.0f, 1000.0f, 0.0f, 0.0f, false, false, 3.0e-7);
+        add("Cos", [](float x, float) { return FastMath::Cos(x); }, cosRef, -1000.0f, 1000.0f, 0.0f, 0.0f, false, false, 3.0e-7);
+        add("Log2", [](float x, float) { return FastMath::Log2(x); }, log2Ref, 1e-37f, 1e37f, 0.0f, 0.0f, true, true, 3.0e-7);
+        add("Exp2", [](float x, float) { return FastMath::Exp2(x); }, exp2Ref, -126.0f, 127.4f, 0.0f, 0.0f, true, false, 3.0e-7);
+        add("Pow (gamma)", [](float x, float y) { return FastMath::Pow(x, y); }, powRef, 1e-6f, 1.0f, 1.0f / 2.2f, 2.2f, true, true, 4.0e-6);
+        add("Pow", [](float x, float y) { return FastMath::Pow(x, y); }, powRef, 1e-3f, 1e3f, -2.0f, 2.0f, true, true, 4.0e-6);
+        add("Pow5", [](float x, float) { return FastMath::Pow5(x); }, pow5Ref, 0.0f, 1.0f, 0.0f, 0.0f, false, false, 1.0e-6);
+
+#if RGS_SIMD_SSE
+        add("Atan2 x4", [](float x, float y) { return Lane(FastMath::Atan2(_mm_set1_ps(y), _mm_set1_ps(x))); }, atan2Ref, -1.0f, 1.0f, -1.0f, 1.0f, false, false, 2.5e-6);
+        add("Acos x4", [](float x, float) { return Lane(FastMath::Acos(_mm_set1_ps(x))); }, acosRef, -1.0f, 1.0f, 0.0f, 0.0f, false, false, 5.0e-7);
+        add("Sin x4", [](float x, float) { return Lane(FastMath::Sin(_mm_set1_ps(x))); }, sinRef, -1000.0f, 1000.0f, 0.0f, 0.0f, false, false, 3.0e-7);
+        add("Cos x4", [](float x, float) { return Lane(FastMath::Cos(_mm_set1_ps(x))); }, cosRef, -1000.0f, 1000.0f, 0.0f, 0.0f, false, false, 3.0e-7);
+        add("Log2 x4", [](float x, float) { return Lane(FastMath::Log2(_mm_set1_ps(x))); }, log2Ref, 1e-37f, 1e37f, 0.0f, 0.0f, true, true, 3.0e-7);
+        add("Exp2 x4", [](float x, float) { return Lane(FastMath::Exp2(_mm_set1_ps(x))); }, exp2Ref, -126.0f, 127.4f, 0.0f, 0.0f, true, false, 3.0e-7);
+        add("Pow x4", [](float x, float y) { return Lane(FastMath::Pow(_mm_set1_ps(x), _mm_set1_ps(y))); }, powRef, 1e-3f, 1e3f, -2.0f, 2.0f, true, true, 4.0e-6);
+#endif
+        return cases;
+    }
+
+}
+
+// Error report of the FastMath approximations against libm. Exit code 0 when every function
+// stays within the bound documented in FastMath.h.
+int main()
+{
+    using namespace RGS;
+    using namespace RGS::Test;
+
+    int failures = 0;
+    std::cout << std::left << std::setw(14) << "function" << std::right << std::setw(10) << "samples"
+              << std::setw(14) << "max abs" << std::setw(14) << "max rel" << std::setw(12) << "bound"
+              << "   worst at" << std::endl;
+    for (const ErrorCase& test : CreateCases())
+    {
+        const bool binary = test.MinY != test.MaxY;
+        const ErrorResult result = Sweep(test, binary ? 4001u : 1000001u, binary ? 251u : 1u);
+        const double error = test.Relative ? result.MaxRelError : result.MaxAbsError;
+        const bool passed = error <= test.Bound;
+        failures += passed ? 0 : 1;
+
+        std::cout << std::left << std::setw(14) << test.Name << std::right << std::setw(10) << result.Samples
+                  << std::scientific << std::setprecision(2)
+                  << std::setw(14) << result.MaxAbsError << std::setw(14) << result.MaxRelError
+                  << std::setw(9) << test.Bound << (test.Relative ? " rel" : " abs")
+                  << "   (" << result.WorstX << ", " << result.WorstY << ")"
+                  << (passed ? "" : "  FAIL") << std::defaultfloat << std::endl;
+    }
+
+    std::cout << (failures == 0 ? "All approximations within their bounds" : std::to_string(failures) + " approximation(s) out of bounds") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+#include "rgspch.h"
+#include "BenchScenes.h"
+
+#include "RGS/JobSystem.h"
+#include "Headless/HeadlessWindow.h"
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include <cmath>
+#include <iomanip>
+#include <thread>
+
+#ifndef RGS_ASSETS_DIR
+    #define RGS_ASSETS_DIR "Assets"
+#endif
+
+#ifndef RGS_GOLDEN_DIR
+    #define RGS_GOLDEN_DIR "golden"
+#endif
+
+namespace RGS::Test {
+
+    struct Options
+    {
+        std::vector<std::string> Scenes;    // empty checks all of them
+        std::vector<int> MSAALevels = { 1, 4 };
+        uint32_t Width = 160u;
+        uint32_t Height = 120u;
+        uint32_t Threads = 0u;              // the multi-threaded run, 0 is max(4, hardware threads)
+        bool Update = false;                // rewrite the golden images instead of comparing
+        bool FastMath = false;              // shade with the FastMath approximations, compared with the same (libm) images
+        TextureStorage Textures = TextureStorage::Linear;   // tiled or block compressed, compared with the same (linear) images
+        std::string AssetsDir = RGS_ASSETS_DIR;
+        std::string GoldenDir = RGS_GOLDEN_DIR;
+        std::string DiffDir;                // failing comparisons write actual and diff images here
+
+        // Per channel difference (0-255) a pixel may have before it counts as wrong,
+        // the fraction of wrong pixels allowed and the minimum PSNR of the whole image.
+        int Tolerance = 2;
+        double MaxBadPixels = 0.001;
+        double MinPSNR = 45.0;
+    };
+
+    struct Image
+    {
+        uint32_t Width = 0, Height = 0;
+        std::vector<unsigned char> Pixels;  // RGB8, top row first
+    };
+
+    struct Comparison
+    {
+        int MaxDiff = 0;
+        double BadPixels = 0.0;             // fraction over the tolerance
+        double PSNR = 0.0;                  // dB, infinity for identical images
+        double MaxBlurredDiff = 0.0;        // largest 3x3 box-filtered error, structured differences stand out, lone pixels don't
+    };
+
+    static Comparison Compare(const Image& expected, const Image& actual, const int tolerance, Image* diffImage)
+    {
+        Comparison result;
+        const uint32_t width = expected.Width, height = expected.Height;
+        std::vector<float> errors(width * height, 0.0f);
+        double squaredError = 0.0;
+        uint32_t badPixels = 0;
+
+        for (uint32_t i = 0; i < width * height; ++i)
+        {
+            int pixelMax = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                int diff = std::abs((int)expected.Pixels[i * 3 + c] - (int)actual.Pixels[i * 3 + c]);
+                pixelMax = std::max(pixelMax, diff);
+                squaredError += (double)diff * diff;
+            }
+            result.MaxDiff = std::max(result.MaxDiff, pixelMax);
+            badPixels += pixelMax > tolerance ? 1 : 0;
+            errors[i] = (float)pixelMax;
+        }
+
+        for (uint32_t y = 1; y + 1 < height; ++y)
+        {
+            for (uint32_t x = 1; x + 1 < width; ++x)
+            {
+                float sum = 0.0f;
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx)
+                        sum += errors[(y + dy) * width + x + dx];
+                result.MaxBlurredDiff = std::max(result.MaxBlurredDiff, (double)sum / 9.0);
+            }
+        }
+
+        const double mse = squaredError / (double)(width * height * 3);
+        result.PSNR = mse == 0.0 ? std::numeric_limits<double>::infinity() : 10.0 * std::log10(255.0 * 255.0 / mse);
+        result.BadPixels = (double)badPixels / (double)(width * height);
+
+        if (diffImage)
+        {
+            // Errors amplified 8x in red
+            diffImage->Width = width;
+            diffImage->Height = height;
+            diffImage->Pixels.assign(width * height * 3, 0);
+            for (uint32_t i = 0; i < width * height; ++i)
+                diffImage->Pixels[i * 3] = (unsigned char)std::min(255.0f, errors[i] * 8.0f);
+        }
+        return result;
+    }
+
+    static bool LoadImage(const std::string& path, Image& image)
+    {
+        // Texture loading flips on the threads it runs on, images here are stored top row first
+        stbi_set_flip_vertically_on_load_thread(false);
+        int width, height, channels;
+        stbi_uc* data = stbi_load(path.c_str(), &width, &height, &channels, 3);
+        if (!data)
+            return false;
+        image.Width = width;
+        image.Height = height;
+        image.Pixels.assign(data, data + width * height * 3);
+        stbi_image_free(data);
+        return true;
+    }
+
+    static bool SaveImage(const std::string& path, const Image& image)
+    {
+        return stbi_write_png(path.c_str(), image.Width, image.Height, 3, image.Pixels.data(), image.Width * 3) != 0;
+    }
+
+    static Image Render(Bench::Scene& scene, const Options& options, const int msaaLevel)
+    {
+        HeadlessWindow window("rgs-golden", options.Width, options.Height);
+        std::unique_ptr<Framebuffer> screen = Framebuffer::Create(options.Width, options.Height);
+        std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(options.Width, options.Height, (MSAA)msaaLevel);
+
+        Camera camera;
+        camera.Aspect = (float)options.Width / (float)options.Height;
+        camera.Pos = { 0.0f, 0.0f, 2.0f, 1.0f };
+
+        // Streamed scenes are drawn again until every page they sample is loaded, a few frames at most
+        constexpr int maxStreamingFrames = 8;
+        Pipeline pipeline;
+        Bench::RenderFrame(scene, pipeline, *framebuffer, *screen, camera);
+        for (int i = 0; i < maxStreamingFrames && scene.UpdateStreaming(true); ++i)
+            Bench::RenderFrame(scene, pipeline, *framebuffer, *screen, camera);
+        window.DrawFramebuffer(*screen);
+
+        Image image;
+        image.Width = options.Width;
+        image.Height = options.Height;
+        image.Pixels.assign(window.GetBuffer(), window.GetBuffer() + options.Width * options.Height * 3);
+        return image;
+    }
+
+    static bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        std::vector<std::string> scenes;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg == "--update")
+            {
+                options.Update = true;
+                continue;
+            }
+            if (arg == "--fast-math")
+            {
+                options.FastMath = true;
+                continue;
+            }
+            if (arg == "--tiled-textures" || arg == "--compressed-textures")
+            {
+                options.Textures = arg == "--tiled-textures" ? TextureStorage::Tiled : TextureStorage::Compressed;
+                continue;
+            }
+            if (arg == "--help" || arg == "-h" || i + 1 >= argc)
+                return false;
+
+            const std::string value = argv[++i];
+            try
+            {
+                if (arg == "--scene")               options.Scenes.push_back(value);
+                else if (arg == "--msaa")           options.MSAALevels = { std::stoi(value) };
+                else if (arg == "--threads")        options.Threads = (uint32_t)std::stoul(value);
+                else if (arg == "--assets")         options.AssetsDir = value;
+                else if (arg == "--golden-dir")     options.GoldenDir = value;
+                else if (arg == "--diff-dir")       options.DiffDir = value;
+                else if (arg == "--tolerance")      options.Tolerance = std::stoi(value);
+                else if (arg == "--max-bad-pixels") options.MaxBadPixels = std::stod(value);
+                else if (arg == "--min-psnr")       options.MinPSNR = std::stod(value);
+                else
+                    return false;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+        // The golden images are always rendered with libm and linear textures
+        return !(options.Update && (options.FastMath || options.Textures != TextureStorage::Linear));
+    }
+
+}
+
+// Renders the reference scenes and compares them with the golden images, and the
+// single-threaded result with the multi-threaded one. Exit code 0 when everything matches.
+int main(int argc, char** argv)
+{
+    using namespace RGS;
+    using namespace RGS::Test;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::cerr << "rgs-golden [--scene NAME]... [--msaa N] [--threads N] [--update] [--fast-math]\n"
+                  << "           [--tiled-textures | --compressed-textures] [--golden-dir DIR] [--diff-dir DIR]\n"
+                  << "           [--tolerance 0-255] [--max-bad-pixels FRACTION] [--min-psnr DB] [--assets DIR]" << std::endl;
+        return 2;
+    }
+
+    Bench::SceneAssets assets;
+    if (!assets.Load(options.AssetsDir, options.AssetsDir + "/sphere.obj", 0, options.Textures))
+        return 2;
+
+    const uint32_t threads = options.Threads != 0 ? options.Threads : std::max(4u, std::thread::hardware_concurrency());
+    int failures = 0;
+
+    std::vector<std::unique_ptr<Bench::Scene>> scenes = Bench::CreateScenes(assets);
+    for (auto& scene : scenes)
+    {
+        if (!options.Scenes.empty() && std::find(options.Scenes.begin(), options.Scenes.end(), scene->GetName()) == options.Scenes.end())
+            continue;
+
+        scene->SetFastMath(options.FastMath);
+        for (int msaa : options.MSAALevels)
+        {
+            const std::string name = scene->GetName() + "_msaa" + std::to_string(msaa);
+            const std::string goldenPath = options.GoldenDir + "/" + name + ".png";
+
+            JobSystem::Init(1);
+            Image single = Render(*scene, options, msaa);
+            JobSystem::Shutdown();
+
+            JobSystem::Init(threads);
+            Image multi = Render(*scene, options, msaa);
+            JobSystem::Shutdown();
+
+            if (options.Update)
+            {
+                if (!SaveImage(goldenPath, single))
+                {
+                    std::cout << "写入失败: " << goldenPath << std::endl;
+                    failures++;
+                }
+                else
+                {
+                    std::cout << "updated " << goldenPath << std::endl;
+                }
+            }
+
+            Image golden;
+            if (!LoadImage(goldenPath, golden) || golden.Width != options.Width || golden.Height != options.Height)
+            {
+                std::cout << "FAIL " << name << ": missing or mismatched golden image " << goldenPath << std::endl;
+                failures++;
+                continue;
+            }
+
+            // The image must not depend on how the work was split between the workers
+            const std::pair<const char*, const Image*> runs[] = { { "1 thread", &single }, { "N threads", &multi } };
+            for (const auto& [label, image] : runs)
+            {
+                Image diff;
+                Comparison result = Compare(golden, *image, options.Tolerance, options.DiffDir.empty() ? nullptr : &diff);
+                const bool passed = result.BadPixels <= options.MaxBadPixels && result.PSNR >= options.MinPSNR;
+
+                std::cout << (passed ? "PASS " : "FAIL ") << name << " (" << label << (image == &multi ? ", " + std::to_string(threads) : std::string()) << ")"
+                          << std::fixed << std::setprecision(2) << ": PSNR " << result.PSNR << " dB, max diff " << result.MaxDiff
+                          << ", bad pixels " << result.BadPixels * 100.0 << "%, max 3x3 error " << result.MaxBlurredDiff << std::endl;
+
+                if (!passed)
+                {
+                    failures++;
+                    if (!options.DiffDir.empty())
+                    {
+                        const std::string suffix = image == &multi ? "_mt" : "";
+                        SaveImage(options.DiffDir + "/" + name + suffix + "_actual.png", *image);
+                        SaveImage(options.DiffDir + "/" + name + suffix + "_diff.png", diff);
+                    }
+                }
+            }
+
+            Comparison threadResult = Compare(single, multi, 0, nullptr);
+            if (threadResult.MaxDiff != 0)
+            {
+                std::cout << "FAIL " << name << ": 1 and " << threads << " threads differ, max diff " << threadResult.MaxDiff
+                          << ", " << threadResult.BadPixels * 100.0 << "% of the pixels" << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    std::cout << (failures == 0 ? "All golden images match" : std::to_string(failures) + " failure(s)") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+#include "rgspch.h"
+#include "RGS/JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+
+namespace RGS::Test {
+
+    struct RaceResult
+    {
+        uint64_t Registered = 0;
+        uint64_t Ran = 0;
+        uint64_t Lost = 0;                  // continuations still not run after the deadline
+        int FailedRound = -1;
+    };
+
+    // Jobs of one context are executed from a second thread while this one registers continuations, so the
+    // last job of the context keeps finishing right as OnComplete takes and drops its reference.
+    // Every continuation has to run exactly once.
+    static RaceResult RaceOnComplete(const int rounds, const int jobsPerRound, const int continuationsPerRound)
+    {
+        RaceResult result;
+        for (int round = 0; round < rounds; ++round)
+        {
+            JobSystem::Context context;
+            std::atomic<uint64_t> ran{ 0 };
+            std::atomic<bool> start{ false };
+
+            std::thread producer([&]()
+            {
+                while (!start.load()) { std::this_thread::yield(); }
+                for (int i = 0; i < jobsPerRound; ++i)
+                {
+                    JobSystem::Execute(context, []() {});
+                }
+            });
+
+            start.store(true);
+            for (int i = 0; i < continuationsPerRound; ++i)
+            {
+                JobSystem::OnComplete(context, [&ran]() { ran.fetch_add(1); });
+            }
+            producer.join();
+            JobSystem::Wait(context);
+
+            // The continuations are pushed once the counter has dropped, Wait may return just before that
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (ran.load() < (uint64_t)continuationsPerRound && std::chrono::steady_clock::now() < deadline)
+            {
+                JobSystem::Wait(JobSystem::JobPriority::Frame);
+                std::this_thread::yield();
+            }
+
+            result.Registered += continuationsPerRound;
+            result.Ran += ran.load();
+            if (ran.load() != (uint64_t)continuationsPerRound)
+            {
+                result.Lost = continuationsPerRound - ran.load();
+                result.FailedRound = round;
+                break;
+            }
+        }
+        return result;
+    }
+
+    // Every worker enters a Frame job that waits on a Background context of its own, so none is left to pick up
+    // the background jobs but the waiters. The main thread only watches. Returns false when the frame jobs
+    // haven't finished before the deadline.
+    static bool NestedWaitAcrossPriorities(const uint32_t workers, const int backgroundJobs)
+    {
+        std::atomic<uint32_t> entered{ 0 };
+        std::atomic<uint64_t> ran{ 0 };
+        for (uint32_t i = 0; i < workers; ++i)
+        {
+            JobSystem::Execute([&, workers, backgroundJobs]()
+            {
+                // Hold the workers until all of them are inside a frame job, unless one is missing
+                entered.fetch_add(1);
+                const auto barrier = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+                while (entered.load() < workers && std::chrono::steady_clock::now() < barrier) { std::this_thread::yield(); }
+
+                JobSystem::Context context;
+                context.Priority = JobSystem::JobPriority::Background;
+                for (int j = 0; j < backgroundJobs; ++j)
+                {
+                    JobSystem::Execute(context, [&ran]() { ran.fetch_add(1); });
+                }
+                JobSystem::Wait(context);
+            }, JobSystem::JobPriority::Frame);
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (JobSystem::IsBusy(JobSystem::JobPriority::Frame))
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+            std::this_thread::yield();
+        }
+        return ran.load() == (uint64_t)workers * backgroundJobs;
+    }
+
+}
+
+// Stress test of the JobSystem contexts. Exit code 0 when no continuation registered with OnComplete is lost
+// or run twice while jobs of its context are finishing, and frame jobs waiting on background contexts finish.
+int main()
+{
+    using namespace RGS;
+    using namespace RGS::Test;
+
+    JobSystem::Init(4);
+
+    struct Case
+    {
+        const char* Name;
+        int Rounds, Jobs, Continuations;
+    };
+    const Case cases[] =
+    {
+        { "1 job", 100000, 1, 1 },
+        { "4 jobs", 20000, 4, 4 },
+        { "64 jobs", 1000, 64, 64 },
+    };
+
+    int failures = 0;
+    for (const Case& test : cases)
+    {
+        const RaceResult result = RaceOnComplete(test.Rounds, test.Jobs, test.Continuations);
+        const bool passed = result.FailedRound < 0;
+        failures += passed ? 0 : 1;
+        std::cout << std::left << std::setw(10) << test.Name << std::right
+                  << std::setw(12) << result.Registered << " registered" << std::setw(12) << result.Ran << " ran";
+        if (!passed)
+            std::cout << "  FAIL: " << result.Lost << " lost in round " << result.FailedRound;
+        std::cout << std::endl;
+    }
+
+    // A deadlock can't be recovered from, the workers would keep Shutdown waiting
+    const bool nested = NestedWaitAcrossPriorities(JobSystem::GetThreadCount(), 64);
+    std::cout << "nested wait " << (nested ? "done" : "FAIL: frame jobs stuck waiting on background contexts") << std::endl;
+    if (!nested)
+        std::_Exit(1);
+
+    JobSystem::Shutdown();
+
+    std::cout << (failures == 0 ? "No continuation lost" : std::to_string(failures) + " case(s) lost continuations") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+#include "rgspch.h"
+#include "RGS/Texture.h"
+#include "RGS/Base/FastMath.h"
+#include "RGS/Render/Framebuffer.h"
+
+#include <stb_image_write.h>
+
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <random>
+
+namespace RGS::Test {
+
+    // Batched lookups against the scalar ones, bit for bit
+    struct CompareResult
+    {
+        uint64_t Samples = 0;
+        uint64_t Mismatches = 0;
+        std::string FirstMismatch;
+    };
+
+    static bool SameBits(const Vec4& a, const Vec4& b) { return memcmp(&a, &b, sizeof(Vec4)) == 0; }
+    static bool SameBits(const Vec3& a, const Vec3& b) { return memcmp(&a, &b, sizeof(Vec3)) == 0; }
+
+    static std::string Describe(const Vec4& v)
+    {
+        std::ostringstream stream;
+        stream << std::setprecision(9) << "(" << v.X << ", " << v.Y << ", " << v.Z << ", " << v.W << ")";
+        return stream.str();
+    }
+
+    static std::string Describe(const Vec3& v)
+    {
+        std::ostringstream stream;
+        stream << std::setprecision(9) << "(" << v.X << ", " << v.Y << ", " << v.Z << ")";
+        return stream.str();
+    }
+
+    // Random coordinates far outside [0, 1] for the wrap modes, plus the ones on the edges of the texels
+    static std::vector<float> CreateCoords(std::mt19937& random, const int count, const int size)
+    {
+        std::vector<float> coords;
+        const float edges[] = { 0.0f, -0.0f, 1.0f, 0.5f, -1.0f, 2.0f, 1e-7f, -1e-7f, 1.0f - 1e-7f, 1.0f + 1e-7f, 1000.25f, -1000.75f };
+        coords.insert(coords.end(), std::begin(edges), std::end(edges));
+        for (int i = 0; i <= size; ++i)
+        {
+            coords.push_back((float)i / (float)size);
+            coords.push_back(((float)i + 0.5f) / (float)size);
+        }
+        std::uniform_real_distribution<float> distribution(-2.5f, 3.5f);
+        while ((int)coords.size() < count)
+            coords.push_back(distribution(random));
+        coords.resize(count);
+        std::shuffle(coords.begin(), coords.end(), random);
+        return coords;
+    }
+
+    template <WrapMode wrap, FilterMode filter>
+    static void CompareTexture(const Texture& texture, const Sampler<wrap, filter>& sampler, const int levels, CompareResult& result)
+    {
+        constexpr int count = 1024;
+        std::mt19937 random(1234u + (uint32_t)wrap * 3u + (uint32_t)filter);
+        const std::vector<float> u = CreateCoords(random, count, 16);
+        const std::vector<float> v = CreateCoords(random, count, 16);
+
+        // Integer and fractional LODs, below 0 and past the last level for the clamp
+        std::vector<float> lods = { 0.0f, 1.0f, (float)levels - 1.0f };
+        std::uniform_real_distribution<float> lodDistribution(-1.0f, (float)levels + 1.0f);
+        for (int i = 0; i < 5; ++i)
+            lods.push_back(lodDistribution(random));
+
+        for (const float lod : lods)
+        {
+            for (int i = 0; i < count; i += 8)
+            {
+                Vec4 batched[8];
+                if ((i / 8) % 2 == 0)
+                {
+                    texture.Sample8(sampler, &u[i], &v[i], batched, lod);
+                }
+                else
+                {
+                    texture.Sample4(sampler, &u[i], &v[i], batched, lod);
+                    texture.Sample4(sampler, &u[i + 4], &v[i + 4], batched + 4, lod);
+                }
+
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    const Vec4 scalar = texture.Sample(sampler, { u[i + lane], v[i + lane] }, lod);
+                    result.Samples++;
+                    if (SameBits(scalar, batched[lane]))
+                        continue;
+                    if (result.Mismatches++ == 0)
+                    {
+                        std::ostringstream stream;
+                        stream << std::setprecision(9) << "uv (" << u[i + lane] << ", " << v[i + lane] << ") lod " << lod
+                               << ": " << Describe(scalar) << " != " << Describe(batched[lane]);
+                        result.FirstMismatch = stream.str();
+                    }
+                }
+            }
+        }
+    }
+
+    // Every wrap mode with every filter, and one sampler with a LOD bias and range
+    static void CompareSamplers(const Texture& texture, const int levels, CompareResult& result)
+    {
+        CompareTexture(texture, Sampler<WrapMode::Clamp, FilterMode::Nearest>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Clamp, FilterMode::Bilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Clamp, FilterMode::Trilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Repeat, FilterMode::Nearest>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Repeat, FilterMode::Bilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Repeat, FilterMode::Trilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Mirror, FilterMode::Nearest>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Mirror, FilterMode::Bilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Mirror, FilterMode::Trilinear>{}, levels, result);
+        CompareTexture(texture, Sampler<WrapMode::Repeat, FilterMode::Trilinear>{ 0.75f, 0.5f, 2.25f }, levels, result);
+    }
+
+    static void CompareLodSphere(const LodTextureSphere& sphere, CompareResult& result)
+    {
+        constexpr int count = 4096;
+        std::mt19937 random(4321u);
+        std::uniform_real_distribution<float> dirDistribution(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> lodDistribution(0.0f, 4.0f);
+
+        std::vector<float> x, y, z, lod;
+        auto add = [&](const float dx, const float dy, const float dz, const float l)
+        {
+            x.push_back(dx); y.push_back(dy); z.push_back(dz); lod.push_back(l);
+        };
+        // The poles, the seam of the equirectangular image on both sides, unnormalized lengths and every integer LOD
+        for (int l = 0; l <= 4; ++l)
+        {
+            add(0.0f, 1.0f, 0.0f, (float)l);
+            add(0.0f, -1.0f, 0.0f, (float)l);
+            add(-1.0f, 0.0f, 0.0f, (float)l);
+            add(-1.0f, 0.0f, -0.0f, (float)l);
+            add(-1.0f, 0.25f, 1e-6f, (float)l);
+            add(-1.0f, 0.25f, -1e-6f, (float)l);
+            add(1.0f, 0.0f, 0.0f, (float)l);
+            add(0.0f, 0.0f, 1.0f, (float)l);
+            add(30.0f, -12.0f, 7.0f, (float)l);
+            add(0.01f, 0.02f, -0.03f, (float)l);
+        }
+        while ((int)x.size() < count)
+        {
+            const float dx = dirDistribution(random), dy = dirDistribution(random), dz = dirDistribution(random);
+            if (dx * dx + dy * dy + dz * dz < 1e-4f)
+                continue;
+            add(dx, dy, dz, lodDistribution(random));
+        }
+        x.resize(count); y.resize(count); z.resize(count); lod.resize(count);
+
+        for (int i = 0; i < count; i += 8)
+        {
+            Vec3 batched[8];
+            if ((i / 8) % 2 == 0)
+            {
+                sphere.Sample8(&x[i], &y[i], &z[i], &lod[i], batched);
+            }
+            else
+            {
+                sphere.Sample4(&x[i], &y[i], &z[i], &lod[i], batched);
+                sphere.Sample4(&x[i + 4], &y[i + 4], &z[i + 4], &lod[i + 4], batched + 4);
+            }
+
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                const Vec3 scalar = sphere.Sample({ x[i + lane], y[i + lane], z[i + lane] }, lod[i + lane]);
+                result.Samples++;
+                if (SameBits(scalar, batched[lane]))
+                    continue;
+                if (result.Mismatches++ == 0)
+                {
+                    std::ostringstream stream;
+                    stream << std::setprecision(9) << "dir (" << x[i + lane] << ", " << y[i + lane] << ", " << z[i + lane]
+                           << ") lod " << lod[i + lane] << ": " << Describe(scalar) << " != " << Describe(batched[lane]);
+                    result.FirstMismatch = stream.str();
+                }
+            }
+        }
+    }
+
+    static int GetLevelCount(const int width, const int height)
+    {
+        int levels = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2)
+            levels++;
+        return levels;
+    }
+
+    static bool WriteImage(const std::string& path, const int width, const int height, const int channels, std::mt19937& random)
+    {
+        std::vector<uint8_t> pixels((size_t)width * height * channels);
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (uint8_t& pixel : pixels)
+            pixel = (uint8_t)distribution(random);
+        return stbi_write_png(path.c_str(), width, height, channels, pixels.data(), width * channels) != 0;
+    }
+
+    static bool WriteHdr(const std::string& path, const int width, const int height, std::mt19937& random)
+    {
+        std::vector<float> pixels((size_t)width * height * 3);
+        std::uniform_real_distribution<float> distribution(0.0f, 8.0f);
+        for (float& pixel : pixels)
+            pixel = distribution(random);
+        return stbi_write_hdr(path.c_str(), width, height, 3, pixels.data()) != 0;
+    }
+
+}
+
+// Sample4/Sample8 of Texture and LodTextureSphere against their scalar Sample, for every texel format, layout,
+// wrap mode and filter, on odd sizes, with FastMath off and on. Exit code 0 when every lane matches bit for bit.
+int main()
+{
+    using namespace RGS;
+    using namespace RGS::Test;
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "rgs-sampler-test";
+    std::error_code error;
+    std::filesystem::remove_all(dir, error);
+    std::filesystem::create_directories(dir, error);
+
+    struct Size
+    {
+        int Width, Height;
+    };
+    const Size sizes[] = { { 1, 1 }, { 5, 1 }, { 3, 5 }, { 13, 9 }, { 33, 17 } };
+    const char* channelNames[] = { "", "R8", "RG8", "RGB8", "RGBA8" };
+    const char* storageNames[] = { "linear", "tiled", "compressed" };
+
+    std::mt19937 random(42u);
+    int failures = 0;
+    auto report = [&failures](const std::string& name, const bool fastMath, const CompareResult& result)
+    {
+        const bool passed = result.Mismatches == 0 && result.Samples > 0;
+        failures += passed ? 0 : 1;
+        std::cout << std::left << std::setw(34) << name << std::setw(6) << (fastMath ? "fast" : "libm") << std::right
+                  << std::setw(10) << result.Samples << std::setw(10) << result.Mismatches
+                  << (passed ? "" : "  FAIL " + (result.Samples > 0 ? result.FirstMismatch : std::string("not loaded"))) << std::endl;
+    };
+
+    std::cout << std::left << std::setw(34) << "texture" << std::setw(6) << "math" << std::right
+              << std::setw(10) << "samples" << std::setw(10) << "mismatch" << std::endl;
+    for (const bool fastMath : { false, true })
+    {
+        FastMath::Scope scope(fastMath);
+        for (const Size& size : sizes)
+        {
+            const std::string sizeName = std::to_string(size.Width) + "x" + std::to_string(size.Height);
+            const int levels = GetLevelCount(size.Width, size.Height);
+
+            // 8-bit images, Compressed encodes them to BC4, BC5, BC1 and BC3
+            for (int channels = 1; channels <= 4; ++channels)
+            {
+                const std::string path = (dir / (sizeName + "-" + std::to_string(channels) + ".png")).string();
+                if (!WriteImage(path, size.Width, size.Height, channels, random))
+                    std::cout << "写入失败: " << path << std::endl;
+                for (int storage = 0; storage < 3; ++storage)
+                {
+                    CompareResult result;
+                    std::unique_ptr<Texture> texture(Texture::LoadTexture(path, (TextureStorage)storage));
+                    if (texture)
+                        CompareSamplers(*texture, levels, result);
+                    report(std::string(channelNames[channels]) + " " + storageNames[storage] + " " + sizeName, fastMath, result);
+                }
+            }
+
+            // RGBA16F, from a framebuffer
+            std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(size.Width, size.Height);
+            std::uniform_real_distribution<float> colorDistribution(0.0f, 4.0f);
+            for (int y = 0; y < size.Height; ++y)
+                for (int x = 0; x < size.Width; ++x)
+                    framebuffer->SetColor(x, y, { colorDistribution(random), colorDistribution(random), colorDistribution(random) });
+            for (int storage = 0; storage < 2; ++storage)
+            {
+                CompareResult result;
+                Texture texture(*framebuffer, (TextureStorage)storage);
+                CompareSamplers(texture, levels, result);
+                report(std::string("RGBA16F ") + storageNames[storage] + " " + sizeName, fastMath, result);
+            }
+        }
+
+        // The five levels of a prefiltered map, halving and down to 1x1
+        const std::vector<std::vector<Size>> sphereLevels =
+        {
+            { { 33, 17 }, { 17, 9 }, { 9, 5 }, { 5, 3 }, { 3, 1 } },
+            { { 7, 7 }, { 5, 5 }, { 3, 3 }, { 2, 2 }, { 1, 1 } },
+        };
+        for (size_t set = 0; set < sphereLevels.size(); ++set)
+        {
+            std::vector<std::string> paths;
+            for (size_t level = 0; level < sphereLevels[set].size(); ++level)
+            {
+                const Size& size = sphereLevels[set][level];
+                paths.push_back((dir / ("sphere" + std::to_string(set) + "-" + std::to_string(level) + ".hdr")).string());
+                if (!WriteHdr(paths.back(), size.Width, size.Height, random))
+                    std::cout << "写入失败: " << paths.back() << std::endl;
+            }
+
+            CompareResult result;
+            std::unique_ptr<LodTextureSphere> sphere(LodTextureSphere::LoadLodTextureSphere(paths));
+            if (sphere)
+                CompareLodSphere(*sphere, result);
+            const Size& top = sphereLevels[set].front();
+            report("LodTextureSphere " + std::to_string(top.Width) + "x" + std::to_string(top.Height), fastMath, result);
+        }
+    }
+
+    std::filesystem::remove_all(dir, error);
+
+    std::cout << (failures == 0 ? "All batched lookups match Sample" : std::to_string(failures) + " texture(s) with mismatching lookups") << std::endl;
+    return failures == 0 ? 0 : 1;
+}